@@ -0,0 +1,357 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <esc/ipc/device.h>
+#include <esc/ipc/ipcstream.h>
+#include <esc/proto/socket.h>
+#include <esc/stream/std.h>
+#include <esc/dns.h>
+#include <sys/common.h>
+#include <sys/sync.h>
+#include <sys/thread.h>
+#include <sys/time.h>
+#include <map>
+#include <mutex>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+using namespace esc;
+
+/* the max. number of cached names */
+static const size_t MAX_ENTRIES			= 256;
+/* the max. number of seconds to cache an answer */
+static const uint32_t MAX_TTL			= 24 * 3600;
+/* the interval in which we check for timeouts (in us) */
+static const uint TICK					= 100 * 1000;
+/* the min. time to wait before we send a query again (in ms) */
+static const uint MIN_RETRANSMIT		= 200;
+static const int DNS_PORT				= 53;
+
+/**
+ * A cached answer, which is either an address or an error (negative caching).
+ */
+struct Entry {
+	explicit Entry() : res(), addr(), expires() {
+	}
+	explicit Entry(int _res,const Net::IPv4Addr &_addr,time_t _expires)
+		: res(_res), addr(_addr), expires(_expires) {
+	}
+
+	int res;
+	Net::IPv4Addr addr;
+	time_t expires;
+};
+
+/**
+ * A client that waits for the answer of a query
+ */
+struct Waiter {
+	explicit Waiter() : fd(), mid(), deadline() {
+	}
+	explicit Waiter(int _fd,msgid_t _mid,uint64_t _deadline)
+		: fd(_fd), mid(_mid), deadline(_deadline) {
+	}
+
+	int fd;
+	msgid_t mid;
+	uint64_t deadline;
+};
+
+/**
+ * An outstanding query. All clients that ask for the same name while the query is in flight wait
+ * for the same answer.
+ */
+struct Query {
+	explicit Query(const char *_name,uint16_t _txid)
+		: name(_name), txid(_txid), server(), retransmit(), interval(), waiters() {
+	}
+
+	std::string name;
+	uint16_t txid;
+	/* the name server we sent the query to */
+	Net::IPv4Addr server;
+	uint64_t retransmit;
+	uint64_t interval;
+	std::vector<Waiter> waiters;
+};
+
+class DNSService : public Device {
+	typedef std::map<std::string,Entry> cache_type;
+	typedef std::map<uint16_t,Query*> query_type;
+
+public:
+	explicit DNSService(const char *path,mode_t mode)
+		: Device(path,mode,DEV_TYPE_SERVICE,DEV_CLOSE), _mutex(), _cache(), _queries(),
+		  _nameserver(), _sock(Socket::SOCK_DGRAM,Socket::PROTO_UDP), _bound(), _sent() {
+		if(usemcrt(&_bound,0) < 0)
+			error("Unable to create semaphore");
+		set(MSG_DNS_RESOLVE,std::make_memfun(this,&DNSService::resolve),false);
+		set(MSG_DNS_SET_SERVER,std::make_memfun(this,&DNSService::setServer));
+		set(MSG_FILE_CLOSE,std::make_memfun(this,&DNSService::close),false);
+	}
+
+	void resolve(IPCStream &is) {
+		uint timeout;
+		CStringBuf<DNS::MAX_NAME_LEN + 1> name;
+		is >> timeout >> name;
+		if(is.error()) {
+			reply(is.fd(),is.msgid(),-EINVAL,Net::IPv4Addr());
+			return;
+		}
+
+		std::lock_guard<std::mutex> guard(_mutex);
+
+		// answer from the cache, if possible
+		cache_type::iterator it = _cache.find(name.str());
+		if(it != _cache.end()) {
+			if(it->second.expires > time(NULL)) {
+				reply(is.fd(),is.msgid(),it->second.res,it->second.addr);
+				return;
+			}
+			_cache.erase(it);
+		}
+
+		uint64_t now = tsctotime(rdtsc());
+		Waiter w(is.fd(),is.msgid(),now + timeout * 1000ULL);
+
+		// is there already a query for this name?
+		for(auto q = _queries.begin(); q != _queries.end(); ++q) {
+			if(q->second->name == name.str()) {
+				q->second->waiters.push_back(w);
+				return;
+			}
+		}
+
+		// no, so send a new one
+		Query *q = new Query(name.str(),genTxId());
+		q->waiters.push_back(w);
+		q->interval = esc::Util::max(timeout / 3,MIN_RETRANSMIT) * 1000ULL;
+		int res = send(q,now);
+		if(res < 0) {
+			reply(w.fd,w.mid,res,Net::IPv4Addr());
+			delete q;
+			return;
+		}
+		_queries[q->txid] = q;
+	}
+
+	void setServer(IPCStream &is) {
+		Net::IPv4Addr ns;
+		is >> ns;
+
+		std::lock_guard<std::mutex> guard(_mutex);
+		_nameserver = ns;
+		// the answers of the old server might differ
+		_cache.clear();
+		is << errcode_t(0) << Reply();
+	}
+
+	void close(IPCStream &is) {
+		{
+			std::lock_guard<std::mutex> guard(_mutex);
+			for(auto q = _queries.begin(); q != _queries.end(); ++q) {
+				std::vector<Waiter> &ws = q->second->waiters;
+				for(auto w = ws.begin(); w != ws.end(); ) {
+					if(w->fd == is.fd())
+						w = ws.erase(w);
+					else
+						++w;
+				}
+			}
+		}
+		Device::close(is);
+	}
+
+	/**
+	 * Receives the responses of the name server
+	 */
+	void receive() {
+		uint8_t buffer[DNS::MAX_MSG_SIZE];
+		// the socket gets its port with the first query; we can't receive anything before that
+		usemdown(&_bound);
+
+		while(1) {
+			Socket::Addr addr;
+			size_t len;
+			try {
+				len = _sock.recvfrom(addr,buffer,sizeof(buffer));
+			}
+			catch(const default_error &e) {
+				errmsg("Receiving DNS response failed: " << e.what());
+				continue;
+			}
+
+			int txid = DNS::getTxId(buffer,len);
+			if(txid < 0 || addr.family != Socket::AF_INET || addr.d.ipv4.port != DNS_PORT)
+				continue;
+
+			std::lock_guard<std::mutex> guard(_mutex);
+			query_type::iterator it = _queries.find(txid);
+			if(it == _queries.end())
+				continue;
+
+			// ignore everything that is not the answer to our query, which might be spoofed
+			Query *q = it->second;
+			if(addr.d.ipv4.addr != q->server.value())
+				continue;
+			uint32_t ttl;
+			Net::IPv4Addr ip;
+			int res = DNS::parseResponse(buffer,len,q->txid,q->name.c_str(),&ip,&ttl);
+			if(res == -EINVAL)
+				continue;
+
+			if(ttl > 0)
+				insert(q->name,Entry(res,ip,time(NULL) + esc::Util::min(ttl,MAX_TTL)));
+			for(auto w = q->waiters.begin(); w != q->waiters.end(); ++w)
+				reply(w->fd,w->mid,res,ip);
+			_queries.erase(it);
+			delete q;
+		}
+	}
+
+	/**
+	 * Sends queries again and lets waiters time out
+	 */
+	void tick() {
+		std::lock_guard<std::mutex> guard(_mutex);
+		uint64_t now = tsctotime(rdtsc());
+		for(auto it = _queries.begin(); it != _queries.end(); ) {
+			Query *q = it->second;
+			for(auto w = q->waiters.begin(); w != q->waiters.end(); ) {
+				if(now >= w->deadline) {
+					reply(w->fd,w->mid,-ETIMEOUT,Net::IPv4Addr());
+					w = q->waiters.erase(w);
+				}
+				else
+					++w;
+			}
+
+			if(q->waiters.empty() || (now >= q->retransmit && send(q,now) < 0)) {
+				for(auto w = q->waiters.begin(); w != q->waiters.end(); ++w)
+					reply(w->fd,w->mid,-ETIMEOUT,Net::IPv4Addr());
+				auto old = it++;
+				_queries.erase(old);
+				delete q;
+			}
+			else
+				++it;
+		}
+	}
+
+private:
+	int send(Query *q,uint64_t now) {
+		uint8_t buffer[DNS::MAX_MSG_SIZE];
+		try {
+			// the name server might have changed in the meantime
+			Net::IPv4Addr ns = _nameserver.value() ? _nameserver : DNS::getNameserver();
+			size_t len = DNS::buildQuery(buffer,q->txid,q->name.c_str());
+
+			Socket::Addr addr;
+			addr.family = Socket::AF_INET;
+			addr.d.ipv4.addr = ns.value();
+			addr.d.ipv4.port = DNS_PORT;
+			_sock.sendto(addr,buffer,len);
+			q->server = ns;
+		}
+		catch(const default_error &e) {
+			errmsg("Sending DNS query for '" << q->name << "' failed: " << e.what());
+			return e.error() ? e.error() : -EINVAL;
+		}
+		q->retransmit = now + q->interval;
+		if(!_sent) {
+			_sent = true;
+			usemup(&_bound);
+		}
+		return 0;
+	}
+
+	uint16_t genTxId() {
+		// use a random id that is not used by another outstanding query
+		uint16_t txid;
+		do {
+			txid = DNS::genTxId();
+		}
+		while(_queries.find(txid) != _queries.end());
+		return txid;
+	}
+
+	void insert(const std::string &name,const Entry &e) {
+		if(_cache.size() >= MAX_ENTRIES) {
+			// remove the expired entries or, if there are none, the one that expires first
+			time_t ts = time(NULL);
+			cache_type::iterator first = _cache.end();
+			for(auto it = _cache.begin(); it != _cache.end(); ) {
+				auto cur = it++;
+				if(cur->second.expires <= ts)
+					_cache.erase(cur);
+				else if(first == _cache.end() || cur->second.expires < first->second.expires)
+					first = cur;
+			}
+			if(_cache.size() >= MAX_ENTRIES)
+				_cache.erase(first);
+		}
+		_cache[name] = e;
+	}
+
+	static void reply(int fd,msgid_t mid,int res,const Net::IPv4Addr &addr) {
+		ulong buffer[IPC_DEF_SIZE / sizeof(ulong)];
+		IPCStream is(fd,buffer,sizeof(buffer),mid);
+		try {
+			is << errcode_t(res) << addr << Reply();
+		}
+		catch(...) {
+			// the client might be gone
+		}
+	}
+
+	std::mutex _mutex;
+	cache_type _cache;
+	query_type _queries;
+	Net::IPv4Addr _nameserver;
+	Socket _sock;
+	/* signals the receive thread that the socket is bound */
+	tUserSem _bound;
+	bool _sent;
+};
+
+static int receiveThread(void *arg) {
+	static_cast<DNSService*>(arg)->receive();
+	return 0;
+}
+
+static int tickThread(void *arg) {
+	while(1) {
+		usleep(TICK);
+		static_cast<DNSService*>(arg)->tick();
+	}
+	return 0;
+}
+
+int main() {
+	DNSService dev(DNS::getServiceDev(),0110);
+
+	if(startthread(receiveThread,&dev) < 0)
+		error("Unable to start receive thread");
+	if(startthread(tickThread,&dev) < 0)
+		error("Unable to start tick thread");
+
+	dev.loop();
+	return EXIT_SUCCESS;
+}
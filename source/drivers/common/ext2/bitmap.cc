@@ -145,20 +145,24 @@ block_t Ext2Bitmap::allocBlock(Ext2FileSystem *e,Ext2CInode *inode) {
 	block_t block = e->getBlockOfInode(inode->inodeNo);
 	block_t i,group = e->getGroupOfBlock(block);
 	block_t bno = 0;
-	uint32_t blocksPerGroup = le32tocpu(e->sb.get()->blocksPerGroup);
 
 	sassert(tpool_lock(EXT2_SUPERBLOCK_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
 	if(le32tocpu(e->sb.get()->freeBlockCount) == 0)
 		goto done;
 
+	/* take the next block of the reservation window of the inode, if possible */
+	bno = e->rsv.alloc(inode,group);
+	if(bno != 0)
+		goto done;
+
 	/* first try to find a block in the block-group of the inode */
-	bno = allocBlockIn(e,group * blocksPerGroup,e->bgs.get(group));
+	bno = allocBlockIn(e,group);
 	if(bno != 0)
 		goto done;
 
 	/* now try the other block-groups */
-	for(i = group + 1; i != group; i = (i + 1) % gcount) {
-		bno = allocBlockIn(e,i * blocksPerGroup,e->bgs.get(i));
+	for(i = (group + 1) % gcount; i != group; i = (i + 1) % gcount) {
+		bno = allocBlockIn(e,i);
 		if(bno != 0)
 			goto done;
 	}
@@ -169,7 +173,7 @@ done:
 }
 
 int Ext2Bitmap::freeBlock(Ext2FileSystem *e,block_t blockNo) {
-	block_t group = e->getGroupOfBlock(blockNo);
+	block_t group = (blockNo - firstBlock(e)) / le32tocpu(e->sb.get()->blocksPerGroup);
 	CBlock *bitmap;
 	uint8_t *bitmapbuf;
 	uint16_t freeBlockCount;
@@ -183,7 +187,7 @@ int Ext2Bitmap::freeBlock(Ext2FileSystem *e,block_t blockNo) {
 	}
 
 	/* mark free in bitmap */
-	blockNo--;
+	blockNo -= firstBlock(e);
 	blockNo %= le32tocpu(e->sb.get()->blocksPerGroup);
 	bitmapbuf = (uint8_t*)bitmap->buffer;
 	bitmapbuf[blockNo / 8] &= ~(1 << (blockNo % 8));
@@ -199,43 +203,137 @@ int Ext2Bitmap::freeBlock(Ext2FileSystem *e,block_t blockNo) {
 	return 0;
 }
 
-block_t Ext2Bitmap::allocBlockIn(Ext2FileSystem *e,block_t groupStart,Ext2BlockGrp *group) {
-	size_t i,j;
-	block_t bno;
-	CBlock *bitmap;
-	uint8_t *bitmapbuf;
-	uint32_t sFreeBlockCount;
-	uint32_t blockCount = le32tocpu(e->sb.get()->blockCount);
-	if(le16tocpu(group->freeBlockCount) == 0)
+block_t Ext2Bitmap::findFree(Ext2FileSystem *e,block_t goal,size_t want,size_t *runLen) {
+	size_t gcount = e->getBlockGroupCount();
+	uint32_t blocksPerGroup = le32tocpu(e->sb.get()->blocksPerGroup);
+	block_t first = firstBlock(e);
+	block_t best = 0;
+	size_t bestLen = 0;
+	if(goal < first || goal >= le32tocpu(e->sb.get()->blockCount))
+		goal = first;
+
+	/* start at <goal> in its group and walk once through all groups */
+	block_t group = (goal - first) / blocksPerGroup;
+	size_t from = (goal - first) % blocksPerGroup;
+	for(size_t n = 0; n <= gcount; n++, from = 0, group = (group + 1) % gcount) {
+		Ext2BlockGrp *bg = e->bgs.get(group);
+		if(le16tocpu(bg->freeBlockCount) == 0)
+			continue;
+
+		CBlock *bitmap = e->blockCache.request(le32tocpu(bg->blockBitmap),BlockCache::READ);
+		if(bitmap == NULL)
+			continue;
+
+		/* the last walk covers the part of the goal-group before <goal> */
+		size_t len;
+		size_t bits = groupBlocks(e,group);
+		ssize_t bit = findFreeIn((const uint32_t*)bitmap->buffer,bits,from,want,&len);
+		e->blockCache.release(bitmap);
+		if(bit >= 0 && len > bestLen) {
+			best = first + group * blocksPerGroup + bit;
+			bestLen = len;
+			if(len >= want)
+				break;
+		}
+	}
+
+	*runLen = bestLen;
+	return best;
+}
+
+bool Ext2Bitmap::claimBlock(Ext2FileSystem *e,block_t bno) {
+	uint32_t blocksPerGroup = le32tocpu(e->sb.get()->blocksPerGroup);
+	if(bno < firstBlock(e) || bno >= le32tocpu(e->sb.get()->blockCount))
+		return false;
+
+	block_t group = (bno - firstBlock(e)) / blocksPerGroup;
+	size_t bit = (bno - firstBlock(e)) % blocksPerGroup;
+	Ext2BlockGrp *bg = e->bgs.get(group);
+	CBlock *bitmap = e->blockCache.request(le32tocpu(bg->blockBitmap),BlockCache::WRITE);
+	if(bitmap == NULL)
+		return false;
+
+	uint8_t *bitmapbuf = (uint8_t*)bitmap->buffer;
+	bool res = !(bitmapbuf[bit / 8] & (1 << (bit % 8)));
+	if(res) {
+		bitmapbuf[bit / 8] |= 1 << (bit % 8);
+		bg->freeBlockCount = cputole16(le16tocpu(bg->freeBlockCount) - 1);
+		e->bgs.markDirty();
+		e->sb.get()->freeBlockCount = cputole32(le32tocpu(e->sb.get()->freeBlockCount) - 1);
+		e->sb.markDirty();
+		e->blockCache.markDirty(bitmap);
+	}
+	e->blockCache.release(bitmap);
+	return res;
+}
+
+block_t Ext2Bitmap::allocBlockIn(Ext2FileSystem *e,block_t group) {
+	Ext2BlockGrp *bg = e->bgs.get(group);
+	if(le16tocpu(bg->freeBlockCount) == 0)
 		return 0;
 
 	/* load bitmap */
-	bitmap = e->blockCache.request(le32tocpu(group->blockBitmap),BlockCache::WRITE);
+	CBlock *bitmap = e->blockCache.request(le32tocpu(bg->blockBitmap),BlockCache::READ);
 	if(bitmap == NULL)
 		return 0;
 
-	bno = 0;
-	bitmapbuf = (uint8_t*)bitmap->buffer;
-	for(i = 0; i < e->blockSize(); i++) {
-		for(j = 1; j < 256; bno++, j <<= 1) {
-			if(bno >= blockCount) {
-				e->blockCache.release(bitmap);
-				return 0;
-			}
-			if(!(bitmapbuf[i] & j)) {
-				uint16_t freeBlockCount = le16tocpu(group->freeBlockCount);
-				group->freeBlockCount = cputole16(freeBlockCount - 1);
-				e->bgs.markDirty();
-				bitmapbuf[i] |= j;
-				sFreeBlockCount = le32tocpu(e->sb.get()->freeBlockCount);
-				e->sb.get()->freeBlockCount = cputole32(sFreeBlockCount - 1);
-				e->sb.markDirty();
-				e->blockCache.markDirty(bitmap);
-				e->blockCache.release(bitmap);
-				return bno + groupStart + 1;
+	size_t len;
+	ssize_t bit = findFreeIn((const uint32_t*)bitmap->buffer,groupBlocks(e,group),0,1,&len);
+	e->blockCache.release(bitmap);
+	if(bit < 0)
+		return 0;
+
+	block_t bno = firstBlock(e) + group * le32tocpu(e->sb.get()->blocksPerGroup) + bit;
+	return claimBlock(e,bno) ? bno : 0;
+}
+
+ssize_t Ext2Bitmap::findFreeIn(const uint32_t *bitmap,size_t bits,size_t from,size_t want,
+		size_t *runLen) {
+	ssize_t best = -1;
+	size_t bestLen = 0;
+	size_t i = from;
+	while(i < bits) {
+		/* skip words that are completely used */
+		uint32_t word = le32tocpu(bitmap[i / 32]) | ((1U << (i % 32)) - 1);
+		if(word == 0xFFFFFFFF) {
+			i = (i + 32) & ~(size_t)31;
+			continue;
+		}
+
+		/* the first free block */
+		size_t start = (i & ~(size_t)31) + __builtin_ctz(~word);
+		if(start >= bits)
+			break;
+
+		/* determine the length of the run, again a word at a time, if possible */
+		size_t end = start + 1;
+		while(end < bits && end - start < want) {
+			uint32_t w = le32tocpu(bitmap[end / 32]) >> (end % 32);
+			if(w == 0) {
+				end += 32 - (end % 32);
+				continue;
 			}
+			end += __builtin_ctz(w);
+			break;
+		}
+		if(end > bits)
+			end = bits;
+
+		if(end - start > bestLen) {
+			best = start;
+			bestLen = end - start;
+			if(bestLen >= want)
+				break;
 		}
+		i = end;
 	}
-	e->blockCache.release(bitmap);
-	return 0;
+
+	*runLen = bestLen;
+	return best;
+}
+
+size_t Ext2Bitmap::groupBlocks(Ext2FileSystem *e,block_t group) {
+	uint32_t blocksPerGroup = le32tocpu(e->sb.get()->blocksPerGroup);
+	size_t rem = le32tocpu(e->sb.get()->blockCount) - firstBlock(e) - group * blocksPerGroup;
+	return rem < blocksPerGroup ? rem : blocksPerGroup;
 }
@@ -49,7 +49,8 @@ public:
 	static int freeInode(Ext2FileSystem *e,ino_t ino,bool isDir);
 
 	/**
-	 * Allocates a new block for the given inode. It will be tried to allocate a block in the same
+	 * Allocates a new block for the given inode. The block is taken from the reservation window of
+	 * the inode, if possible. Otherwise, it will be tried to allocate a block in the same
 	 * block-group.
 	 *
 	 * @param e the ext2-fs
@@ -67,7 +68,35 @@ public:
 	 */
 	static int freeBlock(Ext2FileSystem *e,block_t blockNo);
 
+	/**
+	 * Searches for a run of <want> free blocks, starting at <goal>. The bitmaps are scanned a word
+	 * at a time. Assumes that EXT2_SUPERBLOCK_LOCK is held.
+	 *
+	 * @param e the ext2-fs
+	 * @param goal the block-number to start at
+	 * @param want the desired number of blocks
+	 * @param runLen will be set to the length of the found run (might be less than <want>, if
+	 *  there is no run that long)
+	 * @return the first block of the run or 0 if there is no free block
+	 */
+	static block_t findFree(Ext2FileSystem *e,block_t goal,size_t want,size_t *runLen);
+
+	/**
+	 * Marks the given block as used, if it is free. Assumes that EXT2_SUPERBLOCK_LOCK is held.
+	 *
+	 * @param e the ext2-fs
+	 * @param bno the block-number
+	 * @return true if the block was free
+	 */
+	static bool claimBlock(Ext2FileSystem *e,block_t bno);
+
 private:
+	static block_t firstBlock(Ext2FileSystem *e) {
+		return le32tocpu(e->sb.get()->firstDataBlock);
+	}
+	static size_t groupBlocks(Ext2FileSystem *e,block_t group);
+	static ssize_t findFreeIn(const uint32_t *bitmap,size_t bits,size_t from,size_t want,
+		size_t *runLen);
 	static ino_t allocInodeIn(Ext2FileSystem *e,block_t groupStart,fs::Ext2BlockGrp *group,bool isDir);
-	static block_t allocBlockIn(Ext2FileSystem *e,block_t groupStart,fs::Ext2BlockGrp *group);
+	static block_t allocBlockIn(Ext2FileSystem *e,block_t group);
 };
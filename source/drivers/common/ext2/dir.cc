@@ -28,6 +28,7 @@
 #include "dir.h"
 #include "ext2.h"
 #include "file.h"
+#include "htree.h"
 #include "inodecache.h"
 #include "link.h"
 
@@ -72,6 +73,20 @@ ino_t Ext2Dir::find(Ext2FileSystem *e,Ext2CInode *dir,const char *name,size_t na
 	ino_t ino;
 	size_t size = le32tocpu(dir->inode.size);
 	int res;
+
+	/* use the hashed index, if there is one */
+	if(Ext2HTree::isIndexed(e,dir)) {
+		ino = Ext2HTree::find(e,dir,name,nameLen);
+		if(ino != -ENOTSUP)
+			return ino;
+	}
+	/* otherwise, try the in-memory hash for large directories */
+	else {
+		ino = e->dirCache.find(dir,name,nameLen);
+		if(ino != -ENOTSUP)
+			return ino;
+	}
+
 	Ext2DirEntry *buffer = (Ext2DirEntry*)malloc(size);
 	if(buffer == NULL)
 		return -ENOMEM;
@@ -91,10 +106,11 @@ ino_t Ext2Dir::findIn(Ext2DirEntry *buffer,size_t bufSize,const char *name,size_
 	ssize_t rem = bufSize;
 	Ext2DirEntry *entry = buffer;
 
-	/* search the directory-entries */
-	while(rem > 0 && le32tocpu(entry->inode) != 0) {
+	/* search the directory-entries; unused ones (inode 0) may be everywhere */
+	while(rem > 0 && le16tocpu(entry->recLen) != 0) {
 		/* found a match? */
-		if(nameLen == le16tocpu(entry->nameLen) && strncmp(entry->name,name,nameLen) == 0) {
+		if(le32tocpu(entry->inode) != 0 && nameLen == le16tocpu(entry->nameLen) &&
+				strncmp(entry->name,name,nameLen) == 0) {
 			ino_t ino = le32tocpu(entry->inode);
 			return ino;
 		}
@@ -106,6 +122,40 @@ ino_t Ext2Dir::findIn(Ext2DirEntry *buffer,size_t bufSize,const char *name,size_
 	return -ENOENT;
 }
 
+bool Ext2Dir::addIn(Ext2DirEntry *buffer,size_t bufSize,ino_t ino,const char *name,size_t nameLen) {
+	size_t tlen = Ext2Link::getDirESize(nameLen);
+	uint8_t *end = (uint8_t*)buffer + bufSize;
+	Ext2DirEntry *dire = buffer;
+	while((uint8_t*)dire < end) {
+		uint16_t orgRecLen = le16tocpu(dire->recLen);
+		if(orgRecLen == 0)
+			break;
+
+		/* an unused entry can be taken completely */
+		if(le32tocpu(dire->inode) == 0 && orgRecLen >= tlen) {
+			dire->inode = cputole32(ino);
+			dire->nameLen = cputole16(nameLen);
+			memcpy(dire->name,name,nameLen);
+			return true;
+		}
+
+		/* does our entry fit behind the existing one? */
+		size_t elen = Ext2Link::getDirESize(le16tocpu(dire->nameLen));
+		if(elen < orgRecLen && orgRecLen - elen >= tlen) {
+			/* adjust old entry */
+			dire->recLen = cputole16(elen);
+			dire = (Ext2DirEntry*)((uintptr_t)dire + elen);
+			dire->inode = cputole32(ino);
+			dire->nameLen = cputole16(nameLen);
+			dire->recLen = cputole16(orgRecLen - elen);
+			memcpy(dire->name,name,nameLen);
+			return true;
+		}
+		dire = (Ext2DirEntry*)((uintptr_t)dire + orgRecLen);
+	}
+	return false;
+}
+
 int Ext2Dir::remove(Ext2FileSystem *e,User *u,Ext2CInode *dir,const char *name) {
 	ino_t ino;
 	size_t size = le32tocpu(dir->inode.size);
@@ -141,10 +191,10 @@ int Ext2Dir::remove(Ext2FileSystem *e,User *u,Ext2CInode *dir,const char *name)
 
 	/* search for other entries than '.' and '..' */
 	entry = buffer;
-	while(size > 0 && entry->inode != 0) {
+	while(size > 0 && entry->recLen != 0) {
 		uint16_t namelen = le16tocpu(entry->nameLen);
 		/* found a match? */
-		if(namelen != 1 && namelen != 2 &&
+		if(entry->inode != 0 && namelen != 1 && namelen != 2 &&
 				strncmp(entry->name,".",namelen) != 0 &&
 				strncmp(entry->name,"..",namelen) != 0) {
 			res = -ENOTEMPTY;
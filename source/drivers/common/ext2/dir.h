@@ -64,6 +64,19 @@ public:
 	 */
 	static ino_t findIn(fs::Ext2DirEntry *buffer,size_t bufSize,const char *name,size_t nameLen);
 
+	/**
+	 * Places the entry <name> for <ino> into the unused space of the entries in the given buffer.
+	 *
+	 * @param buffer the buffer with the directory-entries
+	 * @param bufSize the size of the buffer
+	 * @param ino the inode-number of the entry
+	 * @param name the name of the entry
+	 * @param nameLen the length of the name
+	 * @return true if there was enough space
+	 */
+	static bool addIn(fs::Ext2DirEntry *buffer,size_t bufSize,ino_t ino,const char *name,
+		size_t nameLen);
+
 	/**
 	 * Removes the directory with given name from the given directory. It is required that
 	 * the directory is empty!
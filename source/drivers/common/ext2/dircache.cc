@@ -0,0 +1,245 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <fs/common.h>
+#include <sys/common.h>
+#include <sys/endian.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dircache.h"
+#include "ext2.h"
+#include "file.h"
+#include "inodecache.h"
+
+using namespace fs;
+
+Ext2DirCache::Ext2DirCache(Ext2FileSystem *fs)
+		: _hits(), _misses(), _loads(), _time(), _dirs(new Dir[EXT2_DCACHE_SIZE]), _fs(fs) {
+	for(size_t i = 0; i < EXT2_DCACHE_SIZE; i++) {
+		_dirs[i].table = NULL;
+		clear(_dirs + i);
+	}
+}
+
+Ext2DirCache::~Ext2DirCache() {
+	for(size_t i = 0; i < EXT2_DCACHE_SIZE; i++)
+		clear(_dirs + i);
+	delete[] _dirs;
+}
+
+ino_t Ext2DirCache::find(Ext2CInode *dir,const char *name,size_t nameLen) {
+	/* small directories are read with a single block-request anyway */
+	if((size_t)le32tocpu(dir->inode.size) <= _fs->blockSize())
+		return -ENOTSUP;
+
+	sassert(tpool_lock(EXT2_DIRCACHE_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
+	ino_t res = -ENOTSUP;
+	Dir *d = get(dir->inodeNo);
+	if(d)
+		_hits++;
+	else {
+		d = load(dir);
+		_misses++;
+	}
+
+	if(d) {
+		d->lastUse = ++_time;
+		uint32_t h = hash(name,nameLen);
+		res = -ENOENT;
+		for(Entry *e = d->table[h & (d->size - 1)]; e != NULL; e = e->next) {
+			if(e->hash == h && e->nameLen == nameLen && memcmp(e->name,name,nameLen) == 0) {
+				res = e->ino;
+				break;
+			}
+		}
+	}
+	sassert(tpool_unlock(EXT2_DIRCACHE_LOCK) == 0);
+	return res;
+}
+
+void Ext2DirCache::add(ino_t dir,const char *name,size_t nameLen,ino_t ino) {
+	sassert(tpool_lock(EXT2_DIRCACHE_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
+	Dir *d = get(dir);
+	/* if we can't add it, the cache would be incomplete */
+	if(d && !insert(d,name,nameLen,ino))
+		clear(d);
+	sassert(tpool_unlock(EXT2_DIRCACHE_LOCK) == 0);
+}
+
+void Ext2DirCache::remove(ino_t dir,const char *name,size_t nameLen) {
+	sassert(tpool_lock(EXT2_DIRCACHE_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
+	Dir *d = get(dir);
+	if(d) {
+		uint32_t h = hash(name,nameLen);
+		Entry **prev = d->table + (h & (d->size - 1));
+		for(Entry *e = *prev; e != NULL; prev = &e->next, e = e->next) {
+			if(e->hash == h && e->nameLen == nameLen && memcmp(e->name,name,nameLen) == 0) {
+				*prev = e->next;
+				free(e);
+				d->count--;
+				break;
+			}
+		}
+	}
+	sassert(tpool_unlock(EXT2_DIRCACHE_LOCK) == 0);
+}
+
+void Ext2DirCache::invalidate(ino_t dir) {
+	sassert(tpool_lock(EXT2_DIRCACHE_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
+	Dir *d = get(dir);
+	if(d)
+		clear(d);
+	sassert(tpool_unlock(EXT2_DIRCACHE_LOCK) == 0);
+}
+
+void Ext2DirCache::print(FILE *f) {
+	size_t entries = 0,dirs = 0;
+	for(size_t i = 0; i < EXT2_DCACHE_SIZE; i++) {
+		if(_dirs[i].ino != EXT2_BAD_INO) {
+			dirs++;
+			entries += _dirs[i].count;
+		}
+	}
+	fprintf(f,"\tDirectories: %zu of %zu\n",dirs,EXT2_DCACHE_SIZE);
+	fprintf(f,"\tEntries: %zu\n",entries);
+	fprintf(f,"\tLoads: %zu\n",_loads);
+	fprintf(f,"\tHits: %zu\n",_hits);
+	fprintf(f,"\tMisses: %zu\n",_misses);
+}
+
+uint32_t Ext2DirCache::hash(const char *name,size_t nameLen) {
+	/* FNV-1a */
+	uint32_t h = 2166136261U;
+	while(nameLen-- > 0) {
+		h ^= (uchar)*name++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+Ext2DirCache::Dir *Ext2DirCache::get(ino_t dir) {
+	for(size_t i = 0; i < EXT2_DCACHE_SIZE; i++) {
+		if(_dirs[i].ino == dir)
+			return _dirs + i;
+	}
+	return NULL;
+}
+
+Ext2DirCache::Dir *Ext2DirCache::load(Ext2CInode *dir) {
+	size_t size = le32tocpu(dir->inode.size);
+	uint8_t *buffer = static_cast<uint8_t*>(malloc(size));
+	if(buffer == NULL)
+		return NULL;
+	if(Ext2File::readIno(_fs,dir,buffer,0,size) != (ssize_t)size) {
+		free(buffer);
+		return NULL;
+	}
+
+	/* replace the least recently used directory */
+	Dir *d = _dirs;
+	for(size_t i = 1; i < EXT2_DCACHE_SIZE; i++) {
+		if(_dirs[i].ino == EXT2_BAD_INO || _dirs[i].lastUse < d->lastUse) {
+			d = _dirs + i;
+			if(d->ino == EXT2_BAD_INO)
+				break;
+		}
+	}
+	clear(d);
+
+	/* start with roughly one bucket per 32 bytes of entries */
+	d->count = 0;
+	d->size = 16;
+	while(d->size < size / 32)
+		d->size *= 2;
+	d->table = static_cast<Entry**>(calloc(d->size,sizeof(Entry*)));
+	if(d->table == NULL) {
+		free(buffer);
+		return NULL;
+	}
+	d->ino = dir->inodeNo;
+	_loads++;
+
+	for(size_t off = 0; off < size; ) {
+		Ext2DirEntry *de = reinterpret_cast<Ext2DirEntry*>(buffer + off);
+		uint16_t recLen = le16tocpu(de->recLen);
+		if(recLen == 0)
+			break;
+		if(le32tocpu(de->inode) != 0 && le16tocpu(de->nameLen) > 0) {
+			if(!insert(d,de->name,le16tocpu(de->nameLen),le32tocpu(de->inode))) {
+				clear(d);
+				free(buffer);
+				return NULL;
+			}
+		}
+		off += recLen;
+	}
+	free(buffer);
+	return d;
+}
+
+bool Ext2DirCache::insert(Dir *d,const char *name,size_t nameLen,ino_t ino) {
+	/* keep the load-factor <= 1 */
+	if(d->count >= d->size) {
+		size_t nsize = d->size * 2;
+		Entry **ntable = static_cast<Entry**>(calloc(nsize,sizeof(Entry*)));
+		if(ntable == NULL)
+			return false;
+		for(size_t i = 0; i < d->size; i++) {
+			for(Entry *e = d->table[i],*next; e != NULL; e = next) {
+				next = e->next;
+				e->next = ntable[e->hash & (nsize - 1)];
+				ntable[e->hash & (nsize - 1)] = e;
+			}
+		}
+		free(d->table);
+		d->table = ntable;
+		d->size = nsize;
+	}
+
+	Entry *e = static_cast<Entry*>(malloc(sizeof(Entry) + nameLen));
+	if(e == NULL)
+		return false;
+	e->ino = ino;
+	e->hash = hash(name,nameLen);
+	e->nameLen = nameLen;
+	memcpy(e->name,name,nameLen);
+	e->next = d->table[e->hash & (d->size - 1)];
+	d->table[e->hash & (d->size - 1)] = e;
+	d->count++;
+	return true;
+}
+
+void Ext2DirCache::clear(Dir *d) {
+	if(d->table) {
+		for(size_t i = 0; i < d->size; i++) {
+			for(Entry *e = d->table[i],*next; e != NULL; e = next) {
+				next = e->next;
+				free(e);
+			}
+		}
+		free(d->table);
+		d->table = NULL;
+	}
+	d->ino = EXT2_BAD_INO;
+	d->count = 0;
+	d->lastUse = 0;
+}
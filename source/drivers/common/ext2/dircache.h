@@ -0,0 +1,118 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/common.h>
+#include <stdio.h>
+
+struct Ext2CInode;
+class Ext2FileSystem;
+
+/**
+ * An in-memory hash of name -> inode-number for a few large linear directories. It is built
+ * lazily on the first lookup of a directory that spans more than one block and is kept up to
+ * date by Ext2Link, so that a lookup does not need to read and scan all blocks of the directory.
+ * Directories that have a hashed index on disk don't need it.
+ */
+class Ext2DirCache {
+	struct Entry {
+		Entry *next;
+		ino_t ino;
+		uint32_t hash;
+		size_t nameLen;
+		char name[];
+	};
+
+	struct Dir {
+		ino_t ino;
+		ulong lastUse;
+		size_t count;
+		size_t size;
+		Entry **table;
+	};
+
+public:
+	/**
+	 * Inits the directory-cache
+	 */
+	explicit Ext2DirCache(Ext2FileSystem *fs);
+	/**
+	 * Destructor
+	 */
+	~Ext2DirCache();
+
+	/**
+	 * Finds the entry <name> in <dir>. If <dir> is not in the cache yet, it is read and added.
+	 *
+	 * @param dir the directory
+	 * @param name the name of the entry
+	 * @param nameLen the length of the name
+	 * @return the inode-number, -ENOENT if it does not exist or -ENOTSUP if the directory is not
+	 *  cached and should be searched directly
+	 */
+	ino_t find(Ext2CInode *dir,const char *name,size_t nameLen);
+
+	/**
+	 * Adds the entry <name> for <ino> to <dir>, if <dir> is cached.
+	 *
+	 * @param dir the directory-inode-number
+	 * @param name the name of the entry
+	 * @param nameLen the length of the name
+	 * @param ino the inode-number of the entry
+	 */
+	void add(ino_t dir,const char *name,size_t nameLen,ino_t ino);
+
+	/**
+	 * Removes the entry <name> from <dir>, if <dir> is cached.
+	 *
+	 * @param dir the directory-inode-number
+	 * @param name the name of the entry
+	 * @param nameLen the length of the name
+	 */
+	void remove(ino_t dir,const char *name,size_t nameLen);
+
+	/**
+	 * Removes <dir> from the cache.
+	 *
+	 * @param dir the directory-inode-number
+	 */
+	void invalidate(ino_t dir);
+
+	/**
+	 * Prints statistics about the directory-cache into the given file
+	 *
+	 * @param f the file
+	 */
+	void print(FILE *f);
+
+private:
+	static uint32_t hash(const char *name,size_t nameLen);
+	Dir *get(ino_t dir);
+	Dir *load(Ext2CInode *dir);
+	bool insert(Dir *d,const char *name,size_t nameLen,ino_t ino);
+	void clear(Dir *d);
+
+	size_t _hits;
+	size_t _misses;
+	size_t _loads;
+	ulong _time;
+	Dir *_dirs;
+	Ext2FileSystem *_fs;
+};
@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <esc/ipc/filedev.h>
 #include <fs/fsdev.h>
 #include <fs/permissions.h>
 #include <sys/common.h>
@@ -24,6 +25,7 @@
 #include <sys/endian.h>
 #include <sys/io.h>
 #include <sys/proc.h>
+#include <sys/thread.h>
 #include <dirent.h>
 #include <errno.h>
 #include <signal.h>
@@ -43,7 +45,30 @@
 #include "rw.h"
 #include "sbmng.h"
 
+class AllocFileDevice : public esc::FileDevice {
+public:
+	explicit AllocFileDevice(const char *path,mode_t mode,Ext2FileSystem *fs)
+		: esc::FileDevice(path,mode), _fs(fs) {
+	}
+
+	virtual std::string handleRead() {
+		std::string res;
+		FILE *str = fopendyn();
+		if(str) {
+			_fs->rsv.print(str);
+			res = fgetbuf(str,NULL);
+			fclose(str);
+		}
+		return res;
+	}
+
+private:
+	Ext2FileSystem *_fs;
+};
+
 static fs::FSDevice<fs::OpenFile> *fsdev;
+static Ext2FileSystem *ext2fs;
+static char allocPath[MAX_PATH_LEN];
 
 static void sigTermHndl(int) {
 	/* notify init that we're alive and promise to terminate as soon as possible */
@@ -52,6 +77,12 @@ static void sigTermHndl(int) {
 	fsdev->stop();
 }
 
+static int allocFileThread(void*) {
+	AllocFileDevice dev(allocPath,0440,ext2fs);
+	dev.loop();
+	return 0;
+}
+
 int main(int argc,char *argv[]) {
 	if(argc != 3)
 		error("Usage: %s <fsPath> <devicePath>",argv[0]);
@@ -63,7 +94,18 @@ int main(int argc,char *argv[]) {
 	if(signal(SIGTERM,sigTermHndl) == SIG_ERR)
 		error("Unable to set signal-handler for SIGTERM");
 
-	fsdev = new fs::FSDevice<fs::OpenFile>(new Ext2FileSystem(argv[2]),argv[1]);
+	ext2fs = new Ext2FileSystem(argv[2]);
+	fsdev = new fs::FSDevice<fs::OpenFile>(ext2fs,argv[1]);
+
+	/* provide the allocation statistics in /sys/fs/<name> */
+	const char *name = strrchr(argv[1],'/');
+	snprintf(allocPath,sizeof(allocPath),"/sys/fs/%s",name ? name + 1 : argv[1]);
+	int res = mkdir("/sys/fs",DIR_DEF_MODE);
+	if(res < 0 && res != -EEXIST)
+		printe("Unable to create /sys/fs");
+	if(startthread(allocFileThread,NULL) < 0)
+		printe("Unable to start thread for %s",allocPath);
+
 	fsdev->loop();
 	return 0;
 }
@@ -85,7 +127,7 @@ static int open_device(const char *path) {
 
 Ext2FileSystem::Ext2FileSystem(const char *device)
 		: fd(open_device(device)), sb(this), bgs(this),
-		  inodeCache(this), blockCache(this) {
+		  inodeCache(this), blockCache(this), dirCache(this), rsv(this) {
 }
 
 Ext2FileSystem::~Ext2FileSystem() {
@@ -219,6 +261,11 @@ ssize_t Ext2FileSystem::write(fs::OpenFile *file,const void *buffer,off_t offset
 	return Ext2File::write(this,file->ino,buffer,offset,count);
 }
 
+ssize_t Ext2FileSystem::copyrange(A_UNUSED fs::User *u,fs::OpenFile *in,fs::OpenFile *out,
+		off_t inoff,off_t outoff,size_t count) {
+	return Ext2File::copy(this,in->ino,out->ino,inoff,outoff,count);
+}
+
 int Ext2FileSystem::link(fs::User *u,fs::OpenFile *dst,fs::OpenFile *dir,const char *name) {
 	return linkIno(u,dst->ino,dir,name,false);
 }
@@ -339,6 +386,8 @@ void Ext2FileSystem::print(FILE *f) {
 	blockCache.printStats(f);
 	fprintf(f,"Inode cache:\n");
 	inodeCache.print(f);
+	fprintf(f,"Directory cache:\n");
+	dirCache.print(f);
 }
 
 int Ext2FileSystem::hasPermission(Ext2CInode *cnode,fs::User *u,uint perms) {
@@ -28,14 +28,18 @@
 
 #include "bgmng.h"
 #include "dir.h"
+#include "dircache.h"
 #include "inodecache.h"
+#include "rsvmng.h"
 #include "sbmng.h"
 
 static const size_t DISK_SECTOR_SIZE		= 512;
 static const size_t EXT2_ICACHE_SIZE		= 64;
 static const size_t EXT2_BCACHE_SIZE		= 2048;
+static const size_t EXT2_DCACHE_SIZE		= 8;
 
 static const uint EXT2_SUPERBLOCK_LOCK		= 0xF7180002;
+static const uint EXT2_DIRCACHE_LOCK		= 0xF7180003;
 
 class Ext2FileSystem : public fs::FileSystem<fs::OpenFile> {
 public:
@@ -62,6 +66,8 @@ public:
 	int stat(fs::OpenFile *file,struct ::stat *info) override;
 	ssize_t read(fs::OpenFile *file,void *buffer,off_t offset,size_t size) override;
 	ssize_t write(fs::OpenFile *file,const void *buffer,off_t offset,size_t size) override;
+	ssize_t copyrange(fs::User *u,fs::OpenFile *in,fs::OpenFile *out,off_t inoff,off_t outoff,
+		size_t count) override;
 	int link(fs::User *u,fs::OpenFile *dst,fs::OpenFile *dir,const char *name) override;
 	int linkIno(fs::User *u,ino_t dst,fs::OpenFile *dir,const char *name,bool isdir);
 	int doUnlink(fs::User *u,fs::OpenFile *dir,const char *name,bool isdir);
@@ -217,4 +223,8 @@ public:
 	/* caches */
 	Ext2INodeCache inodeCache;
 	Ext2BlockCache blockCache;
+	Ext2DirCache dirCache;
+
+	/* block allocation */
+	Ext2RsvMng rsv;
 };
@@ -66,6 +66,9 @@ int Ext2File::create(Ext2FileSystem *e,fs::User *u,Ext2CInode *dirNode,const cha
 
 int Ext2File::remove(Ext2FileSystem *e,Ext2CInode *cnode) {
 	int res;
+	/* the inode-number might be reused for a different directory */
+	if(S_ISDIR(le16tocpu(cnode->inode.mode)))
+		e->dirCache.invalidate(cnode->inodeNo);
 	/* truncate the file */
 	if((res = truncate(e,cnode,true)) < 0)
 		return res;
@@ -79,6 +82,9 @@ int Ext2File::truncate(Ext2FileSystem *e,Ext2CInode *cnode,bool del) {
 	int res;
 	size_t i;
 
+	/* the window doesn't fit to the end of the file anymore */
+	e->rsv.discard(cnode->inodeNo);
+
 	/* nothing to do for small symlinks */
 	if(S_ISLNK(le16tocpu(cnode->inode.mode)) && le32tocpu(cnode->inode.size) < 60)
 		return 0;
@@ -253,6 +259,11 @@ ssize_t Ext2File::writeIno(Ext2FileSystem *e,Ext2CInode *cnode,const void *buffe
 		offset %= blockSize;
 		blockCount = (offset + count + blockSize - 1) / blockSize;
 
+		/* let the allocator know how many blocks we'll need, so that they can be contiguous */
+		size_t allocated = (inoSize + blockSize - 1) / blockSize;
+		if(startBlock + blockCount > allocated)
+			e->rsv.reserve(cnode->inodeNo,startBlock + blockCount - allocated);
+
 		leftBytes = count;
 		bufWork = (const uint8_t*)buffer;
 		for(i = 0; i < blockCount; i++) {
@@ -293,6 +304,68 @@ ssize_t Ext2File::writeIno(Ext2FileSystem *e,Ext2CInode *cnode,const void *buffe
 	return count;
 }
 
+ssize_t Ext2File::copy(Ext2FileSystem *e,ino_t inNo,ino_t outNo,off_t inOffset,off_t outOffset,
+		size_t count) {
+	/* copying within one file would require to care about overlapping ranges */
+	if(inNo == outNo)
+		return -ENOTSUP;
+
+	Ext2CInode *src = e->inodeCache.request(inNo,IMODE_WRITE);
+	Ext2CInode *dst = e->inodeCache.request(outNo,IMODE_WRITE);
+	ssize_t res = 0;
+	if(src == NULL || dst == NULL)
+		res = -ENOBUFS;
+	else if(!S_ISREG(le16tocpu(src->inode.mode)) || !S_ISREG(le16tocpu(dst->inode.mode)))
+		res = -ENOTSUP;
+	else {
+		int32_t inoSize = le32tocpu(src->inode.size);
+		if((int32_t)inOffset >= 0 && (int32_t)inOffset < inoSize) {
+			size_t blockSize = e->blockSize();
+			count = esc::Util::min(count,(size_t)(inoSize - inOffset));
+
+			/* reserve the blocks for the destination at once, so that they can be contiguous */
+			size_t allocated = e->bytesToBlocks(le32tocpu(dst->inode.size));
+			size_t last = e->bytesToBlocks(outOffset + count);
+			if(last > allocated)
+				e->rsv.reserve(outNo,last - allocated);
+
+			size_t total = 0;
+			while(total < count) {
+				block_t block = Ext2INode::getDataBlock(e,src,(inOffset + total) / blockSize);
+				CBlock *cblock = e->blockCache.request(block,BlockCache::READ);
+				if(cblock == NULL) {
+					res = -ENOBUFS;
+					break;
+				}
+
+				/* write the requested part of the block directly to the destination */
+				size_t offset = (inOffset + total) % blockSize;
+				size_t amount = esc::Util::min(count - total,blockSize - offset);
+				res = writeIno(e,dst,(uint8_t*)cblock->buffer + offset,outOffset + total,amount);
+				e->blockCache.release(cblock);
+				if(res <= 0)
+					break;
+
+				total += res;
+				if((size_t)res < amount)
+					break;
+			}
+			if(total > 0)
+				res = total;
+
+			/* mark accessed */
+			src->inode.accesstime = cputole32(time(NULL));
+			e->inodeCache.markDirty(src);
+		}
+	}
+
+	if(src)
+		e->inodeCache.release(src);
+	if(dst)
+		e->inodeCache.release(dst);
+	return res;
+}
+
 int Ext2File::freeDIndirBlock(Ext2FileSystem *e,block_t blockNo) {
 	size_t i,count;
 	/* note that we don't need to set the block-numbers to 0 here (-> write), since the whole
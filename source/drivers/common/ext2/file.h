@@ -113,6 +113,22 @@ public:
 	 */
 	static ssize_t writeIno(Ext2FileSystem *e,Ext2CInode *cnode,const void *buffer,off_t offset,size_t count);
 
+	/**
+	 * Copies <count> bytes at <inOffset> from the inode <inNo> to <outOffset> in the inode <outNo>.
+	 * The data is written directly from the block cache, without an intermediate buffer. Will
+	 * set the access-time of the source and the modification-time of the destination.
+	 *
+	 * @param e the ext2-handle
+	 * @param inNo the inode-number of the source
+	 * @param outNo the inode-number of the destination
+	 * @param inOffset the offset in the source
+	 * @param outOffset the offset in the destination
+	 * @param count the number of bytes to copy
+	 * @return the number of copied bytes
+	 */
+	static ssize_t copy(Ext2FileSystem *e,ino_t inNo,ino_t outNo,off_t inOffset,off_t outOffset,
+		size_t count);
+
 private:
 	/**
 	 * Free's the given doubly-indirect-block
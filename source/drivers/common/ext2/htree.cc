@@ -0,0 +1,692 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/endian.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dir.h"
+#include "ext2.h"
+#include "file.h"
+#include "htree.h"
+#include "inodecache.h"
+#include "link.h"
+
+using namespace fs;
+
+/* the upper 4 bits of the block-number are reserved */
+#define DX_BLOCK(ent)			(le32tocpu((ent)->block) & 0x0FFFFFFF)
+#define DX_COUNTLIMIT(ents)		(reinterpret_cast<Ext2DxCountLimit*>(ents))
+
+/* ------------------------- *
+ * -- the hash functions -- *
+ * ------------------------- */
+
+static uint32_t legacy_hash(const char *name,size_t len,bool unsig) {
+	uint32_t hash,hash0 = 0x12A3FE2D,hash1 = 0x37ABE8F9;
+	while(len-- > 0) {
+		int c = unsig ? (int)(uchar)*name : (int)(signed char)*name;
+		name++;
+		hash = hash1 + (hash0 ^ (uint32_t)(c * 7152373));
+		if(hash & 0x80000000)
+			hash -= 0x7FFFFFFF;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+	return hash0 << 1;
+}
+
+/* fills <num> words of <buf> with the next bytes of <msg>, padded with the length */
+static void str2hashbuf(const char *msg,size_t len,uint32_t *buf,int num,bool unsig) {
+	uint32_t pad = (uint32_t)len | ((uint32_t)len << 8);
+	pad |= pad << 16;
+
+	uint32_t val = pad;
+	if(len > (size_t)num * 4)
+		len = num * 4;
+	for(size_t i = 0; i < len; i++) {
+		int c = unsig ? (int)(uchar)msg[i] : (int)(signed char)msg[i];
+		val = c + (val << 8);
+		if((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if(--num >= 0)
+		*buf++ = val;
+	while(--num >= 0)
+		*buf++ = pad;
+}
+
+static inline uint32_t rol32(uint32_t x,int s) {
+	return (x << s) | (x >> (32 - s));
+}
+
+#define F(x,y,z)				((z) ^ ((x) & ((y) ^ (z))))
+#define G(x,y,z)				(((x) & (y)) + (((x) ^ (y)) & (z)))
+#define H(x,y,z)				((x) ^ (y) ^ (z))
+#define ROUND(f,a,b,c,d,x,s)	(a += f(b,c,d) + (x), a = rol32(a,s))
+#define K1						0
+#define K2						013240474631U
+#define K3						015666365641U
+
+/* the MD4 transform with only 3 rounds of 8 steps */
+static void half_md4_transform(uint32_t buf[4],const uint32_t in[8]) {
+	uint32_t a = buf[0],b = buf[1],c = buf[2],d = buf[3];
+
+	ROUND(F,a,b,c,d,in[0] + K1,3);
+	ROUND(F,d,a,b,c,in[1] + K1,7);
+	ROUND(F,c,d,a,b,in[2] + K1,11);
+	ROUND(F,b,c,d,a,in[3] + K1,19);
+	ROUND(F,a,b,c,d,in[4] + K1,3);
+	ROUND(F,d,a,b,c,in[5] + K1,7);
+	ROUND(F,c,d,a,b,in[6] + K1,11);
+	ROUND(F,b,c,d,a,in[7] + K1,19);
+
+	ROUND(G,a,b,c,d,in[1] + K2,3);
+	ROUND(G,d,a,b,c,in[3] + K2,5);
+	ROUND(G,c,d,a,b,in[5] + K2,9);
+	ROUND(G,b,c,d,a,in[7] + K2,13);
+	ROUND(G,a,b,c,d,in[0] + K2,3);
+	ROUND(G,d,a,b,c,in[2] + K2,5);
+	ROUND(G,c,d,a,b,in[4] + K2,9);
+	ROUND(G,b,c,d,a,in[6] + K2,13);
+
+	ROUND(H,a,b,c,d,in[3] + K3,3);
+	ROUND(H,d,a,b,c,in[7] + K3,9);
+	ROUND(H,c,d,a,b,in[2] + K3,11);
+	ROUND(H,b,c,d,a,in[6] + K3,15);
+	ROUND(H,a,b,c,d,in[1] + K3,3);
+	ROUND(H,d,a,b,c,in[5] + K3,9);
+	ROUND(H,c,d,a,b,in[0] + K3,11);
+	ROUND(H,b,c,d,a,in[4] + K3,15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+static void tea_transform(uint32_t buf[4],const uint32_t in[4]) {
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0],b1 = buf[1];
+	uint32_t a = in[0],b = in[1],c = in[2],d = in[3];
+	for(int n = 0; n < 16; ++n) {
+		sum += 0x9E3779B9;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	}
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+uint32_t Ext2HTree::hash(Ext2FileSystem *e,int version,const char *name,size_t nameLen) {
+	/* the default seed, if the superblock has none */
+	uint32_t buf[4] = {0x67452301,0xEFCDAB89,0x98BADCFE,0x10325476};
+	const Ext2SuperBlock *sb = e->sb.get();
+	if(sb->hashSeed[0] || sb->hashSeed[1] || sb->hashSeed[2] || sb->hashSeed[3]) {
+		for(size_t i = 0; i < 4; ++i)
+			buf[i] = le32tocpu(sb->hashSeed[i]);
+	}
+
+	uint32_t in[8],res;
+	bool unsig = version >= EXT2_HASH_LEGACY_UNSIGNED;
+	switch(version) {
+		case EXT2_HASH_HALF_MD4:
+		case EXT2_HASH_HALF_MD4_UNSIGNED:
+			for(ssize_t len = nameLen; len > 0; len -= 32, name += 32) {
+				str2hashbuf(name,len,in,8,unsig);
+				half_md4_transform(buf,in);
+			}
+			res = buf[1];
+			break;
+
+		case EXT2_HASH_TEA:
+		case EXT2_HASH_TEA_UNSIGNED:
+			for(ssize_t len = nameLen; len > 0; len -= 16, name += 16) {
+				str2hashbuf(name,len,in,4,unsig);
+				tea_transform(buf,in);
+			}
+			res = buf[0];
+			break;
+
+		default:
+			res = legacy_hash(name,nameLen,unsig);
+			break;
+	}
+
+	/* the lowest bit is used to mark collisions in the index and the largest value means EOF */
+	res &= ~1;
+	if(res == (0x7FFFFFFFU << 1))
+		res = 0x7FFFFFFEU << 1;
+	return res;
+}
+
+/* ----------------------- *
+ * -- index management -- *
+ * ----------------------- */
+
+bool Ext2HTree::isIndexed(Ext2FileSystem *e,const Ext2CInode *dir) {
+	return (le32tocpu(dir->inode.flags) & EXT2_INDEX_FL) &&
+		(le32tocpu(e->sb.get()->featureCompat) & EXT2_FEATURE_COMPAT_DIR_INDEX);
+}
+
+bool Ext2HTree::readBlock(Ext2FileSystem *e,const Ext2CInode *dir,block_t block,void *buffer) {
+	size_t bsize = e->blockSize();
+	return Ext2File::readIno(e,dir,buffer,(off_t)block * bsize,bsize) == (ssize_t)bsize;
+}
+
+bool Ext2HTree::writeBlock(Ext2FileSystem *e,Ext2CInode *dir,block_t block,const void *buffer) {
+	size_t bsize = e->blockSize();
+	return Ext2File::writeIno(e,dir,buffer,(off_t)block * bsize,bsize) == (ssize_t)bsize;
+}
+
+static Ext2DxEntry *search(Ext2DxEntry *entries,uint32_t hash) {
+	/* the first entry has no hash, so that we find the last entry with a hash <= <hash> */
+	Ext2DxEntry *p = entries + 1;
+	Ext2DxEntry *q = entries + le16tocpu(DX_COUNTLIMIT(entries)->count) - 1;
+	while(p <= q) {
+		Ext2DxEntry *m = p + (q - p) / 2;
+		if(le32tocpu(m->hash) > hash)
+			q = m - 1;
+		else
+			p = m + 1;
+	}
+	return p - 1;
+}
+
+int Ext2HTree::probe(Ext2FileSystem *e,Ext2CInode *dir,const char *name,size_t nameLen,Path *p) {
+	size_t bsize = e->blockSize();
+	p->levels = 0;
+
+	uint8_t *buf = static_cast<uint8_t*>(malloc(bsize));
+	if(buf == NULL)
+		return -ENOMEM;
+	if(!readBlock(e,dir,0,buf)) {
+		free(buf);
+		return -ENOBUFS;
+	}
+
+	/* check whether we understand the index */
+	Ext2DxRoot *root = reinterpret_cast<Ext2DxRoot*>(buf);
+	if(root->reserved != 0 || root->hashVersion > EXT2_HASH_TEA || root->infoLength != 8 ||
+			root->indirectLevels >= MAX_LEVELS) {
+		free(buf);
+		return -ENOTSUP;
+	}
+
+	int version = root->hashVersion;
+	if(le32tocpu(e->sb.get()->flags) & EXT2_FLAGS_UNSIGNED_HASH)
+		version += EXT2_HASH_LEGACY_UNSIGNED;
+	p->hash = hash(e,version,name,nameLen);
+
+	size_t levels = root->indirectLevels + 1;
+	size_t offset = offsetof(Ext2DxRoot,reserved) + root->infoLength;
+	block_t block = 0;
+	while(1) {
+		Ext2DxEntry *entries = reinterpret_cast<Ext2DxEntry*>(buf + offset);
+		Ext2DxCountLimit *cl = DX_COUNTLIMIT(entries);
+		size_t count = le16tocpu(cl->count);
+		if(le16tocpu(cl->limit) != (bsize - offset) / sizeof(Ext2DxEntry) ||
+				count == 0 || count > le16tocpu(cl->limit)) {
+			free(buf);
+			release(p);
+			return -ENOTSUP;
+		}
+
+		Frame *f = p->frames + p->levels++;
+		f->buffer = buf;
+		f->block = block;
+		f->entries = entries;
+		f->at = search(entries,p->hash);
+		if(p->levels == levels)
+			return 0;
+
+		/* walk down to the next level */
+		block = DX_BLOCK(f->at);
+		buf = static_cast<uint8_t*>(malloc(bsize));
+		if(buf == NULL) {
+			release(p);
+			return -ENOMEM;
+		}
+		if(!readBlock(e,dir,block,buf)) {
+			free(buf);
+			release(p);
+			return -ENOBUFS;
+		}
+		offset = sizeof(Ext2DxNode);
+	}
+	A_UNREACHED;
+}
+
+int Ext2HTree::nextLeaf(Ext2FileSystem *e,Ext2CInode *dir,Path *p) {
+	/* find the lowest level that has another entry */
+	ssize_t i;
+	for(i = p->levels - 1; i >= 0; --i) {
+		Frame *f = p->frames + i;
+		if(f->at + 1 < f->entries + le16tocpu(DX_COUNTLIMIT(f->entries)->count))
+			break;
+	}
+	if(i < 0)
+		return 0;
+
+	/* if the next block starts with a different hash, the name can't be there */
+	Frame *f = p->frames + i;
+	f->at++;
+	if((le32tocpu(f->at->hash) & ~1) != p->hash)
+		return 0;
+
+	/* load the index-blocks below */
+	for(++i; i < (ssize_t)p->levels; ++i) {
+		Frame *child = p->frames + i;
+		child->block = DX_BLOCK(p->frames[i - 1].at);
+		if(!readBlock(e,dir,child->block,child->buffer))
+			return -ENOBUFS;
+		child->entries = reinterpret_cast<Ext2DxEntry*>(child->buffer + sizeof(Ext2DxNode));
+		child->at = child->entries;
+	}
+	return 1;
+}
+
+void Ext2HTree::release(Path *p) {
+	for(size_t i = 0; i < p->levels; ++i)
+		free(p->frames[i].buffer);
+	p->levels = 0;
+}
+
+ino_t Ext2HTree::find(Ext2FileSystem *e,Ext2CInode *dir,const char *name,size_t nameLen,
+		block_t *block) {
+	/* "." and ".." are not in the leafs, but in the root */
+	if((nameLen == 1 && name[0] == '.') || (nameLen == 2 && name[0] == '.' && name[1] == '.')) {
+		Ext2DxRoot root;
+		if(Ext2File::readIno(e,dir,&root,0,sizeof(root)) != sizeof(root))
+			return -ENOBUFS;
+		if(block)
+			*block = 0;
+		return le32tocpu(nameLen == 1 ? root.dotInode : root.dotdotInode);
+	}
+
+	Path p;
+	int res = probe(e,dir,name,nameLen,&p);
+	if(res < 0)
+		return res;
+
+	size_t bsize = e->blockSize();
+	Ext2DirEntry *buf = static_cast<Ext2DirEntry*>(malloc(bsize));
+	if(buf == NULL) {
+		release(&p);
+		return -ENOMEM;
+	}
+
+	/* search the leaf and the following ones, as long as they may contain the hash. errors are
+	 * not reported as -ENOENT, because the caller might add the entry in this case */
+	ino_t ino;
+	do {
+		block_t leaf = DX_BLOCK(p.frames[p.levels - 1].at);
+		if(!readBlock(e,dir,leaf,buf)) {
+			ino = -ENOBUFS;
+			break;
+		}
+		ino = Ext2Dir::findIn(buf,bsize,name,nameLen);
+		if(ino >= 0) {
+			if(block)
+				*block = leaf;
+			break;
+		}
+	}
+	while((res = nextLeaf(e,dir,&p)) > 0);
+	if(ino < 0 && res < 0)
+		ino = res;
+
+	free(buf);
+	release(&p);
+	return ino;
+}
+
+void Ext2HTree::insertEntry(Frame *f,uint32_t hash,block_t block) {
+	Ext2DxCountLimit *cl = DX_COUNTLIMIT(f->entries);
+	uint16_t count = le16tocpu(cl->count);
+	Ext2DxEntry *end = f->entries + count;
+	Ext2DxEntry *pos = f->at + 1;
+	memmove(pos + 1,pos,(end - pos) * sizeof(Ext2DxEntry));
+	pos->hash = cputole32(hash);
+	pos->block = cputole32(block);
+	cl->count = cputole16(count + 1);
+}
+
+int Ext2HTree::growIndex(Ext2FileSystem *e,Ext2CInode *dir,Path *p) {
+	size_t bsize = e->blockSize();
+	Frame *root = p->frames;
+	Frame *f = p->frames + p->levels - 1;
+	Ext2DxCountLimit *fcl = DX_COUNTLIMIT(f->entries);
+	if(le16tocpu(fcl->count) < le16tocpu(fcl->limit))
+		return 0;
+
+	size_t nodeLimit = (bsize - sizeof(Ext2DxNode)) / sizeof(Ext2DxEntry);
+	block_t newBlock = le32tocpu(dir->inode.size) / bsize;
+	uint8_t *buf = static_cast<uint8_t*>(malloc(bsize));
+	if(buf == NULL)
+		return -ENOMEM;
+
+	/* build an empty index-node */
+	Ext2DxNode *node = reinterpret_cast<Ext2DxNode*>(buf);
+	node->fakeInode = cputole32(0);
+	node->fakeRecLen = cputole16(bsize);
+	node->fakeNameLen = cputole16(0);
+	Ext2DxEntry *entries = reinterpret_cast<Ext2DxEntry*>(node + 1);
+
+	if(p->levels == 1) {
+		/* the root is full and has no levels below. so, move all entries to a new node */
+		size_t count = le16tocpu(fcl->count);
+		memcpy(entries,root->entries,count * sizeof(Ext2DxEntry));
+		DX_COUNTLIMIT(entries)->limit = cputole16(nodeLimit);
+		DX_COUNTLIMIT(entries)->count = cputole16(count);
+		if(!writeBlock(e,dir,newBlock,buf)) {
+			free(buf);
+			return -ENOBUFS;
+		}
+
+		/* the root references only the new node now */
+		DX_COUNTLIMIT(root->entries)->count = cputole16(1);
+		root->entries->block = cputole32(newBlock);
+		reinterpret_cast<Ext2DxRoot*>(root->buffer)->indirectLevels = 1;
+		if(!writeBlock(e,dir,0,root->buffer)) {
+			free(buf);
+			return -ENOBUFS;
+		}
+
+		Frame *child = p->frames + 1;
+		child->buffer = buf;
+		child->block = newBlock;
+		child->entries = entries;
+		child->at = entries + (root->at - root->entries);
+		root->at = root->entries;
+		p->levels = 2;
+		return 0;
+	}
+
+	/* otherwise, split the node, if there is still space in the root */
+	Ext2DxCountLimit *rcl = DX_COUNTLIMIT(root->entries);
+	if(le16tocpu(rcl->count) >= le16tocpu(rcl->limit)) {
+		free(buf);
+		return -ENOSPC;
+	}
+
+	size_t count = le16tocpu(fcl->count);
+	size_t keep = count / 2;
+	uint32_t splitHash = le32tocpu(f->entries[keep].hash);
+	memcpy(entries,f->entries + keep,(count - keep) * sizeof(Ext2DxEntry));
+	DX_COUNTLIMIT(entries)->limit = cputole16(nodeLimit);
+	DX_COUNTLIMIT(entries)->count = cputole16(count - keep);
+	fcl->count = cputole16(keep);
+
+	insertEntry(root,splitHash,newBlock);
+	if(!writeBlock(e,dir,newBlock,buf) || !writeBlock(e,dir,f->block,f->buffer) ||
+			!writeBlock(e,dir,0,root->buffer)) {
+		free(buf);
+		return -ENOBUFS;
+	}
+
+	/* continue with the node that contains our position */
+	if(f->at >= f->entries + keep) {
+		root->at++;
+		f->at = entries + (f->at - (f->entries + keep));
+		free(f->buffer);
+		f->buffer = buf;
+		f->block = newBlock;
+		f->entries = entries;
+	}
+	else
+		free(buf);
+	return 0;
+}
+
+struct SplitEntry {
+	uint32_t hash;
+	Ext2DirEntry *entry;
+};
+
+static int compareEntries(const void *a,const void *b) {
+	uint32_t ha = static_cast<const SplitEntry*>(a)->hash;
+	uint32_t hb = static_cast<const SplitEntry*>(b)->hash;
+	return ha < hb ? -1 : (ha > hb ? 1 : 0);
+}
+
+/* writes the given entries compactly into <dst>, where the last one spans the rest of the block */
+static void buildLeaf(uint8_t *dst,size_t bsize,const SplitEntry *ents,size_t count) {
+	Ext2DirEntry *last = reinterpret_cast<Ext2DirEntry*>(dst);
+	size_t pos = 0;
+	for(size_t i = 0; i < count; ++i) {
+		size_t len = Ext2Link::getDirESize(le16tocpu(ents[i].entry->nameLen));
+		last = reinterpret_cast<Ext2DirEntry*>(dst + pos);
+		memcpy(last,ents[i].entry,len);
+		last->recLen = cputole16(len);
+		pos += len;
+	}
+	if(count == 0) {
+		last->inode = cputole32(0);
+		last->nameLen = cputole16(0);
+		pos = 0;
+	}
+	else
+		pos -= le16tocpu(last->recLen);
+	last->recLen = cputole16(bsize - pos);
+}
+
+int Ext2HTree::splitLeaf(Ext2FileSystem *e,Ext2CInode *dir,Path *p,uint8_t *leaf,uint8_t *newLeaf,
+		uint32_t *splitHash) {
+	size_t bsize = e->blockSize();
+	int res;
+
+	/* make room for the new index-entry first */
+	if((res = growIndex(e,dir,p)) < 0)
+		return res;
+
+	/* determine the hashes of all entries in the leaf */
+	int version = reinterpret_cast<Ext2DxRoot*>(p->frames[0].buffer)->hashVersion;
+	if(le32tocpu(e->sb.get()->flags) & EXT2_FLAGS_UNSIGNED_HASH)
+		version += EXT2_HASH_LEGACY_UNSIGNED;
+	size_t count = 0;
+	SplitEntry *ents = static_cast<SplitEntry*>(malloc((bsize / 12) * sizeof(SplitEntry)));
+	if(ents == NULL)
+		return -ENOMEM;
+	uint8_t *copy = static_cast<uint8_t*>(malloc(bsize));
+	if(copy == NULL) {
+		free(ents);
+		return -ENOMEM;
+	}
+	memcpy(copy,leaf,bsize);
+	for(size_t off = 0; off < bsize; ) {
+		Ext2DirEntry *de = reinterpret_cast<Ext2DirEntry*>(copy + off);
+		if(le16tocpu(de->recLen) == 0)
+			break;
+		if(le32tocpu(de->inode) != 0) {
+			ents[count].hash = hash(e,version,de->name,le16tocpu(de->nameLen));
+			ents[count].entry = de;
+			count++;
+		}
+		off += le16tocpu(de->recLen);
+	}
+	if(count < 2) {
+		res = -ENOSPC;
+		goto error;
+	}
+
+	/* move the upper half to the new leaf */
+	qsort(ents,count,sizeof(SplitEntry),compareEntries);
+	{
+		size_t keep = count / 2;
+		/* if the hashes are equal at the split-point, mark the index-entry as continuation */
+		*splitHash = ents[keep].hash;
+		uint32_t continued = ents[keep - 1].hash == ents[keep].hash ? 1 : 0;
+		buildLeaf(leaf,bsize,ents,keep);
+		buildLeaf(newLeaf,bsize,ents + keep,count - keep);
+
+		Frame *f = p->frames + p->levels - 1;
+		block_t newBlock = le32tocpu(dir->inode.size) / bsize;
+		insertEntry(f,*splitHash | continued,newBlock);
+		if(!writeBlock(e,dir,newBlock,newLeaf) || !writeBlock(e,dir,DX_BLOCK(f->at),leaf) ||
+				!writeBlock(e,dir,f->block,f->buffer)) {
+			res = -ENOBUFS;
+			goto error;
+		}
+		/* let the caller know which block is the new one */
+		f->at++;
+	}
+	res = 0;
+
+error:
+	free(copy);
+	free(ents);
+	return res;
+}
+
+int Ext2HTree::insert(Ext2FileSystem *e,Ext2CInode *dir,ino_t ino,const char *name,size_t nameLen) {
+	size_t bsize = e->blockSize();
+	Path p;
+	int res = probe(e,dir,name,nameLen,&p);
+	if(res < 0)
+		return res;
+
+	uint8_t *buf = static_cast<uint8_t*>(malloc(bsize * 2));
+	if(buf == NULL) {
+		release(&p);
+		return -ENOMEM;
+	}
+
+	block_t leaf = DX_BLOCK(p.frames[p.levels - 1].at);
+	if(!readBlock(e,dir,leaf,buf)) {
+		res = -ENOBUFS;
+		goto error;
+	}
+
+	if(!Ext2Dir::addIn(reinterpret_cast<Ext2DirEntry*>(buf),bsize,ino,name,nameLen)) {
+		/* the leaf is full, so split it and insert it into the appropriate half */
+		uint32_t splitHash;
+		uint8_t *newLeaf = buf + bsize;
+		if((res = splitLeaf(e,dir,&p,buf,newLeaf,&splitHash)) < 0)
+			goto error;
+
+		if(p.hash >= splitHash) {
+			/* splitLeaf has moved us to the new leaf */
+			leaf = DX_BLOCK(p.frames[p.levels - 1].at);
+			memcpy(buf,newLeaf,bsize);
+		}
+		if(!Ext2Dir::addIn(reinterpret_cast<Ext2DirEntry*>(buf),bsize,ino,name,nameLen)) {
+			res = -ENOSPC;
+			goto error;
+		}
+	}
+
+	res = writeBlock(e,dir,leaf,buf) ? 0 : -ENOBUFS;
+
+error:
+	free(buf);
+	release(&p);
+	return res;
+}
+
+int Ext2HTree::create(Ext2FileSystem *e,Ext2CInode *dir) {
+	size_t bsize = e->blockSize();
+	if((size_t)le32tocpu(dir->inode.size) != bsize)
+		return -EINVAL;
+
+	uint8_t *buf = static_cast<uint8_t*>(malloc(bsize * 2));
+	if(buf == NULL)
+		return -ENOMEM;
+	if(!readBlock(e,dir,0,buf)) {
+		free(buf);
+		return -ENOBUFS;
+	}
+
+	/* the directory has to start with "." and "..", which stay in the root */
+	Ext2DirEntry *dot = reinterpret_cast<Ext2DirEntry*>(buf);
+	Ext2DirEntry *dotdot = reinterpret_cast<Ext2DirEntry*>(buf + le16tocpu(dot->recLen));
+	if(le16tocpu(dot->nameLen) != 1 || dot->name[0] != '.' ||
+			le16tocpu(dot->recLen) > bsize - Ext2Link::getDirESize(2) ||
+			le16tocpu(dotdot->nameLen) != 2 || strncmp(dotdot->name,"..",2) != 0) {
+		free(buf);
+		return -EINVAL;
+	}
+
+	/* move all other entries to the second block */
+	uint8_t *leaf = buf + bsize;
+	Ext2DirEntry *last = NULL;
+	size_t pos = 0;
+	size_t off = le16tocpu(dot->recLen) + le16tocpu(dotdot->recLen);
+	while(off < bsize) {
+		Ext2DirEntry *de = reinterpret_cast<Ext2DirEntry*>(buf + off);
+		if(le16tocpu(de->recLen) == 0)
+			break;
+		if(le32tocpu(de->inode) != 0) {
+			size_t len = Ext2Link::getDirESize(le16tocpu(de->nameLen));
+			last = reinterpret_cast<Ext2DirEntry*>(leaf + pos);
+			memcpy(last,de,len);
+			last->recLen = cputole16(len);
+			pos += len;
+		}
+		off += le16tocpu(de->recLen);
+	}
+	if(last)
+		last->recLen = cputole16(le16tocpu(last->recLen) + bsize - pos);
+	else {
+		last = reinterpret_cast<Ext2DirEntry*>(leaf);
+		last->inode = cputole32(0);
+		last->nameLen = cputole16(0);
+		last->recLen = cputole16(bsize);
+	}
+
+	/* build the root */
+	Ext2DxRoot *root = reinterpret_cast<Ext2DxRoot*>(buf);
+	ino_t dotIno = dot->inode;
+	ino_t dotdotIno = dotdot->inode;
+	memset(root,0,bsize);
+	root->dotInode = dotIno;
+	root->dotRecLen = cputole16(12);
+	root->dotNameLen = cputole16(1);
+	root->dotName[0] = '.';
+	root->dotdotInode = dotdotIno;
+	root->dotdotRecLen = cputole16(bsize - 12);
+	root->dotdotNameLen = cputole16(2);
+	root->dotdotName[0] = '.';
+	root->dotdotName[1] = '.';
+	uint8_t defVersion = e->sb.get()->defHashVersion;
+	root->hashVersion = defVersion <= EXT2_HASH_TEA ? defVersion : EXT2_HASH_HALF_MD4;
+	root->infoLength = 8;
+	root->indirectLevels = 0;
+	Ext2DxCountLimit *cl = reinterpret_cast<Ext2DxCountLimit*>(root + 1);
+	cl->limit = cputole16((bsize - sizeof(Ext2DxRoot)) / sizeof(Ext2DxEntry));
+	cl->count = cputole16(1);
+	cl->block = cputole32(1);
+
+	/* write the leaf first, so that the directory is consistent if we fail in between */
+	int res = 0;
+	if(!writeBlock(e,dir,1,leaf) || !writeBlock(e,dir,0,root))
+		res = -ENOBUFS;
+	else {
+		dir->inode.flags = cputole32(le32tocpu(dir->inode.flags) | EXT2_INDEX_FL);
+		e->inodeCache.markDirty(dir);
+	}
+	free(buf);
+	return res;
+}
@@ -0,0 +1,120 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <fs/ext2/ext2.h>
+#include <sys/common.h>
+
+struct Ext2CInode;
+class Ext2FileSystem;
+
+/**
+ * The hashed directory index (dir_index) of ext3/ext4. The first block of an indexed directory
+ * contains the root of a B-tree of height 1 or 2, which maps the hashes of the names to the
+ * leaf-blocks that contain the entries. Thus, a lookup reads at most three blocks, regardless
+ * of the size of the directory.
+ */
+class Ext2HTree {
+	Ext2HTree() = delete;
+
+	/* the maximum number of index-levels, including the root */
+	static const size_t MAX_LEVELS		= 2;
+
+	struct Frame {
+		uint8_t *buffer;
+		block_t block;
+		fs::Ext2DxEntry *entries;
+		fs::Ext2DxEntry *at;
+	};
+
+	struct Path {
+		Frame frames[MAX_LEVELS];
+		size_t levels;
+		uint32_t hash;
+	};
+
+public:
+	/**
+	 * @param e the ext2-fs
+	 * @param dir the directory
+	 * @return true if the given directory has an index that we should use
+	 */
+	static bool isIndexed(Ext2FileSystem *e,const Ext2CInode *dir);
+
+	/**
+	 * Finds the entry <name> in the indexed directory <dir>.
+	 *
+	 * @param e the ext2-fs
+	 * @param dir the directory
+	 * @param name the name of the entry to find
+	 * @param nameLen the length of the name
+	 * @param block if not NULL, the logical block of the directory that contains the entry will
+	 *  be stored there
+	 * @return the inode-number, -ENOENT if not found, -ENOTSUP if the index is not usable or
+	 *  another negative error-code if reading the index failed
+	 */
+	static ino_t find(Ext2FileSystem *e,Ext2CInode *dir,const char *name,size_t nameLen,
+		block_t *block = NULL);
+
+	/**
+	 * Inserts the entry <name> for <ino> into the indexed directory <dir>. If the leaf is full,
+	 * it is split and the index is extended.
+	 *
+	 * @param e the ext2-fs
+	 * @param dir the directory
+	 * @param ino the inode-number of the entry
+	 * @param name the name of the entry
+	 * @param nameLen the length of the name
+	 * @return 0 on success, -ENOSPC if the index is full or -ENOTSUP if it is not usable
+	 */
+	static int insert(Ext2FileSystem *e,Ext2CInode *dir,ino_t ino,const char *name,size_t nameLen);
+
+	/**
+	 * Converts the linear directory <dir>, which has to consist of exactly one block, into an
+	 * indexed directory. The existing entries are moved into the second block.
+	 *
+	 * @param e the ext2-fs
+	 * @param dir the directory
+	 * @return 0 on success
+	 */
+	static int create(Ext2FileSystem *e,Ext2CInode *dir);
+
+	/**
+	 * Calculates the hash of the given name.
+	 *
+	 * @param e the ext2-fs
+	 * @param version the hash-version (EXT2_HASH_*)
+	 * @param name the name
+	 * @param nameLen the length of the name
+	 * @return the hash
+	 */
+	static uint32_t hash(Ext2FileSystem *e,int version,const char *name,size_t nameLen);
+
+private:
+	static int probe(Ext2FileSystem *e,Ext2CInode *dir,const char *name,size_t nameLen,Path *p);
+	static int nextLeaf(Ext2FileSystem *e,Ext2CInode *dir,Path *p);
+	static void release(Path *p);
+	static int growIndex(Ext2FileSystem *e,Ext2CInode *dir,Path *p);
+	static int splitLeaf(Ext2FileSystem *e,Ext2CInode *dir,Path *p,uint8_t *leaf,uint8_t *newLeaf,
+		uint32_t *splitHash);
+	static void insertEntry(Frame *f,uint32_t hash,block_t block);
+	static bool readBlock(Ext2FileSystem *e,const Ext2CInode *dir,block_t block,void *buffer);
+	static bool writeBlock(Ext2FileSystem *e,Ext2CInode *dir,block_t block,const void *buffer);
+};
@@ -27,80 +27,92 @@
 #include "dir.h"
 #include "ext2.h"
 #include "file.h"
+#include "htree.h"
 #include "inodecache.h"
 #include "link.h"
 
 using namespace fs;
 
 int Ext2Link::create(Ext2FileSystem *e,User *u,Ext2CInode *dir,Ext2CInode *cnode,const char *name) {
-	uint8_t *buf;
-	Ext2DirEntry *dire;
 	size_t len = strlen(name);
-	size_t tlen = getDirESize(len);
-	size_t recLen = 0;
 	int res;
-	int32_t dirSize = le32tocpu(dir->inode.size);
 
 	/* we need write-permission to create dir-entries */
 	if((res = e->hasPermission(dir,u,MODE_WRITE)) < 0)
 		return res;
 
-	/* TODO we don't have to read the whole directory at once */
+	/* check if the entry exists */
+	ino_t ino = Ext2Dir::find(e,dir,name,len);
+	if(ino >= 0)
+		return -EEXIST;
+	if(ino != -ENOENT)
+		return ino;
 
-	/* read directory-entries */
-	buf = static_cast<uint8_t*>(malloc(dirSize + tlen));
-	if(buf == NULL)
-		return -ENOMEM;
-	if((res = Ext2File::readIno(e,dir,buf,0,dirSize)) != dirSize) {
-		free(buf);
+	if((res = add(e,dir,cnode->inodeNo,name,len)) < 0)
 		return res;
+	e->dirCache.add(dir->inodeNo,name,len,cnode->inodeNo);
+
+	/* increase link-count */
+	cnode->inode.linkCount = cputole16(le16tocpu(cnode->inode.linkCount) + 1);
+	e->inodeCache.markDirty(cnode);
+	return 0;
+}
+
+int Ext2Link::add(Ext2FileSystem *e,Ext2CInode *dir,ino_t ino,const char *name,size_t len) {
+	size_t bsize = e->blockSize();
+	int res;
+
+	if(Ext2HTree::isIndexed(e,dir)) {
+		res = Ext2HTree::insert(e,dir,ino,name,len);
+		if(res != -ENOSPC && res != -ENOTSUP)
+			return res;
+
+		/* we can't use the index for this directory anymore. so, drop it and treat it as a linear
+		 * directory, which is still valid, because the index-blocks look like empty entries */
+		dir->inode.flags = cputole32(le32tocpu(dir->inode.flags) & ~EXT2_INDEX_FL);
+		e->inodeCache.markDirty(dir);
 	}
 
-	/* check if the entry exists */
-	if(Ext2Dir::findIn((Ext2DirEntry*)buf,dirSize,name,len) >= 0) {
-		free(buf);
-		return -EEXIST;
+	uint8_t *buf = static_cast<uint8_t*>(malloc(bsize));
+	if(buf == NULL)
+		return -ENOMEM;
+
+	/* search for a place for our entry, block by block */
+	int32_t dirSize = le32tocpu(dir->inode.size);
+	for(off_t off = 0; off < dirSize; off += bsize) {
+		if((res = Ext2File::readIno(e,dir,buf,off,bsize)) != (ssize_t)bsize)
+			goto done;
+		if(Ext2Dir::addIn((Ext2DirEntry*)buf,bsize,ino,name,len)) {
+			res = Ext2File::writeIno(e,dir,buf,off,bsize);
+			goto done;
+		}
 	}
 
-	/* search for a place for our entry */
-	dire = (Ext2DirEntry*)buf;
-	while((uint8_t*)dire < buf + dirSize) {
-		/* does our entry fit? */
-		size_t elen = getDirESize(le16tocpu(dire->nameLen));
-		uint16_t orgRecLen = le16tocpu(dire->recLen);
-		if(elen < orgRecLen && orgRecLen - elen >= tlen) {
-			recLen = orgRecLen - elen;
-			/* adjust old entry */
-			dire->recLen = cputole16(orgRecLen - recLen);
-			dire = (Ext2DirEntry*)((uintptr_t)dire + elen);
-			break;
+	/* a single block is full; this is the point where we start to use an index */
+	if(dirSize == (int32_t)bsize && !Ext2HTree::isIndexed(e,dir) &&
+			(le32tocpu(e->sb.get()->featureCompat) & EXT2_FEATURE_COMPAT_DIR_INDEX)) {
+		if(Ext2HTree::create(e,dir) == 0) {
+			e->dirCache.invalidate(dir->inodeNo);
+			free(buf);
+			return add(e,dir,ino,name,len);
 		}
-		dire = (Ext2DirEntry*)((uintptr_t)dire + orgRecLen);
 	}
+
 	/* nothing found yet? so store it on the next block */
-	if(recLen == 0) {
-		dire = (Ext2DirEntry*)(buf + dirSize);
-		recLen = e->blockSize();
-		dirSize += recLen;
+	{
+		Ext2DirEntry *dire = (Ext2DirEntry*)buf;
+		dire->inode = cputole32(ino);
+		dire->nameLen = cputole16(len);
+		dire->recLen = cputole16(bsize);
+		memcpy(dire->name,name,len);
+		res = Ext2File::writeIno(e,dir,buf,dirSize,bsize);
 	}
 
-	/* build entry */
-	dire->inode = cputole32(cnode->inodeNo);
-	dire->nameLen = cputole16(len);
-	dire->recLen = cputole16(recLen);
-	memcpy(dire->name,name,len);
-
-	/* write it back */
-	if((res = Ext2File::writeIno(e,dir,buf,0,dirSize)) != dirSize) {
-		free(buf);
-		return res;
-	}
+done:
 	free(buf);
-
-	/* increase link-count */
-	cnode->inode.linkCount = cputole16(le16tocpu(cnode->inode.linkCount) + 1);
-	e->inodeCache.markDirty(cnode);
-	return 0;
+	if(res == (ssize_t)bsize)
+		return 0;
+	return res < 0 ? res : -ENOBUFS;
 }
 
 int Ext2Link::remove(Ext2FileSystem *e,User *u,Ext2CInode *pdir,Ext2CInode *dir,const char *name,
@@ -110,66 +122,89 @@ int Ext2Link::remove(Ext2FileSystem *e,User *u,Ext2CInode *pdir,Ext2CInode *dir,
 	ino_t ino = -1;
 	Ext2DirEntry *dire,*prev;
 	int res;
+	size_t bsize = e->blockSize();
 	int32_t dirSize = le32tocpu(dir->inode.size);
+	off_t off,end = dirSize;
 	Ext2CInode *cnode;
 
 	/* we need write-permission to delete dir-entries */
 	if((res = e->hasPermission(dir,u,MODE_WRITE)) < 0)
 		return res;
 
-	/* read directory-entries */
-	buf = static_cast<uint8_t*>(malloc(dirSize));
+	/* with an index, we know the block that contains the entry */
+	nameLen = strlen(name);
+	off = 0;
+	if(Ext2HTree::isIndexed(e,dir)) {
+		block_t block;
+		ino = Ext2HTree::find(e,dir,name,nameLen,&block);
+		if(ino >= 0) {
+			off = block * bsize;
+			end = off + bsize;
+		}
+		else if(ino != -ENOTSUP)
+			return ino;
+		ino = -1;
+	}
+
+	buf = static_cast<uint8_t*>(malloc(bsize));
 	if(buf == NULL)
 		return -ENOMEM;
-	if((res = Ext2File::readIno(e,dir,buf,0,dirSize)) != dirSize) {
-		free(buf);
-		return res;
-	}
 
-	/* search our entry */
-	nameLen = strlen(name);
-	prev = NULL;
-	dire = (Ext2DirEntry*)buf;
-	while((uint8_t*)dire < buf + dirSize) {
-		if(nameLen == le16tocpu(dire->nameLen) && strncmp(dire->name,name,nameLen) == 0) {
-			ino = le32tocpu(dire->inode);
-			if(pdir && ino == pdir->inodeNo)
-				cnode = pdir;
-			else if(ino == dir->inodeNo)
-				cnode = dir;
-			else {
-				cnode = e->inodeCache.request(ino,IMODE_WRITE);
-				if(cnode == NULL) {
+	/* search our entry; entries never span blocks */
+	for(; ino == -1 && off < end; off += bsize) {
+		if((res = Ext2File::readIno(e,dir,buf,off,bsize)) != (ssize_t)bsize) {
+			free(buf);
+			return res < 0 ? res : -ENOBUFS;
+		}
+
+		prev = NULL;
+		dire = (Ext2DirEntry*)buf;
+		while((uint8_t*)dire < buf + bsize && le16tocpu(dire->recLen) != 0) {
+			if(le32tocpu(dire->inode) != 0 && nameLen == le16tocpu(dire->nameLen) &&
+					strncmp(dire->name,name,nameLen) == 0) {
+				ino = le32tocpu(dire->inode);
+				if(pdir && ino == pdir->inodeNo)
+					cnode = pdir;
+				else if(ino == dir->inodeNo)
+					cnode = dir;
+				else {
+					cnode = e->inodeCache.request(ino,IMODE_WRITE);
+					if(cnode == NULL) {
+						free(buf);
+						return -ENOBUFS;
+					}
+				}
+
+				if(!delDir && S_ISDIR(le16tocpu(cnode->inode.mode))) {
+					if(cnode != pdir && cnode != dir)
+						e->inodeCache.release(cnode);
 					free(buf);
-					return -ENOBUFS;
+					return -EISDIR;
 				}
-			}
 
-			if(!delDir && S_ISDIR(le16tocpu(cnode->inode.mode))) {
-				if(cnode != pdir && cnode != dir)
-					e->inodeCache.release(cnode);
-				free(buf);
-				return -EISDIR;
-			}
+				/* check permissions (sticky bit) */
+				if((res = e->canRemove(dir,cnode,u)) < 0) {
+					if(cnode != pdir && cnode != dir)
+						e->inodeCache.release(cnode);
+					free(buf);
+					return res;
+				}
 
-			/* check permissions (sticky bit) */
-			if((res = e->canRemove(dir,cnode,u)) < 0) {
-				free(buf);
-				return res;
+				/* if we have a previous one in this block, simply increase its length */
+				if(prev != NULL)
+					prev->recLen = cputole16(le16tocpu(prev->recLen) + le16tocpu(dire->recLen));
+				/* otherwise make an empty entry */
+				else {
+					dire->inode = cputole32(0);
+					dire->nameLen = cputole16(0);
+				}
+				break;
 			}
 
-			/* if we have a previous one, simply increase its length */
-			if(prev != NULL)
-				prev->recLen = cputole16(le16tocpu(prev->recLen) + le16tocpu(dire->recLen));
-			/* otherwise make an empty entry */
-			else
-				dire->inode = cputole32(0);
-			break;
+			/* to next */
+			prev = dire;
+			dire = (Ext2DirEntry*)((uintptr_t)dire + le16tocpu(dire->recLen));
 		}
-
-		/* to next */
-		prev = dire;
-		dire = (Ext2DirEntry*)((uintptr_t)dire + le16tocpu(dire->recLen));
 	}
 
 	/* no match? */
@@ -179,13 +214,15 @@ int Ext2Link::remove(Ext2FileSystem *e,User *u,Ext2CInode *pdir,Ext2CInode *dir,
 	}
 
 	/* write it back */
-	if((res = Ext2File::writeIno(e,dir,buf,0,dirSize)) != dirSize) {
+	off -= bsize;
+	if((res = Ext2File::writeIno(e,dir,buf,off,bsize)) != (ssize_t)bsize) {
 		if(cnode && cnode != pdir && cnode != dir)
 			e->inodeCache.release(cnode);
 		free(buf);
-		return res;
+		return res < 0 ? res : -ENOBUFS;
 	}
 	free(buf);
+	e->dirCache.remove(dir->inodeNo,name,nameLen);
 
 	/* update inode */
 	if(cnode != NULL) {
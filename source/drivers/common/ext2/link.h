@@ -54,9 +54,14 @@ public:
 	static int remove(Ext2FileSystem *e,fs::User *u,Ext2CInode *pdir,Ext2CInode *dir,const char *name,
 		bool delDir);
 
-private:
 	/**
 	 * Calculates the total size of a dir-entry, including padding
 	 */
 	static size_t getDirESize(size_t namelen);
+
+private:
+	/**
+	 * Adds the entry <name> for <ino> to <dir>, using the index, if there is one.
+	 */
+	static int add(Ext2FileSystem *e,Ext2CInode *dir,ino_t ino,const char *name,size_t len);
 };
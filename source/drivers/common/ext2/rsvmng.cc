@@ -0,0 +1,223 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <esc/util.h>
+#include <fs/common.h>
+#include <sys/common.h>
+#include <sys/endian.h>
+
+#include "bitmap.h"
+#include "ext2.h"
+#include "inodecache.h"
+#include "rsvmng.h"
+
+Ext2RsvMng::Ext2RsvMng(Ext2FileSystem *fs)
+		: _allocs(), _contiguous(), _hits(), _created(), _evicted(), _batches(), _time(),
+		  _windows(), _fs(fs) {
+	for(size_t i = 0; i < WINDOWS; i++)
+		_windows[i].ino = EXT2_BAD_INO;
+}
+
+block_t Ext2RsvMng::alloc(Ext2CInode *inode,block_t group) {
+	std::lock_guard<std::mutex> guard(_mutex);
+	Window *w = get(inode->inodeNo);
+	block_t goal;
+	size_t size;
+
+	/* windows that have only been reserved so far are placed like new ones */
+	if(w && w->end != 0) {
+		/* the window was made for us, but someone might have allocated it without window */
+		if(w->next < w->end && Ext2Bitmap::claimBlock(_fs,w->next)) {
+			_allocs++;
+			_contiguous++;
+			_hits++;
+			w->lastUse = ++_time;
+			return w->next++;
+		}
+
+		/* continue behind the used up window with a larger one */
+		goal = w->end;
+		size = w->size * 2;
+		if(size > MAX_WINDOW)
+			size = MAX_WINDOW;
+	}
+	else {
+		if(!w)
+			w = take(inode->inodeNo);
+
+		goal = le32tocpu(_fs->sb.get()->firstDataBlock) +
+			group * le32tocpu(_fs->sb.get()->blocksPerGroup);
+		size = w->size;
+	}
+
+	block_t prev = w->end;
+	if(!place(w,goal,size)) {
+		w->ino = EXT2_BAD_INO;
+		return 0;
+	}
+	if(!Ext2Bitmap::claimBlock(_fs,w->next)) {
+		w->ino = EXT2_BAD_INO;
+		return 0;
+	}
+
+	_allocs++;
+	_created++;
+	if(w->next == prev)
+		_contiguous++;
+	w->lastUse = ++_time;
+	return w->next++;
+}
+
+void Ext2RsvMng::reserve(ino_t ino,size_t count) {
+	if(count <= 1)
+		return;
+
+	std::lock_guard<std::mutex> guard(_mutex);
+	Window *w = get(ino);
+	if(!w) {
+		/* remember the size, so that the first window is large enough for the whole request */
+		w = take(ino);
+		w->size = esc::Util::max(esc::Util::min(count,MAX_WINDOW),MIN_WINDOW);
+		w->lastUse = ++_time;
+		_batches++;
+	}
+	else if(w->end - w->next < count) {
+		bool changed = false;
+		/* let the next window be large enough for the whole request */
+		while(w->size < count && w->size < MAX_WINDOW) {
+			w->size = esc::Util::min(w->size * 2,MAX_WINDOW);
+			changed = true;
+		}
+		/* the rest of this window is too small; don't split the request */
+		if(w->next > w->start && w->end != w->next) {
+			w->end = w->next;
+			changed = true;
+		}
+		if(changed)
+			_batches++;
+	}
+}
+
+void Ext2RsvMng::discard(ino_t ino) {
+	std::lock_guard<std::mutex> guard(_mutex);
+	Window *w = get(ino);
+	if(w)
+		w->ino = EXT2_BAD_INO;
+}
+
+void Ext2RsvMng::print(FILE *f) {
+	size_t active = 0,reserved = 0;
+	size_t allocs,contiguous,hits,created,evicted,batches;
+
+	/* take a consistent snapshot, but don't hold the lock while writing to <f> */
+	{
+		std::lock_guard<std::mutex> guard(_mutex);
+		for(size_t i = 0; i < WINDOWS; i++) {
+			if(_windows[i].ino != EXT2_BAD_INO) {
+				active++;
+				reserved += _windows[i].end - _windows[i].next;
+			}
+		}
+		allocs = _allocs;
+		contiguous = _contiguous;
+		hits = _hits;
+		created = _created;
+		evicted = _evicted;
+		batches = _batches;
+	}
+
+	fprintf(f,"Allocated blocks: %zu\n",allocs);
+	fprintf(f,"Contiguous blocks: %zu\n",contiguous);
+	fprintf(f,"Fragments: %zu\n",allocs - contiguous);
+	fprintf(f,"Fragmentation: %.3f%%\n",allocs == 0 ? 0.0f
+		: 100.0f * (float)(allocs - contiguous) / (float)allocs);
+	fprintf(f,"Window hits: %zu\n",hits);
+	fprintf(f,"Windows created: %zu\n",created);
+	fprintf(f,"Windows evicted: %zu\n",evicted);
+	fprintf(f,"Batched requests: %zu\n",batches);
+	fprintf(f,"Active windows: %zu of %zu\n",active,WINDOWS);
+	fprintf(f,"Reserved blocks: %zu\n",reserved);
+}
+
+Ext2RsvMng::Window *Ext2RsvMng::take(ino_t ino) {
+	/* take a free slot or replace the least recently used window */
+	Window *w = _windows;
+	for(size_t i = 0; i < WINDOWS && w->ino != EXT2_BAD_INO; i++) {
+		if(_windows[i].ino == EXT2_BAD_INO || _windows[i].lastUse < w->lastUse)
+			w = _windows + i;
+	}
+	if(w->ino != EXT2_BAD_INO)
+		_evicted++;
+
+	w->ino = ino;
+	w->start = w->next = w->end = 0;
+	w->size = MIN_WINDOW;
+	return w;
+}
+
+Ext2RsvMng::Window *Ext2RsvMng::get(ino_t ino) {
+	for(size_t i = 0; i < WINDOWS; i++) {
+		if(_windows[i].ino == ino)
+			return _windows + i;
+	}
+	return NULL;
+}
+
+Ext2RsvMng::Window *Ext2RsvMng::overlaps(const Window *w,block_t start,block_t end) {
+	for(size_t i = 0; i < WINDOWS; i++) {
+		Window *o = _windows + i;
+		if(o != w && o->ino != EXT2_BAD_INO && o->next < o->end && start < o->end && o->next < end)
+			return o;
+	}
+	return NULL;
+}
+
+bool Ext2RsvMng::place(Window *w,block_t goal,size_t size) {
+	block_t blockCount = le32tocpu(_fs->sb.get()->blockCount);
+	/* bound the number of attempts; every window we collide with can only push us forward */
+	for(size_t tries = 0; tries <= WINDOWS; tries++) {
+		size_t len;
+		block_t start = Ext2Bitmap::findFree(_fs,goal,size,&len);
+		if(start == 0)
+			return false;
+
+		/* don't use the part of the run that is reserved for somebody else */
+		block_t end = start + len;
+		Window *o;
+		while((o = overlaps(w,start,end)) != NULL) {
+			if(o->next <= start)
+				start = o->end;
+			else
+				end = o->next;
+			if(start >= end)
+				break;
+		}
+
+		if(start < end) {
+			w->start = w->next = start;
+			w->end = end;
+			w->size = size;
+			return true;
+		}
+
+		/* try behind the window we collided with */
+		goal = o->end < blockCount ? o->end : 0;
+	}
+	return false;
+}
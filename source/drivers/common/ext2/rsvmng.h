@@ -0,0 +1,108 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/common.h>
+#include <mutex>
+#include <stdio.h>
+
+struct Ext2CInode;
+class Ext2FileSystem;
+
+/**
+ * Manages the reservation windows of the inodes that are currently written. A window is a run of
+ * free blocks that is reserved in memory for one inode, so that its blocks are allocated
+ * contiguously, even if multiple files are written concurrently. Other inodes don't allocate
+ * blocks in it, but it is not marked in the bitmap. Thus, nothing needs to be undone if a window
+ * is dropped. If a window is used up, the next one is placed behind it and grows up to
+ * MAX_WINDOW blocks. All methods are thread-safe, because the statistics are read by a different
+ * thread.
+ */
+class Ext2RsvMng {
+	static const size_t WINDOWS		= 32;
+	static const size_t MIN_WINDOW	= 8;
+	static const size_t MAX_WINDOW	= 1024;
+
+	struct Window {
+		ino_t ino;
+		block_t start;
+		block_t end;
+		block_t next;
+		size_t size;
+		ulong lastUse;
+	};
+
+public:
+	/**
+	 * Inits the reservation windows
+	 */
+	explicit Ext2RsvMng(Ext2FileSystem *fs);
+
+	/**
+	 * Allocates the next block for <inode> from its reservation window. If it has none or it is
+	 * used up, a new window is searched. Assumes that EXT2_SUPERBLOCK_LOCK is held.
+	 *
+	 * @param inode the inode
+	 * @param group the block-group to start the search at for new windows
+	 * @return the block-number or 0 if there is no window with free blocks
+	 */
+	block_t alloc(Ext2CInode *inode,block_t group);
+
+	/**
+	 * Announces that <count> blocks will be allocated for <ino> in a row. If this is more than
+	 * the current window of the inode provides, the window will be replaced by a larger one with
+	 * the next allocation. If the inode has no window yet, the first one will be large enough.
+	 *
+	 * @param ino the inode-number
+	 * @param count the number of blocks
+	 */
+	void reserve(ino_t ino,size_t count);
+
+	/**
+	 * Drops the window of the given inode, if it has one (e.g., because the inode is truncated).
+	 *
+	 * @param ino the inode-number
+	 */
+	void discard(ino_t ino);
+
+	/**
+	 * Prints the allocation statistics into the given file
+	 *
+	 * @param f the file
+	 */
+	void print(FILE *f);
+
+private:
+	Window *get(ino_t ino);
+	Window *take(ino_t ino);
+	Window *overlaps(const Window *w,block_t start,block_t end);
+	bool place(Window *w,block_t goal,size_t size);
+
+	size_t _allocs;
+	size_t _contiguous;
+	size_t _hits;
+	size_t _created;
+	size_t _evicted;
+	size_t _batches;
+	ulong _time;
+	Window _windows[WINDOWS];
+	Ext2FileSystem *_fs;
+	std::mutex _mutex;
+};
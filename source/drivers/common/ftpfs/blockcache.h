@@ -0,0 +1,108 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <sys/common.h>
+
+/**
+ * A small LRU cache for the blocks of one file.
+ */
+class BlockCache {
+public:
+	static const size_t BLOCK_SIZE		= 16 * 1024;
+	static const size_t MAX_BLOCKS		= 64;
+
+	struct Block {
+		size_t no;
+		size_t length;
+		ulong lastUse;
+		char *data;
+	};
+
+	explicit BlockCache() : _blocks(), _count(), _useCounter() {
+	}
+	~BlockCache() {
+		for(size_t i = 0; i < _count; ++i)
+			delete[] _blocks[i].data;
+	}
+
+	/**
+	 * @param no the block number
+	 * @return the cached block or NULL
+	 */
+	Block *get(size_t no) {
+		for(size_t i = 0; i < _count; ++i) {
+			if(_blocks[i].no == no) {
+				_blocks[i].lastUse = ++_useCounter;
+				return _blocks + i;
+			}
+		}
+		return NULL;
+	}
+
+	/**
+	 * Allocates an empty block for block number <no>. If the cache is full, the least recently
+	 * used block is reused.
+	 *
+	 * @param no the block number
+	 * @return the block
+	 */
+	Block *alloc(size_t no) {
+		Block *b = get(no);
+		if(!b) {
+			if(_count < MAX_BLOCKS) {
+				b = _blocks + _count++;
+				b->data = new char[BLOCK_SIZE];
+			}
+			else {
+				b = _blocks;
+				for(size_t i = 1; i < _count; ++i) {
+					if(_blocks[i].lastUse < b->lastUse)
+						b = _blocks + i;
+				}
+			}
+			b->no = no;
+			b->lastUse = ++_useCounter;
+		}
+		b->length = 0;
+		return b;
+	}
+
+	/**
+	 * Removes the given block from the cache (e.g., because it could not be filled)
+	 */
+	void drop(Block *b) {
+		b->no = (size_t)-1;
+		b->lastUse = 0;
+	}
+
+	/**
+	 * Removes all blocks from the cache
+	 */
+	void invalidate() {
+		for(size_t i = 0; i < _count; ++i)
+			delete[] _blocks[i].data;
+		_count = 0;
+	}
+
+private:
+	Block _blocks[MAX_BLOCKS];
+	size_t _count;
+	ulong _useCounter;
+};
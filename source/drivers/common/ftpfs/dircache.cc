@@ -30,6 +30,11 @@
 
 DirCache::dirmap_type DirCache::dirs;
 time_t DirCache::now = time(NULL);
+ulong DirCache::useCounter = 0;
+ulong DirCache::hits = 0;
+ulong DirCache::misses = 0;
+ulong DirCache::expired = 0;
+ulong DirCache::evicted = 0;
 
 DirCache::List *DirCache::getList(const CtrlConRef &ctrlRef,const char *path,bool load) {
 	char cpath[MAX_PATH_LEN];
@@ -59,15 +64,33 @@ int DirCache::getInfo(const CtrlConRef &ctrlRef,const char *path,struct stat *in
 }
 
 void DirCache::removeDir(const char *path) {
-	dirs.erase(path);
+	dirmap_type::iterator it = dirs.find(path);
+	if(it != dirs.end())
+		remove(it);
 }
 
 void DirCache::removeDirOf(const char *path) {
 	char cpath[MAX_PATH_LEN];
 	cleanpath(cpath,sizeof(cpath),path);
 
-	const char *dir = dirname(cpath);
-	dirs.erase(dir);
+	removeDir(dirname(cpath));
+}
+
+void DirCache::remove(dirmap_type::iterator it) {
+	delete it->second;
+	dirs.erase(it);
+}
+
+void DirCache::evict() {
+	dirmap_type::iterator lru = dirs.end();
+	for(auto it = dirs.begin(); it != dirs.end(); ++it) {
+		if(lru == dirs.end() || it->second->lastUse < lru->second->lastUse)
+			lru = it;
+	}
+	if(lru != dirs.end()) {
+		remove(lru);
+		evicted++;
+	}
 }
 
 DirCache::List *DirCache::loadList(const CtrlConRef &ctrlRef,const char *dir) {
@@ -84,6 +107,8 @@ DirCache::List *DirCache::loadList(const CtrlConRef &ctrlRef,const char *dir) {
 
 		list = new List;
 		list->path = dir;
+		list->loaded = time(NULL);
+		list->lastUse = ++useCounter;
 		char line[256];
 		esc::FStream in(data.fd(),"r");
 		while(!in.eof()) {
@@ -96,6 +121,9 @@ DirCache::List *DirCache::loadList(const CtrlConRef &ctrlRef,const char *dir) {
 			finfo.st_ino = genINodeNo(dir,name.c_str());
 			list->nodes[name] = finfo;
 		}
+
+		while(dirs.size() >= MAX_DIRS)
+			evict();
 		dirs[dir] = list;
 	}
 	ctrl->readReply();
@@ -104,8 +132,20 @@ DirCache::List *DirCache::loadList(const CtrlConRef &ctrlRef,const char *dir) {
 
 DirCache::List *DirCache::findList(const char *path) {
 	dirmap_type::iterator it = dirs.find(path);
-	if(it == dirs.end())
+	if(it == dirs.end()) {
+		misses++;
 		return NULL;
+	}
+
+	if(time(NULL) - it->second->loaded >= TTL) {
+		remove(it);
+		expired++;
+		misses++;
+		return NULL;
+	}
+
+	hits++;
+	it->second->lastUse = ++useCounter;
 	return it->second;
 }
 
@@ -193,11 +233,16 @@ mode_t DirCache::decodePerm(const char *perms) {
 	return res;
 }
 
-void DirCache::print(esc::OStream &os) {
-	os << "Directory lists:\n";
+void DirCache::print(FILE *f) {
+	fprintf(f,"Directory cache:\n");
+	fprintf(f,"\tEntries: %zu of %zu\n",dirs.size(),MAX_DIRS);
+	fprintf(f,"\tHits   : %lu\n",hits);
+	fprintf(f,"\tMisses : %lu\n",misses);
+	fprintf(f,"\tExpired: %lu\n",expired);
+	fprintf(f,"\tEvicted: %lu\n",evicted);
+	time_t ts = time(NULL);
 	for(auto it = dirs.begin(); it != dirs.end(); ++it) {
-		os << "  " << it->first << ":\n";
-		for(auto n = it->second->nodes.begin(); n != it->second->nodes.end(); ++n)
-			os << "    " << n->first << " (" << n->second.st_ino << "," << n->second.st_size << ")\n";
+		fprintf(f,"\t%s (%zu entries, age %lds)\n",
+			it->first.c_str(),it->second->nodes.size(),(long)(ts - it->second->loaded));
 	}
 }
@@ -19,7 +19,6 @@
 
 #pragma once
 
-#include <esc/stream/ostream.h>
 #include <sys/common.h>
 #include <sys/stat.h>
 #include <map>
@@ -27,17 +26,27 @@
 
 #include "ctrlcon.h"
 
-// TODO maybe we should limit the cache size somehow
-
+/**
+ * Caches the directory listings of the FTP server. The number of cached directories is limited
+ * (the least recently used one is evicted) and every listing expires after a while so that we
+ * notice changes done by others.
+ */
 class DirCache {
 	DirCache() = delete;
 
+	/* the max. number of cached directories */
+	static const size_t MAX_DIRS		= 64;
+	/* the number of seconds after which a listing is reloaded */
+	static const time_t TTL				= 30;
+
 public:
 	typedef std::map<std::string,struct stat> nodemap_type;
 
 	struct List {
 		std::string path;
 		nodemap_type nodes;
+		time_t loaded;
+		ulong lastUse;
 	};
 
 	typedef std::map<std::string,List*> dirmap_type;
@@ -46,13 +55,15 @@ public:
 	static int getInfo(const CtrlConRef &ctrlRef,const char *path,struct stat *info);
 	static void removeDir(const char *path);
 	static void removeDirOf(const char *path);
-	static void print(esc::OStream &os);
+	static void print(FILE *f);
 
 private:
 	static List *loadList(const CtrlConRef &ctrlRef,const char *dir);
 	static List *findList(const char *path);
 	static int find(List *list,const char *name,struct stat *info);
 	static void insert(const char *path,struct stat *info);
+	static void remove(dirmap_type::iterator it);
+	static void evict();
 
 	static std::string decode(const char *line,struct stat *info);
 	static ino_t genINodeNo(const char *dir,const char *name);
@@ -62,4 +73,9 @@ private:
 
 	static dirmap_type dirs;
 	static time_t now;
+	static ulong useCounter;
+	static ulong hits;
+	static ulong misses;
+	static ulong expired;
+	static ulong evicted;
 };
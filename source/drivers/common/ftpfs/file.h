@@ -16,44 +16,67 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
-
 #pragma once
 
+#include <esc/util.h>
 #include <sys/common.h>
+#include <string.h>
 
+#include "blockcache.h"
 #include "blockfile.h"
 #include "ctrlcon.h"
-#include "datacon.h"
+#include "transfer.h"
 
+/**
+ * A file on the FTP server. Reads are served from a block cache. Misses are fetched from the
+ * current transfer, if it is at the right position, reading ahead for sequential accesses. Large
+ * misses are split into multiple ranges that are fetched over parallel data-connections.
+ */
 class File : public BlockFile {
+	/* the max. number of blocks to read ahead */
+	static const size_t MAX_AHEAD		= 8;
+	/* the min. number of missing blocks to fetch them in parallel */
+	static const size_t PAR_MIN_BLOCKS	= 8;
+	/* the max. number of parallel transfers */
+	static const size_t MAX_TRANSFERS	= 4;
+	/* the amount to read from one transfer before switching to the next one */
+	static const size_t CHUNK_SIZE		= 4096;
+
 public:
 	explicit File(const std::string &path,size_t size,const CtrlConRef &ctrl)
-			: _reading(false), _offset(-1), _fd(), _shm(), _shmsize(), _total(size), _path(path),
-			  _ctrlRef(ctrl), _ctrl(), _data() {
-	}
-	virtual ~File() {
-		if(_data) {
-			try {
-				stop();
-			}
-			catch(...) {
-			}
-		}
+			: _fd(), _shm(), _shmsize(), _total(size), _ahead(1), _lastBlock(-1), _path(path),
+			  _ctrlRef(ctrl), _main(path,size,ctrl), _cache() {
 	}
 
 	virtual size_t read(void *buf,size_t offset,size_t count) {
-		if(!_reading || offset != _offset)
-			startTransfer(offset,true);
-		size_t res = _data->read(buf,count);
-		_offset += res;
+		// don't start transfers beyond the end of the file
+		if(offset >= _total)
+			return 0;
+		count = esc::Util::min(count,_total - offset);
+
+		size_t res = 0;
+		while(res < count) {
+			size_t pos = offset + res;
+			BlockCache::Block *b = _cache.get(pos / BlockCache::BLOCK_SIZE);
+			if(!b)
+				b = fetch(pos / BlockCache::BLOCK_SIZE,(offset + count - 1) / BlockCache::BLOCK_SIZE);
+
+			size_t boff = pos % BlockCache::BLOCK_SIZE;
+			if(boff >= b->length)
+				break;
+			size_t amount = esc::Util::min(b->length - boff,count - res);
+			memcpy(static_cast<char*>(buf) + res,b->data + boff,amount);
+			res += amount;
+		}
 		return res;
 	}
 
 	virtual void write(const void *buf,size_t offset,size_t count) {
-		if(_reading || offset != _offset)
-			startTransfer(offset,false);
-		_data->write(buf,count);
-		_offset += count;
+		_cache.invalidate();
+		if(!_main.active() || _main.reading() || offset != _main.offset())
+			_main.start(offset,false,_fd,_shm,_shmsize);
+		_main.write(buf,count);
+		_total = esc::Util::max(_total,offset + count);
 	}
 
 	virtual int sharemem(int fd,void *mem,size_t size) {
@@ -66,57 +89,136 @@ public:
 	}
 
 private:
-	void startTransfer(size_t offset,bool reading) {
-		// if not done yet, request the control-connection for ourself. we'll release it in our
-		// destructor, i.e. when the transfer is finished
-		if(!_ctrl)
-			_ctrl = _ctrlRef.request();
-		else if(_data) {
-			stop();
-			_data = NULL;
+	BlockCache::Block *fetch(size_t first,size_t last) {
+		// never fetch blocks beyond the end of the file
+		size_t fileEnd = (_total - 1) / BlockCache::BLOCK_SIZE + 1;
+		last = esc::Util::min(last,fileEnd - 1);
+
+		// determine the number of consecutive blocks that are missing
+		size_t end = first + 1;
+		while(end <= last && end - first < BlockCache::MAX_BLOCKS / 2 && !_cache.get(end))
+			end++;
+
+		BlockCache::Block *b;
+		if(end - first >= PAR_MIN_BLOCKS)
+			b = fetchParallel(first,end);
+		else {
+			// read ahead if the file is read sequentially
+			if(first == _lastBlock + 1)
+				_ahead = esc::Util::min(_ahead * 2,MAX_AHEAD);
+			else
+				_ahead = 1;
+
+			size_t ahead = esc::Util::min(esc::Util::max(_ahead,end - first),fileEnd - first);
+			b = fetchBlock(first);
+			for(size_t i = 1; i < ahead && b->length == BlockCache::BLOCK_SIZE; ++i) {
+				if(_cache.get(first + i) || fetchBlock(first + i)->length < BlockCache::BLOCK_SIZE)
+					break;
+			}
+			// fetchBlock might have reused it, but only if we read ahead more than the cache holds
+			b = _cache.get(first);
 		}
-		_data = new DataCon(_ctrlRef);
-		if(_shm)
-			_data->sharemem(_fd,_shm,_shmsize);
-		_offset = offset;
-		_reading = reading;
+		_lastBlock = end - 1;
+		return b;
+	}
+
+	BlockCache::Block *fetchBlock(size_t no) {
+		size_t offset = no * BlockCache::BLOCK_SIZE;
+		if(!_main.active() || !_main.reading() || _main.offset() != offset)
+			_main.start(offset,true);
 
-		// if RETR or STOR fail for example, we won't get a reply on the control-channel
-		// so, better destroy the data-channel. we can't use it anyway.
+		BlockCache::Block *b = _cache.alloc(no);
 		try {
-			if(offset != 0) {
-				char buf[32];
-				snprintf(buf,sizeof(buf),"%zu",offset);
-				_ctrl->execute(CtrlCon::CMD_REST,buf);
+			while(b->length < BlockCache::BLOCK_SIZE) {
+				size_t res = _main.read(b->data + b->length,BlockCache::BLOCK_SIZE - b->length);
+				if(res == 0)
+					break;
+				b->length += res;
 			}
-			_ctrl->execute(_reading ? CtrlCon::CMD_RETR : CtrlCon::CMD_STOR,_path.c_str());
 		}
 		catch(...) {
-			delete _data;
-			_data = NULL;
+			_cache.drop(b);
 			throw;
 		}
+		return b;
 	}
 
-	void stop() {
-		bool aborting = _offset == (size_t)-1 || _offset < _total;
-		if(aborting)
-			_data->abort();
-		delete _data;
-		if(_reading && aborting)
-			_ctrl->abort();
-		else
-			_ctrl->readReply();
+	BlockCache::Block *fetchParallel(size_t first,size_t end) {
+		struct Range {
+			Transfer *trans;
+			size_t next;
+			size_t end;
+			BlockCache::Block *block;
+		} ranges[MAX_TRANSFERS];
+
+		// the last range is fetched by the main transfer, so that it can simply continue afterwards
+		size_t count = esc::Util::min(MAX_TRANSFERS,(end - first) / (PAR_MIN_BLOCKS / 2));
+		size_t per = (end - first + count - 1) / count;
+		for(size_t i = 0; i < count; ++i) {
+			ranges[i].next = first + i * per;
+			ranges[i].end = esc::Util::min(first + (i + 1) * per,end);
+			ranges[i].block = NULL;
+			ranges[i].trans = i == count - 1 ? &_main : NULL;
+		}
+
+		size_t active = 0;
+		try {
+			// start the main transfer first to let it keep the main control-connection
+			for(size_t i = count; i-- > 0; ) {
+				if(!ranges[i].trans)
+					ranges[i].trans = new Transfer(_path,_total,_ctrlRef);
+				size_t offset = ranges[i].next * BlockCache::BLOCK_SIZE;
+				if(!ranges[i].trans->active() || !ranges[i].trans->reading() ||
+						ranges[i].trans->offset() != offset)
+					ranges[i].trans->start(offset,true);
+				ranges[i].block = _cache.alloc(ranges[i].next);
+				active++;
+			}
+
+			// receive the ranges round-robin. the server sends on all connections in the meantime
+			while(active > 0) {
+				for(size_t i = 0; i < count; ++i) {
+					Range *r = ranges + i;
+					if(!r->block)
+						continue;
+
+					size_t amount = esc::Util::min(CHUNK_SIZE,BlockCache::BLOCK_SIZE - r->block->length);
+					size_t res = r->trans->read(r->block->data + r->block->length,amount);
+					r->block->length += res;
+					if(res == 0 || r->block->length == BlockCache::BLOCK_SIZE) {
+						if(res == 0 || ++r->next == r->end) {
+							r->block = NULL;
+							active--;
+						}
+						else
+							r->block = _cache.alloc(r->next);
+					}
+				}
+			}
+		}
+		catch(...) {
+			for(size_t i = 0; i < count; ++i) {
+				if(ranges[i].block)
+					_cache.drop(ranges[i].block);
+			}
+			for(size_t i = 0; i < count - 1; ++i)
+				delete ranges[i].trans;
+			throw;
+		}
+
+		for(size_t i = 0; i < count - 1; ++i)
+			delete ranges[i].trans;
+		return _cache.get(first);
 	}
 
-	bool _reading;
-	size_t _offset;
 	int _fd;
 	void *_shm;
 	size_t _shmsize;
 	size_t _total;
+	size_t _ahead;
+	size_t _lastBlock;
 	const std::string &_path;
 	CtrlConRef _ctrlRef;
-	CtrlCon *_ctrl;
-	DataCon *_data;
+	Transfer _main;
+	BlockCache _cache;
 };
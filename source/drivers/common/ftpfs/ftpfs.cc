@@ -113,6 +113,21 @@ public:
 		return DirCache::getInfo(file->ctrlRef,file->path.c_str(),info);
 	}
 
+	int pathstat(User *u,const char *path,ssize_t *sympos,ino_t root,uint flags,int fd,
+			struct stat *info) override {
+		/* resolve paths relative to a different root inode in the same way as open() does */
+		if(root != 0)
+			return FileSystem<OpenFTPFile>::pathstat(u,path,sympos,root,flags,fd,info);
+
+		return DirCache::getInfo(_ctrlRef,path,info);
+	}
+
+	int entrystat(User *,OpenFTPFile *dir,const char *name,struct stat *info) override {
+		char path[MAX_PATH_LEN];
+		snprintf(path,sizeof(path),"%s/%s",dir->path.c_str(),name);
+		return DirCache::getInfo(dir->ctrlRef,path,info);
+	}
+
 	ssize_t read(OpenFTPFile *file,void *data,off_t pos,size_t count) override {
 		return file->read(data,pos,count);
 	}
@@ -158,6 +173,7 @@ public:
 		fprintf(f,"port: %d\n",port);
 		fprintf(f,"user: %s\n",user);
 		fprintf(f,"dir : %s\n",dir);
+		DirCache::print(f);
 	}
 
 private:
@@ -0,0 +1,153 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <sys/common.h>
+#include <stdio.h>
+
+#include "ctrlcon.h"
+#include "datacon.h"
+
+/**
+ * A RETR or STOR of one file, starting at a given offset. Every transfer requests its own
+ * control-connection, so that multiple transfers of the same file can run in parallel.
+ */
+class Transfer {
+public:
+	explicit Transfer(const std::string &path,size_t total,const CtrlConRef &ctrl)
+		: _reading(false), _eof(false), _offset(-1), _total(total), _path(path), _ctrlRef(ctrl),
+		  _ctrl(), _data() {
+	}
+	~Transfer() {
+		if(_data) {
+			try {
+				stop();
+			}
+			catch(...) {
+			}
+		}
+	}
+
+	/**
+	 * @return true if the transfer is running
+	 */
+	bool active() const {
+		return _data != NULL;
+	}
+	/**
+	 * @return true if it is a RETR transfer
+	 */
+	bool reading() const {
+		return _reading;
+	}
+	/**
+	 * @return the current offset in the file
+	 */
+	size_t offset() const {
+		return _offset;
+	}
+
+	/**
+	 * Starts a new transfer at given offset. A running transfer is stopped before.
+	 *
+	 * @param offset the offset in the file
+	 * @param reading whether to read or write
+	 * @param fd the shared memory file (-1 if not present)
+	 * @param shm the shared memory
+	 * @param shmsize the size of the shared memory
+	 */
+	void start(size_t offset,bool reading,int fd = -1,void *shm = NULL,size_t shmsize = 0) {
+		// if not done yet, request the control-connection for ourself. we'll release it in our
+		// destructor, i.e. when the transfer is finished
+		if(!_ctrl)
+			_ctrl = _ctrlRef.request();
+		else if(_data) {
+			stop();
+			_data = NULL;
+		}
+		_data = new DataCon(_ctrlRef);
+		if(shm)
+			_data->sharemem(fd,shm,shmsize);
+		_offset = offset;
+		_reading = reading;
+		_eof = false;
+
+		// if RETR or STOR fail for example, we won't get a reply on the control-channel
+		// so, better destroy the data-channel. we can't use it anyway.
+		try {
+			if(offset != 0) {
+				char buf[32];
+				snprintf(buf,sizeof(buf),"%zu",offset);
+				_ctrl->execute(CtrlCon::CMD_REST,buf);
+			}
+			_ctrl->execute(_reading ? CtrlCon::CMD_RETR : CtrlCon::CMD_STOR,_path.c_str());
+		}
+		catch(...) {
+			delete _data;
+			_data = NULL;
+			throw;
+		}
+	}
+
+	/**
+	 * Reads up to <count> bytes from the data-connection. If the end of the file is reached, the
+	 * transfer is finished.
+	 *
+	 * @return the number of read bytes (0 = EOF)
+	 */
+	size_t read(void *buf,size_t count) {
+		size_t res = _data->read(buf,count);
+		_offset += res;
+		if(res == 0) {
+			_eof = true;
+			stop();
+			_data = NULL;
+		}
+		return res;
+	}
+
+	/**
+	 * Writes <count> bytes to the data-connection.
+	 */
+	void write(const void *buf,size_t count) {
+		_data->write(buf,count);
+		_offset += count;
+	}
+
+private:
+	void stop() {
+		bool aborting = !_eof && (_offset == (size_t)-1 || _offset < _total);
+		if(aborting)
+			_data->abort();
+		delete _data;
+		if(_reading && aborting)
+			_ctrl->abort();
+		else
+			_ctrl->readReply();
+	}
+
+	bool _reading;
+	bool _eof;
+	size_t _offset;
+	size_t _total;
+	const std::string &_path;
+	CtrlConRef _ctrlRef;
+	CtrlCon *_ctrl;
+	DataCon *_data;
+};
@@ -121,13 +121,15 @@ public:
 
 		std::lock_guard<std::mutex> guard(mutex);
 		std::vector<Process*> ui;
+		std::vector<DriverProcess*> drvs;
 		while(ifs.good()) {
 			DriverProcess *drv = new DriverProcess();
 			ifs >> *drv;
 			drv->replace("$ui",uipath);
-			drv->load();
 			ui.push_back(drv);
+			drvs.push_back(drv);
 		}
+		ProcessManager::loadAll(drvs,nullptr);
 		uim.add(ui);
 
 		is << 0 << esc::Reply();
@@ -36,7 +36,35 @@ using namespace std;
 
 sNamedItem *DriverProcess::groupList = nullptr;
 
+bool DriverProcess::provides(const std::string &path) const {
+	for(auto it = _devices.begin(); it != _devices.end(); ++it) {
+		if(it->name() == path)
+			return true;
+	}
+	return false;
+}
+
+bool DriverProcess::needs(const DriverProcess &drv) const {
+	for(auto it = _args.begin(); it != _args.end(); ++it) {
+		// for environment variables, the value is what matters
+		size_t pos = strchri(it->c_str(),'=');
+		if(pos == it->length() ? drv.provides(*it) : drv.provides(it->c_str() + pos + 1))
+			return true;
+	}
+	for(auto it = _requires.begin(); it != _requires.end(); ++it) {
+		if(drv.provides(*it))
+			return true;
+	}
+	return false;
+}
+
 void DriverProcess::load() {
+	spawn();
+	while(!poll())
+		wait();
+}
+
+void DriverProcess::spawn() {
 	// load groups from file, if not already done
 	if(groupList == nullptr) {
 		size_t count;
@@ -45,6 +73,9 @@ void DriverProcess::load() {
 			throw esc::default_error("Unable to get group list");
 	}
 
+	_readyDevs = 0;
+	_start = rdtsc();
+
 	// now load the driver
 	_pid = fork();
 	if(_pid == 0) {
@@ -80,40 +111,46 @@ void DriverProcess::load() {
 	}
 	else if(_pid < 0)
 		throw esc::default_error("fork failed");
+}
 
-	// wait for all specified devices
-	for(auto it = _devices.begin(); it != _devices.end(); ++it) {
-		sNamedItem *g;
-		int fd;
-		int j = 0;
-		do {
-			fd = open(it->name().c_str(),O_NOCHAN);
-			if(fd < 0) {
-				// check whether the child already died
-				int state;
-				if(waitpid(_pid,&state,WNOHANG) == _pid) {
-					VTHROW("Child '" << it->name() << "' died with exitcode "
-						<< WEXITSTATUS(state) << " (signal " << WTERMSIG(state) << ")");
-				}
-
-				usleep(RETRY_INTERVAL);
+bool DriverProcess::poll() {
+	for(; _readyDevs < _devices.size(); ++_readyDevs) {
+		const Device &dev = _devices[_readyDevs];
+		int fd = open(dev.name().c_str(),O_NOCHAN);
+		if(fd < 0) {
+			// check whether the child already died
+			int state;
+			if(waitpid(_pid,&state,WNOHANG) == _pid) {
+				VTHROW("Child '" << dev.name() << "' died with exitcode "
+					<< WEXITSTATUS(state) << " (signal " << WTERMSIG(state) << ")");
 			}
+			if(tsctotime(rdtsc() - _start) >= (uint64_t)MAX_WAIT)
+				throw esc::default_error(string("Timeout reached while waiting for '") + dev.name() + "'");
+			return false;
 		}
-		while(j++ < MAX_WAIT_RETRIES && fd < 0);
-		if(fd < 0)
-			throw esc::default_error(string("Max retries reached while waiting for '") + it->name() + "'");
 
 		// set permissions
-		if(fchmod(fd,it->permissions()) < 0)
-			throw esc::default_error(string("Unable to set permissions for '") + it->name() + "'");
+		if(fchmod(fd,dev.permissions()) < 0)
+			throw esc::default_error(string("Unable to set permissions for '") + dev.name() + "'");
 		// set group
-		g = usergroup_getByName(groupList,it->group().c_str());
+		sNamedItem *g = usergroup_getByName(groupList,dev.group().c_str());
 		if(!g)
-			throw esc::default_error(string("Unable to find group '") + it->group() + "'");
+			throw esc::default_error(string("Unable to find group '") + dev.group() + "'");
 		if(fchown(fd,-1,g->id) < 0)
-			throw esc::default_error(string("Unable to set group for '") + it->name() + "'");
+			throw esc::default_error(string("Unable to set group for '") + dev.name() + "'");
 		close(fd);
 	}
+
+	_ready = rdtsc();
+	return true;
+}
+
+void DriverProcess::wait() const {
+	// let the kernel wake us up as soon as the device is there. if that's not possible (it is not
+	// in the virtual fs), fall back to polling
+	int res = waitpath(_devices[_readyDevs].name().c_str(),WAIT_SLICE);
+	if(res < 0 && res != -ETIMEOUT)
+		usleep(RETRY_INTERVAL);
 }
 
 esc::IStream& operator >>(esc::IStream& is,Device& dev) {
@@ -135,13 +172,23 @@ esc::IStream& operator >>(esc::IStream& is,DriverProcess& drv) {
 		drv._args.push_back(arg);
 	}
 
-	/* read devices, if any */
+	/* read devices and requirements, if any */
 	if(is.good()) {
 		char c;
 		while((c = is.get()) == '\t') {
-			Device dev;
-			is >> dev;
-			drv._devices.push_back(dev);
+			std::string devline;
+			is.getline(devline);
+			esc::IStringStream devis(devline);
+			if(devline.compare(0,9,"requires ") == 0) {
+				string req;
+				devis >> req >> req;
+				drv._requires.push_back(req);
+			}
+			else {
+				Device dev;
+				devis >> dev;
+				drv._devices.push_back(dev);
+			}
 		}
 		is.putback(c);
 	}
@@ -155,6 +202,9 @@ esc::OStream& operator <<(esc::OStream& os,const DriverProcess& drv) {
 		os << '\t' << it->name() << ' ';
 		os << esc::fmt(it->permissions(),"0o",4) << ' ' << it->group() << '\n';
 	}
+	const vector<string>& reqs = drv.requirements();
+	for(auto it = reqs.begin(); it != reqs.end(); ++it)
+		os << "\trequires " << *it << '\n';
 	os << esc::endl;
 	return os;
 }
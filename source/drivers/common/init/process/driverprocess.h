@@ -22,6 +22,7 @@
 #include <esc/stream/istream.h>
 #include <esc/stream/ostream.h>
 #include <sys/common.h>
+#include <sys/time.h>
 #include <usergroup/usergroup.h>
 #include <string>
 #include <vector>
@@ -64,12 +65,14 @@ class DriverProcess : public Process {
 public:
 	static const int MAX_WAIT_RETRIES	= 1000;
 	static const int RETRY_INTERVAL		= 40000 /* us */;
+	static const time_t MAX_WAIT		= MAX_WAIT_RETRIES * RETRY_INTERVAL /* us */;
+	static const time_t WAIT_SLICE		= 100 /* ms */;
 
 private:
 	static sNamedItem *groupList;
 
 public:
-	DriverProcess() : Process(), _user(), _devices() {
+	DriverProcess() : Process(), _user(), _devices(), _requires(), _readyDevs(), _start(), _ready() {
 	}
 	virtual ~DriverProcess() {
 	}
@@ -83,18 +86,70 @@ public:
 	const std::vector<Device>& devices() const {
 		return _devices;
 	}
+	const std::vector<std::string>& requirements() const {
+		return _requires;
+	}
+
+	/**
+	 * @return the time in microseconds it took from starting the driver until all its devices
+	 *  were ready
+	 */
+	uint64_t loadTime() const {
+		return tsctotime(_ready - _start);
+	}
+
+	/**
+	 * @param path the path
+	 * @return true if this driver creates the device <path>
+	 */
+	bool provides(const std::string &path) const;
+
+	/**
+	 * Checks whether this driver has to wait for <drv>, i.e., whether <drv> provides a device that
+	 * is mentioned in our arguments (directly or as value of an environment variable) or in one of
+	 * our "requires" lines.
+	 *
+	 * @param drv the other driver
+	 * @return true if so
+	 */
+	bool needs(const DriverProcess &drv) const;
 
 	virtual void replace(const std::string &var,const std::string &value) {
 		Process::replace(var,value);
 		for(auto &d : _devices)
 			d.replace(var,value);
+		for(auto &r : _requires)
+			replace_var(r,var,value);
 	}
 
+	/**
+	 * Starts the driver and waits until all its devices are ready.
+	 */
 	virtual void load();
 
+	/**
+	 * Starts the driver without waiting for its devices.
+	 */
+	void spawn();
+	/**
+	 * Checks whether the devices of the driver are ready and sets their permissions, if so.
+	 * Throws if the driver died or did not create its devices in time.
+	 *
+	 * @return true if all devices are ready
+	 */
+	bool poll();
+	/**
+	 * Waits until the next device we're waiting for has been created or WAIT_SLICE has passed.
+	 */
+	void wait() const;
+
 private:
 	std::string _user;
 	std::vector<Device> _devices;
+	std::vector<std::string> _requires;
+	size_t _readyDevs;
+	uint64_t _start;
+	uint64_t _ready;
 };
 
 esc::IStream& operator >>(esc::IStream& is,Device& dev);
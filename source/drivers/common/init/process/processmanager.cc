@@ -27,6 +27,7 @@
 #include <sys/io.h>
 #include <sys/messages.h>
 #include <sys/thread.h>
+#include <sys/time.h>
 #include <vterm/vtctrl.h>
 #include <algorithm>
 #include <dirent.h>
@@ -55,18 +56,82 @@ void ProcessManager::start() {
 	esc::FStream ifs("/etc/init/drivers","r");
 	if(!ifs)
 		throw esc::default_error("Unable to open /etc/init/drivers");
+	vector<DriverProcess*> drvs;
 	while(ifs.good()) {
 		DriverProcess *drv = new DriverProcess();
 		ifs >> *drv;
 		_procs.push_back(drv);
+		drvs.push_back(drv);
 	}
 
 	// load processes
+	uint64_t start = rdtsc();
 	Progress pg(KERNEL_PERCENT,0,_procs.size());
-	for(auto  it = _procs.begin(); it != _procs.end(); ++it) {
-		pg.itemStarting(string("Loading ") + (*it)->name() + "...");
-		(*it)->load();
-		pg.itemLoaded();
+	loadAll(drvs,&pg);
+
+	esc::sout << "Driver startup took " << (tsctotime(rdtsc() - start) / 1000) << " ms:\n";
+	for(auto it = drvs.begin(); it != drvs.end(); ++it) {
+		esc::sout << "  " << esc::fmt((*it)->name(),"-",16) << " "
+			<< esc::fmt((*it)->loadTime() / 1000,6) << " ms\n";
+	}
+	esc::sout.flush();
+}
+
+void ProcessManager::loadAll(const vector<DriverProcess*> &drvs,Progress *pg) {
+	enum {
+		WAITING,
+		STARTED,
+		READY,
+	};
+
+	// dependencies are only allowed on earlier drivers, which prevents cycles
+	size_t count = drvs.size();
+	vector<vector<size_t>> deps(count);
+	for(size_t i = 0; i < count; ++i) {
+		for(size_t j = 0; j < i; ++j) {
+			if(drvs[i]->needs(*drvs[j]))
+				deps[i].push_back(j);
+		}
+	}
+
+	vector<int> states(count,WAITING);
+	for(size_t ready = 0; ready < count; ) {
+		// start all drivers whose dependencies are satisfied
+		for(size_t i = 0; i < count; ++i) {
+			if(states[i] != WAITING)
+				continue;
+
+			bool satisfied = true;
+			for(auto d = deps[i].begin(); satisfied && d != deps[i].end(); ++d)
+				satisfied = states[*d] == READY;
+			if(satisfied) {
+				if(pg)
+					pg->itemStarting(string("Loading ") + drvs[i]->name() + "...");
+				drvs[i]->spawn();
+				states[i] = STARTED;
+			}
+		}
+
+		// collect all drivers that are ready now
+		size_t oldReady = ready;
+		ssize_t oldest = -1;
+		for(size_t i = 0; i < count; ++i) {
+			if(states[i] != STARTED)
+				continue;
+
+			if(drvs[i]->poll()) {
+				states[i] = READY;
+				ready++;
+				if(pg)
+					pg->itemLoaded();
+			}
+			else if(oldest == -1)
+				oldest = i;
+		}
+
+		// if nothing happened, wait for the device the oldest driver is waiting for
+		if(ready == oldReady && oldest != -1)
+			drvs[oldest]->wait();
 	}
 }
 
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "../progress.h"
+#include "driverprocess.h"
 #include "process.h"
 
 class ProcessManager {
@@ -40,6 +41,16 @@ public:
 	~ProcessManager() {
 	}
 
+	/**
+	 * Loads the given drivers. Every driver is started as soon as the drivers it depends on
+	 * (see DriverProcess::needs) have created their devices, so that independent drivers are
+	 * started in parallel.
+	 *
+	 * @param drvs the drivers in the order of the configuration file
+	 * @param pg the progress bar to update (may be null)
+	 */
+	static void loadAll(const std::vector<DriverProcess*> &drvs,Progress *pg);
+
 	void start();
 	void restart(pid_t pid);
 	void shutdown();
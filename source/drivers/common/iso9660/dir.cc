@@ -69,6 +69,8 @@ ino_t ISO9660Dir::resolve(ISO9660FileSystem *h,A_UNUSED User *u,const char *path
 			return -ENOENT;
 		}
 
+		if(e->flags & ISO_FILEFL_DIR)
+			res = h->dirIno(e->extentLoc.littleEndian);
 		p += pos;
 
 		/* skip slashes */
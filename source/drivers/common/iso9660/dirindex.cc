@@ -0,0 +1,352 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <esc/util.h>
+#include <fs/blockcache.h>
+#include <sys/common.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dirindex.h"
+#include "iso9660.h"
+#include "rw.h"
+
+void ISO9660DirIndex::clear() {
+	for(size_t i = 0; i < _dirCount; ++i) {
+		free(_dirs[i].name);
+		free(_dirs[i].entries);
+		free(_dirs[i].names);
+	}
+	free(_dirs);
+	free(_nameHash);
+	free(_extHash);
+	_dirs = NULL;
+	_dirCount = 0;
+	_nameHash = _extHash = NULL;
+	_hashSize = 0;
+}
+
+int ISO9660DirIndex::init() {
+	size_t tblSize = _fs->primary.data.primary.pathTableSize.littleEndian;
+	block_t tblLoc = _fs->primary.data.primary.lPathTblLoc;
+	size_t blockSize = _fs->blockSize();
+	size_t blocks = (tblSize + blockSize - 1) / blockSize;
+	if(tblSize == 0 || tblLoc == 0)
+		return -ENOENT;
+
+	uint8_t *tbl = static_cast<uint8_t*>(malloc(blocks * blockSize));
+	if(!tbl)
+		return -ENOMEM;
+	if(ISO9660RW::readBlocks(_fs,tbl,tblLoc,blocks) != 0) {
+		free(tbl);
+		return -ENOBUFS;
+	}
+
+	/* count the entries first; each one is padded to an even length */
+	size_t count = 0;
+	for(size_t off = 0; off + sizeof(ISOPathTblEntry) <= tblSize; ) {
+		const ISOPathTblEntry *pe = reinterpret_cast<const ISOPathTblEntry*>(tbl + off);
+		if(pe->length == 0)
+			break;
+		off += sizeof(ISOPathTblEntry) + pe->length + (pe->length & 1);
+		count++;
+	}
+
+	int res = -ENOMEM;
+	_hashSize = 16;
+	while(_hashSize < count)
+		_hashSize *= 2;
+	_dirs = static_cast<Dir*>(calloc(count,sizeof(Dir)));
+	_dirCount = 0;
+	_nameHash = static_cast<ssize_t*>(malloc(_hashSize * sizeof(ssize_t)));
+	_extHash = static_cast<ssize_t*>(malloc(_hashSize * sizeof(ssize_t)));
+	if(!_dirs || !_nameHash || !_extHash)
+		goto error;
+	for(size_t i = 0; i < _hashSize; ++i)
+		_nameHash[i] = _extHash[i] = -1;
+
+	for(size_t i = 0, off = 0; i < count; ++i) {
+		const ISOPathTblEntry *pe = reinterpret_cast<const ISOPathTblEntry*>(tbl + off);
+		Dir *d = _dirs + i;
+		/* the table is sorted by parent, so that the parent always comes first */
+		if(pe->parentTblIndx == 0 || pe->parentTblIndx > i + 1 ||
+				off + sizeof(ISOPathTblEntry) + pe->length > tblSize) {
+			res = -EINVAL;
+			goto error;
+		}
+
+		d->extLoc = pe->extentLoc;
+		d->parent = pe->parentTblIndx - 1;
+		if(i > 0) {
+			d->name = static_cast<char*>(malloc(pe->length));
+			if(!d->name)
+				goto error;
+			d->nameLen = normalize(d->name,pe->name,pe->length);
+
+			size_t h = hashName(d->parent,d->name,d->nameLen) & (_hashSize - 1);
+			d->nameNext = _nameHash[h];
+			_nameHash[h] = i;
+		}
+		/* use the same hash function for the extent location */
+		size_t h = hashName(d->extLoc,"",0) & (_hashSize - 1);
+		d->extNext = _extHash[h];
+		_extHash[h] = i;
+
+		off += sizeof(ISOPathTblEntry) + pe->length + (pe->length & 1);
+		_dirCount++;
+	}
+
+	free(tbl);
+	return 0;
+
+error:
+	free(tbl);
+	clear();
+	return res;
+}
+
+ino_t ISO9660DirIndex::resolve(const char *path,ino_t root) {
+	ssize_t dir = root == 0 ? 0 : dirOf(root);
+	if(dir < 0)
+		return dir;
+
+	ino_t res = dirIno(dir);
+	bool isDir = true;
+	char name[NAME_LEN + 1];
+	const char *p = path;
+	while(*p) {
+		while(*p == '/')
+			p++;
+		/* "/" at the end is optional */
+		if(!*p)
+			break;
+
+		size_t len = strchri(p,'/');
+		const char *comp = p;
+		p += len;
+		if(!isDir)
+			return -ENOTDIR;
+		if(len > NAME_LEN)
+			return -ENOENT;
+
+		if(len == 1 && comp[0] == '.')
+			continue;
+		if(len == 2 && comp[0] == '.' && comp[1] == '.') {
+			dir = _dirs[dir].parent;
+			res = dirIno(dir);
+			continue;
+		}
+
+		for(size_t i = 0; i < len; ++i)
+			name[i] = tolower(comp[i]);
+
+		ssize_t sub = findDir(dir,name,len);
+		if(sub >= 0) {
+			_hits++;
+			dir = sub;
+			res = dirIno(dir);
+			continue;
+		}
+
+		const Entry *e = findEntry(dir,name,len);
+		if(e == NULL)
+			return -ENOENT;
+		if(e->dir) {
+			/* directories that are too deep for the path-table are not in the index */
+			dir = findExtent(e->extLoc);
+			if(dir < 0)
+				return -ENOENT;
+			res = dirIno(dir);
+		}
+		else {
+			isDir = false;
+			res = e->ino;
+		}
+	}
+	return res;
+}
+
+size_t ISO9660DirIndex::normalize(char *dst,const char *name,size_t len) {
+	size_t i;
+	for(i = 0; i < len && name[i] != ';'; ++i)
+		dst[i] = tolower(name[i]);
+	return i;
+}
+
+void ISO9660DirIndex::print(FILE *f) {
+	size_t loaded = 0,entries = 0;
+	for(size_t i = 0; i < _dirCount; ++i) {
+		if(_dirs[i].entries) {
+			loaded++;
+			entries += _dirs[i].count;
+		}
+	}
+	fprintf(f,"\tDirectories: %zu\n",_dirCount);
+	fprintf(f,"\tLoaded directories: %zu (%zu entries)\n",loaded,entries);
+	fprintf(f,"\tIndex hits: %lu\n",_hits);
+	fprintf(f,"\tDirectory loads: %lu\n",_loads);
+}
+
+size_t ISO9660DirIndex::hashName(size_t parent,const char *name,size_t len) {
+	size_t h = 2166136261u ^ parent;
+	for(size_t i = 0; i < len; ++i)
+		h = (h ^ (uchar)name[i]) * 16777619u;
+	return h ^ (h >> 15);
+}
+
+int ISO9660DirIndex::compare(const void *a,const void *b) {
+	const Entry *ea = static_cast<const Entry*>(a);
+	const Entry *eb = static_cast<const Entry*>(b);
+	int res = memcmp(ea->name,eb->name,esc::Util::min(ea->nameLen,eb->nameLen));
+	if(res != 0)
+		return res;
+	return (int)ea->nameLen - (int)eb->nameLen;
+}
+
+ino_t ISO9660DirIndex::dirIno(size_t dir) const {
+	return _fs->dirIno(_dirs[dir].extLoc);
+}
+
+ssize_t ISO9660DirIndex::findDir(size_t parent,const char *name,size_t len) const {
+	size_t h = hashName(parent,name,len) & (_hashSize - 1);
+	for(ssize_t i = _nameHash[h]; i != -1; i = _dirs[i].nameNext) {
+		const Dir *d = _dirs + i;
+		if(d->parent == parent && d->nameLen == len && memcmp(d->name,name,len) == 0)
+			return i;
+	}
+	return -ENOENT;
+}
+
+ssize_t ISO9660DirIndex::findExtent(block_t extLoc) const {
+	size_t h = hashName(extLoc,"",0) & (_hashSize - 1);
+	for(ssize_t i = _extHash[h]; i != -1; i = _dirs[i].extNext) {
+		if(_dirs[i].extLoc == extLoc)
+			return i;
+	}
+	return -ENOENT;
+}
+
+ssize_t ISO9660DirIndex::dirOf(ino_t ino) {
+	if(ino == _fs->rootDirId())
+		return 0;
+
+	const ISOCDirEntry *e = _fs->dirCache.get(ino);
+	if(e == NULL)
+		return -ENOBUFS;
+	if(!(e->entry.flags & ISO_FILEFL_DIR))
+		return -ENOTDIR;
+	return findExtent(e->entry.extentLoc.littleEndian);
+}
+
+const ISO9660DirIndex::Entry *ISO9660DirIndex::findEntry(size_t dir,const char *name,size_t len) {
+	Dir *d = _dirs + dir;
+	if(d->entries == NULL && loadEntries(d) < 0)
+		return NULL;
+
+	size_t lo = 0, hi = d->count;
+	while(lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		const Entry *e = d->entries + mid;
+		int res = memcmp(e->name,name,esc::Util::min(e->nameLen,len));
+		if(res == 0)
+			res = (int)e->nameLen - (int)len;
+		if(res == 0)
+			return e;
+		if(res < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+int ISO9660DirIndex::loadEntries(Dir *d) {
+	size_t blockSize = _fs->blockSize();
+	fs::CBlock *blk = _fs->blockCache.request(d->extLoc,fs::BlockCache::READ);
+	if(blk == NULL)
+		return -ENOBUFS;
+
+	/* the "." entry tells us the size of the extent */
+	const ISODirEntry *e = static_cast<const ISODirEntry*>(blk->buffer);
+	size_t extSize = e->extentSize.littleEndian;
+	/* every record has at least 33 bytes plus the name, padded to an even length */
+	size_t max = extSize / (sizeof(ISODirEntry) + 1) + 1;
+	d->entries = static_cast<Entry*>(malloc(max * sizeof(Entry)));
+	d->names = static_cast<char*>(malloc(extSize));
+	int res = -ENOMEM;
+	if(!d->entries || !d->names) {
+		_fs->blockCache.release(blk);
+		goto error;
+	}
+
+	_loads++;
+	d->count = 0;
+	for(size_t i = 0, off = 0, nameOff = 0; ; ) {
+		/* continue with next block? */
+		if((uintptr_t)e >= (uintptr_t)blk->buffer + blockSize || e->length == 0) {
+			_fs->blockCache.release(blk);
+			off += blockSize;
+			if(off >= extSize)
+				break;
+
+			blk = _fs->blockCache.request(d->extLoc + ++i,fs::BlockCache::READ);
+			if(blk == NULL) {
+				res = -ENOBUFS;
+				goto error;
+			}
+			e = static_cast<const ISODirEntry*>(blk->buffer);
+			continue;
+		}
+
+		bool special = e->nameLen == 1 &&
+			(e->name[0] == ISO_FILENAME_THIS || e->name[0] == ISO_FILENAME_PARENT);
+		if(!special && d->count < max && nameOff + e->nameLen <= extSize) {
+			Entry *ent = d->entries + d->count;
+			ent->name = d->names + nameOff;
+			ent->nameLen = normalize(d->names + nameOff,e->name,e->nameLen);
+			/* files with multiple extents have one record per extent; take the first one */
+			const Entry *prev = d->count > 0 ? ent - 1 : NULL;
+			if(!prev || prev->nameLen != ent->nameLen ||
+					memcmp(prev->name,ent->name,ent->nameLen) != 0) {
+				ent->extLoc = e->extentLoc.littleEndian;
+				ent->dir = e->flags & ISO_FILEFL_DIR;
+				if(ent->dir)
+					ent->ino = _fs->dirIno(ent->extLoc);
+				else
+					ent->ino = (d->extLoc + i) * blockSize + ((uintptr_t)e - (uintptr_t)blk->buffer);
+				nameOff += ent->nameLen;
+				d->count++;
+			}
+		}
+
+		e = reinterpret_cast<const ISODirEntry*>((uintptr_t)e + e->length);
+	}
+
+	qsort(d->entries,d->count,sizeof(Entry),compare);
+	return 0;
+
+error:
+	free(d->entries);
+	free(d->names);
+	d->entries = NULL;
+	d->names = NULL;
+	d->count = 0;
+	return res;
+}
@@ -0,0 +1,135 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <sys/common.h>
+#include <stdio.h>
+
+class ISO9660FileSystem;
+
+/**
+ * An index of all directories of the volume, built from the path-table at mount time. The
+ * directories are hashed by (parent,name) and by extent location, so that resolving a path does
+ * not need to read any directory extents. Files are found via a sorted array of the entries of
+ * their directory, which is loaded on first use and kept afterwards (the volume is read-only).
+ */
+class ISO9660DirIndex {
+	static const size_t NAME_LEN	= 255;
+
+	struct Entry {
+		/* points into Dir::names */
+		const char *name;
+		size_t nameLen;
+		ino_t ino;
+		block_t extLoc;
+		bool dir;
+	};
+
+	struct Dir {
+		block_t extLoc;
+		size_t parent;
+		/* normalized name; NULL for the root directory */
+		char *name;
+		size_t nameLen;
+		/* next directory in the name and the extent hash chain */
+		ssize_t nameNext;
+		ssize_t extNext;
+		/* the sorted entries; NULL until loaded */
+		Entry *entries;
+		size_t count;
+		char *names;
+	};
+
+public:
+	/**
+	 * Creates an empty index. Call init() to load the path-table.
+	 *
+	 * @param fs the iso9660 filesystem
+	 */
+	explicit ISO9660DirIndex(ISO9660FileSystem *fs)
+		: _fs(fs), _dirs(NULL), _dirCount(0), _nameHash(NULL), _extHash(NULL), _hashSize(0),
+		  _hits(0), _loads(0) {
+	}
+	~ISO9660DirIndex() {
+		clear();
+	}
+
+	/**
+	 * Reads the L-path-table of the primary volume descriptor and builds the directory index.
+	 *
+	 * @return 0 on success
+	 */
+	int init();
+
+	/**
+	 * @return true if the index has been built successfully
+	 */
+	bool available() const {
+		return _dirCount > 0;
+	}
+
+	/**
+	 * Resolves <path>, starting at <root>, to the inode number. Directories get the inode number
+	 * of their "." entry (see ISO9660FileSystem::dirIno).
+	 *
+	 * @param path the path
+	 * @param root the root inode (0 = root directory)
+	 * @return the inode number or a negative error-code
+	 */
+	ino_t resolve(const char *path,ino_t root);
+
+	/**
+	 * Normalizes the given name from the disk: the version number is removed and all
+	 * characters are converted to lowercase.
+	 *
+	 * @param dst the destination with room for <len> characters
+	 * @param name the name
+	 * @param len the length of <name>
+	 * @return the length of the normalized name
+	 */
+	static size_t normalize(char *dst,const char *name,size_t len);
+
+	/**
+	 * Prints information and statistics to the given file
+	 *
+	 * @param f the file
+	 */
+	void print(FILE *f);
+
+private:
+	void clear();
+	static size_t hashName(size_t parent,const char *name,size_t len);
+	static int compare(const void *a,const void *b);
+
+	ino_t dirIno(size_t dir) const;
+	ssize_t findDir(size_t parent,const char *name,size_t len) const;
+	ssize_t findExtent(block_t extLoc) const;
+	ssize_t dirOf(ino_t ino);
+	const Entry *findEntry(size_t dir,const char *name,size_t len);
+	int loadEntries(Dir *d);
+
+	ISO9660FileSystem *_fs;
+	Dir *_dirs;
+	size_t _dirCount;
+	ssize_t *_nameHash;
+	ssize_t *_extHash;
+	size_t _hashSize;
+	ulong _hits;
+	ulong _loads;
+};
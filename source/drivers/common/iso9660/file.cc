@@ -114,7 +114,10 @@ void ISO9660File::buildDirEntries(ISO9660FileSystem *h,block_t lba,uint8_t *dst,
 			memclear(de,((uintptr_t)cdst + blockSize) - (uintptr_t)de);
 			break;
 		}
-		de->d_ino = (lba * blockSize) + ((uintptr_t)e - (uintptr_t)src);
+		if(e->flags & ISO_FILEFL_DIR)
+			de->d_ino = h->dirIno(e->extentLoc.littleEndian);
+		else
+			de->d_ino = (lba * blockSize) + ((uintptr_t)e - (uintptr_t)src);
 		if(e->name[0] == ISO_FILENAME_THIS) {
 			de->d_namelen = 1;
 			de->d_name[0] = '.';
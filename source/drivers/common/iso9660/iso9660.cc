@@ -92,7 +92,10 @@ bool ISO9660FileSystem::ISO9660BlockCache::writeBlocks(const void *,size_t,size_
 
 ISO9660FileSystem::ISO9660FileSystem(const char *device)
 		: FileSystem(), fd(::open(device,O_RDONLY)), primary(), dummy(initPrimaryVol(this,device)),
-		  dirCache(this), blockCache(this) {
+		  dirCache(this), blockCache(this), dirIndex(this) {
+	/* without path-table, we walk the directories on every lookup */
+	if(dirIndex.init() != 0)
+		printe("Unable to load path-table; directory index disabled");
 }
 
 int ISO9660FileSystem::initPrimaryVol(ISO9660FileSystem *fs,const char *device) {
@@ -120,7 +123,14 @@ int ISO9660FileSystem::initPrimaryVol(ISO9660FileSystem *fs,const char *device)
 
 ino_t ISO9660FileSystem::open(fs::User *u,const char *path,ssize_t *,ino_t root,uint flags,mode_t,
 		int fd,fs::OpenFile **file) {
-	ino_t ino = ISO9660Dir::resolve(this,u,path,root,flags);
+	ino_t ino;
+	if(dirIndex.available()) {
+		ino = dirIndex.resolve(path,root);
+		if(ino == -ENOENT && (flags & O_CREAT))
+			ino = -EROFS;
+	}
+	else
+		ino = ISO9660Dir::resolve(this,u,path,root,flags);
 	if(ino < 0)
 		return ino;
 	*file = new fs::OpenFile(fd,ino);
@@ -220,6 +230,8 @@ void ISO9660FileSystem::print(FILE *f) {
 	blockCache.printStats(f);
 	fprintf(f,"Directory entry cache:\n");
 	dirCache.print(f);
+	fprintf(f,"Directory index:\n");
+	dirIndex.print(f);
 }
 
 #if DEBUGGING
@@ -27,6 +27,7 @@
 
 #include "common.h"
 #include "direcache.h"
+#include "dirindex.h"
 
 static const size_t ATAPI_SECTOR_SIZE		= 2048;
 static const size_t ISO_BCACHE_SIZE			= 1024;
@@ -190,6 +191,18 @@ public:
 	ino_t rootDirId() const {
 		return blockSize();
 	}
+	/**
+	 * Directories can be reached via several entries (their entry in the parent, "." and ".."),
+	 * so that they are always identified by the "." entry at the beginning of their extent.
+	 *
+	 * @param extLoc the location of the directory extent
+	 * @return the inode number of the directory
+	 */
+	ino_t dirIno(block_t extLoc) const {
+		if(extLoc == primary.data.primary.rootDir.extentLoc.littleEndian)
+			return rootDirId();
+		return extLoc * blockSize();
+	}
 
 	ino_t open(fs::User *u,const char *path,ssize_t *sympos,ino_t root,uint flags,mode_t mode,
 		int fd,fs::OpenFile **file) override;
@@ -240,4 +253,5 @@ public:
 	int dummy;
 	ISO9660DirCache dirCache;
 	ISO9660BlockCache blockCache;
+	ISO9660DirIndex dirIndex;
 };
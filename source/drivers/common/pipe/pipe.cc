@@ -19,114 +19,116 @@
 
 #include <esc/ipc/clientdevice.h>
 #include <esc/ipc/requestqueue.h>
+#include <esc/vthrow.h>
 #include <sys/common.h>
+#include <sys/pipe.h>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static ulong buffer[IPC_DEF_SIZE / sizeof(ulong)];
 
-class VarRingBuf {
+/**
+ * The ring buffer of a pipe in a shared memory file, which clients can map (see sys/pipe.h). For
+ * the clients that use read and write, the driver acts as the producer or consumer, so that both
+ * ways can be mixed.
+ */
+class PipeRing {
 public:
-	explicit VarRingBuf(size_t size) : _data(new uint8_t[size]), _size(size), _rdpos(), _wrpos(), _last() {
+	explicit PipeRing() : _fd(), _ring(), _refs(2) {
+		_fd = createbuf(PIPE_RING_DATA + PIPE_RING_SIZE,(void**)&_ring,0);
+		if(_fd < 0)
+			VTHROWE("createbuf",_fd);
+		memset(_ring,0,PIPE_RING_DATA);
 	}
-	~VarRingBuf() {
-		delete[] _data;
+	~PipeRing() {
+		destroybuf(_ring,_fd);
 	}
 
-	void *push(size_t size) {
-		if(_wrpos >= _rdpos) {
-			if(_size - _wrpos >= size) {
-				_wrpos += size;
-				return _data + _wrpos - size;
-			}
-			else if(_rdpos > size) {
-				_last = _wrpos;
-				_wrpos = size;
-				return _data;
-			}
-		}
-		else if(_rdpos - _wrpos > size) {
-			_wrpos += size;
-			return _data + _wrpos - size;
-		}
-		return NULL;
+	int fd() const {
+		return _fd;
+	}
+	tPipeRing *get() {
+		return _ring;
 	}
 
-	void *pull(size_t *size) {
-		if(_wrpos == _rdpos)
-			return NULL;
-
-		if(_rdpos == _last) {
-			_rdpos = 0;
-			_last = 0;
-		}
-		if(_wrpos > _rdpos)
-			*size = std::min(_wrpos - _rdpos,*size);
-		else
-			*size = std::min(_size - _rdpos,*size);
-		void *res = _data + _rdpos;
-		_rdpos += *size;
-		return res;
+	/**
+	 * Releases one reference (one for each end) and deletes the ring if it was the last one.
+	 */
+	void release() {
+		if(--_refs == 0)
+			delete this;
 	}
 
 private:
-	uint8_t *_data;
-	size_t _size;
-	size_t _rdpos;
-	size_t _wrpos;
-	size_t _last;
+	int _fd;
+	tPipeRing *_ring;
+	int _refs;
 };
 
 class PipeClient : public esc::Client {
 public:
-	enum {
-		RINGBUF_SIZE	= 128 * 1024
-	};
 	enum {
 		FL_READ			= 1,
 		FL_WRITE		= 2
 	};
 
 	explicit PipeClient(int f,uint _flags = FL_WRITE)
-		: esc::Client(f), partner(), pendingRead(), pendingWrite(), ringbuf(), flags(_flags) {
-		if(flags & FL_READ)
-			ringbuf = new VarRingBuf(RINGBUF_SIZE);
+		: esc::Client(f), partner(), ring(), pendingRead(), pendingWrite(), pendingWait(),
+		  flags(_flags) {
 	}
-	virtual ~PipeClient() {
-		delete ringbuf;
+
+	/**
+	 * Answers all pending requests that can be answered now.
+	 */
+	void wakeup() {
+		replyRead();
+		replyWrite();
+		replyWait();
 	}
 
 	void replyRead() {
 		if(pendingRead.count == 0)
 			return;
 
-		/* check how much we can/want pull out of the ringbuffer */
-		size_t size = pendingRead.count;
-		void *data = ringbuf->pull(&size);
-		if(!data) {
+		tPipeRing *r = ring->get();
+		size_t avail = pipering_used(r);
+		if(avail == 0) {
+			if(partner && mustWait(1))
+				return;
+
 			/* EOF */
-			if(partner == NULL) {
+			avail = pipering_used(r);
+			if(avail == 0) {
 				esc::IPCStream is(pendingRead.fd,buffer,sizeof(buffer),pendingRead.mid);
 				is << esc::FileRead::Response::success(0) << esc::Reply();
 				pendingRead.count = 0;
+				return;
 			}
-			return;
 		}
 
 		/* reply that data */
 		esc::IPCStream is(pendingRead.fd,buffer,sizeof(buffer),pendingRead.mid);
-		if(pendingRead.offset != (size_t)-1)
-			memcpy(shm() + pendingRead.offset,data,size);
-		is << esc::FileRead::Response::success(size) << esc::Reply();
-		if(pendingRead.offset == (size_t)-1)
-			is << esc::ReplyData(data,size);
+		size_t size = esc::Util::min(avail,pendingRead.count);
+		if(pendingRead.offset != (size_t)-1) {
+			pipering_get(r,shm() + pendingRead.offset,size);
+			is << esc::FileRead::Response::success(size) << esc::Reply();
+		}
+		else {
+			/* only reply the contiguous part to send it directly from the ring */
+			size_t off = r->rdpos & (PIPE_RING_SIZE - 1);
+			size = esc::Util::min(size,(size_t)PIPE_RING_SIZE - off);
+			is << esc::FileRead::Response::success(size) << esc::Reply();
+			is << esc::ReplyData(pipering_data(r) + off,size);
+			pipering_commitread(r,size);
+		}
 
 		/* invalidate pending read */
 		pendingRead.count = 0;
-		/* check if we can write new data now */
+		/* check if the writer can continue now */
 		if(partner)
-			partner->replyWrite();
+			partner->wakeup();
 	}
 
 	void replyWrite() {
@@ -142,46 +144,91 @@ public:
 			is << esc::FileWrite::Response::error(-EDESTROYED) << esc::Reply();
 			delete[] pendingWrite.data;
 			pendingWrite.count = 0;
+			return;
 		}
-		else {
-			/* try to get a push-position */
-			void *pos = partner->ringbuf->push(pendingWrite.count);
-			if(pos) {
-				esc::IPCStream is(pendingWrite.fd,buffer,sizeof(buffer),pendingWrite.mid);
-				if(pendingWrite.offset == (size_t)-1) {
-					/* if we had to allocate the data, write it from there */
-					if(pendingWrite.data) {
-						memcpy(pos,pendingWrite.data,pendingWrite.count);
-						delete[] pendingWrite.data;
-					}
-					/* otherwise read it directly to that position */
-					else
-						is >> esc::ReceiveData(pos,pendingWrite.count);
-				}
-				/* copy from shared memory */
-				else
-					memcpy(pos,shm() + pendingWrite.offset,pendingWrite.count);
-
-				/* reply and invalidate */
-				is << esc::FileWrite::Response::result(pendingWrite.count) << esc::Reply();
-				pendingWrite.count = 0;
-				/* check if somebody wanted to read */
-				partner->replyRead();
-			}
+
+		tPipeRing *r = ring->get();
+		if(pipering_free(r) < pendingWrite.count && mustWait(pendingWrite.count)) {
 			/* if we don't have space atm, we still have to read the data-message */
-			else if(!pendingWrite.data && pendingWrite.offset == (size_t)-1) {
+			if(!pendingWrite.data && pendingWrite.offset == (size_t)-1) {
 				esc::IPCStream is(pendingWrite.fd,buffer,sizeof(buffer),pendingWrite.mid);
 				pendingWrite.data = new char[pendingWrite.count];
 				is >> esc::ReceiveData(pendingWrite.data,pendingWrite.count);
 			}
+			return;
 		}
+
+		esc::IPCStream is(pendingWrite.fd,buffer,sizeof(buffer),pendingWrite.mid);
+		if(pendingWrite.offset == (size_t)-1) {
+			/* if we had to allocate the data, write it from there */
+			if(pendingWrite.data) {
+				pipering_put(r,pendingWrite.data,pendingWrite.count);
+				delete[] pendingWrite.data;
+			}
+			else {
+				/* receive it directly into the ring, if it fits without wrapping around */
+				size_t off = r->wrpos & (PIPE_RING_SIZE - 1);
+				if(PIPE_RING_SIZE - off >= pendingWrite.count) {
+					is >> esc::ReceiveData(pipering_data(r) + off,pendingWrite.count);
+					pipering_commitwrite(r,pendingWrite.count);
+				}
+				else {
+					char *tmp = new char[pendingWrite.count];
+					is >> esc::ReceiveData(tmp,pendingWrite.count);
+					pipering_put(r,tmp,pendingWrite.count);
+					delete[] tmp;
+				}
+			}
+		}
+		/* copy from shared memory */
+		else
+			pipering_put(r,shm() + pendingWrite.offset,pendingWrite.count);
+
+		/* reply and invalidate */
+		is << esc::FileWrite::Response::result(pendingWrite.count) << esc::Reply();
+		pendingWrite.count = 0;
+		/* check if somebody wanted to read */
+		partner->wakeup();
+	}
+
+	void replyWait() {
+		if(pendingWait.count == 0)
+			return;
+		if(partner && mustWait(1))
+			return;
+
+		esc::IPCStream is(pendingWait.fd,buffer,sizeof(buffer),pendingWait.mid);
+		is << (errcode_t)0 << esc::Reply();
+		pendingWait.count = 0;
 	}
 
 	PipeClient *partner;
+	PipeRing *ring;
 	esc::Request pendingRead;
 	esc::Request pendingWrite;
-	VarRingBuf *ringbuf;
+	esc::Request pendingWait;
 	uint flags;
+
+private:
+	/**
+	 * Sets the wait flag of this end, so that the other end wakes us up, and checks again whether
+	 * we still have to wait afterwards.
+	 *
+	 * @param count the number of bytes we need to continue
+	 * @return true if we have to wait
+	 */
+	bool mustWait(size_t count) {
+		tPipeRing *r = ring->get();
+		volatile long *flag = (flags & FL_READ) ? &r->rdwait : &r->wrwait;
+		*flag = 1;
+		__sync_synchronize();
+		size_t avail = (flags & FL_READ) ? pipering_used(r) : pipering_free(r);
+		if(avail >= count) {
+			*flag = 0;
+			return false;
+		}
+		return true;
+	}
 };
 
 class PipeDevice : public esc::ClientDevice<PipeClient> {
@@ -194,6 +241,9 @@ public:
 		set(MSG_FILE_READ,std::make_memfun(this,&PipeDevice::read));
 		set(MSG_FILE_WRITE,std::make_memfun(this,&PipeDevice::write));
 		set(MSG_FILE_CLOSE,std::make_memfun(this,&PipeDevice::close));
+		set(MSG_PIPE_ISPIPE,std::make_memfun(this,&PipeDevice::ispipe));
+		set(MSG_PIPE_WAIT,std::make_memfun(this,&PipeDevice::wait));
+		set(MSG_PIPE_WAKE,std::make_memfun(this,&PipeDevice::wake),false);
 	}
 
 	void cancel(esc::IPCStream &is) {
@@ -207,6 +257,7 @@ public:
 			 * kernel that we do that but just cancel the request in every case */
 			if(c->pendingWrite.count > 0 && c->pendingWrite.mid == r.mid) {
 				res = esc::DevCancel::CANCELED;
+				delete[] c->pendingWrite.data;
 				c->pendingWrite.count = 0;
 			}
 		}
@@ -225,19 +276,29 @@ public:
 		esc::DevObtain::Request r;
 		is >> r;
 
+		if(r.arg == OBT_ARG_PIPERING) {
+			/* both ends get full access, because the consumer has to update its position */
+			if(c->ring)
+				is << esc::DevObtain::Response::success(c->ring->fd(),O_RDWR) << esc::Reply();
+			else
+				is << esc::DevObtain::Response::error(-ENOTSUP) << esc::Reply();
+			return;
+		}
+
 		int res = 0;
-		if(c->flags != PipeClient::FL_WRITE)
+		if(c->flags != PipeClient::FL_WRITE || c->partner)
 			res = -EINVAL;
 		else {
-			res = createchan(id(),O_RDONLY);
+			res = createchan(id(),O_RDONLY | O_MSGS);
 			if(res >= 0) {
 				PipeClient *nc = new PipeClient(res,PipeClient::FL_READ);
+				nc->ring = c->ring = new PipeRing();
 				nc->partner = c;
 				c->partner = nc;
 				add(res,nc);
 			}
 		}
-		is << esc::DevObtain::Response::result(res,O_RDONLY) << esc::Reply();
+		is << esc::DevObtain::Response::result(res,O_RDONLY | O_MSGS) << esc::Reply();
 	}
 
 	void read(esc::IPCStream &is) {
@@ -256,7 +317,8 @@ public:
 
 		c->pendingRead.fd = is.fd();
 		c->pendingRead.mid = is.msgid();
-		c->pendingRead.count = r.count;
+		/* we never reply more than the ring can hold */
+		c->pendingRead.count = esc::Util::min(r.count,(size_t)PIPE_RING_SIZE);
 		c->pendingRead.offset = r.shmemoff;
 		c->replyRead();
 	}
@@ -267,7 +329,7 @@ public:
 		is >> r;
 
 		int res = 0;
-		if(c->pendingWrite.count != 0 || r.count > PipeClient::RINGBUF_SIZE) {
+		if(c->pendingWrite.count != 0 || r.count > PIPE_RING_SIZE) {
 			res = -EINVAL;
 			goto error;
 		}
@@ -291,21 +353,48 @@ public:
 		is << esc::FileWrite::Response::result(res) << esc::Reply();
 	}
 
+	void ispipe(esc::IPCStream &is) {
+		is << (errcode_t)0 << esc::Reply();
+	}
+
+	void wait(esc::IPCStream &is) {
+		PipeClient *c = (*this)[is.fd()];
+		if(!c->ring || c->pendingWait.count != 0) {
+			is << (errcode_t)-EINVAL << esc::Reply();
+			return;
+		}
+
+		c->pendingWait.fd = is.fd();
+		c->pendingWait.mid = is.msgid();
+		c->pendingWait.count = 1;
+		c->replyWait();
+	}
+
+	void wake(esc::IPCStream &is) {
+		PipeClient *c = (*this)[is.fd()];
+		if(c->partner)
+			c->partner->wakeup();
+	}
+
 	void close(esc::IPCStream &is) {
 		PipeClient *c = (*this)[is.fd()];
+		if(c->ring) {
+			/* let the mapped ends know that this end is gone */
+			c->ring->get()->closed |= (c->flags & PipeClient::FL_WRITE) ? PIPE_WRCLOSED : PIPE_RDCLOSED;
+			__sync_synchronize();
+		}
 		if(c->partner) {
 			c->partner->partner = NULL;
-			if(c->flags & PipeClient::FL_WRITE)
-				c->partner->replyRead();
-			else
-				c->partner->replyWrite();
+			c->partner->wakeup();
 		}
+		if(c->ring)
+			c->ring->release();
 		esc::ClientDevice<PipeClient>::close(is);
 	}
 };
 
 int main() {
-	PipeDevice dev("/dev/pipe",0600);
+	PipeDevice dev("/dev/pipe",0700);
 	dev.loop();
 	return EXIT_SUCCESS;
 }
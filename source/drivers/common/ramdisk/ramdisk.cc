@@ -18,7 +18,9 @@
  */
 
 #include <esc/ipc/clientdevice.h>
+#include <esc/proto/device.h>
 #include <sys/common.h>
+#include <sys/io.h>
 #include <sys/mman.h>
 #include <usergroup/usergroup.h>
 #include <assert.h>
@@ -26,15 +28,51 @@
 
 using namespace esc;
 
-class RamDiskDevice : public ClientDevice<> {
+class RamDiskClient : public Client {
 public:
-	explicit RamDiskDevice(const char *name,mode_t mode,size_t disksize,char *diskaddr)
+	explicit RamDiskClient(int fd,uint _flags = 0) : Client(fd), flags(_flags) {
+	}
+
+	uint flags;
+};
+
+/**
+ * The disk memory is a shared memory file, which is handed out to clients via obtain(), so that
+ * they can map it directly (DAX) instead of copying blocks via read and write.
+ */
+class RamDiskDevice : public ClientDevice<RamDiskClient> {
+public:
+	explicit RamDiskDevice(const char *name,mode_t mode,size_t disksize,char *diskaddr,int diskfd)
 		: ClientDevice(name,mode,DEV_TYPE_BLOCK,
-			DEV_OPEN | DEV_DELEGATE | DEV_READ | DEV_WRITE | DEV_SIZE | DEV_CLOSE),
-		  _disksize(disksize), _diskaddr(diskaddr) {
+			DEV_OPEN | DEV_DELEGATE | DEV_OBTAIN | DEV_READ | DEV_WRITE | DEV_SIZE | DEV_CLOSE),
+		  _disksize(disksize), _diskaddr(diskaddr), _diskfd(diskfd) {
+		set(MSG_FILE_OPEN,std::make_memfun(this,&RamDiskDevice::open));
 		set(MSG_FILE_READ,std::make_memfun(this,&RamDiskDevice::read));
 		set(MSG_FILE_WRITE,std::make_memfun(this,&RamDiskDevice::write));
 		set(MSG_FILE_SIZE,std::make_memfun(this,&RamDiskDevice::size));
+		set(MSG_DEV_OBTAIN,std::make_memfun(this,&RamDiskDevice::obtain));
+	}
+
+	void open(IPCStream &is) {
+		char buffer[MAX_PATH_LEN];
+		FileOpen::Request r(buffer,sizeof(buffer));
+		is >> r;
+
+		add(is.fd(),new RamDiskClient(is.fd(),r.flags));
+		is << FileOpen::Response::success(0) << Reply();
+	}
+
+	void obtain(IPCStream &is) {
+		RamDiskClient *c = (*this)[is.fd()];
+		DevObtain::Request r;
+		is >> r;
+
+		// clients get the same access to the memory as to the device
+		uint perm = c->flags & O_RDWR;
+		if(r.arg != OBT_ARG_DAX || perm == 0)
+			is << DevObtain::Response::error(-EINVAL) << Reply();
+		else
+			is << DevObtain::Response::success(_diskfd,perm) << Reply();
 	}
 
 	void read(IPCStream &is) {
@@ -81,6 +119,7 @@ private:
 
 	size_t _disksize;
 	char *_diskaddr;
+	int _diskfd;
 };
 
 static void usage(const char *name) {
@@ -113,19 +152,28 @@ int main(int argc,char **argv) {
 	else
 		usage(argv[0]);
 
-	/* mmap file or anonymous memory */
-	char *diskaddr = static_cast<char*>(
-		mmap(NULL,size,argc > 2 ? size : 0,PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0));
-	if(!diskaddr)
-		error("mmap failed");
-	if(fd != -1)
+	/* create a shared memory file for the disk, so that clients can map it */
+	void *diskaddr;
+	int diskfd = createbuf(size,&diskaddr,0);
+	if(diskfd < 0)
+		error("Unable to create disk memory");
+
+	/* load the image into it */
+	if(fd != -1) {
+		for(size_t pos = 0; pos < size; ) {
+			ssize_t res = read(fd,static_cast<char*>(diskaddr) + pos,size - pos);
+			if(res <= 0)
+				error("Unable to read module '%s'",image);
+			pos += res;
+		}
 		close(fd);
+	}
 
 	/* handle device */
-	RamDiskDevice ramdisk(device,0660,size,diskaddr);
+	RamDiskDevice ramdisk(device,0660,size,static_cast<char*>(diskaddr),diskfd);
 	ramdisk.loop();
 
 	/* clean up */
-	munmap(diskaddr);
+	destroybuf(diskaddr,diskfd);
 	return EXIT_SUCCESS;
 }
@@ -56,7 +56,9 @@ struct TarINode {
 	}
 
 	struct stat info;
+	/* the offset of the content in the archive */
 	off_t offset;
+	/* the content, if it has been changed (otherwise it is read from the archive) */
 	char *data;
 	size_t datasize;
 
@@ -79,7 +81,15 @@ public:
 
 class RegularFile : public BlockFile {
 public:
-	explicit RegularFile(esc::PathTreeItem<TarINode> *item,FILE *archive,int flags)
+	/**
+	 * Creates a file for <item>, whose content is read from the mapped archive until it is
+	 * changed.
+	 *
+	 * @param item the tree item
+	 * @param archive the mapped archive (may be NULL if it is empty)
+	 * @param flags the open flags
+	 */
+	explicit RegularFile(esc::PathTreeItem<TarINode> *item,const char *archive,int flags)
 		: _file(item->getData()), _archive(archive) {
 		if(flags & O_TRUNC) {
 			if(_file->data) {
@@ -88,15 +98,27 @@ public:
 			}
 			setSize(0);
 		}
+	}
 
-		if(_file->data == NULL) {
-			_file->datasize = esc::Util::max((off_t)1024,_file->info.st_size);
-			_file->data = (char*)malloc(_file->datasize);
-			if(_file->info.st_size > 0) {
-				fseek(_archive,_file->offset,SEEK_SET);
-				fread(_file->data,_file->info.st_size,1,_archive);
-			}
-		}
+	/**
+	 * Copies the content of <file> from the mapped archive into memory, so that it can be
+	 * changed or written back.
+	 *
+	 * @param file the file
+	 * @param archive the mapped archive
+	 * @return 0 on success
+	 */
+	static int load(TarINode *file,const char *archive) {
+		if(file->data)
+			return 0;
+		size_t size = esc::Util::max((off_t)1024,file->info.st_size);
+		file->data = (char*)malloc(size);
+		if(!file->data)
+			return -ENOMEM;
+		file->datasize = size;
+		if(file->info.st_size > 0)
+			memcpy(file->data,archive + file->offset,file->info.st_size);
+		return 0;
 	}
 
 	virtual ssize_t read(void *buf,size_t offset,size_t count) {
@@ -104,12 +126,19 @@ public:
 			return -EINVAL;
 		if((off_t)(offset + count) > _file->info.st_size)
 			count = _file->info.st_size - offset;
-		memcpy(buf,_file->data + offset,count);
+		// as long as it is unchanged, serve it directly from the mapping
+		if(_file->data)
+			memcpy(buf,_file->data + offset,count);
+		else if(count > 0)
+			memcpy(buf,_archive + _file->offset + offset,count);
 		_file->info.st_atime = time(NULL);
 		return count;
 	}
 
 	virtual ssize_t write(const void *buf,size_t offset,size_t count) {
+		int res;
+		if((res = load(_file,_archive)) < 0)
+			return res;
 		if(offset + count > _file->datasize) {
 			char *ndata = (char*)realloc(_file->data,offset + count);
 			if(!ndata)
@@ -125,6 +154,9 @@ public:
 	}
 
 	virtual int truncate(off_t length) {
+		int res;
+		if((res = load(_file,_archive)) < 0)
+			return res;
 		if(_file->info.st_size < length) {
 			if(_file->datasize < (size_t)length) {
 				char *ndata = (char*)realloc(_file->data,length);
@@ -147,7 +179,7 @@ private:
 
 	// don't need to add a reference here; OpenFile has one already
 	TarINode *_file;
-	FILE *_archive;
+	const char *_archive;
 };
 
 class DirFile : public BlockFile {
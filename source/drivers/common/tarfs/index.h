@@ -0,0 +1,221 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <esc/pathtree.h>
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/mman.h>
+#include <sys/proc.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "file.h"
+
+/**
+ * A compact sidecar index for a tar archive, so that mounting it does not require to walk
+ * through all headers of the archive. The index is stored next to the archive as
+ * "<archive>.idx" and is only used if the size and modification time of the archive match.
+ * Since both are easy to forge and the index determines the modes and owners of all files, it
+ * is furthermore only used if it is owned by the owner of the archive (or by us, because we
+ * have created it) and not writable by anybody else.
+ */
+class TarIndex {
+	static const uint32_t MAGIC		= 0x58444954;	// "TIDX"
+	static const uint32_t VERSION	= 1;
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t archiveSize;
+		uint64_t archiveMtime;
+		uint32_t count;
+		uint32_t strsize;
+	} A_PACKED;
+
+	struct Entry {
+		uint64_t offset;
+		uint64_t size;
+		uint64_t mtime;
+		uint32_t mode;
+		uint32_t uid;
+		uint32_t gid;
+		uint32_t name;
+	} A_PACKED;
+
+public:
+	/**
+	 * Creates an empty index for the given archive
+	 *
+	 * @param archive the archive info
+	 */
+	explicit TarIndex(const struct stat &archive) : _archive(archive), _entries(), _names() {
+	}
+
+	/**
+	 * Builds the sidecar path for <archive> into <path>.
+	 */
+	static void getPath(char *path,size_t size,const char *archive) {
+		snprintf(path,size,"%s.idx",archive);
+	}
+
+	/**
+	 * Adds the given file to the index. The files have to be added in archive order.
+	 *
+	 * @param path the path in the archive
+	 * @param file the inode
+	 */
+	void add(const char *path,const TarINode *file) {
+		Entry e;
+		e.offset = file->offset;
+		e.size = file->info.st_size;
+		e.mtime = file->info.st_mtime;
+		e.mode = file->info.st_mode;
+		e.uid = file->info.st_uid;
+		e.gid = file->info.st_gid;
+		e.name = _names.size();
+		_entries.push_back(e);
+		for(; *path; ++path)
+			_names.push_back(*path);
+		_names.push_back('\0');
+	}
+
+	/**
+	 * Writes the index to <path>.
+	 *
+	 * @param path the path of the index
+	 * @return 0 on success
+	 */
+	int store(const char *path) const {
+		FILE *f = fopen(path,"w");
+		if(!f)
+			return -errno;
+
+		Header h;
+		h.magic = MAGIC;
+		h.version = VERSION;
+		h.archiveSize = _archive.st_size;
+		h.archiveMtime = _archive.st_mtime;
+		h.count = _entries.size();
+		h.strsize = _names.size();
+		// nobody but us may be able to change the index (see load)
+		bool ok = fchmod(fileno(f),S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0;
+		if(ok)
+			ok = fwrite(&h,sizeof(h),1,f) == 1;
+		if(ok && h.count)
+			ok = fwrite(&_entries[0],sizeof(Entry),h.count,f) == h.count;
+		if(ok && h.strsize)
+			ok = fwrite(&_names[0],1,h.strsize,f) == h.strsize;
+		fclose(f);
+		if(!ok) {
+			(void)unlink(path);
+			return -ENOSPC;
+		}
+		return 0;
+	}
+
+	/**
+	 * Loads the index at <path> into <tree>, if it belongs to the archive described by
+	 * <archive>. The index is checked completely before anything is inserted, so that a corrupt
+	 * index is rejected and the caller can fall back to walking through the archive. An index that
+	 * could have been written by somebody else than the archive owner or us is rejected as well.
+	 *
+	 * @param path the path of the index
+	 * @param archive the archive info
+	 * @param tree the tree to insert the files into
+	 * @return 0 on success or a negative error-code (nothing has been inserted in this case)
+	 */
+	static int load(const char *path,const struct stat &archive,esc::PathTree<TarINode> &tree) {
+		int fd = open(path,O_RDONLY);
+		if(fd < 0)
+			return fd;
+
+		int res = -EPERM;
+		struct stat info;
+		if(fstat(fd,&info) < 0 || !S_ISREG(info.st_mode))
+			goto errClose;
+		if(info.st_uid != archive.st_uid && info.st_uid != getuid())
+			goto errClose;
+		if(info.st_mode & (S_IWGRP | S_IWOTH))
+			goto errClose;
+
+		res = -EINVAL;
+		off_t size;
+		size = info.st_size;
+		if(size < (off_t)sizeof(Header))
+			goto errClose;
+
+		{
+			const char *idx = (const char*)mmap(NULL,size,size,PROT_READ,MAP_PRIVATE,fd,0);
+			if(!idx) {
+				res = -ENOMEM;
+				goto errClose;
+			}
+
+			const Header *h = (const Header*)idx;
+			if(h->magic != MAGIC || h->version != VERSION ||
+					h->archiveSize != (uint64_t)archive.st_size ||
+					h->archiveMtime != (uint64_t)archive.st_mtime ||
+					sizeof(Header) + (uint64_t)h->count * sizeof(Entry) + h->strsize != (uint64_t)size) {
+				munmap((void*)idx);
+				goto errClose;
+			}
+
+			const Entry *entries = (const Entry*)(h + 1);
+			const char *names = (const char*)(entries + h->count);
+			for(uint32_t i = 0; i < h->count; ++i) {
+				if(!isValid(entries + i,names,h->strsize,archive.st_size)) {
+					munmap((void*)idx);
+					goto errClose;
+				}
+			}
+
+			for(uint32_t i = 0; i < h->count; ++i) {
+				const Entry *e = entries + i;
+				TarINode *file = new TarINode(e->mtime,e->size,e->mode);
+				file->offset = e->offset;
+				file->info.st_uid = e->uid;
+				file->info.st_gid = e->gid;
+				tree.insert(names + e->name,file);
+			}
+			munmap((void*)idx);
+			res = 0;
+		}
+
+	errClose:
+		close(fd);
+		return res;
+	}
+
+private:
+	static bool isValid(const Entry *e,const char *names,uint32_t strsize,uint64_t archiveSize) {
+		// the file has to be within the archive
+		if(e->offset > archiveSize || e->size > archiveSize - e->offset)
+			return false;
+		// the name has to be within the string table and null-terminated
+		return e->name < strsize && memchr(names + e->name,'\0',strsize - e->name) != NULL;
+	}
+
+	struct stat _archive;
+	std::vector<Entry> _entries;
+	std::vector<char> _names;
+};
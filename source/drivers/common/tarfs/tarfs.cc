@@ -25,6 +25,7 @@
 #include <fs/permissions.h>
 #include <sys/common.h>
 #include <sys/endian.h>
+#include <sys/mman.h>
 #include <sys/proc.h>
 #include <sys/stat.h>
 #include <usergroup/usergroup.h>
@@ -33,6 +34,7 @@
 #include <time.h>
 
 #include "file.h"
+#include "index.h"
 
 using namespace esc;
 using namespace fs;
@@ -44,10 +46,11 @@ static sNamedItem *userList = nullptr;
 static sNamedItem *groupList = nullptr;
 static PathTree<TarINode> tree;
 static bool changed = false;
+static bool indexed = false;
 
 struct OpenTarFile : public OpenFile {
 	explicit OpenTarFile(int f,const char *_path = NULL,PathTreeItem<TarINode> *_item = NULL,
-			FILE *_archive = NULL,int _flags = 0)
+			const char *_archive = NULL,int _flags = 0)
 		: OpenFile(f), flags(_flags), path(_path), file(_item->getData()), bfile() {
 		if(S_ISDIR(_item->getData()->info.st_mode))
 			bfile = new DirFile(_item,tree);
@@ -89,8 +92,9 @@ struct OpenTarFile : public OpenFile {
 
 class TarFileSystem : public FileSystem<OpenTarFile> {
 public:
-	explicit TarFileSystem(FILE *archive) : FileSystem<OpenTarFile>(), _archive(archive) {
-		init(_archive);
+	explicit TarFileSystem(const char *archive,const struct stat &info)
+		: FileSystem<OpenTarFile>(), _archive(archive) {
+		init(info);
 	}
 
 	ino_t open(User *u,const char *path,ssize_t *,ino_t root,uint flags,mode_t mode,int fd,OpenTarFile **file) override  {
@@ -130,6 +134,32 @@ public:
 		return 0;
 	}
 
+	int pathstat(User *u,const char *path,ssize_t *sympos,ino_t root,uint flags,int fd,
+			struct stat *info) override {
+		/* resolve paths relative to a different root inode in the same way as open() does */
+		if(root != 0)
+			return FileSystem<OpenTarFile>::pathstat(u,path,sympos,root,flags,fd,info);
+
+		char cpath[MAX_PATH_LEN];
+		cleanpath(cpath,sizeof(cpath),path);
+
+		const char *end = NULL;
+		PathTreeItem<TarINode> *tfile = tree.find(cpath,&end);
+		if(tfile == NULL || *end != '\0')
+			return -ENOENT;
+		if(!canReach(u,tfile))
+			return -EPERM;
+
+		*info = tfile->getData()->info;
+		return 0;
+	}
+
+	int entrystat(User *u,OpenTarFile *dir,const char *name,struct stat *info) override {
+		char path[MAX_PATH_LEN];
+		snprintf(path,sizeof(path),"%s/%s",dir->path.c_str(),name);
+		return pathstat(u,path,NULL,0,O_NOFOLLOW,dir->fd(),info);
+	}
+
 	ssize_t read(OpenTarFile *file,void *data,off_t pos,size_t count) override {
 		return file->read(data,pos,count);
 	}
@@ -294,24 +324,39 @@ public:
 	void print(FILE *f) override {
 		fprintf(f,"file : %s\n",archiveFile);
 		fprintf(f,"dirty: %s\n",changed ? "yes" : "no");
+		fprintf(f,"index: %s\n",indexed ? "yes" : "no");
 	}
 
 private:
-	void init(FILE *f) {
+	void init(const struct stat &info) {
 		// add root directory
 		tree.insert("/",new TarINode(time(NULL),0,S_IFDIR | 0777));
 
-		Tar::FileHeader header;
-		off_t total = filesize(fileno(f));
+		// try the sidecar index first, which spares us walking through the whole archive
+		char ipath[MAX_PATH_LEN];
+		TarIndex::getPath(ipath,sizeof(ipath),archiveFile);
+		if(TarIndex::load(ipath,info,tree) == 0) {
+			indexed = true;
+			return;
+		}
+
+		TarIndex index(info);
+		off_t total = info.st_size;
 		off_t offset = 0;
-		while(offset < total) {
-			Tar::readHeader(f,offset,&header);
+		while(offset + Tar::BLOCK_SIZE <= total) {
+			const Tar::FileHeader &header = *(const Tar::FileHeader*)(_archive + offset);
 			if(header.filename[0] == '\0')
 				break;
 
+			size_t fsize = strtoul(header.size,NULL,8);
+			if(offset + Tar::BLOCK_SIZE + (off_t)fsize > total) {
+				printe("File '%.100s' exceeds the archive",header.filename);
+				break;
+			}
+
 			TarINode *tarfile = new TarINode(
 				strtoul(header.mtime,NULL,8),
-				strtoul(header.size,NULL,8),
+				fsize,
 				strtoul(header.mode,NULL,8)
 			);
 			tarfile->offset = offset + Tar::BLOCK_SIZE;
@@ -346,12 +391,18 @@ private:
 					tarfile->info.st_gid = g->id;
 			}
 
-			tree.insert(header.filename,tarfile);
+			// the name is not necessarily null-terminated
+			char name[sizeof(header.filename) + 1];
+			strnzcpy(name,header.filename,sizeof(name));
+			tree.insert(name,tarfile);
+			index.add(name,tarfile);
 
 			// to next header
-			size_t fsize = strtoul(header.size,NULL,8);
 			offset += (fsize + Tar::BLOCK_SIZE * 2 - 1) & ~(Tar::BLOCK_SIZE - 1);
 		}
+
+		// it's no error if we can't store it (e.g., the archive lies on a read-only fs)
+		indexed = index.store(ipath) == 0;
 	}
 
 	bool canReach(User *u,PathTreeItem<TarINode> *file) {
@@ -365,23 +416,20 @@ private:
 		return true;
 	}
 
-	FILE *_archive;
+	const char *_archive;
 };
 
 static char buffer[Tar::BLOCK_SIZE];
 static off_t offset = 0;
 
-static void loadRec(FILE *f,const std::string &path) {
+static void loadRec(const char *archive,const std::string &path) {
 	PathTreeItem<TarINode> *dir = tree.find(path.c_str());
 	assert(dir != NULL);
 	for(auto it = tree.begin(dir); it != tree.end(); ++it) {
 		if(S_ISDIR(it->getData()->info.st_mode))
-			loadRec(f,path + "/" + it->getName());
-		else if(it->getData()->data == NULL && it->getData()->info.st_size > 0) {
-			it->getData()->data = new char[it->getData()->info.st_size];
-			fseek(f,it->getData()->offset,SEEK_SET);
-			fread(it->getData()->data,it->getData()->info.st_size,1,f);
-		}
+			loadRec(archive,path + "/" + it->getName());
+		else if(RegularFile::load(it->getData(),archive) < 0)
+			error("Unable to load '%s/%s' into memory",path.c_str(),it->getName());
 	}
 }
 
@@ -432,12 +480,23 @@ int main(int argc,char **argv) {
 
 	archiveFile = abspath(apath,sizeof(apath),argv[2]);
 
-	FILE *ar = fopen(archiveFile,"r");
-	if(ar == NULL)
+	int fd = open(archiveFile,O_RDONLY);
+	if(fd < 0)
 		error("Unable to open '%s' for reading",archiveFile);
+	struct stat info;
+	if(fstat(fd,&info) < 0)
+		error("Unable to stat '%s'",archiveFile);
+
+	// map the archive and serve all reads from there; the pages are loaded on demand
+	char *ar = NULL;
+	if(info.st_size > 0) {
+		ar = (char*)mmap(NULL,info.st_size,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(ar == NULL)
+			error("Unable to map '%s'",archiveFile);
+	}
 
 	{
-		TarFileSystem fs(ar);
+		TarFileSystem fs(ar,info);
 		FSDevice<OpenTarFile> dev(&fs,argv[1]);
 		dev.loop();
 	}
@@ -445,7 +504,9 @@ int main(int argc,char **argv) {
 	// if there was a change, first load all files into memory
 	if(changed)
 		loadRec(ar,"");
-	fclose(ar);
+	if(ar)
+		munmap(ar);
+	close(fd);
 	// now write the entire file again
 	if(changed) {
 		FILE *f = fopen(archiveFile,"w");
@@ -455,6 +516,11 @@ int main(int argc,char **argv) {
 		}
 		else
 			printe("Unable to open '%s' for writing",archiveFile);
+
+		// the index is stale now; it is rebuilt on the next mount
+		char ipath[MAX_PATH_LEN];
+		TarIndex::getPath(ipath,sizeof(ipath),archiveFile);
+		(void)unlink(ipath);
 	}
 	return 0;
 }
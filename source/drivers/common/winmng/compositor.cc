@@ -0,0 +1,239 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <esc/util.h>
+#include <esc/vthrow.h>
+#include <sys/common.h>
+#include <sys/thread.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "compositor.h"
+#include "preview.h"
+#include "winlist.h"
+
+Compositor *Compositor::_inst;
+
+Compositor::Compositor()
+	: _width(), _height(), _cols(), _rows(), _bytespp(), _format(), _dirty(), _dirtyCount(),
+	  _changed(), _pending(), _lastFrame(), _sem(), _stack(), _visible(), _spans(), _next() {
+	if(usemcrt(&_sem,0) < 0)
+		error("Unable to create compositor semaphore");
+	if(startthread(thread,this) < 0)
+		error("Unable to start compositor thread");
+}
+
+void Compositor::setMode(const esc::Screen::Mode &mode) {
+	gui::PixelFormat *format = gui::PixelFormat::create(mode);
+	if(!format)
+		VTHROWE("Unsupported color depth " << mode.bitsPerPixel,-ENOTSUP);
+	delete _format;
+	_format = format;
+
+	_width = mode.width;
+	_height = mode.height;
+	_bytespp = mode.bitsPerPixel / 8;
+	_cols = (_width + TILE_SIZE - 1) / TILE_SIZE;
+	_rows = (_height + TILE_SIZE - 1) / TILE_SIZE;
+
+	/* the old screen content is meaningless now. we don't wake up the frame thread here, because
+	 * the windows will send updates anyway, after they have been reset */
+	_dirty.assign(_cols * _rows,1);
+	_dirtyCount = _dirty.size();
+	_changed = gui::Rectangle();
+}
+
+bool Compositor::clip(gui::Rectangle &r) const {
+	r = gui::intersection(r,gui::Rectangle(0,0,_width,_height));
+	return !r.empty();
+}
+
+void Compositor::wakeup() {
+	/* the frame thread takes one element from the semaphore per frame */
+	if(!_pending) {
+		_pending = true;
+		usemup(&_sem);
+	}
+}
+
+void Compositor::damage(const gui::Rectangle &r) {
+	gui::Rectangle rect(r);
+	if(!clip(rect))
+		return;
+
+	size_t tx1 = rect.x() / TILE_SIZE;
+	size_t tx2 = (rect.x() + rect.width() - 1) / TILE_SIZE;
+	size_t ty1 = rect.y() / TILE_SIZE;
+	size_t ty2 = (rect.y() + rect.height() - 1) / TILE_SIZE;
+	for(size_t ty = ty1; ty <= ty2; ++ty) {
+		uint8_t *tile = &_dirty[ty * _cols];
+		for(size_t tx = tx1; tx <= tx2; ++tx) {
+			_dirtyCount += !tile[tx];
+			tile[tx] = 1;
+		}
+	}
+	wakeup();
+}
+
+void Compositor::notify(const gui::Rectangle &r) {
+	gui::Rectangle rect(r);
+	if(!clip(rect))
+		return;
+
+	_changed = _changed.empty() ? rect : gui::unify(_changed,rect);
+	wakeup();
+}
+
+void Compositor::flush() {
+	WinList &wl = WinList::get();
+	_pending = false;
+	_lastFrame = tsctotime(rdtsc());
+
+	if(_dirtyCount > 0) {
+		/* collect the windows that are ready, from top to bottom */
+		_stack.clear();
+		for(auto w = wl.windows.begin(); w != wl.windows.end(); ++w) {
+			if(w->ready)
+				_stack.push_back(&*w);
+		}
+		std::sort(_stack.begin(),_stack.end(),[](const Window *a,const Window *b) {
+			return a->z > b->z;
+		});
+
+		/* composite each run of dirty tiles within a row of tiles */
+		for(size_t ty = 0; ty < _rows; ++ty) {
+			uint8_t *tiles = &_dirty[ty * _cols];
+			for(size_t tx = 0; tx < _cols; ) {
+				if(!tiles[tx]) {
+					tx++;
+					continue;
+				}
+
+				size_t start = tx;
+				while(tx < _cols && tiles[tx])
+					tiles[tx++] = 0;
+
+				gui::Rectangle r(start * TILE_SIZE,ty * TILE_SIZE,
+					(tx - start) * TILE_SIZE,TILE_SIZE);
+				if(clip(r)) {
+					composite(r);
+					Preview::get().updateRect(wl.fb->addr(),r);
+					_changed = _changed.empty() ? r : gui::unify(_changed,r);
+				}
+			}
+		}
+		_dirtyCount = 0;
+	}
+
+	if(!_changed.empty()) {
+		wl.ui->update(_changed.x(),_changed.y(),_changed.width(),_changed.height());
+		_changed = gui::Rectangle();
+	}
+}
+
+void Compositor::composite(const gui::Rectangle &r) {
+	/* determine the windows that are involved, keeping the order */
+	_visible.clear();
+	for(auto w = _stack.begin(); w != _stack.end(); ++w) {
+		if(!gui::intersection(**w,r).empty())
+			_visible.push_back(*w);
+	}
+
+	/* walk through the rectangle in bands of rows, in which no window begins or ends. thus, the
+	 * visible parts of the windows are the same for all rows of a band */
+	gpos_t end = r.y() + r.height();
+	for(gpos_t y = r.y(); y < end; ) {
+		gpos_t bandEnd = end;
+		for(auto w = _visible.begin(); w != _visible.end(); ++w) {
+			gpos_t wtop = (*w)->y();
+			gpos_t wbottom = wtop + (*w)->height();
+			if(wtop > y && wtop < bandEnd)
+				bandEnd = wtop;
+			if(wbottom > y && wbottom < bandEnd)
+				bandEnd = wbottom;
+		}
+
+		/* start with the whole row and let the windows take their parts, front to back */
+		_spans.clear();
+		_spans.push_back(Span {r.x(),r.x() + (gpos_t)r.width()});
+		for(auto w = _visible.begin(); w != _visible.end() && !_spans.empty(); ++w) {
+			if((*w)->y() <= y && (*w)->y() + (gpos_t)(*w)->height() > y)
+				paint(*w,y,bandEnd);
+		}
+
+		/* clear what is not covered by any window */
+		uint8_t *fb = reinterpret_cast<uint8_t*>(WinList::get().fb->addr());
+		size_t stride = _width * _bytespp;
+		for(auto s = _spans.begin(); s != _spans.end(); ++s) {
+			_format->fillRect(fb + y * stride + s->begin * _bytespp,stride,
+				s->end - s->begin,bandEnd - y,0);
+		}
+		y = bandEnd;
+	}
+}
+
+void Compositor::paint(Window *w,gpos_t y,gpos_t end) {
+	gpos_t wleft = w->x();
+	gpos_t wright = wleft + w->width();
+	esc::FrameBuffer *winbuf = w->getBuffer();
+	uint8_t *fb = reinterpret_cast<uint8_t*>(WinList::get().fb->addr());
+	size_t dstride = _width * _bytespp;
+	size_t sstride = w->width() * _bytespp;
+
+	_next.clear();
+	for(auto s = _spans.begin(); s != _spans.end(); ++s) {
+		gpos_t begin = esc::Util::max(s->begin,wleft);
+		gpos_t finish = esc::Util::min(s->end,wright);
+		if(begin >= finish) {
+			_next.push_back(*s);
+			continue;
+		}
+
+		/* the window covers [begin, finish). without a buffer, we keep the old content */
+		if(winbuf) {
+			const uint8_t *src = reinterpret_cast<uint8_t*>(winbuf->addr()) +
+				(y - w->y()) * sstride + (begin - wleft) * _bytespp;
+			_format->copyRows(fb + y * dstride + begin * _bytespp,dstride,src,sstride,
+				finish - begin,end - y);
+		}
+		if(s->begin < begin)
+			_next.push_back(Span {s->begin,begin});
+		if(finish < s->end)
+			_next.push_back(Span {finish,s->end});
+	}
+	_spans.swap(_next);
+}
+
+int Compositor::thread(void *arg) {
+	Compositor *comp = reinterpret_cast<Compositor*>(arg);
+	while(1) {
+		/* wait for damage */
+		usemdown(&comp->_sem);
+
+		/* don't produce more than one frame per FRAME_TIME */
+		uint64_t now = tsctotime(rdtsc());
+		uint64_t next = comp->_lastFrame + FRAME_TIME;
+		if(now < next)
+			usleep(next - now);
+
+		WinList::get().flush();
+	}
+	return 0;
+}
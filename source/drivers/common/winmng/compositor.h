@@ -0,0 +1,109 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <esc/proto/ui.h>
+#include <gui/graphics/pixelformat.h>
+#include <gui/graphics/rectangle.h>
+#include <sys/common.h>
+#include <sys/sync.h>
+#include <vector>
+
+#include "window.h"
+
+/**
+ * The compositor collects the damaged screen areas in a grid of tiles and composites only the
+ * dirty tiles once per frame. Afterwards, a single update for the changed area is sent to the
+ * ui-manager. All methods except the frame thread expect the window-lock to be held.
+ */
+class Compositor {
+	explicit Compositor();
+
+	struct Span {
+		gpos_t begin;
+		gpos_t end;
+	};
+
+public:
+	/* the width and height of a tile in pixels */
+	static const gsize_t TILE_SIZE		= 64;
+	/* the minimum time between two frames in microseconds */
+	static const uint64_t FRAME_TIME	= 16666;
+
+	static void create() {
+		_inst = new Compositor();
+	}
+	static Compositor &get() {
+		return *_inst;
+	}
+
+	/**
+	 * Sets the screen mode to composite for. This marks the whole screen as damaged.
+	 *
+	 * @param mode the new mode
+	 */
+	void setMode(const esc::Screen::Mode &mode);
+
+	/**
+	 * Marks the given area of the screen as damaged, so that it is composited from the window
+	 * buffers in the next frame.
+	 *
+	 * @param r the rectangle
+	 */
+	void damage(const gui::Rectangle &r);
+
+	/**
+	 * Marks the given area of the screen as changed, so that the ui-manager is notified about
+	 * it in the next frame. In contrast to damage(), the framebuffer has already been updated.
+	 *
+	 * @param r the rectangle
+	 */
+	void notify(const gui::Rectangle &r);
+
+	/**
+	 * Composites all dirty tiles and notifies the ui-manager about the changed area.
+	 */
+	void flush();
+
+private:
+	bool clip(gui::Rectangle &r) const;
+	void wakeup();
+	void composite(const gui::Rectangle &r);
+	void paint(Window *w,gpos_t y,gpos_t end);
+	static int thread(void *arg);
+
+	gsize_t _width;
+	gsize_t _height;
+	size_t _cols;
+	size_t _rows;
+	size_t _bytespp;
+	gui::PixelFormat *_format;
+	std::vector<uint8_t> _dirty;
+	size_t _dirtyCount;
+	gui::Rectangle _changed;
+	bool _pending;
+	uint64_t _lastFrame;
+	tUserSem _sem;
+	std::vector<Window*> _stack;
+	std::vector<Window*> _visible;
+	std::vector<Span> _spans;
+	std::vector<Span> _next;
+	static Compositor *_inst;
+};
@@ -105,11 +105,11 @@ void Window::resize(const gui::Rectangle &r) {
 
 		if(r.width() < oldWidth) {
 			gui::Rectangle nrect(this->x() + r.width(),this->y(),oldWidth - r.width(),oldHeight);
-			WinList::get().repaint(nrect,NULL,-1);
+			WinList::get().repaint(nrect);
 		}
 		if(r.height() < oldHeight) {
 			gui::Rectangle nrect(this->x(),this->y() + r.height(),oldWidth,oldHeight - r.height());
-			WinList::get().repaint(nrect,NULL,-1);
+			WinList::get().repaint(nrect);
 		}
 	}
 
@@ -133,15 +133,15 @@ void Window::moveTo(const gui::Rectangle &r) {
 	if(!rects.empty()) {
 		/* if there is an intersection, use the splitted parts */
 		for(auto rect = rects.begin(); rect != rects.end(); ++rect)
-			WinList::get().repaint(*rect,NULL,-1);
+			WinList::get().repaint(*rect);
 	}
 	else {
 		/* no intersection, so use the whole old rectangle */
-		WinList::get().repaint(orect,NULL,-1);
+		WinList::get().repaint(orect);
 	}
 
 	/* repaint new position */
-	WinList::get().repaint(r,this,z);
+	WinList::get().repaint(r);
 }
 
 void Window::sendActive(bool isActive,const gui::Pos &mouse) {
@@ -27,6 +27,7 @@
 
 static const gwinid_t WINID_UNUSED	= -1;
 
+class Compositor;
 class Input;
 class InfoDev;
 class WinList;
@@ -46,6 +47,7 @@ public:
 };
 
 class Window : public WinRect {
+	friend class Compositor;
 	friend class Input;
 	friend class InfoDev;
 	friend class WinList;
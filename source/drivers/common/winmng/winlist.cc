@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "compositor.h"
 #include "input.h"
 #include "stack.h"
 #include "winlist.h"
@@ -71,6 +72,7 @@ int WinList::setMode(int id) {
 		::print("Creating new framebuffer");
 		std::unique_ptr<esc::FrameBuffer> newfb(
 			new esc::FrameBuffer(newmode,esc::Screen::MODE_TYPE_GUI));
+		Compositor::get().setMode(newmode);
 		::print("Setting mode %d: %zux%zux%u",newmode.id,newmode.width,newmode.height,newmode.bitsPerPixel);
 		ui->setMode(esc::Screen::MODE_TYPE_GUI,newmode.id,newfb->fd(),true);
 
@@ -84,6 +86,7 @@ int WinList::setMode(int id) {
 		::printe("%s",e.what());
 		::print("Restoring old framebuffer and mode");
 		fb = new esc::FrameBuffer(mode,esc::Screen::MODE_TYPE_GUI);
+		Compositor::get().setMode(mode);
 		ui->setMode(esc::Screen::MODE_TYPE_GUI,mode.id,fb->fd(),true);
 		/* we have to repaint everything */
 		for(auto w = windows.begin(); w != windows.end(); ++w)
@@ -125,7 +128,7 @@ void WinList::remove(Window *win) {
 	windows.remove(win);
 
 	/* repaint window-area */
-	repaint(*win,NULL,-1);
+	repaint(*win);
 
 	/* delete window */
 	delete win;
@@ -261,7 +264,7 @@ void WinList::setActive(Window *win,bool repaint,bool updateWinStack) {
 		win->notifyWinActive();
 
 		if(repaint && win->style != Window::STYLE_DESKTOP)
-			this->repaint(*win,win,win->z);
+			this->repaint(*win);
 	}
 }
 
@@ -271,8 +274,11 @@ void WinList::resize(gwinid_t wid,const gui::Rectangle &r,bool finished) {
 	if(win) {
 		if(finished)
 			win->resize(r);
-		else
+		else {
+			/* the preview saves the screen content, which has to be up to date */
+			Compositor::get().flush();
 			Preview::get().set(fb->addr(),r,2);
+		}
 	}
 }
 
@@ -283,8 +289,10 @@ void WinList::moveTo(gwinid_t wid,const gui::Pos &pos,bool finished) {
 		gui::Rectangle r(pos,win->getSize());
 		if(finished)
 			win->moveTo(r);
-		else
+		else {
+			Compositor::get().flush();
 			Preview::get().set(fb->addr(),r,2);
+		}
 	}
 }
 
@@ -301,13 +309,7 @@ int WinList::update(gwinid_t wid,const gui::Rectangle &r) {
 void WinList::update(Window *win,const gui::Rectangle &r) {
 	win->ready = true;
 
-	gui::Rectangle rect(win->x() + r.x(),win->y() + r.y(),r.width(),r.height());
-	if(validateRect(rect)) {
-		if(topWindow == win->id())
-			copyRegion(fb->addr(),rect,win->id());
-		else
-			repaint(rect,win,win->z);
-	}
+	repaint(gui::Rectangle(win->x() + r.x(),win->y() + r.y(),r.width(),r.height()));
 }
 
 void WinList::sendKeyEvent(const esc::UIEvents::Event &data) {
@@ -343,144 +345,17 @@ void WinList::sendMouseEvent(gwinid_t wid,const gui::Pos &mouse,const esc::UIEve
 	send(win->evfd,MSG_WIN_EVENT,&ev,sizeof(ev));
 }
 
-bool WinList::validateRect(gui::Rectangle &r) {
-	if(r.x() < 0) {
-		if(-r.x() > (gpos_t)r.width())
-			return false;
-
-		r.setSize(r.width() + r.x(),r.height());
-		r.setPos(0,r.y());
-	}
-
-	if(r.x() >= (gpos_t)mode.width || r.y() >= (gpos_t)mode.height)
-		return false;
-
-	gsize_t width = esc::Util::min((gsize_t)mode.width - r.x(),r.width());
-	gsize_t height = esc::Util::min((gsize_t)mode.height - r.y(),r.height());
-	r.setSize(width,height);
-	return true;
-}
-
-void WinList::repaint(const gui::Rectangle &r,Window *win,gpos_t z) {
-	std::vector<WinRect> rects;
-	getRepaintRegions(rects,windows.begin(),win,z,r);
-	for(auto rect = rects.begin(); rect != rects.end(); ++rect) {
-		/* validate rect */
-		if(!validateRect(*rect))
-			continue;
-
-		/* if it doesn't belong to a window, we have to clear it */
-		if(rect->id() == WINID_UNUSED)
-			clearRegion(fb->addr(),*rect);
-		/* otherwise copy from the window buffer. only do that if we either want to update the
-		 * screen or if it's from the specific window we want to update */
-		else if(!win || rect->id() == win->id())
-			copyRegion(fb->addr(),*rect,rect->id());
-	}
-}
-
-void WinList::getRepaintRegions(std::vector<WinRect> &list,esc::DListTreap<Window>::iterator w,
-		Window *win,gpos_t z,const gui::Rectangle &r) {
-	/* we walk through the window list exactly once, even when recursing, because we do not change
-	 * the parameters in recursive call in such a way that we have to check the previous windows
-	 * again. this is because we do only split the rectangle */
-	for(; w != windows.end(); ) {
-		auto next = w;
-		++next;
-
-		/* skip unused, ourself and rects behind ourself */
-		if((win && w->id() == win->id()) || w->z < z || !w->ready) {
-			w = next;
-			continue;
-		}
-
-		/* substract the window-rectangle from r */
-		std::vector<gui::Rectangle> rects = gui::substraction(r,*w);
-		bool rec = false;
-
-		gui::Rectangle inter = gui::intersection(*w,r);
-		if(!inter.empty()) {
-			getRepaintRegions(list,next,&*w,w->z,inter);
-			rec = true;
-		}
-
-		/* split all by all other windows */
-		for(auto rect = rects.begin(); rect != rects.end(); ++rect) {
-			getRepaintRegions(list,next,win,z,*rect);
-			rec = true;
-		}
-
-		/* if we made a recursive call we can leave here */
-		if(rec)
-			return;
-
-		w = next;
-	}
-
-	/* no split, so its on top */
-	WinRect final(r);
-	if(win)
-		final.key(win->id());
-	else
-		final.key(WINID_UNUSED);
-	list.push_back(final);
-}
-
-void WinList::clearRegion(char *mem,const gui::Rectangle &r) {
-	gpos_t y = r.y();
-	size_t pxsize = mode.bitsPerPixel / 8;
-	size_t count = r.width() * pxsize;
-	gpos_t maxy = y + r.height();
-	mem += (y * mode.width + r.x()) * pxsize;
-	while(y < maxy) {
-		memclear(mem,count);
-		mem += mode.width * pxsize;
-		y++;
-	}
-
-	Preview::get().updateRect(mem,r);
-	notifyUimng(r);
+void WinList::repaint(const gui::Rectangle &r) {
+	Compositor::get().damage(r);
 }
 
-void WinList::copyRegion(char *mem,const gui::Rectangle &r,gwinid_t id) {
-	Window *w = get(id);
-	/* ignore that if we don't have a framebuffer yet */
-	esc::FrameBuffer *winbuf = w->getBuffer();
-	if(!winbuf)
-		return;
-
-	gpos_t x = r.x() - w->x();
-	gpos_t y = r.y() - w->y();
-
-	gpos_t endy = y + r.height();
-	size_t pxsize = mode.bitsPerPixel / 8;
-	size_t count = r.width() * pxsize;
-	size_t srcAdd = w->width() * pxsize;
-	size_t dstAdd = mode.width * pxsize;
-	char *src = winbuf->addr() + (y * w->width() + x) * pxsize;
-	char *dst = mem + ((w->y() + y) * mode.width + (w->x() + x)) * pxsize;
-
-	while(y < endy) {
-		memcpy(dst,src,count);
-		src += srcAdd;
-		dst += dstAdd;
-		y++;
-	}
-
-	gui::Rectangle rect(gui::Pos(w->x() + x,w->y() + (endy - r.height())),r.getSize());
-	Preview::get().updateRect(mem,rect);
-	notifyUimng(rect);
+void WinList::flush() {
+	std::lock_guard<std::mutex> guard(winMutex);
+	Compositor::get().flush();
 }
 
 void WinList::notifyUimng(const gui::Rectangle &r) {
-	gpos_t x = r.x();
-	gsize_t width = r.width();
-	if(x < 0) {
-		width += x;
-		x = 0;
-	}
-	ui->update(x,r.y(),esc::Util::min((gsize_t)mode.width - x,width),
-		esc::Util::min((gsize_t)mode.height - r.y(),r.height()));
+	Compositor::get().notify(r);
 }
 
 void WinList::print(esc::OStream &os) {
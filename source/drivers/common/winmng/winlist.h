@@ -31,6 +31,7 @@
 #include "window.h"
 
 class WinList {
+	friend class Compositor;
 	friend class Window;
 
 	explicit WinList(int sid,esc::UI *ui,int mode);
@@ -213,6 +214,11 @@ public:
 	 */
 	int update(gwinid_t wid,const gui::Rectangle &r);
 
+	/**
+	 * Composites the damaged areas of the screen and notifies the UI-manager about the changes.
+	 */
+	void flush();
+
 	/**
 	 * Removes the preview rectangle, if necessary.
 	 */
@@ -221,7 +227,8 @@ public:
 	}
 
 	/**
-	 * Notifies the UI-manager that the given rectangle has changed.
+	 * Notifies the UI-manager that the given rectangle has changed. This is done with the next
+	 * frame, together with all other changes.
 	 *
 	 * @param r the rectangle
 	 */
@@ -259,14 +266,9 @@ private:
 
 	void remove(Window *win);
 	void setActive(Window *win,bool repaint,bool updateWinStack);
-	void repaint(const gui::Rectangle &r,Window *win,gpos_t z);
+	void repaint(const gui::Rectangle &r);
 	void update(Window *win,const gui::Rectangle &r);
 	void resetAll();
-	bool validateRect(gui::Rectangle &r);
-	void getRepaintRegions(std::vector<WinRect> &list,esc::DListTreap<Window>::iterator w,
-		Window *win,gpos_t z,const gui::Rectangle &r);
-	void clearRegion(char *mem,const gui::Rectangle &r);
-	void copyRegion(char *mem,const gui::Rectangle &r,gwinid_t id);
 
 	esc::UI *ui;
 	int drvId;
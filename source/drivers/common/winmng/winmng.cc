@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "compositor.h"
 #include "input.h"
 #include "listener.h"
 #include "preview.h"
@@ -294,6 +295,7 @@ int main(int argc,char *argv[]) {
 	UIEvents *uiev = new UIEvents(*ui);
 
 	esc::Screen::Mode mode = ui->findGraphicsMode(atoi(argv[1]),atoi(argv[2]),DEF_BPP);
+	Compositor::create();
 	WinList::create(windev.id(),ui,mode.id);
 
 	/* start helper modules */
@@ -19,7 +19,9 @@
 
 #include <sys/arch/x86/ports.h>
 #include <sys/common.h>
+#include <esc/util.h>
 #include <sys/debug.h>
+#include <sys/mman.h>
 #include <sys/proc.h>
 #include <signal.h>
 #include <stdio.h>
@@ -31,25 +33,41 @@
 
 static bool ata_setupCommand(sATADevice *device,uint64_t lba,size_t secCount,uint cmd);
 static uint ata_getCommand(sATADevice *device,uint op);
+static size_t ata_buildPRDT(sATAController *ctrl,const void *buffer,size_t size,size_t secSize);
 
 bool ata_readWrite(sATADevice *device,uint op,void *buffer,uint64_t lba,size_t secSize,
 		size_t secCount) {
 	uint cmd = ata_getCommand(device,op);
-	if(!ata_setupCommand(device,lba,secCount,cmd))
-		return false;
-
 	switch(cmd) {
 		case COMMAND_PACKET:
 		case COMMAND_READ_SEC:
 		case COMMAND_READ_SEC_EXT:
 		case COMMAND_WRITE_SEC:
 		case COMMAND_WRITE_SEC_EXT:
+			if(!ata_setupCommand(device,lba,secCount,cmd))
+				return false;
 			return ata_transferPIO(device,op,buffer,secSize,secCount,true);
+
 		case COMMAND_READ_DMA:
 		case COMMAND_READ_DMA_EXT:
 		case COMMAND_WRITE_DMA:
-		case COMMAND_WRITE_DMA_EXT:
-			return ata_transferDMA(device,op,buffer,secSize,secCount);
+		case COMMAND_WRITE_DMA_EXT: {
+			/* the sector count is limited to 8 or 16 bits */
+			size_t max = device->info.features.lba48 ? 0xFFFF : 0xFF;
+			uint8_t *buf = (uint8_t*)buffer;
+			while(secCount > 0) {
+				/* usually, the whole request is done with one command */
+				size_t count = ata_prepareDMA(device,buf,secSize,esc::Util::min(secCount,max));
+				if(!ata_setupCommand(device,lba,count,cmd))
+					return false;
+				if(!ata_transferDMA(device,op,buf,secSize,count))
+					return false;
+				buf += count * secSize;
+				lba += count;
+				secCount -= count;
+			}
+			return true;
+		}
 	}
 	return false;
 }
@@ -90,16 +108,38 @@ bool ata_transferPIO(sATADevice *device,uint op,void *buffer,size_t secSize,
 	return true;
 }
 
+size_t ata_prepareDMA(sATADevice *device,const void *buffer,size_t secSize,size_t secCount) {
+	sATAController *ctrl = device->ctrl;
+	size_t size = ata_buildPRDT(ctrl,buffer,secCount * secSize,secSize);
+	ctrl->dma_direct = size > 0;
+	if(!ctrl->dma_direct) {
+		/* use the bounce buffer */
+		size = esc::Util::min(secCount * secSize,DMA_BUF_SIZE - DMA_BUF_SIZE % secSize);
+		ctrl->dma_prdt_virt->buffer = (uint32_t)(uintptr_t)ctrl->dma_buf_phys;
+		ctrl->dma_prdt_virt->byteCount = size;
+		ctrl->dma_prdt_virt->last = 1;
+	}
+	ctrl->dma_buffer = buffer;
+	ctrl->dma_size = size;
+	return size / secSize;
+}
+
 bool ata_transferDMA(sATADevice *device,uint op,void *buffer,size_t secSize,size_t secCount) {
 	sATAController* ctrl = device->ctrl;
 	uint8_t status;
 	size_t size = secCount * secSize;
 	int res;
 
-	/* setup PRDT */
-	ctrl->dma_prdt_virt->buffer = (uint32_t)(uintptr_t)ctrl->dma_buf_phys;
-	ctrl->dma_prdt_virt->byteCount = size;
-	ctrl->dma_prdt_virt->last = 1;
+	/* setup PRDT, if not already done */
+	if(ctrl->dma_buffer != buffer || ctrl->dma_size != size) {
+		if(ata_prepareDMA(device,buffer,secSize,secCount) != secCount) {
+			ATA_LOG("Device %d: DMA-transfer of %zu bytes is too large",device->id,size);
+			ctrl->dma_buffer = NULL;
+			return false;
+		}
+	}
+	/* the PRDT is only valid for this transfer */
+	ctrl->dma_buffer = NULL;
 
 	/* stop running transfers */
 	ATA_PR2("Stopping running transfers");
@@ -111,9 +151,8 @@ bool ata_transferDMA(sATADevice *device,uint op,void *buffer,size_t secSize,size
 	ATA_PR2("Setting PRDT");
 	ctrl_outbmrl(ctrl,BMR_REG_PRDT,reinterpret_cast<uintptr_t>(ctrl->dma_prdt_phys));
 
-	/* write data to buffer, if we should write */
-	/* TODO we should use the buffer directly when reading from the client */
-	if(op == OP_WRITE || op == OP_PACKET)
+	/* write data to buffer, if we should write and can't use the buffer directly */
+	if(!ctrl->dma_direct && (op == OP_WRITE || op == OP_PACKET))
 		memcpy(ctrl->dma_buf_virt,buffer,size);
 
 	/* it seems to be necessary to read those ports here */
@@ -145,11 +184,77 @@ bool ata_transferDMA(sATADevice *device,uint op,void *buffer,size_t secSize,size
 	ctrl_inbmrb(ctrl,BMR_REG_STATUS);
 	ctrl_outbmrb(ctrl,BMR_REG_COMMAND,0);
 	/* copy data when reading */
-	if(op == OP_READ)
+	if(!ctrl->dma_direct && op == OP_READ)
 		memcpy(buffer,ctrl->dma_buf_virt,size);
 	return true;
 }
 
+static size_t ata_prdLength(const sPRD *prd) {
+	return prd->byteCount == 0 ? 0x10000 : prd->byteCount;
+}
+
+static size_t ata_buildPRDT(sATAController *ctrl,const void *buffer,size_t size,size_t secSize) {
+	uintptr_t frames[MAX_VIRT2PHYS_PAGES];
+	uintptr_t virt = (uintptr_t)buffer;
+	sPRD *prdt = ctrl->dma_prdt_virt;
+	size_t prds = 0,total = 0;
+
+	/* the controller requires word-aligned buffers */
+	if(virt & 1)
+		return 0;
+
+	while(total < size) {
+		/* translate the next pages; this fails if the buffer is not locked */
+		uintptr_t page = (virt + total) & ~(uintptr_t)(PAGE_SIZE - 1);
+		size_t pages = esc::Util::min((size_t)MAX_VIRT2PHYS_PAGES,
+			(size_t)(esc::Util::round_page_up(virt + size) - page) / PAGE_SIZE);
+		if(virt2phys((void*)page,pages,frames) < 0)
+			return 0;
+
+		for(size_t i = 0; i < pages && total < size; ++i) {
+			uintptr_t off = (virt + total) & (PAGE_SIZE - 1);
+			uint64_t phys = (uint64_t)frames[i] + off;
+			size_t len = esc::Util::min((size_t)(PAGE_SIZE - off),size - total);
+			/* the controller can only address the first 4 GiB */
+			if(phys + len > 0x100000000ULL)
+				return 0;
+
+			/* extend the previous entry, if it's contiguous and stays within the 64K window */
+			sPRD *last = prds > 0 ? prdt + prds - 1 : NULL;
+			if(last && last->buffer + ata_prdLength(last) == phys &&
+					(last->buffer & ~0xFFFFUL) == ((phys + len - 1) & ~0xFFFFULL))
+				last->byteCount += len;
+			else {
+				if(prds == DMA_MAX_PRDS)
+					goto done;
+				prdt[prds].buffer = phys;
+				prdt[prds].byteCount = len;
+				prdt[prds].last = 0;
+				prds++;
+			}
+			total += len;
+		}
+	}
+
+done:
+	/* the PRDT is full; we can only transfer whole sectors */
+	for(size_t rem = total % secSize; rem > 0; ) {
+		size_t len = ata_prdLength(prdt + prds - 1);
+		if(len <= rem) {
+			prds--;
+			rem -= len;
+		}
+		else {
+			prdt[prds - 1].byteCount = len - rem;
+			rem = 0;
+		}
+	}
+	total -= total % secSize;
+	if(total > 0)
+		prdt[prds - 1].last = 1;
+	return total;
+}
+
 static bool ata_setupCommand(sATADevice *device,uint64_t lba,size_t secCount,uint cmd) {
 	sATAController *ctrl = device->ctrl;
 	uint8_t devValue;
@@ -59,7 +59,22 @@ bool ata_transferPIO(sATADevice *device,uint op,void *buffer,size_t secSize,size
 		bool waitFirst);
 
 /**
- * Performs a DMA-transfer
+ * Prepares the PRDT for a DMA-transfer of up to <secCount> sectors into/from <buffer>. If the
+ * buffer is locked, the PRDT refers to its frames directly. Otherwise, the bounce buffer of the
+ * controller is used. This has to be done before the command is sent to the device, because the
+ * number of sectors for the command may be reduced.
+ *
+ * @param device the device
+ * @param buffer the buffer
+ * @param secSize the size of a sector
+ * @param secCount the number of sectors
+ * @return the number of sectors that can be transferred with one command
+ */
+size_t ata_prepareDMA(sATADevice *device,const void *buffer,size_t secSize,size_t secCount);
+
+/**
+ * Performs a DMA-transfer. If the PRDT has not been prepared for it via ata_prepareDMA, it is
+ * done here.
  *
  * @param device the device
  * @param op the operation: OP_READ, OP_WRITE or OP_PACKET
@@ -52,21 +52,37 @@ bool atapi_read(sATADevice *device,uint op,void *buffer,uint64_t lba,A_UNUSED si
 		return false;
 	if(secCount == 0)
 		return false;
-	if(cmd[0] == SCSI_CMD_READ_SECTORS_EXT) {
-		cmd[6] = (secCount >> 24) & 0xFF;
-		cmd[7] = (secCount >> 16) & 0xFF;
-		cmd[8] = (secCount >> 8) & 0xFF;
-		cmd[9] = (secCount >> 0) & 0xFF;
-	}
-	else {
-		cmd[7] = (secCount >> 8) & 0xFF;
-		cmd[8] = (secCount >> 0) & 0xFF;
+
+	uint8_t *buf = (uint8_t*)buffer;
+	bool dma = device->ctrl->useDma && device->info.capabilities.DMA;
+	while(secCount > 0) {
+		/* with DMA, the PRDT determines how much we can read at once */
+		size_t count = secCount;
+		if(dma)
+			count = ata_prepareDMA(device,buf,device->secSize,secCount);
+
+		if(cmd[0] == SCSI_CMD_READ_SECTORS_EXT) {
+			cmd[6] = (count >> 24) & 0xFF;
+			cmd[7] = (count >> 16) & 0xFF;
+			cmd[8] = (count >> 8) & 0xFF;
+			cmd[9] = (count >> 0) & 0xFF;
+		}
+		else {
+			cmd[7] = (count >> 8) & 0xFF;
+			cmd[8] = (count >> 0) & 0xFF;
+		}
+		cmd[2] = (lba >> 24) & 0xFF;
+		cmd[3] = (lba >> 16) & 0xFF;
+		cmd[4] = (lba >> 8) & 0xFF;
+		cmd[5] = (lba >> 0) & 0xFF;
+		if(!atapi_request(device,cmd,buf,count * device->secSize))
+			return false;
+
+		buf += count * device->secSize;
+		lba += count;
+		secCount -= count;
 	}
-	cmd[2] = (lba >> 24) & 0xFF;
-	cmd[3] = (lba >> 16) & 0xFF;
-	cmd[4] = (lba >> 8) & 0xFF;
-	cmd[5] = (lba >> 0) & 0xFF;
-	return atapi_request(device,cmd,buffer,secCount * device->secSize);
+	return true;
 }
 
 size_t atapi_getCapacity(sATADevice *device) {
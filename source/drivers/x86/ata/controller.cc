@@ -46,7 +46,6 @@ static const int IDE_CTRL_BAR				= 4;
 
 static const size_t BMR_SEC_OFFSET			= 0x8;
 
-static const size_t DMA_BUF_SIZE			= 64 * 1024;
 
 static bool ctrl_isBusResponding(sATAController* ctrl);
 
@@ -117,7 +116,8 @@ void ctrl_init(bool useDma,bool useIRQ) {
 			ctrls[i].bmrBase += i * BMR_SEC_OFFSET;
 			/* allocate memory for PRDT and buffer */
 			ctrls[i].dma_prdt_virt = static_cast<sPRD*>(
-				mmapphys((uintptr_t*)&ctrls[i].dma_prdt_phys,8,4096,MAP_PHYS_ALLOC));
+				mmapphys((uintptr_t*)&ctrls[i].dma_prdt_phys,DMA_PRDT_SIZE,DMA_PRDT_SIZE,
+					MAP_PHYS_ALLOC));
 			if(!ctrls[i].dma_prdt_virt)
 				error("Unable to allocate PRDT for controller %d",ctrls[i].id);
 			ctrls[i].dma_buf_virt = mmapphys((uintptr_t*)&ctrls[i].dma_buf_phys,
@@ -310,11 +310,18 @@ struct sATADevice {
 /* physical region descriptor */
 typedef struct {
 	uint32_t buffer;
+	/* 0 means 64K */
 	uint16_t byteCount;
 	uint16_t : 15;
 	uint16_t last : 1;
 } A_PACKED sPRD;
 
+/* the size of the bounce buffer, used if we can't DMA into the caller's buffer */
+static const size_t DMA_BUF_SIZE			= 64 * 1024;
+/* the size of the PRDT (it must not cross a 64K boundary) */
+static const size_t DMA_PRDT_SIZE			= 4096;
+static const size_t DMA_MAX_PRDS			= DMA_PRDT_SIZE / sizeof(sPRD);
+
 /* the controller is declared here, because otherwise device.h needs controller.h and the other way
  * around */
 struct sATAController {
@@ -331,6 +338,11 @@ struct sATAController {
 	sPRD *dma_prdt_virt;
 	void *dma_buf_phys;
 	void *dma_buf_virt;
+	/* the buffer and number of bytes the PRDT has been prepared for */
+	const void *dma_buffer;
+	size_t dma_size;
+	/* whether the PRDT refers to dma_buffer directly or to our bounce buffer */
+	bool dma_direct;
 	sATADevice devices[2];
 };
 
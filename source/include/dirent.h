@@ -20,6 +20,7 @@
 #pragma once
 
 #include <sys/common.h>
+#include <sys/stat.h>
 #include <stdio.h>
 
 #define NAME_MAX		52
@@ -32,6 +33,13 @@ struct dirent {
 	char d_name[NAME_MAX + 1];
 } A_PACKED;
 
+/* an entry returned by readdirplus(). d_ent.d_reclen is the size of the whole record and the name
+ * is null-terminated. d_stat is zeroed if the attributes could not be retrieved. */
+struct direntplus {
+	struct stat d_stat;
+	struct dirent d_ent;
+};
+
 typedef FILE DIR;
 
 #if defined(__cplusplus)
@@ -123,6 +131,20 @@ struct dirent *readdir(DIR *dir);
  */
 bool readdirto(DIR *dir,struct dirent *e);
 
+/**
+ * Reads as many entries of the directory <fd> as fit into <buffer>, together with their
+ * attributes (as lstat() would report them). This needs a single request to the filesystem,
+ * instead of one per entry. Starts at the current position of <fd> and advances it. Don't mix it
+ * with readdir() on the same file.
+ *
+ * @param fd the file-descriptor for the directory
+ * @param buffer the buffer to write the direntplus records to
+ * @param size the size of <buffer>
+ * @return the number of written bytes (0 = end of directory) or a negative error-code. -ENOTSUP
+ *  is returned if the directory is not in a userspace filesystem.
+ */
+ssize_t readdirplus(int fd,void *buffer,size_t size);
+
 /**
  * Closes the given directory
  *
@@ -25,12 +25,19 @@
 namespace esc {
 
 /**
- * The DNS class allows you to resolve names to IP addresses.
+ * The DNS class allows you to resolve names to IP addresses. If the DNS service is running, names
+ * are resolved via the service, which caches the answers. Otherwise, the name server is queried
+ * directly.
  */
 class DNS {
 	DNS() = delete;
 
 public:
+	/* the max. length of a query or response */
+	static const size_t MAX_MSG_SIZE	= 512;
+	/* the max. length of a domain name */
+	static const size_t MAX_NAME_LEN	= 255;
+
 	/**
 	 * @return the file in which the nameserver is stored
 	 */
@@ -38,6 +45,13 @@ public:
 		return "/sys/net/nameserver";
 	}
 
+	/**
+	 * @return the device of the DNS service
+	 */
+	static const char *getServiceDev() {
+		return "/dev/dns";
+	}
+
 	/**
 	 * Gets the host for given name. It might also be an IP address, in which case it is not
 	 * resolved, but only translated in an esc::Net::IPv4Addr object.
@@ -67,13 +81,67 @@ public:
 	 */
 	static esc::Net::IPv4Addr resolve(const char *name,uint timeout = 1000);
 
+	/**
+	 * Reads the nameserver from the resolve file.
+	 *
+	 * @return the nameserver
+	 * @throws if the operation failed or there is no nameserver
+	 */
+	static esc::Net::IPv4Addr getNameserver();
+
+	/**
+	 * Generates a transaction id for a new query. The ids are not predictable for others, so that
+	 * they can't easily spoof responses.
+	 *
+	 * @return the transaction id
+	 */
+	static uint16_t genTxId();
+
+	/**
+	 * Builds a query for the A record of <name>.
+	 *
+	 * @param buf the buffer to write to (MAX_MSG_SIZE bytes)
+	 * @param txid the transaction id
+	 * @param name the domain name
+	 * @return the length of the query
+	 * @throws if the name is too long
+	 */
+	static size_t buildQuery(uint8_t *buf,uint16_t txid,const char *name);
+
+	/**
+	 * Determines the transaction id of the given response, e.g., to find the corresponding query.
+	 *
+	 * @param buf the response
+	 * @param len the length of the response
+	 * @return the transaction id or -EINVAL if the response is too short
+	 */
+	static int getTxId(const uint8_t *buf,size_t len);
+
+	/**
+	 * Parses the given response to the query for <name> with id <txid>.
+	 *
+	 * @param buf the response
+	 * @param len the length of the response
+	 * @param txid the transaction id of the query
+	 * @param name the domain name that has been queried
+	 * @param addr will be set to the IP address
+	 * @param ttl will be set to the number of seconds the result may be cached (0 = not at all).
+	 *  This is also set for negative answers, i.e., -EHOSTNOTFOUND.
+	 * @return 0 on success, -EINVAL if it is no response to the query (it should be ignored in
+	 *  this case) or another negative error code
+	 */
+	static int parseResponse(const uint8_t *buf,size_t len,uint16_t txid,const char *name,
+		esc::Net::IPv4Addr *addr,uint32_t *ttl);
+
 private:
 	static void sigalarm(int) {
 	}
+	static bool resolveViaService(const char *name,uint timeout,esc::Net::IPv4Addr *addr);
 	static void convertHostname(char *dst,const char *src,size_t len);
-	static size_t questionLength(const uint8_t *data);
+	static const uint8_t *skipName(const uint8_t *data,const uint8_t *end);
+	static const uint8_t *matchName(const uint8_t *data,const uint8_t *end,const char *name);
 
-	static uint16_t _nextId;
+	static uint64_t _rand;
 	static esc::Net::IPv4Addr _nameserver;
 };
 
@@ -25,6 +25,7 @@
 #include <dirent.h>
 #include <string>
 #include <time.h>
+#include <utility>
 #include <vector>
 
 namespace esc {
@@ -47,6 +48,11 @@ namespace esc {
 		 */
 		static void printMode(esc::OStream &os,mode_t mode);
 
+		/**
+		 * Builds an empty file-object
+		 */
+		file() : _info(), _parent(), _name() {
+		}
 		/**
 		 * Builds a file-object for given path
 		 *
@@ -64,6 +70,14 @@ namespace esc {
 		 * @throws default_error if stat fails
 		 */
 		file(const std::string& parent,const std::string& name,uint flags = O_NOCHAN);
+		/**
+		 * Builds a file-object for <name> in <parent> with already known file info
+		 *
+		 * @param parent the absolute and canonical parent-path
+		 * @param name the filename
+		 * @param info the file info
+		 */
+		file(const std::string& parent,const std::string& name,const struct stat &info);
 		/**
 		 * Copy-constructor
 		 */
@@ -86,6 +100,20 @@ namespace esc {
 		 */
 		std::vector<struct dirent> list_files(bool showHidden,const std::string& pattern = std::string()) const;
 
+		/**
+		 * Builds a vector with file-objects for all entries in the directory denoted by this
+		 * file-object. Symlinks are not followed. If supported by the filesystem, the entries
+		 * and their info are fetched in bulk via readdirplus(). Entries that can't be
+		 * stat'ed are not included in the result, but reported in <errors>, if given.
+		 *
+		 * @param showHidden whether to include hidden files/folders
+		 * @param pattern a pattern the files have to match
+		 * @param errors if not NULL, the names of the skipped entries and the reasons are added
+		 * @return the vector
+		 */
+		std::vector<file> list_entries(bool showHidden,const std::string& pattern = std::string(),
+			std::vector<std::pair<std::string,default_error>> *errors = NULL) const;
+
 		/**
 		 * @return the mode of the file
 		 */
@@ -195,6 +223,8 @@ namespace esc {
 		}
 
 	private:
+		static void addEntry(std::vector<file> &v,const std::string &dir,const char *name,
+			std::vector<std::pair<std::string,default_error>> *errors);
 		void init(const std::string& parent,const std::string& name,uint flags);
 
 	private:
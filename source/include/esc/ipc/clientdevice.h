@@ -24,6 +24,7 @@
 #include <esc/proto/file.h>
 #include <esc/proto/device.h>
 #include <esc/vthrow.h>
+#include <sys/conf.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/sync.h>
@@ -88,13 +89,11 @@ private:
 };
 
 /**
- * A device that maintains a list of clients.
+ * A device that maintains a list of clients. The clients are stored in a table indexed by their
+ * file-descriptor, so that the lookup, which is done for nearly every message, is a single load.
  */
 template<class C = Client>
 class ClientDevice : public Device {
-	typedef std::map<int,C*> map_type;
-	typedef typename map_type::iterator iterator;
-
 public:
 	/**
 	 * Creates the device at given path.
@@ -106,7 +105,11 @@ public:
 	 * @throws if the operation failed
 	 */
 	explicit ClientDevice(const char *path,mode_t mode,uint type,uint ops)
-		: Device(path,mode,type,ops | DEV_OPEN), _clients(), _mutex() {
+		: Device(path,mode,type,ops | DEV_OPEN), _clients(), _max(sysconf(CONF_MAX_FDS)), _count(),
+		  _mutex() {
+		if((long)_max <= 0)
+			_max = 1024;
+		_clients = new C*[_max]();
 		set(MSG_FILE_OPEN,std::make_memfun(this,&ClientDevice::open));
 		if(ops & DEV_DELEGATE)
 			set(MSG_DEV_DELEGATE,std::make_memfun(this,&ClientDevice::delegate));
@@ -116,24 +119,24 @@ public:
 	 * Cleans up
 	 */
 	virtual ~ClientDevice() {
+		delete[] _clients;
 	}
 
 	/**
 	 * @return the number of clients
 	 */
 	size_t client_count() const {
-		return _clients.size();
+		return _count;
 	}
 
 	/**
 	 * @return the client with given file-descriptor
 	 */
 	C *operator[](int fd) {
-		typename map_type::iterator it = _clients.find(fd);
-		return it != _clients.end() ? it->second : NULL;
+		return (size_t)fd < _max ? _clients[fd] : NULL;
 	}
 	const C *operator[](int fd) const {
-		return const_cast<ClientDevice*>(this)[fd];
+		return (size_t)fd < _max ? _clients[fd] : NULL;
 	}
 
 	/**
@@ -143,10 +146,10 @@ public:
 	 * @throws if the client does not exist
 	 */
 	C *get(int fd) {
-		typename map_type::iterator it = _clients.find(fd);
-		if(it == _clients.end())
+		C *c = (*this)[fd];
+		if(c == NULL)
 			VTHROWE("No client with id " << fd,-ENOTFOUND);
-		return it->second;
+		return c;
 	}
 	const C *get(int fd) const {
 		return const_cast<ClientDevice*>(this)->get(fd);
@@ -160,8 +163,10 @@ public:
 	 */
 	void broadcast(msgid_t mid,IPCBuf &ib) {
 		std::lock_guard<std::mutex> guard(_mutex);
-		for(auto it = _clients.begin(); it != _clients.end(); ++it)
-			send(it->first,mid,ib.buffer(),ib.pos());
+		for(size_t fd = 0; fd < _max; ++fd) {
+			if(_clients[fd])
+				send(fd,mid,ib.buffer(),ib.pos());
+		}
 	}
 
 	/**
@@ -169,9 +174,14 @@ public:
 	 *
 	 * @param fd the file-descriptor
 	 * @param c the client
+	 * @throws if the file-descriptor is out of range
 	 */
 	void add(int fd,C *c) {
+		if((size_t)fd >= _max)
+			VTHROWE("Client id " << fd << " out of range",-EINVAL);
 		std::lock_guard<std::mutex> guard(_mutex);
+		if(!_clients[fd])
+			_count++;
 		_clients[fd] = c;
 	}
 	/**
@@ -183,7 +193,8 @@ public:
 	void remove(int fd,bool del = true) {
 		C *c = get(fd);
 		std::lock_guard<std::mutex> guard(_mutex);
-		_clients.erase(fd);
+		_clients[fd] = NULL;
+		_count--;
 		if(del)
 			delete c;
 	}
@@ -204,9 +215,9 @@ public:
 			// check whether we already have this file. we can't map it twice
 			std::lock_guard<std::mutex> guard(_mutex);
 			res = -ENOENT;
-			for(auto it = _clients.begin(); it != _clients.end(); ++it) {
-				C *oc = it->second;
-				if(c != oc && oc->_shm && oc->_shm->ino == info.st_ino && oc->_shm->dev == info.st_dev) {
+			for(size_t i = 0; i < _max; ++i) {
+				C *oc = _clients[i];
+				if(oc && c != oc && oc->_shm && oc->_shm->ino == info.st_ino && oc->_shm->dev == info.st_dev) {
 					c->_shm = oc->_shm;
 					res = 0;
 					break;
@@ -254,7 +265,9 @@ protected:
 	}
 
 private:
-	map_type _clients;
+	C **_clients;
+	size_t _max;
+	size_t _count;
 	std::mutex _mutex;
 };
 
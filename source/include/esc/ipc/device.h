@@ -22,14 +22,16 @@
 #include <esc/ipc/ipcstream.h>
 #include <sys/common.h>
 #include <sys/driver.h>
+#include <sys/messages.h>
 #include <functor.h>
-#include <map>
 #include <sstream>
 
 namespace esc {
 
 /**
- * The base class for all devices
+ * The base class for all devices. The handlers are stored in dense tables indexed by message-id:
+ * one for the file and device messages, which every device has, and one that spans the protocol
+ * messages of the device (they are usually numbered consecutively).
  */
 class Device {
 public:
@@ -43,7 +45,6 @@ public:
 		handler_type *func;
 		bool reply;
 	};
-	typedef std::map<msgid_t,Handler> oplist_type;
 
 	/**
 	 * Creates the device at given path
@@ -123,6 +124,21 @@ public:
 	 */
 	void handleMsg(msgid_t mid,IPCStream &is);
 
+	/**
+	 * @param op the operation (message-id)
+	 * @return the handler for <op> or NULL if there is none
+	 */
+	const Handler *lookup(msgid_t op) const {
+		const Handler *h;
+		if(op - MSG_FILE_OPEN < ARRAY_SIZE(_devOps))
+			h = _devOps + (op - MSG_FILE_OPEN);
+		else if(op - _opsBase < _opsCount)
+			h = _ops + (op - _opsBase);
+		else
+			return NULL;
+		return h->func ? h : NULL;
+	}
+
 protected:
 	void reply(IPCStream &is,errcode_t errcode);
 	void close(IPCStream &is) {
@@ -130,7 +146,12 @@ protected:
 	}
 
 private:
-	oplist_type _ops;
+	Handler *slot(msgid_t op);
+
+	Handler _devOps[MSG_DEV_OBTAIN - MSG_FILE_OPEN + 1];
+	Handler *_ops;
+	msgid_t _opsBase;
+	size_t _opsCount;
 	int _id;
 	volatile bool _run;
 };
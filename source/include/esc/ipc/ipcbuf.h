@@ -132,6 +132,22 @@ public:
 		}
 	}
 
+	/**
+	 * Reads the given item without copying it, i.e., returns a pointer into the buffer. Note that
+	 * the pointer is only valid until the buffer is reused.
+	 *
+	 * @return the item or NULL if the buffer does not contain enough data
+	 */
+	template<typename T>
+	const T *view() {
+		if(EXPECT_TRUE(checkSpace(sizeof(T)))) {
+			size_t apos = align(_pos);
+			_pos = apos + sizeof(T);
+			return reinterpret_cast<const T*>(_buf + apos / sizeof(ulong));
+		}
+		return NULL;
+	}
+
 private:
 	static inline size_t align(size_t sz) {
 		return (sz + sizeof(ulong) - 1) & ~(sizeof(ulong) - 1);
@@ -185,6 +185,14 @@ public:
 		startReading();
 		_buf.fetch(data,size);
 	}
+	/**
+	 * Reads the given item without copying it (see IPCBuf::view).
+	 */
+	template<typename T>
+	const T *view() {
+		startReading();
+		return _buf.template view<T>();
+	}
 
 private:
 	void startWriting() {
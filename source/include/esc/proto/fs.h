@@ -91,6 +91,79 @@ struct FSStat {
 	typedef ValueResponse<struct stat> Response;
 };
 
+struct FSPathStat {
+	static const msgid_t MSG = MSG_FS_STAT;
+
+	typedef FileOpen::Request Request;
+
+	struct Result {
+		explicit Result() : info(), sympos(-1) {
+		}
+
+		struct stat info;
+		ssize_t sympos;
+	};
+
+	typedef ValueResponse<Result> Response;
+};
+
+struct FSReaddirPlus {
+	static const msgid_t MSG = MSG_FS_READDIRPLUS;
+
+	/* the maximum number of bytes that are returned at once */
+	static const size_t MAX_SIZE = 64 * 1024;
+
+	struct Request {
+		explicit Request() {
+		}
+		explicit Request(const fs::User &_u,size_t _offset,size_t _count)
+			: u(_u), offset(_offset), count(_count) {
+		}
+
+		fs::User u;
+		size_t offset;
+		size_t count;
+	};
+
+	struct Result {
+		explicit Result() : size(), next() {
+		}
+		explicit Result(size_t _size,size_t _next) : size(_size), next(_next) {
+		}
+
+		/* the number of bytes of direntplus records that follow */
+		size_t size;
+		/* the directory offset to continue at */
+		size_t next;
+	};
+
+	typedef ValueResponse<Result> Response;
+};
+
+struct FSCopyRange {
+	static const msgid_t MSG = MSG_FS_COPYRANGE;
+
+	/* the maximum number of bytes that are copied at once */
+	static const size_t MAX_SIZE = 1024 * 1024;
+
+	struct Request {
+		explicit Request() {
+		}
+		explicit Request(const fs::User &_u,int _outFd,size_t _inOffset,size_t _outOffset,
+			size_t _count)
+			: u(_u), outFd(_outFd), inOffset(_inOffset), outOffset(_outOffset), count(_count) {
+		}
+
+		fs::User u;
+		int outFd;
+		size_t inOffset;
+		size_t outOffset;
+		size_t count;
+	};
+
+	typedef ValueResponse<ssize_t> Response;
+};
+
 struct FSLink {
 	static const msgid_t MSG = MSG_FS_LINK;
 
@@ -36,6 +36,11 @@ struct CBlock {
 	void *buffer;
 };
 
+/**
+ * A cache for disk blocks. If the disk device supports it (see OBT_ARG_DAX), the device memory
+ * is mapped directly and the blocks point into this mapping. In this case, neither reads nor
+ * writes have to be copied and the blocks are not cached twice.
+ */
 class BlockCache {
 	static const size_t HASH_SIZE	= 256;
 
@@ -79,6 +84,13 @@ public:
 	 */
 	virtual bool writeBlocks(const void *buffer,size_t start,size_t blockCount) = 0;
 
+	/**
+	 * @return true if the device memory is mapped directly
+	 */
+	bool isDirect() const {
+		return _dax != NULL;
+	}
+
 	/**
 	 * Writes all dirty blocks to disk
 	 */
@@ -159,6 +171,10 @@ private:
 	 * Fetches a block-cache-entry
 	 */
 	CBlock *getBlock(block_t blockNo);
+	/**
+	 * Tries to map the memory of the disk <fd> directly
+	 */
+	bool mapDirect(int fd);
 
 	size_t _blockCacheSize;
 	size_t _blockSize;
@@ -169,6 +185,8 @@ private:
 	CBlock *_blockCache;
 	void *_blockmem;
 	int _blockfd;
+	char *_dax;
+	size_t _daxsize;
 	ulong _hits;
 	ulong _misses;
 };
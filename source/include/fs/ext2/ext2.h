@@ -84,6 +84,19 @@
 #define EXT2_FEATURE_RO_COMPAT_LARGE_FILE	0x0002
 #define EXT2_FEATURE_RO_COMPAT_BTREE_DIR	0x0004
 
+/* superblock flags */
+#define EXT2_FLAGS_SIGNED_HASH				0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH			0x0002
+
+/* hash versions for directory indexing */
+#define EXT2_HASH_LEGACY					0
+#define EXT2_HASH_HALF_MD4					1
+#define EXT2_HASH_TEA						2
+/* the same with unsigned chars; only used in memory (depending on EXT2_FLAGS_UNSIGNED_HASH) */
+#define EXT2_HASH_LEGACY_UNSIGNED			3
+#define EXT2_HASH_HALF_MD4_UNSIGNED			4
+#define EXT2_HASH_TEA_UNSIGNED				5
+
 /* compression algorithms */
 #define EXT2_LZV1_ALG						0x0001
 #define EXT2_LZRW3A_ALG						0x0002
@@ -242,8 +255,21 @@ struct Ext2SuperBlock {
 	uint32_t defMountOptions;
 	/* A 32bit value indicating the block group ID of the first meta block group. */
 	uint32_t firstMetaBg;
+	/* the time when the file system was created */
+	uint32_t mkfsTime;
+	/* backup of the journal inode's block array */
+	uint32_t journalBlocks[17];
+	/* the high 32 bits of the block counts (64bit feature) */
+	uint32_t blockCountHi;
+	uint32_t suResBlockCountHi;
+	uint32_t freeBlockCountHi;
+	/* the minimum and desired size of the additional inode fields */
+	uint16_t minExtraInodeSize;
+	uint16_t wantExtraInodeSize;
+	/* miscellaneous flags (EXT2_FLAGS_*) */
+	uint32_t flags;
 	/* UNUSED */
-	uint8_t unused[760];
+	uint8_t unused[668];
 } A_PACKED;
 
 struct Ext2BlockGrp {
@@ -273,6 +299,52 @@ struct Ext2DirEntry {
 	char name[];
 } A_PACKED;
 
+/* the root of a hashed directory index, stored in the first block of the directory. The entries
+ * for "." and ".." are ordinary directory-entries, so that the directory can still be read
+ * linearly. ".." spans the rest of the block, which contains the index. */
+struct Ext2DxRoot {
+	ino_t dotInode;
+	uint16_t dotRecLen;
+	uint16_t dotNameLen;
+	char dotName[4];
+	ino_t dotdotInode;
+	uint16_t dotdotRecLen;
+	uint16_t dotdotNameLen;
+	char dotdotName[4];
+	/* has to be 0 */
+	uint32_t reserved;
+	/* one of EXT2_HASH_* */
+	uint8_t hashVersion;
+	/* the length of the info-part, i.e. from <reserved> to <unusedFlags> (8) */
+	uint8_t infoLength;
+	/* the number of index-levels below the root */
+	uint8_t indirectLevels;
+	uint8_t unusedFlags;
+	/* the index-entries follow */
+} A_PACKED;
+
+/* an index-block below the root. It starts with an empty directory-entry spanning the whole
+ * block, which is followed by the index-entries */
+struct Ext2DxNode {
+	ino_t fakeInode;
+	uint16_t fakeRecLen;
+	uint16_t fakeNameLen;
+	/* the index-entries follow */
+} A_PACKED;
+
+/* an index-entry: all names with a hash >= <hash> are in <block> (or below) */
+struct Ext2DxEntry {
+	uint32_t hash;
+	uint32_t block;
+} A_PACKED;
+
+/* the first index-entry has no hash (it's implicitly 0), but the limit and count instead */
+struct Ext2DxCountLimit {
+	uint16_t limit;
+	uint16_t count;
+	uint32_t block;
+} A_PACKED;
+
 struct Ext2Inode {
 	uint16_t mode;
 	uint16_t uid;
@@ -21,6 +21,7 @@
 
 #include <fs/common.h>
 #include <sys/common.h>
+#include <sys/io.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <stdio.h>
@@ -45,12 +46,68 @@ public:
 
 	virtual int stat(F *file,struct ::stat *info) = 0;
 
+	/**
+	 * Retrieves information about the file at <path>, relative to <root>. By default, the file
+	 * is opened, stat'ed and closed again.
+	 *
+	 * @param u the user
+	 * @param path the path
+	 * @param sympos will be set to the position of the symlink in <path>, if one is found
+	 * @param root the root inode
+	 * @param flags the open flags (O_NOFOLLOW is respected)
+	 * @param fd the file descriptor of the request
+	 * @param info the info to fill
+	 * @return 0 on success, -ENOTSUP to let the client fall back to open and fstat
+	 */
+	virtual int pathstat(User *u,const char *path,ssize_t *sympos,ino_t root,uint flags,int fd,
+			struct ::stat *info) {
+		F *file;
+		ino_t ino = open(u,path,sympos,root,flags,0,fd,&file);
+		if(ino < 0)
+			return ino;
+		int res = stat(file,info);
+		close(file);
+		delete file;
+		return res;
+	}
+
+	/**
+	 * Retrieves information about the entry <name> in directory <dir> without following symlinks.
+	 * By default, the entry is opened relative to the inode of <dir>. Filesystems that don't
+	 * support different root inodes have to override it.
+	 *
+	 * @param u the user
+	 * @param dir the directory
+	 * @param name the name of the entry
+	 * @param info the info to fill
+	 * @return 0 on success
+	 */
+	virtual int entrystat(User *u,F *dir,const char *name,struct ::stat *info) {
+		ssize_t sympos = -1;
+		return pathstat(u,name,&sympos,dir->ino,O_NOCHAN | O_NOFOLLOW,dir->fd(),info);
+	}
+
 	virtual ssize_t read(F *,void *,off_t,size_t) {
 		return -ENOTSUP;
 	}
 	virtual ssize_t write(F *,const void *,off_t,size_t) {
 		return -ENOTSUP;
 	}
+	/**
+	 * Copies up to <count> bytes from <in> at <inoff> to <out> at <outoff> within this filesystem.
+	 * If it's not supported, the kernel moves the data through the client instead.
+	 *
+	 * @param u the user
+	 * @param in the source file
+	 * @param out the destination file
+	 * @param inoff the offset in <in>
+	 * @param outoff the offset in <out>
+	 * @param count the max. number of bytes to copy
+	 * @return the number of copied bytes
+	 */
+	virtual ssize_t copyrange(User *,F *,F *,off_t,off_t,size_t) {
+		return -ENOTSUP;
+	}
 	virtual int link(User *,F *,F *,const char *) {
 		return -ENOTSUP;
 	}
@@ -22,10 +22,15 @@
 #include <esc/ipc/clientdevice.h>
 #include <esc/proto/fs.h>
 #include <esc/proto/init.h>
+#include <esc/util.h>
 #include <fs/common.h>
 #include <sys/common.h>
+#include <sys/endian.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 namespace fs {
 
@@ -65,6 +70,9 @@ public:
 		this->set(MSG_FS_UTIME,std::make_memfun(this,&FSDevice::utime));
 		this->set(MSG_FS_TRUNCATE,std::make_memfun(this,&FSDevice::truncate));
 		this->set(MSG_FS_SYMLINK,std::make_memfun(this,&FSDevice::symlink));
+		this->set(MSG_FS_STAT,std::make_memfun(this,&FSDevice::pathstat));
+		this->set(MSG_FS_READDIRPLUS,std::make_memfun(this,&FSDevice::readdirplus));
+		this->set(MSG_FS_COPYRANGE,std::make_memfun(this,&FSDevice::copyrange));
 	}
 
 	virtual ~FSDevice() {
@@ -121,37 +129,60 @@ public:
 
 	void read(esc::IPCStream &is) {
 		F *file = (*this)[is.fd()];
-		esc::FileRead::Request r;
-		is >> r;
+		// read and write are the hot path; avoid copying the request out of the message buffer
+		const esc::FileRead::Request *r = is.view<esc::FileRead::Request>();
+		if(EXPECT_FALSE(r == NULL)) {
+			is << esc::FileRead::Response::result(-EINVAL) << esc::Reply();
+			return;
+		}
 
 		if(file) {
-			esc::DataBuf buf(r.count,file->shm(),r.shmemoff);
-			ssize_t res = _fs->read(file,buf.data(),r.offset,r.count);
+			// the reply overwrites the request
+			ssize_t shmemoff = r->shmemoff;
+			esc::DataBuf buf(r->count,file->shm(),shmemoff);
+			ssize_t res = _fs->read(file,buf.data(),r->offset,r->count);
 
 			is << esc::FileRead::Response::result(res) << esc::Reply();
-			if(r.shmemoff == -1 && res > 0)
+			if(shmemoff == -1 && res > 0)
 				is << esc::ReplyData(buf.data(),res);
 		}
 		else
-			handleInfoRead(is,r);
+			handleInfoRead(is,esc::FileRead::Request(*r));
 	}
 
 	void write(esc::IPCStream &is) {
 		F *file = (*this)[is.fd()];
-		esc::FileWrite::Request r;
-		is >> r;
+		const esc::FileWrite::Request *r = is.view<esc::FileWrite::Request>();
 
 		ssize_t res = -ENOTSUP;
-		if(file) {
-			esc::DataBuf buf(r.count,file->shm(),r.shmemoff);
-			if(r.shmemoff == -1)
-				is >> esc::ReceiveData(buf.data(),r.count);
-
-			res = _fs->write(file,buf.data(),r.offset,r.count);
+		if(EXPECT_FALSE(r == NULL))
+			res = -EINVAL;
+		else if(file) {
+			size_t offset = r->offset, count = r->count;
+			esc::DataBuf buf(count,file->shm(),r->shmemoff);
+			if(r->shmemoff == -1)
+				is >> esc::ReceiveData(buf.data(),count);
+
+			res = _fs->write(file,buf.data(),offset,count);
 		}
 		is << esc::FileWrite::Response::result(res) << esc::Reply();
 	}
 
+	void copyrange(esc::IPCStream &is) {
+		esc::FSCopyRange::Request r;
+		is >> r;
+
+		F *in = (*this)[is.fd()];
+		F *out = (*this)[r.outFd];
+
+		ssize_t res = -EINVAL;
+		if(in && out) {
+			size_t count = esc::Util::min(r.count,esc::FSCopyRange::MAX_SIZE);
+			res = _fs->copyrange(&r.u,in,out,r.inOffset,r.outOffset,count);
+		}
+		is << esc::FSCopyRange::Response::result(res) << esc::Reply();
+	}
+
 	void close(esc::IPCStream &is) {
 		F *file = (*this)[is.fd()];
 		_fs->close(file);
@@ -164,6 +195,102 @@ public:
 		is << esc::FSStat::Response(info,res) << esc::Reply();
 	}
 
+	void pathstat(esc::IPCStream &is) {
+		char path[MAX_PATH_LEN];
+		esc::FSPathStat::Request r(path,sizeof(path));
+		is >> r;
+
+		esc::FSPathStat::Result res;
+		int err = _fs->pathstat(&r.u,path,&res.sympos,r.root,r.flags,is.fd(),&res.info);
+		is << esc::FSPathStat::Response(res,err) << esc::Reply();
+	}
+
+	void readdirplus(esc::IPCStream &is) {
+		static const size_t DIRE_SIZE = sizeof(struct dirent) - (NAME_MAX + 1);
+		static const size_t RAW_SIZE = 4096;
+
+		F *dir = (*this)[is.fd()];
+		esc::FSReaddirPlus::Request r;
+		is >> r;
+
+		size_t count = esc::Util::min(r.count,esc::FSReaddirPlus::MAX_SIZE);
+		char *raw = static_cast<char*>(malloc(RAW_SIZE));
+		char *buf = static_cast<char*>(malloc(count));
+		size_t off = r.offset;
+		size_t pos = 0;
+		int err = 0;
+		if(!dir)
+			err = -EBADF;
+		else if(!raw || !buf)
+			err = -ENOMEM;
+
+		/* read the raw entries in chunks and stat each one until the buffer is full */
+		bool full = false;
+		while(err == 0 && !full) {
+			ssize_t res = _fs->read(dir,raw,off,RAW_SIZE);
+			if(res <= 0) {
+				if(pos == 0)
+					err = res;
+				break;
+			}
+
+			size_t i = 0;
+			while(i + DIRE_SIZE <= (size_t)res) {
+				struct dirent *e = reinterpret_cast<struct dirent*>(raw + i);
+				size_t reclen = le16tocpu(e->d_reclen);
+				size_t namelen = le16tocpu(e->d_namelen);
+				if(reclen < DIRE_SIZE || namelen > NAME_MAX) {
+					err = -EINVAL;
+					break;
+				}
+				/* the name is incomplete; read it again with the next chunk */
+				if(i + DIRE_SIZE + namelen > (size_t)res)
+					break;
+
+				/* skip unused entries */
+				if(namelen > 0) {
+					size_t size = sizeof(struct stat) + DIRE_SIZE + namelen + 1;
+					size = (size + alignof(struct direntplus) - 1) & ~(alignof(struct direntplus) - 1);
+					if(pos + size > count) {
+						full = true;
+						break;
+					}
+
+					struct direntplus *dp = reinterpret_cast<struct direntplus*>(buf + pos);
+					dp->d_ent.d_ino = le32tocpu(e->d_ino);
+					dp->d_ent.d_reclen = size;
+					dp->d_ent.d_namelen = namelen;
+					memcpy(dp->d_ent.d_name,e->d_name,namelen);
+					dp->d_ent.d_name[namelen] = '\0';
+					if(_fs->entrystat(&r.u,dir,dp->d_ent.d_name,&dp->d_stat) < 0)
+						memclear(&dp->d_stat,sizeof(dp->d_stat));
+					pos += size;
+				}
+				off += reclen;
+				i += reclen;
+			}
+
+			/* no complete entry in this chunk */
+			if(i == 0)
+				break;
+		}
+
+		/* the buffer is too small for a single entry */
+		if(full && pos == 0)
+			err = -EINVAL;
+
+		if(err < 0)
+			is << esc::FSReaddirPlus::Response::error(err) << esc::Reply();
+		else {
+			esc::FSReaddirPlus::Result res(pos,off);
+			is << esc::FSReaddirPlus::Response::success(res) << esc::Reply();
+			if(pos > 0)
+				is << esc::ReplyData(buf,pos);
+		}
+		free(buf);
+		free(raw);
+	}
+
 	void syncfs(esc::IPCStream &is) {
 		_fs->sync();
 
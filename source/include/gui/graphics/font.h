@@ -43,6 +43,12 @@ namespace gui {
 		bool isPixelSet(char c,gpos_t x,gpos_t y) const {
 			return _font[(uchar)c * charHeight + y] & (1 << (charWidth - x - 1));
 		}
+		/**
+		 * @return the bitmap of the given character, one byte per row
+		 */
+		const uint8_t *getGlyph(char c) const {
+			return _font + (uchar)c * charHeight;
+		}
 
 	private:
 		static uint8_t _font[];
@@ -332,27 +332,39 @@ namespace gui {
 		 * Sets a pixel (without check)
 		 */
 		void doSetPixel(gpos_t x,gpos_t y) {
-			gcoldepth_t bpp = Application::getInstance()->getColorDepth();
-			size_t bytespp = bpp / 8;
-			gsize_t bwidth = _buf->getSize().width;
-			uint8_t *addr = getPixels() + ((_off.y + y) * bwidth + (_off.x + x)) * bytespp;
+			size_t bytespp = _buf->getFormat()->getBytesPerPixel();
+			uint8_t *addr = getPixelAddr(x,y);
 
-			switch(bpp) {
-				case 16:
+			switch(bytespp) {
+				case 2:
 					*(uint16_t*)addr = _col;
 					break;
-				case 24: {
+				case 3: {
 					uint8_t *col = (uint8_t*)&_col;
 					*addr++ = *col++;
 					*addr++ = *col++;
 					*addr = *col;
 				}
 				break;
-				case 32:
+				case 4:
 					*(uint32_t*)addr = _col;
 					break;
 			}
 		}
+		/**
+		 * Blends the given ARGB colors over the <count> pixels starting at <x>,<y> (without check)
+		 */
+		void doBlendSpan(gpos_t x,gpos_t y,const uint32_t *cols,gsize_t count) {
+			_buf->getFormat()->blendSpan(getPixelAddr(x,y),cols,count);
+		}
+		/**
+		 * @return the address of the given pixel in the buffer
+		 */
+		uint8_t *getPixelAddr(gpos_t x,gpos_t y) {
+			size_t bytespp = _buf->getFormat()->getBytesPerPixel();
+			gsize_t bwidth = _buf->getSize().width;
+			return _buf->getBuffer() + ((_off.y + y) * bwidth + (_off.x + x)) * bytespp;
+		}
 		/**
 		 * Adds the given position to the dirty region
 		 */
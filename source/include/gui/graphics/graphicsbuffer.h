@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <gui/graphics/pixelformat.h>
 #include <gui/graphics/pos.h>
 #include <gui/graphics/rectangle.h>
 #include <gui/graphics/size.h>
@@ -50,7 +51,7 @@ namespace gui {
 		 */
 		GraphicsBuffer(Window *win,const Pos &pos,const Size &size)
 			: _win(win), _pos(pos), _size(size), _minx(0),_miny(0),
-			  _maxx(size.width - 1), _maxy(size.height - 1), _pixels(nullptr) {
+			  _maxx(size.width - 1), _maxy(size.height - 1), _pixels(nullptr), _format(nullptr) {
 		}
 		/**
 		 * Destructor
@@ -102,6 +103,18 @@ namespace gui {
 		uint8_t *getBuffer() const {
 			return _pixels;
 		}
+		/**
+		 * @return the pixel-format of the buffer (nullptr if there is no buffer)
+		 */
+		const PixelFormat *getFormat() const {
+			return _format;
+		}
+		/**
+		 * @return the number of bytes per row
+		 */
+		size_t getStride() const {
+			return _size.width * _format->getBytesPerPixel();
+		}
 		/**
 		 * Sets the coordinates for this buffer
 		 */
@@ -162,5 +175,7 @@ namespace gui {
 		gpos_t _minx,_miny,_maxx,_maxy;
 		// buffer for this window; controls use this, too (don't have their own)
 		uint8_t *_pixels;
+		// the rendering primitives for the current color-depth
+		PixelFormat *_format;
 	};
 }
@@ -0,0 +1,284 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <esc/proto/screen.h>
+#include <gui/graphics/color.h>
+#include <sys/common.h>
+#include <string.h>
+
+namespace gui {
+	/**
+	 * The pixel-format provides the rendering primitives for one color-depth. It is chosen once
+	 * per GraphicsBuffer, so that the drawing routines work on whole spans of pixels instead of
+	 * deciding the format for every single pixel.
+	 */
+	class PixelFormat {
+	public:
+		typedef Color::color_type color_type;
+
+		/**
+		 * Creates the pixel-format for the given screen mode
+		 *
+		 * @param mode the screen mode
+		 * @return the pixel-format (nullptr if the depth is not supported)
+		 */
+		static PixelFormat *create(const esc::Screen::Mode &mode);
+
+		/**
+		 * Constructor
+		 *
+		 * @param mode the screen mode
+		 */
+		explicit PixelFormat(const esc::Screen::Mode &mode)
+			: _bytespp(mode.bitsPerPixel / 8), _mode(mode) {
+		}
+		/**
+		 * Destructor
+		 */
+		virtual ~PixelFormat() {
+		}
+
+		/**
+		 * @return the number of bytes per pixel
+		 */
+		size_t getBytesPerPixel() const {
+			return _bytespp;
+		}
+
+		/**
+		 * Converts the given color into the value that is stored in the buffer
+		 *
+		 * @param col the color
+		 * @return the pixel value
+		 */
+		color_type fromColor(const Color &col) const {
+			color_type val = ((col.getRed() >> (8 - _mode.redMaskSize)) << _mode.redFieldPosition) |
+				((col.getGreen() >> (8 - _mode.greenMaskSize)) << _mode.greenFieldPosition) |
+				((col.getBlue() >> (8 - _mode.blueMaskSize)) << _mode.blueFieldPosition);
+			if(_bytespp == 4)
+				val |= (color_type)col.getAlpha() << 24;
+			return val;
+		}
+		/**
+		 * Converts the given pixel value back to a color.
+		 *
+		 * @param val the pixel value
+		 * @return the color
+		 */
+		Color toColor(color_type val) const {
+			return Color(component(val,_mode.redFieldPosition,_mode.redMaskSize),
+				component(val,_mode.greenFieldPosition,_mode.greenMaskSize),
+				component(val,_mode.blueFieldPosition,_mode.blueMaskSize));
+		}
+
+		/**
+		 * Fills <count> pixels at <dst> with <col>.
+		 *
+		 * @param dst the first pixel
+		 * @param count the number of pixels
+		 * @param col the pixel value
+		 */
+		virtual void fillSpan(uint8_t *dst,gsize_t count,color_type col) const = 0;
+
+		/**
+		 * Fills a rectangle of <width>*<height> pixels at <dst> with <col>.
+		 *
+		 * @param dst the top left pixel
+		 * @param stride the number of bytes per row in the buffer
+		 * @param width the width of the rectangle
+		 * @param height the height of the rectangle
+		 * @param col the pixel value
+		 */
+		void fillRect(uint8_t *dst,size_t stride,gsize_t width,gsize_t height,color_type col) const {
+			for(gsize_t y = 0; y < height; ++y) {
+				fillSpan(dst,width,col);
+				dst += stride;
+			}
+		}
+
+		/**
+		 * Draws the rows <yoff>..<yend>-1 and columns <xoff>..<xend>-1 of the given glyph with
+		 * <col>. Each row of the glyph is a byte, with the most significant bit being the leftmost
+		 * pixel.
+		 *
+		 * @param dst the pixel for the top left corner of the glyph
+		 * @param stride the number of bytes per row in the buffer
+		 * @param glyph the glyph bitmap
+		 * @param xoff the first column to draw
+		 * @param yoff the first row to draw
+		 * @param xend the end column
+		 * @param yend the end row
+		 * @param col the pixel value
+		 */
+		virtual void drawGlyph(uint8_t *dst,size_t stride,const uint8_t *glyph,gpos_t xoff,gpos_t yoff,
+			gpos_t xend,gpos_t yend,color_type col) const = 0;
+
+		/**
+		 * Blends the given colors over the <count> pixels at <dst>. An alpha-value of 0 means
+		 * opaque, 0xFF means completely transparent.
+		 *
+		 * @param dst the first pixel
+		 * @param src the colors (as 32-bit ARGB values)
+		 * @param count the number of pixels
+		 */
+		virtual void blendSpan(uint8_t *dst,const uint32_t *src,gsize_t count) const = 0;
+
+		/**
+		 * Copies <height> rows of <width> pixels from <src> to <dst>. The rows may overlap.
+		 *
+		 * @param dst the destination
+		 * @param dstride the number of bytes per row in the destination
+		 * @param src the source
+		 * @param sstride the number of bytes per row in the source
+		 * @param width the number of pixels per row
+		 * @param height the number of rows
+		 */
+		void copyRows(uint8_t *dst,ssize_t dstride,const uint8_t *src,ssize_t sstride,
+				gsize_t width,gsize_t height) const {
+			size_t bytes = width * _bytespp;
+			for(gsize_t y = 0; y < height; ++y) {
+				memmove(dst,src,bytes);
+				dst += dstride;
+				src += sstride;
+			}
+		}
+
+	protected:
+		/**
+		 * Blends <col> over <old>, both being ARGB values.
+		 */
+		static uint32_t blend(uint32_t old,uint32_t col) {
+			uint32_t a = col >> 24;
+			uint32_t rb = (((col & 0xFF00FF) * (0xFF - a)) + ((old & 0xFF00FF) * a)) >> 8;
+			uint32_t g = (((col & 0x00FF00) * (0xFF - a)) + ((old & 0x00FF00) * a)) >> 8;
+			return (rb & 0xFF00FF) | (g & 0x00FF00);
+		}
+		/**
+		 * Blends the ARGB color <col> over the pixel value <old>.
+		 */
+		color_type blendPixel(color_type old,uint32_t col) const {
+			uint32_t a = col >> 24;
+			if(EXPECT_TRUE(a == 0))
+				return fromColor(Color(col));
+			return fromColor(Color(blend(toColor(old).getColor(),col)));
+		}
+
+		static Color::comp_type component(color_type val,uint pos,uint size) {
+			uint c = (val >> pos) & ((1 << size) - 1);
+			// replicate the upper bits to get the full range
+			c <<= 8 - size;
+			return c | (c >> size);
+		}
+
+		size_t _bytespp;
+		esc::Screen::Mode _mode;
+	};
+
+	/**
+	 * The pixel-format for 16 and 32 bit pixels, which can be accessed as a whole.
+	 */
+	template<typename T>
+	class PixelFormatImpl : public PixelFormat {
+	public:
+		explicit PixelFormatImpl(const esc::Screen::Mode &mode) : PixelFormat(mode) {
+		}
+
+		virtual void fillSpan(uint8_t *dst,gsize_t count,color_type col) const {
+			T *pix = reinterpret_cast<T*>(dst);
+			T *end = pix + count;
+			// align to words
+			while(pix < end && ((uintptr_t)pix & (sizeof(ulong) - 1)))
+				*pix++ = col;
+			// write as many pixels as fit into a word at once
+			ulong word = pattern(col);
+			ulong *wpix = reinterpret_cast<ulong*>(pix);
+			ulong *wend = wpix + (end - pix) / (sizeof(ulong) / sizeof(T));
+			while(wpix + 4 <= wend) {
+				wpix[0] = word;
+				wpix[1] = word;
+				wpix[2] = word;
+				wpix[3] = word;
+				wpix += 4;
+			}
+			while(wpix < wend)
+				*wpix++ = word;
+			// the remaining pixels
+			pix = reinterpret_cast<T*>(wpix);
+			while(pix < end)
+				*pix++ = col;
+		}
+
+		virtual void drawGlyph(uint8_t *dst,size_t stride,const uint8_t *glyph,gpos_t xoff,gpos_t yoff,
+				gpos_t xend,gpos_t yend,color_type col) const {
+			dst += yoff * stride;
+			for(gpos_t y = yoff; y < yend; ++y) {
+				uint bits = glyph[y];
+				T *pix = reinterpret_cast<T*>(dst);
+				for(gpos_t x = xoff; x < xend; ++x) {
+					if(bits & (0x80 >> x))
+						pix[x] = col;
+				}
+				dst += stride;
+			}
+		}
+
+		virtual void blendSpan(uint8_t *dst,const uint32_t *src,gsize_t count) const {
+			T *pix = reinterpret_cast<T*>(dst);
+			for(gsize_t i = 0; i < count; ++i) {
+				uint32_t a = src[i] >> 24;
+				if(a != 0xFF)
+					pix[i] = blendPixel(pix[i],src[i]);
+			}
+		}
+
+	private:
+		static ulong pattern(color_type col) {
+			ulong word = static_cast<T>(col);
+			for(size_t i = 1; i < sizeof(ulong) / sizeof(T); ++i)
+				word = (word << (sizeof(T) * 8)) | static_cast<T>(col);
+			return word;
+		}
+	};
+
+	/**
+	 * The pixel-format for 24 bit pixels.
+	 */
+	class PixelFormat24 : public PixelFormat {
+	public:
+		explicit PixelFormat24(const esc::Screen::Mode &mode) : PixelFormat(mode) {
+		}
+
+		virtual void fillSpan(uint8_t *dst,gsize_t count,color_type col) const;
+		virtual void drawGlyph(uint8_t *dst,size_t stride,const uint8_t *glyph,gpos_t xoff,gpos_t yoff,
+			gpos_t xend,gpos_t yend,color_type col) const;
+		virtual void blendSpan(uint8_t *dst,const uint32_t *src,gsize_t count) const;
+
+	private:
+		static void set(uint8_t *dst,color_type col) {
+			memcpy(dst,&col,3);
+		}
+		static color_type get(const uint8_t *src) {
+			color_type col = 0;
+			memcpy(&col,src,3);
+			return col;
+		}
+	};
+}
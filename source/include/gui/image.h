@@ -44,6 +44,10 @@ namespace gui {
 				_g->doSetPixel(x + _pos.x,y + _pos.y);
 		}
 
+		virtual void paintRow(gpos_t x,gpos_t y,const uint32_t *cols,gsize_t count) {
+			_g->doBlendSpan(x + _pos.x,y + _pos.y,cols,count);
+		}
+
 	private:
 		Graphics *_g;
 		uint32_t _last;
@@ -34,6 +34,20 @@ public:
 	}
 
 	virtual void paintPixel(gpos_t x,gpos_t y,uint32_t col) = 0;
+
+	/**
+	 * Paints <count> pixels in the row <y>, starting at <x>. By default, this paints the pixels
+	 * one by one.
+	 *
+	 * @param x the x-coordinate of the first pixel
+	 * @param y the y-coordinate
+	 * @param cols the colors
+	 * @param count the number of pixels
+	 */
+	virtual void paintRow(gpos_t x,gpos_t y,const uint32_t *cols,gsize_t count) {
+		for(gsize_t i = 0; i < count; ++i)
+			paintPixel(x + i,y,cols[i]);
+	}
 };
 
 class Image {
@@ -21,6 +21,7 @@
 
 #include <esc/stream/istream.h>
 #include <esc/stream/ostream.h>
+#include <sys/procstats.h>
 #include <limits>
 #include <stddef.h>
 #include <string>
@@ -49,6 +50,7 @@ namespace info {
 			  _sharedFrames(0), _swapped(0), _cycles(0), _runtime(0), _input(0), _output(0),
 			  _cmd() {
 		}
+		explicit process(const struct procstats_proc &rec,bool fullcmd = false);
 		process(const process& p);
 		process& operator =(const process& p);
 
@@ -0,0 +1,92 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <sys/common.h>
+#include <sys/procstats.h>
+
+namespace info {
+	/**
+	 * A binary snapshot of all processes and threads, taken with a single read of /sys/procstats.
+	 * This is much cheaper than reading and parsing the info-files of every process and thread.
+	 */
+	class procstats {
+	public:
+		/**
+		 * Takes a snapshot.
+		 *
+		 * @throws if /sys/procstats does not exist or has an unsupported version
+		 */
+		explicit procstats();
+		~procstats() {
+			delete[] _buf;
+		}
+
+		/**
+		 * No copying
+		 */
+		procstats(const procstats&) = delete;
+		procstats &operator=(const procstats&) = delete;
+
+		/**
+		 * @return the number of processes/threads
+		 */
+		size_t proc_count() const {
+			return _hdr->procCount;
+		}
+		size_t thread_count() const {
+			return _hdr->threadCount;
+		}
+
+		/**
+		 * @return the TSC value at the time of the snapshot
+		 */
+		uint64_t cycles() const {
+			return _hdr->cycles;
+		}
+		/**
+		 * @return the uptime in seconds
+		 */
+		uint64_t uptime() const {
+			return _hdr->uptime;
+		}
+
+		/**
+		 * @param i the index
+		 * @return the <i>th process/thread record. Fields the kernel does not provide are zero.
+		 */
+		struct procstats_proc proc(size_t i) const {
+			struct procstats_proc rec;
+			get(&rec,sizeof(rec),_hdr->hdrSize + i * _hdr->procSize,_hdr->procSize);
+			return rec;
+		}
+		struct procstats_thread thread(size_t i) const {
+			struct procstats_thread rec;
+			size_t off = _hdr->hdrSize + _hdr->procCount * _hdr->procSize + i * _hdr->threadSize;
+			get(&rec,sizeof(rec),off,_hdr->threadSize);
+			return rec;
+		}
+
+	private:
+		void get(void *rec,size_t size,size_t off,size_t recsize) const;
+
+		char *_buf;
+		const struct procstats_hdr *_hdr;
+	};
+}
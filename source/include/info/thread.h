@@ -21,6 +21,7 @@
 
 #include <esc/stream/istream.h>
 #include <esc/stream/ostream.h>
+#include <sys/procstats.h>
 #include <vector>
 
 namespace info {
@@ -48,7 +49,15 @@ namespace info {
 	public:
 		thread()
 			: _tid(0), _pid(0), _procName(), _state(0), _flags(), _prio(0),
-			  _stackPages(0), _schedCount(0), _syscalls(0), _cycles(0), _runtime(0), _cpu(0) {
+			  _stackPages(0), _schedCount(0), _syscalls(0), _cycles(0), _runtime(0), _cpu(0),
+			  _wakeups(0), _wakeupLatency(0) {
+		}
+		explicit thread(const struct procstats_thread &rec,const std::string &procName)
+			: _tid(rec.tid), _pid(rec.pid), _procName(procName), _state(rec.state),
+			  _flags(rec.flags), _prio(rec.priority), _stackPages(rec.stackPages),
+			  _schedCount(rec.schedCount), _syscalls(rec.syscalls), _cycles(rec.cycles),
+			  _runtime(rec.runtime), _cpu(rec.cpu), _wakeups(rec.wakeups),
+			  _wakeupLatency(rec.wakeupLatency) {
 		}
 
 		std::string procName() const {
@@ -87,6 +96,15 @@ namespace info {
 		cpu_type cpu() const {
 			return _cpu;
 		}
+		size_type wakeups() const {
+			return _wakeups;
+		}
+		/**
+		 * @return the average number of cycles between a wakeup and the next run
+		 */
+		cycle_type wakeupLatency() const {
+			return _wakeupLatency;
+		}
 
 	private:
 		tid_type _tid;
@@ -101,6 +119,8 @@ namespace info {
 		cycle_type _cycles;
 		time_type _runtime;
 		cpu_type _cpu;
+		size_type _wakeups;
+		cycle_type _wakeupLatency;
 	};
 
 	esc::IStream& operator >>(esc::IStream& is,thread& t);
@@ -0,0 +1,152 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/common.h>
+#include <sys/proc.h>
+
+/* the maximum number of actions in posix_spawn_file_actions_t */
+#define SPAWN_MAX_ACTIONS	8
+
+enum {
+	SPAWN_CLOSE,
+	SPAWN_DUP2,
+	SPAWN_OPEN,
+};
+
+typedef struct {
+	int type;
+	int fd;
+	int src;
+	char *path;
+	uint oflag;
+	mode_t mode;
+} sSpawnAction;
+
+typedef struct {
+	size_t count;
+	sSpawnAction actions[SPAWN_MAX_ACTIONS];
+} posix_spawn_file_actions_t;
+
+typedef struct {
+	short flags;
+} posix_spawnattr_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * Initializes the given file actions with an empty list.
+ *
+ * @param fa the file actions
+ * @return 0 on success
+ */
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa);
+
+/**
+ * Destroys the given file actions.
+ *
+ * @param fa the file actions
+ * @return 0 on success
+ */
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa);
+
+/**
+ * Adds the action to close <fd> in the child.
+ *
+ * @param fa the file actions
+ * @param fd the file descriptor
+ * @return 0 on success or a negative error-code
+ */
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa,int fd);
+
+/**
+ * Adds the action to make <newfd> a copy of <fd> in the child.
+ *
+ * @param fa the file actions
+ * @param fd the file descriptor to copy
+ * @param newfd the file descriptor to replace
+ * @return 0 on success or a negative error-code
+ */
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,int fd,int newfd);
+
+/**
+ * Adds the action to open <path> as <fd> in the child. Note that the file is opened by the
+ * parent in posix_spawn().
+ *
+ * @param fa the file actions
+ * @param fd the file descriptor to use
+ * @param path the path to open
+ * @param oflag the open flags
+ * @param mode the mode to use, if the file is created
+ * @return 0 on success or a negative error-code
+ */
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa,int fd,const char *path,
+	int oflag,mode_t mode);
+
+/**
+ * Initializes the given attributes. Attributes are not supported yet.
+ *
+ * @param attr the attributes
+ * @return 0 on success
+ */
+int posix_spawnattr_init(posix_spawnattr_t *attr);
+
+/**
+ * Destroys the given attributes.
+ *
+ * @param attr the attributes
+ * @return 0 on success
+ */
+int posix_spawnattr_destroy(posix_spawnattr_t *attr);
+
+/**
+ * Creates a new process that executes the program at <path>, without cloning the address space
+ * of the current process. The child inherits all file descriptors and applies <fa> to them.
+ *
+ * @param pid will be set to the pid of the child (may be NULL)
+ * @param path the program-path
+ * @param fa the file actions (may be NULL)
+ * @param attr the attributes (may be NULL)
+ * @param argv a NULL-terminated array of arguments
+ * @param envp a NULL-terminated array of environment-variables (NULL = the current environment)
+ * @return 0 on success or a negative error-code
+ */
+int posix_spawn(pid_t *pid,const char *path,const posix_spawn_file_actions_t *fa,
+	const posix_spawnattr_t *attr,char *const argv[],char *const envp[]);
+
+/**
+ * The same as posix_spawn(), but if <file> does not contain a slash, it is searched in PATH.
+ *
+ * @param pid will be set to the pid of the child (may be NULL)
+ * @param file the file to execute
+ * @param fa the file actions (may be NULL)
+ * @param attr the attributes (may be NULL)
+ * @param argv a NULL-terminated array of arguments
+ * @param envp a NULL-terminated array of environment-variables (NULL = the current environment)
+ * @return 0 on success or a negative error-code
+ */
+int posix_spawnp(pid_t *pid,const char *file,const posix_spawn_file_actions_t *fa,
+	const posix_spawnattr_t *attr,char *const argv[],char *const envp[]);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -43,6 +43,19 @@ typedef struct {
 	llong rem;
 } lldiv_t;
 
+/* statistics of the heap */
+typedef struct {
+	size_t heapPages;		/* pages taken from the data-region */
+	size_t spans;			/* spans that have been carved for the size-classes */
+	size_t usedBytes;		/* bytes in use by small objects */
+	size_t largeBytes;		/* bytes mapped for large objects */
+	size_t largeCount;		/* number of large objects */
+	size_t mallocs;			/* number of small allocations */
+	size_t frees;			/* number of small deallocations */
+	size_t cacheRefills;	/* number of times a thread-cache fetched objects from a size-class */
+	size_t cacheFlushes;	/* number of times a thread-cache gave objects back to a size-class */
+} sHeapStats;
+
 /**
  * An array of strings, terminated with NULL
  */
@@ -231,12 +244,21 @@ bool isOnHeap(const void *ptr);
 
 /**
  * Note that the heap does increase the data-pages of the process as soon as it's required and
- * does not decrease them. So the free-space may increase during runtime!
+ * does not decrease them. So the free-space may increase during runtime! Objects in the caches of
+ * the threads count as free, while large objects, that are mapped separately, are not included.
  *
  * @return the free space on the heap
  */
 size_t heapspace(void);
 
+/**
+ * Collects statistics about the heap. Note that the values of other threads might change while
+ * they are collected.
+ *
+ * @param stats the statistics to fill
+ */
+void heapstats(sHeapStats *stats);
+
 #if DEBUGGING
 /**
  * Prints the heap
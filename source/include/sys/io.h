@@ -63,6 +63,7 @@ enum {
 	F_GETACCESS				= 2,
 	F_SEMUP					= 3,
 	F_SEMDOWN				= 4,
+	F_GETREFS				= 5,
 };
 
 /* seek-types */
@@ -77,6 +78,15 @@ enum {
 	DEL_ARG_SHFILE			= -1,
 };
 
+/* reserved obtain arguments */
+enum {
+	/* obtain a shared memory file that holds the contents of a memory-backed block device. mapping
+	 * it with MAP_SHARED gives direct access to the device's memory */
+	OBT_ARG_DAX				= -1,
+	/* obtain the shared memory file with the ring buffer of a pipe (see sys/pipe.h) */
+	OBT_ARG_PIPERING		= -2,
+};
+
 /* retry a syscall until it succeeded, skipping tries that failed because of a signal */
 #define IGNSIGS(expr) ({ \
 		int __err; \
@@ -149,7 +159,8 @@ A_CHECKRET static inline int tell(int fd,off_t *pos) {
  * @param fd the file-descriptor
  * @param cmd the command (F_*)
  * @param arg the argument (just used for F_SETFL)
- * @return >= 0 on success
+ * @return >= 0 on success (for F_GETREFS, the number of file-descriptors in all processes that
+ *  refer to the file)
  */
 static inline int fcntl(int fd,uint cmd,int arg) {
 	return syscall3(SYSCALL_FCNTL,fd,cmd,arg);
@@ -193,6 +204,23 @@ A_CHECKRET static inline ssize_t write(int fd,const void *buffer,size_t count) {
 	return syscall3(SYSCALL_WRITE,fd,(ulong)buffer,count);
 }
 
+/**
+ * Copies up to <count> bytes from <infd> to <outfd>, starting at the current positions of both
+ * files and advancing them. The data does not pass through the caller: if both files are on the
+ * same filesystem, the filesystem copies it itself. Otherwise, the kernel moves it from one
+ * driver to the other via <shm>, which has to be shared with both (see delegate()).
+ *
+ * @param infd the file-descriptor to read from
+ * @param outfd the file-descriptor to write to
+ * @param shm the buffer that is shared with both drivers (may be NULL)
+ * @param count the max. number of bytes to copy
+ * @return the number of copied bytes (0 = end of file), -ENOTSUP if the data has to be copied
+ *  manually or another negative error-code
+ */
+A_CHECKRET static inline ssize_t copyrange(int infd,int outfd,void *shm,size_t count) {
+	return syscall4(SYSCALL_COPYRANGE,infd,outfd,(ulong)shm,count);
+}
+
 /**
  * Truncates the file to <length> bytes by either extending it with 0-bytes or cutting it to
  * that length.
@@ -476,6 +504,16 @@ A_CHECKRET int fsymlink(const char *target,int fd,const char *name);
  */
 A_CHECKRET ssize_t readlink(const char *path,char *buf,size_t size);
 
+/**
+ * Waits until <path> exists in the virtual filesystem, e.g., until a driver has created the
+ * device. In contrast to polling with open(), the caller is woken up as soon as a node appears.
+ *
+ * @param path the path
+ * @param msecs the maximum time to wait in milliseconds (0 = forever)
+ * @return 0 if it exists, -ETIMEOUT if it didn't appear in time or a negative error code
+ */
+A_CHECKRET int waitpath(const char *path,time_t msecs);
+
 /**
  * Writes all dirty objects of the affected filesystem to disk
  *
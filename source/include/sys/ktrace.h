@@ -0,0 +1,70 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/common.h>
+
+/**
+ * The kernel tracepoints, exported in /sys/trace. Writing a mask of (1 << KTRACE_*) bits to the
+ * file enables the corresponding tracepoints; writing 0 disables all of them. Each CPU records its
+ * events into its own ring buffer, so that old events are overwritten if the reader is too slow.
+ * A read returns a header, followed by <eventCount> records of <eventSize> bytes. The events are
+ * sorted by CPU and, per CPU, from the oldest to the newest.
+ */
+
+#define KTRACE_PATH				"/sys/trace"
+#define KTRACE_VERSION			1
+
+/* the lock contention statistics as text; only collected if KTRACE_LOCK is enabled */
+#define LOCKSTAT_PATH			"/sys/lockstat"
+
+/* the event types; the meaning of the arguments is given in the comments */
+enum {
+	KTRACE_SCHED,				/* a context switch: old tid, new tid */
+	KTRACE_MSG_SEND,			/* a message has been sent: msg id, length, channel inode */
+	KTRACE_MSG_RECV,			/* a message has been received: msg id, length, channel inode */
+	KTRACE_PAGEFAULT,			/* a page fault: address, write */
+	KTRACE_LOCK,				/* a contended spinlock: call site, wait cycles */
+	KTRACE_TYPES
+};
+
+#define KTRACE_ALL				((1 << KTRACE_TYPES) - 1)
+
+struct ktrace_hdr {
+	uint32_t version;
+	uint32_t hdrSize;
+	uint32_t eventSize;
+	uint32_t cpuCount;
+	uint32_t eventCount;
+	/* the currently enabled tracepoints */
+	uint32_t mask;
+	/* the number of events that have been overwritten before they could be read */
+	uint64_t lost;
+};
+
+struct ktrace_event {
+	/* the TSC value at the time of the event */
+	uint64_t tsc;
+	uint32_t type;
+	uint32_t cpu;
+	uint32_t tid;
+	uint32_t pid;
+	uint64_t args[3];
+};
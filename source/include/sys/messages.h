@@ -49,6 +49,9 @@ enum {
 	MSG_FS_UTIME					= 113,
 	MSG_FS_TRUNCATE					= 114,
 	MSG_FS_SYMLINK					= 115,
+	MSG_FS_STAT						= 116,
+	MSG_FS_READDIRPLUS				= 117,
+	MSG_FS_COPYRANGE				= 118,
 
 	/* speaker */
 	MSG_SPEAKER_BEEP				= 200,	/* performs a beep */
@@ -142,6 +145,11 @@ enum {
 
 	/* initui */
 	MSG_INITUI_START				= 1500,	/* starts a new UI */
+
+	/* pipe */
+	MSG_PIPE_ISPIPE					= 1600,	/* dummy message on which only pipe answers with no error */
+	MSG_PIPE_WAIT					= 1601,	/* waits until the ring buffer can be used again */
+	MSG_PIPE_WAKE					= 1602,	/* wakes up the other end; has no response */
 };
 
 static const size_t IPC_DEF_SIZE	= 256;
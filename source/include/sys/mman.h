@@ -49,6 +49,9 @@ enum {
 	MATTR_WC			= 1,		/* write combining */
 };
 
+/* the maximum number of pages that can be translated by virt2phys at once */
+#define MAX_VIRT2PHYS_PAGES	32
+
 struct mmap_params {
 	void *addr;
 	size_t length;
@@ -113,6 +116,20 @@ static inline int mattr(uintptr_t phys,size_t bytes,int attr) {
 	return syscall3(SYSCALL_MATTR,phys,bytes,attr);
 }
 
+/**
+ * Determines the physical addresses of the <count> pages at <virt>. The pages have to belong to
+ * a locked region (see mlock) and have to be present. This way, the frames can be used for DMA.
+ * Only root and members of DRIVER_GID are allowed to do that.
+ *
+ * @param virt the virtual address (page-aligned)
+ * @param count the number of pages (at most MAX_VIRT2PHYS_PAGES)
+ * @param phys the array to write the physical addresses to
+ * @return 0 on success
+ */
+static inline int virt2phys(const void *virt,size_t count,uintptr_t *phys) {
+	return syscall3(SYSCALL_VIRT2PHYS,(ulong)virt,count,(ulong)phys);
+}
+
 /**
  * Changes the protection of the region denoted by the given address.
  *
@@ -0,0 +1,216 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/atomic.h>
+#include <sys/common.h>
+#include <string.h>
+
+/**
+ * Pipes are provided by the pipe driver, but the data is kept in a ring buffer in a shared memory
+ * file, which both ends can map via pipemap(). There is always exactly one producer (the writer or
+ * the driver on behalf of it) and one consumer (the reader or the driver on behalf of it), so that
+ * no locks are needed: wrpos and rdpos are free-running counters and are only changed by the
+ * producer and consumer, respectively. If one side has to block, it asks the driver to wait,
+ * which sets rdwait or wrwait. If the other side finds the flag set after it has moved its
+ * position, it clears it and sends MSG_PIPE_WAKE to the driver.
+ */
+
+/* the size of the data area of the ring (a power of 2) */
+#define PIPE_RING_SIZE			(128 * 1024)
+/* the offset of the data area in the shared memory file */
+#define PIPE_RING_DATA			256
+
+/* flags for tPipeRing.closed */
+enum {
+	PIPE_RDCLOSED			= 1,
+	PIPE_WRCLOSED			= 2,
+};
+
+typedef struct {
+	/* the number of bytes written so far */
+	volatile size_t wrpos;
+	/* set if the consumer waits for data */
+	volatile long rdwait;
+	/* the number of bytes read so far; on a separate cache line to not slow down the producer */
+	volatile size_t rdpos A_ALIGNED(64);
+	/* set if the producer waits for space */
+	volatile long wrwait;
+	/* the ends that have been closed (set by the driver) */
+	volatile int closed A_ALIGNED(64);
+} tPipeRing;
+
+/* a mapped end of a pipe */
+typedef struct {
+	int fd;
+	int shmfd;
+	/* the message-id of an interrupted wait, whose response has not been received yet */
+	msgid_t waitmid;
+	tPipeRing *ring;
+} tPipeEnd;
+
+static inline char *pipering_data(tPipeRing *r) {
+	return (char*)r + PIPE_RING_DATA;
+}
+
+static inline size_t pipering_used(const tPipeRing *r) {
+	/* the positions are writable by both ends; never trust them to be consistent */
+	size_t used = r->wrpos - r->rdpos;
+	return used > PIPE_RING_SIZE ? PIPE_RING_SIZE : used;
+}
+
+static inline size_t pipering_free(const tPipeRing *r) {
+	return PIPE_RING_SIZE - pipering_used(r);
+}
+
+/**
+ * Publishes <count> bytes that have been written at wrpos. Has to be called by the producer only.
+ *
+ * @param r the ring
+ * @param count the number of bytes
+ */
+static inline void pipering_commitwrite(tPipeRing *r,size_t count) {
+	/* the data has to be visible before the position and the position before we check rdwait */
+	__sync_synchronize();
+	r->wrpos += count;
+	__sync_synchronize();
+}
+
+/**
+ * Releases <count> bytes that have been read at rdpos. Has to be called by the consumer only.
+ *
+ * @param r the ring
+ * @param count the number of bytes
+ */
+static inline void pipering_commitread(tPipeRing *r,size_t count) {
+	/* the data has to be read before the producer may overwrite it */
+	__sync_synchronize();
+	r->rdpos += count;
+	__sync_synchronize();
+}
+
+/**
+ * Appends <count> bytes to the ring. Has to be called by the producer only, which has to make sure
+ * that there is enough space.
+ *
+ * @param r the ring
+ * @param src the data
+ * @param count the number of bytes
+ */
+static inline void pipering_put(tPipeRing *r,const void *src,size_t count) {
+	size_t off = r->wrpos & (PIPE_RING_SIZE - 1);
+	size_t first = MIN(count,PIPE_RING_SIZE - off);
+	memcpy(pipering_data(r) + off,src,first);
+	memcpy(pipering_data(r),(const char*)src + first,count - first);
+	pipering_commitwrite(r,count);
+}
+
+/**
+ * Removes <count> bytes from the ring. Has to be called by the consumer only, which has to make
+ * sure that there are enough bytes.
+ *
+ * @param r the ring
+ * @param dst the buffer to copy the data to
+ * @param count the number of bytes
+ */
+static inline void pipering_get(tPipeRing *r,void *dst,size_t count) {
+	size_t off = r->rdpos & (PIPE_RING_SIZE - 1);
+	size_t first = MIN(count,PIPE_RING_SIZE - off);
+	memcpy(dst,pipering_data(r) + off,first);
+	memcpy((char*)dst + first,pipering_data(r),count - first);
+	pipering_commitread(r,count);
+}
+
+/**
+ * Checks whether <flag> is set and clears it, if so. The side that does that has to wake up the
+ * other side via MSG_PIPE_WAKE.
+ *
+ * @param flag the rdwait or wrwait flag
+ * @return true if the flag was set
+ */
+static inline bool pipering_takewait(volatile long *flag) {
+	return *flag && atomic_cmpnswap(flag,1,0);
+}
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * Checks whether <fd> is an end of a pipe, that supports the shared ring buffer. This requires
+ * that it has been opened with O_MSGS.
+ *
+ * @param fd the file-descriptor
+ * @return true if so
+ */
+bool ispipe(int fd);
+
+/**
+ * Maps the ring buffer of the pipe end <fd>, so that it can be used with piperead() and
+ * pipewrite() without going through the driver, unless blocking is required. Note that an end
+ * that has been mapped should only be used by one process at a time.
+ *
+ * @param fd the file-descriptor of the pipe end
+ * @return the mapped end or NULL if it failed (errno is set)
+ */
+tPipeEnd *pipemap(int fd);
+
+/**
+ * Maps the ring buffer of <fd> like pipemap(), but only if <fd> is a pipe end that is not shared
+ * with other file-descriptors, neither in this nor in other processes. This is used by stdio for
+ * all streams, so that the processes of a pipeline exchange the data without the driver.
+ *
+ * @param fd the file-descriptor
+ * @return the mapped end or NULL if <fd> is no pipe, is shared or the mapping failed
+ */
+tPipeEnd *pipemapexcl(int fd);
+
+/**
+ * Reads up to <count> bytes from the given pipe end into <buffer>. Blocks if the pipe is empty.
+ *
+ * @param end the pipe end
+ * @param buffer the buffer
+ * @param count the max. number of bytes
+ * @return the number of read bytes (0 = the writer has been closed) or a negative error-code
+ */
+ssize_t piperead(tPipeEnd *end,void *buffer,size_t count);
+
+/**
+ * Writes <count> bytes from <buffer> into the given pipe end. Blocks until everything has been
+ * written.
+ *
+ * @param end the pipe end
+ * @param buffer the data
+ * @param count the number of bytes
+ * @return the number of written bytes or a negative error-code (-EDESTROYED if the reader has
+ *  been closed)
+ */
+ssize_t pipewrite(tPipeEnd *end,const void *buffer,size_t count);
+
+/**
+ * Unmaps the given pipe end. The file-descriptor itself is not closed.
+ *
+ * @param end the pipe end
+ */
+void pipeunmap(tPipeEnd *end);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -26,12 +26,20 @@
 
 typedef void (*fExitFunc)(void *arg);
 
+/* a file descriptor action for fspawn(): <fd> becomes a copy of <src> or is closed (src = -1) */
+typedef struct {
+	int src;
+	int fd;
+} sSpawnFd;
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 static const uid_t ROOT_UID				= 0;
 static const gid_t ROOT_GID				= 0;
+/* the group all drivers are members of */
+static const gid_t DRIVER_GID			= 1;
 
 extern char **environ;
 
@@ -133,12 +141,25 @@ static inline int isingroup(pid_t pid,gid_t gid) {
 }
 
 /**
- * Clones the current process
+ * Clones the current process. Only the calling thread exists in the child.
  *
  * @return new pid for parent, 0 for child, < 0 if failed
  */
-A_CHECKRET static inline int fork(void) {
-	return syscall0(SYSCALL_FORK);
+A_CHECKRET int fork(void);
+
+/**
+ * Creates a new process that executes the given program. In contrast to fork() + exec(), the
+ * address space is not cloned. The child inherits all file descriptors and applies <fds> to
+ * them before the program is started.
+ *
+ * @param fd the file descriptor to the program (with exec and read permissions; stays open)
+ * @param fds the file descriptor actions, terminated by an entry with fd = -1 (may be NULL)
+ * @param args a NULL-terminated array of arguments
+ * @param env a NULL-terminated array of environment-variables
+ * @return the pid of the child or a negative error-code
+ */
+A_CHECKRET static inline int fspawn(int fd,const sSpawnFd *fds,const char **args,const char **env) {
+	return syscall4(SYSCALL_SPAWN,fd,(ulong)fds,(ulong)args,(ulong)env);
 }
 
 /**
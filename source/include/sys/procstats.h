@@ -0,0 +1,88 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <sys/common.h>
+
+/**
+ * The binary snapshot of all processes and threads in /sys/procstats. A single read returns a
+ * header, followed by <procCount> records of <procSize> bytes and <threadCount> records of
+ * <threadSize> bytes. New fields are only added at the end of the records, so that readers can
+ * use the sizes from the header to skip unknown fields. The version is increased if existing
+ * fields change.
+ */
+
+#define PROCSTATS_PATH			"/sys/procstats"
+#define PROCSTATS_VERSION		1
+#define PROCSTATS_CMD_LEN		64
+
+/* flags for procstats_proc */
+#define PROCSTATS_CMD_TRUNC		0x1		/* the command has been truncated */
+
+struct procstats_hdr {
+	uint32_t version;
+	uint32_t hdrSize;
+	uint32_t procSize;
+	uint32_t threadSize;
+	uint32_t procCount;
+	uint32_t threadCount;
+	/* the TSC value at the time of the snapshot */
+	uint64_t cycles;
+	/* the uptime in seconds */
+	uint64_t uptime;
+};
+
+struct procstats_proc {
+	uint32_t pid;
+	uint32_t ppid;
+	uint32_t uid;
+	uint32_t gid;
+	uint32_t flags;
+	uint32_t threadCount;
+	/* memory usage in pages/frames */
+	uint64_t pages;
+	uint64_t ownFrames;
+	uint64_t sharedFrames;
+	uint64_t swapped;
+	/* I/O in bytes */
+	uint64_t input;
+	uint64_t output;
+	/* the total runtime in microseconds and the cycles of the last second */
+	uint64_t runtime;
+	uint64_t cycles;
+	char command[PROCSTATS_CMD_LEN];
+};
+
+struct procstats_thread {
+	uint32_t tid;
+	uint32_t pid;
+	uint32_t state;
+	uint32_t flags;
+	uint32_t priority;
+	uint32_t cpu;
+	uint64_t stackPages;
+	uint64_t schedCount;
+	uint64_t syscalls;
+	/* the total runtime in microseconds and the cycles of the last second */
+	uint64_t runtime;
+	uint64_t cycles;
+	uint64_t wakeups;
+	/* the average wakeup latency in cycles */
+	uint64_t wakeupLatency;
+};
@@ -114,6 +114,12 @@ enum {
 	SYSCALL_UTIME,
 	SYSCALL_TRUNCATE,
 	SYSCALL_SYMLINK,
+	SYSCALL_WAITPATH,
+	SYSCALL_SPAWN,
+	SYSCALL_VIRT2PHYS,
+	SYSCALL_STAT,
+	SYSCALL_READDIRPLUS,
+	SYSCALL_COPYRANGE,
 #	ifdef __x86__
 	SYSCALL_REQIOPORTS,
 	SYSCALL_RELIOPORTS,
@@ -134,6 +140,9 @@ enum {
 #	endif
 #endif
 
+/* the maximum number of file descriptor actions for SYSCALL_SPAWN */
+#define MAX_SPAWN_FDS					16
+
 #if defined(__x86__)
 #	define ASM_IRQ_ACKSIG				49
 #endif
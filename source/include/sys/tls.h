@@ -30,7 +30,7 @@
 #	include <sys/arch/mmix/tls.h>
 #endif
 
-#define MAX_TLS_ENTRIES		4
+#define MAX_TLS_ENTRIES		8
 
 #if defined(__cplusplus)
 extern "C" {
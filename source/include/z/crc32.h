@@ -24,7 +24,8 @@
 namespace z {
 
 /**
- * Computes the Cyclic Redundancy Check.
+ * Computes the Cyclic Redundancy Check. The implementation uses the slicing-by-8 technique, i.e.,
+ * it processes 8 bytes per step with 8 tables, which are shared by all instances.
  */
 class CRC32 {
 public:
@@ -58,7 +59,10 @@ public:
 	type update(type crc,const void *buf,size_t len);
 
 private:
-	type _table[256];
+	static void init();
+
+	static type _table[8][256];
+	static bool _initialized;
 };
 
 }
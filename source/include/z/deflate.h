@@ -26,6 +26,7 @@
 #include <z/deflatebase.h>
 #include <algorithm>
 #include <assert.h>
+#include <string.h>
 
 namespace z {
 
@@ -50,25 +51,13 @@ public:
 	virtual size_t count() const = 0;
 
 	/**
-	 * @return true if there is more data than the current block
-	 */
-	virtual bool more() = 0;
-
-	/**
-	 * @return the remaining data from the currently cached block
-	 */
-	virtual size_t cached() = 0;
-
-	/**
-	 * @param off the offset (might be negative). has to be within the current block
-	 * @return the byte at current position plus <off>
-	 */
-	virtual uint8_t peek(ssize_t off) = 0;
-
-	/**
-	 * @return the next byte
+	 * Reads up to <count> bytes into <buf>.
+	 *
+	 * @param buf the buffer to read into
+	 * @param count the maximum number of bytes
+	 * @return the number of read bytes (0 if there is no more data)
 	 */
-	virtual uint8_t get() = 0;
+	virtual size_t read(uint8_t *buf,size_t count) = 0;
 };
 
 /**
@@ -85,76 +74,42 @@ public:
 	 * @param c the character to write
 	 */
 	virtual void put(uint8_t c) = 0;
+
+	/**
+	 * Writes the <count> bytes at <buf> to the drain.
+	 *
+	 * @param buf the bytes
+	 * @param count the number of bytes
+	 */
+	virtual void write(const uint8_t *buf,size_t count) {
+		while(count-- > 0)
+			put(*buf++);
+	}
 };
 
 /**
  * A source implementation that reads from a stream.
  */
 class StreamDeflateSource : public DeflateSource {
-	static const size_t CACHE_SIZE	= 4096;
-
 public:
 	explicit StreamDeflateSource(esc::IStream &is)
-		: DeflateSource(), _cache(new uint8_t[CACHE_SIZE / 2]), _next(new uint8_t[CACHE_SIZE / 2]),
-		  _pos(0), _cached(0), _nextcount(0), _total(0), _checksum(0), _crc(), _is(is) {
-	}
-	virtual ~StreamDeflateSource() {
-		delete[] _cache;
-		delete[] _next;
+		: DeflateSource(), _total(0), _checksum(0), _crc(), _is(is) {
 	}
 
 	virtual CRC32::type crc32() {
-		if(_pos != _cached) {
-			_checksum = _crc.update(_checksum,_cache,_pos);
-			_pos = _cached;
-		}
 		return _checksum;
 	}
 	virtual size_t count() const {
 		return _total;
 	}
-	virtual bool more() {
-		load();
-		return _nextcount > 0;
-	}
-	virtual size_t cached() {
-		load();
-		return _cached - _pos;
-	}
-	virtual uint8_t peek(ssize_t off) {
-		load();
-		assert(_pos + off >= 0 && _pos + off < _cached);
-		return _cache[_pos + off];
-	}
-	virtual uint8_t get() {
-		load();
-		assert(_pos < _cached);
-		_total++;
-		return _cache[_pos++];
+	virtual size_t read(uint8_t *buf,size_t count) {
+		size_t res = _is.read(buf,count);
+		_checksum = _crc.update(_checksum,buf,res);
+		_total += res;
+		return res;
 	}
 
 private:
-	void load() {
-		if(_cached - _pos == 0) {
-			bool first = _cached == 0 && _pos == 0;
-			if(!first)
-				_checksum = _crc.update(_checksum,_cache,_pos);
-			_cached = _is.read(_cache,CACHE_SIZE / 2);
-			_pos = 0;
-			if(first)
-				_nextcount = _is.read(_next,CACHE_SIZE / 2);
-			else {
-				std::swap(_cache,_next);
-				std::swap(_cached,_nextcount);
-			}
-		}
-	}
-
-	uint8_t *_cache;
-	uint8_t *_next;
-	size_t _pos;
-	size_t _cached;
-	size_t _nextcount;
 	size_t _total;
 	CRC32::type _checksum;
 	CRC32 _crc;
@@ -173,27 +128,133 @@ public:
 	virtual void put(uint8_t c) {
 		_os.write(c);
 	}
+	virtual void write(const uint8_t *buf,size_t count) {
+		_os.write(buf,count);
+	}
 
 private:
 	esc::OStream &_os;
 };
 
 /**
- * The encoder part of the deflate compression algorithm.
+ * A source implementation that reads from memory.
+ */
+class MemDeflateSource : public DeflateSource {
+public:
+	explicit MemDeflateSource(const void *buffer,size_t size)
+		: DeflateSource(), _buffer(reinterpret_cast<const uint8_t*>(buffer)), _size(size), _pos() {
+	}
+
+	virtual CRC32::type crc32() {
+		CRC32 crc;
+		return crc.get(_buffer,_pos);
+	}
+	virtual size_t count() const {
+		return _pos;
+	}
+	virtual size_t read(uint8_t *buf,size_t count) {
+		count = std::min(count,_size - _pos);
+		memcpy(buf,_buffer + _pos,count);
+		_pos += count;
+		return count;
+	}
+
+private:
+	const uint8_t *_buffer;
+	size_t _size;
+	size_t _pos;
+};
+
+/**
+ * A drain implementation that writes to memory. Everything behind the end of the buffer is
+ * dropped.
+ */
+class MemDeflateDrain : public DeflateDrain {
+public:
+	explicit MemDeflateDrain(void *buffer,size_t size)
+		: DeflateDrain(), _buffer(reinterpret_cast<uint8_t*>(buffer)), _size(size), _pos() {
+	}
+
+	/**
+	 * @return the number of written bytes
+	 */
+	size_t count() const {
+		return _pos;
+	}
+
+	virtual void put(uint8_t c) {
+		if(_pos < _size)
+			_buffer[_pos++] = c;
+	}
+	virtual void write(const uint8_t *buf,size_t count) {
+		count = std::min(count,_size - _pos);
+		memcpy(_buffer + _pos,buf,count);
+		_pos += count;
+	}
+
+private:
+	uint8_t *_buffer;
+	size_t _size;
+	size_t _pos;
+};
+
+/**
+ * The encoder part of the deflate compression algorithm. Matches are searched in a sliding
+ * window of 32K with hash chains. Depending on the level, the search is greedy or lazy, i.e.,
+ * a match is only taken if the match at the next position is not longer. Since all state of a
+ * compress-operation is allocated by it, an instance may be used by multiple threads
+ * simultaneously.
  */
 class Deflate : public DeflateBase {
-	struct Tree {
-		unsigned int litbase[4];
-		unsigned int length[4];
-		unsigned int codebase[4];
+	static const size_t WSIZE			= 32 * 1024;
+	static const size_t MIN_MATCH		= 3;
+	static const size_t MAX_MATCH		= 258;
+	static const size_t MIN_LOOKAHEAD	= MAX_MATCH + MIN_MATCH + 1;
+	static const size_t MAX_DIST		= WSIZE - MIN_LOOKAHEAD;
+	/* matches of length 3 are not worth it if they are too far away */
+	static const size_t TOO_FAR			= 4096;
+	static const size_t HASH_BITS		= 15;
+	static const size_t HASH_SIZE		= 1 << HASH_BITS;
+	static const size_t SYM_BUF_SIZE	= 16 * 1024;
+	static const size_t OUT_BUF_SIZE	= 4096;
+	static const size_t MAX_STORED		= 0xFFFF;
+
+	/* the parameters for the match search of one level */
+	struct Config {
+		uint16_t good_length;	/* reduce the chain length if we have a match of this length */
+		uint16_t max_lazy;		/* don't search for a better match if we have one of this length */
+		uint16_t nice_length;	/* stop the search if we have a match of this length */
+		uint16_t max_chain;		/* the maximum number of chain entries to visit */
 	};
 
 	struct Data {
 		DeflateSource *source;
-		unsigned int tag;
-		unsigned int bitcount;
-
 		DeflateDrain *drain;
+		const Config *config;
+
+		/* sliding window */
+		uint8_t window[2 * WSIZE];
+		int head[HASH_SIZE];
+		int prev[WSIZE];
+		size_t strstart;
+		size_t lookahead;
+		size_t match_start;
+		bool eof;
+
+		/* symbols of the current block */
+		uint16_t dists[SYM_BUF_SIZE];
+		uint8_t lcs[SYM_BUF_SIZE];
+		size_t symcount;
+		/* the window position and the number of bytes the block covers (the start becomes
+		 * negative if the bytes have been slided out of the window) */
+		long block_start;
+		size_t block_len;
+
+		/* bit output */
+		uint32_t tag;
+		unsigned int bitcount;
+		uint8_t out[OUT_BUF_SIZE];
+		size_t outpos;
 	};
 
 	enum {
@@ -204,8 +265,9 @@ class Deflate : public DeflateBase {
 public:
 	enum Level {
 		NONE	= 0,
-		FIXED	= 1,
-		DYN		= 2
+		FASTEST	= 1,
+		DEFAULT	= 6,
+		BEST	= 9
 	};
 
 	/**
@@ -218,25 +280,41 @@ public:
 	 *
 	 * @param drain the destination
 	 * @param source the source
-	 * @param compr the compression level
+	 * @param level the compression level (NONE .. BEST)
 	 * @return 0 on success or -1 on error
 	 */
-	int compress(DeflateDrain *drain,DeflateSource *source,int compr);
+	int compress(DeflateDrain *drain,DeflateSource *source,int level);
 
 private:
-	void flush(Data *d);
-	void writebit(Data *d,int bit);
-	void write_bits(Data *d,unsigned int bits,int num);
-	void write_bits_reverse(Data *d,unsigned int bits,unsigned int num);
-	void write_symbol(Data *d,Tree *t,unsigned int sym);
-	void write_int(Data *d,Tree *t,unsigned short *base,unsigned char *bits,unsigned int value,int add);
-	void write_symbol_chain(Data *d,Tree *lt,Tree *dt,unsigned int len,unsigned int dist);
-
-	void deflate_fixed_block(Data *d);
-	void deflate_uncompressed_block(Data *d);
-
-	Tree sltree;
-	Tree sdtree;
+	void flush_output(Data *d);
+	void flush_bits(Data *d);
+	void write_bits(Data *d,unsigned int bits,unsigned int num);
+
+	size_t read_fully(Data *d,uint8_t *buf,size_t count);
+	void fill_window(Data *d);
+	int insert_string(Data *d,size_t pos);
+	size_t longest_match(Data *d,int cur_match,size_t prev_length);
+
+	void tally_literal(Data *d,uint8_t c);
+	void tally_match(Data *d,size_t dist,size_t len);
+	size_t fixed_block_size(Data *d);
+	void stored_block(Data *d,const uint8_t *buf,size_t len,bool final);
+	void fixed_block(Data *d,bool final);
+	void flush_block(Data *d,bool final);
+
+	void deflate_stored(Data *d);
+	void deflate_fast(Data *d);
+	void deflate_slow(Data *d);
+
+	/* the fixed huffman codes (already reversed) */
+	uint16_t lit_codes[288];
+	uint8_t lit_lengths[288];
+	uint16_t dist_codes[30];
+	/* maps match lengths and distances to their code */
+	uint8_t length_code[MAX_MATCH - MIN_MATCH + 1];
+	uint8_t dist_code[512];
+
+	static const Config configs[];
 };
 
 }
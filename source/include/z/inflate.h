@@ -26,6 +26,7 @@
 #include <z/deflatebase.h>
 #include <algorithm>
 #include <assert.h>
+#include <string.h>
 
 namespace z {
 
@@ -41,6 +42,27 @@ public:
 	 * @return the next byte
 	 */
 	virtual uint8_t get() = 0;
+
+	/**
+	 * Provides the buffered input without consuming it. This allows Inflate to read the input
+	 * without a call per byte. The default implementation provides nothing, so that get() is
+	 * used instead.
+	 *
+	 * @param count will be set to the number of available bytes (0 if there are none)
+	 * @return the available bytes
+	 */
+	virtual const uint8_t *chunk(size_t *count) {
+		*count = 0;
+		return NULL;
+	}
+
+	/**
+	 * Marks the first <count> bytes of the last chunk as consumed.
+	 *
+	 * @param count the number of bytes
+	 */
+	virtual void consume(A_UNUSED size_t count) {
+	}
 };
 
 /**
@@ -72,6 +94,29 @@ public:
 	 * @param c the character to write
 	 */
 	virtual void put(uint8_t c) = 0;
+
+	/**
+	 * Writes the <count> bytes at <buf> to the drain.
+	 *
+	 * @param buf the bytes
+	 * @param count the number of bytes
+	 */
+	virtual void write(const uint8_t *buf,size_t count) {
+		while(count-- > 0)
+			put(*buf++);
+	}
+
+	/**
+	 * Writes the <len> bytes again that start <off> bytes ago. Note that <len> might be larger
+	 * than <off>, in which case the bytes written by this call are repeated.
+	 *
+	 * @param off the offset (at most 32*1024)
+	 * @param len the number of bytes
+	 */
+	virtual void copy(size_t off,size_t len) {
+		while(len-- > 0)
+			put(get(off));
+	}
 };
 
 /**
@@ -79,16 +124,43 @@ public:
  */
 class StreamInflateSource : public InflateSource {
 public:
+	static const size_t BUF_SIZE	= 4096;
+
 	explicit StreamInflateSource(esc::IStream &is)
-		: InflateSource(), _is(is) {
+		: InflateSource(), _is(is), _buf(new uint8_t[BUF_SIZE]), _pos(), _count() {
+	}
+	virtual ~StreamInflateSource() {
+		delete[] _buf;
 	}
 
 	virtual uint8_t get() {
-		return _is.get();
+		if(_pos == _count && fill() == 0)
+			return _is.get();
+		return _buf[_pos++];
+	}
+
+	virtual const uint8_t *chunk(size_t *count) {
+		if(_pos == _count)
+			fill();
+		*count = _count - _pos;
+		return _buf + _pos;
+	}
+	virtual void consume(size_t count) {
+		assert(_pos + count <= _count);
+		_pos += count;
 	}
 
 private:
+	size_t fill() {
+		_pos = 0;
+		_count = _is.read(_buf,BUF_SIZE);
+		return _count;
+	}
+
 	esc::IStream &_is;
+	uint8_t *_buf;
+	size_t _pos;
+	size_t _count;
 };
 
 /**
@@ -125,7 +197,37 @@ public:
 			_checksum = _crc.update(_checksum,_buf,BUF_SIZE);
 	}
 
+	virtual void write(const uint8_t *buf,size_t count) {
+		_os.write(buf,count);
+		while(count > 0) {
+			size_t amount = std::min(count,BUF_SIZE - _wpos);
+			memcpy(_buf + _wpos,buf,amount);
+			advance(amount);
+			buf += amount;
+			count -= amount;
+		}
+	}
+
+	virtual void copy(size_t off,size_t len) {
+		assert(off > 0 && off <= BUF_SIZE);
+		while(len > 0) {
+			size_t src = (_wpos + BUF_SIZE - off) % BUF_SIZE;
+			/* don't copy bytes that are written by this step and stay within the buffer */
+			size_t amount = std::min(std::min(len,off),std::min(BUF_SIZE - _wpos,BUF_SIZE - src));
+			memmove(_buf + _wpos,_buf + src,amount);
+			_os.write(_buf + _wpos,amount);
+			advance(amount);
+			len -= amount;
+		}
+	}
+
 private:
+	void advance(size_t amount) {
+		_wpos = (_wpos + amount) % BUF_SIZE;
+		if(_wpos == 0)
+			_checksum = _crc.update(_checksum,_buf,BUF_SIZE);
+	}
+
 	CRC32 _crc;
 	CRC32::type _checksum;
 	esc::OStream &_os;
@@ -145,6 +247,15 @@ public:
 		return _buffer[_pos++];
 	}
 
+	virtual const uint8_t *chunk(size_t *count) {
+		*count = _size - _pos;
+		return _buffer + _pos;
+	}
+	virtual void consume(size_t count) {
+		assert(_pos + count <= _size);
+		_pos += count;
+	}
+
 private:
 	uint8_t *_buffer;
 	size_t _size;
@@ -172,27 +283,66 @@ public:
 			_buffer[_pos++] = c;
 	}
 
+	virtual void write(const uint8_t *buf,size_t count) {
+		count = std::min(count,_size - _pos);
+		memcpy(_buffer + _pos,buf,count);
+		_pos += count;
+	}
+
+	virtual void copy(size_t off,size_t len) {
+		assert(off > 0 && off <= _pos);
+		len = std::min(len,_size - _pos);
+		uint8_t *dst = _buffer + _pos;
+		const uint8_t *src = dst - off;
+		_pos += len;
+		/* if the areas overlap, the bytes have to be repeated */
+		if(off >= len)
+			memcpy(dst,src,len);
+		else {
+			while(len-- > 0)
+				*dst++ = *src++;
+		}
+	}
+
 private:
 	uint8_t *_buffer;
 	size_t _size;
 	size_t _pos;
 };
 
+/**
+ * The decoder of the deflate compression algorithm. The Huffman codes are decoded with a lookup
+ * table for the first FAST_BITS bits, so that most symbols are decoded with a single lookup.
+ * Since all state of an uncompress-operation is kept on the stack, an instance may be used by
+ * multiple threads simultaneously.
+ */
 class Inflate : public DeflateBase {
-	struct Tree {
-		unsigned short table[16];  /* table of code length counts */
-		unsigned short trans[288]; /* code -> symbol translation table */
+	static const uint FAST_BITS		= 9;
+	static const size_t LIT_BUF_SIZE	= 256;
+
+	struct Huffman {
+		uint16_t fast[1 << FAST_BITS];	/* (length << 9) | symbol; 0 = not in the table */
+		uint16_t firstcode[16];			/* the first code of each length */
+		int maxcode[17];				/* the first code behind each length, left-aligned */
+		uint16_t firstsymbol[16];		/* the index in value of the first code of each length */
+		uint8_t size[288];				/* code length of the symbols, sorted by code */
+		uint16_t value[288];			/* the symbols, sorted by code */
 	};
 
 	struct Data {
 		InflateSource *source;
-		unsigned int tag;
+		const uint8_t *chunk;
+		const uint8_t *in;
+		const uint8_t *inend;
+		uint32_t tag;
 		unsigned int bitcount;
 
 		InflateDrain *drain;
+		uint8_t lits[LIT_BUF_SIZE];
+		size_t litcount;
 
-		Tree ltree; /* dynamic length/symbol tree */
-		Tree dtree; /* dynamic distance tree */
+		Huffman ltree; /* dynamic length/symbol tree */
+		Huffman dtree; /* dynamic distance tree */
 	};
 
 	enum {
@@ -207,7 +357,8 @@ public:
 	explicit Inflate();
 
 	/**
-	 * Uncompresses the data in <source> into <drain>.
+	 * Uncompresses the data in <source> into <drain>. Afterwards, <source> is positioned
+	 * directly behind the compressed data.
 	 *
 	 * @param drain the destination
 	 * @param source the source
@@ -216,27 +367,26 @@ public:
 	int uncompress(InflateDrain *drain,InflateSource *source);
 
 private:
-	void build_fixed_trees(Tree *lt,Tree *dt);
-	void build_tree(Tree *t,const unsigned char *lengths,unsigned int num);
-
-	void flush(Data *d);
-	void writebit(Data *d,int bit);
-	void write_bits(Data *d,unsigned int bits,int num);
+	void build_fixed_trees(Huffman *lt,Huffman *dt);
+	bool build_tree(Huffman *t,const unsigned char *lengths,unsigned int num);
 
-	int getbit(Data *d);
+	uint8_t next_byte(Data *d);
+	void refill(Data *d);
+	void need(Data *d,unsigned int num);
 	unsigned int read_bits(Data *d,int num,int base);
-	int decode_symbol(Data *d,Tree *t);
-	void decode_trees(Data *d,Tree *lt,Tree *dt);
-
-	int deflate_uncompressed_block(Data *d);
+	int decode_slow(Data *d,const Huffman *t,unsigned int *len);
+	int decode_symbol(Data *d,const Huffman *t);
+	int decode_trees(Data *d,Huffman *lt,Huffman *dt);
+	void flush_literals(Data *d);
+	void finish(Data *d);
 
-	int inflate_block_data(Data *d,Tree *lt,Tree *dt);
+	int inflate_block_data(Data *d,const Huffman *lt,const Huffman *dt);
 	int inflate_uncompressed_block(Data *d);
 	int inflate_fixed_block(Data *d);
 	int inflate_dynamic_block(Data *d);
 
-	Tree sltree; /* fixed length/symbol tree */
-	Tree sdtree; /* fixed distance tree */
+	Huffman sltree; /* fixed length/symbol tree */
+	Huffman sdtree; /* fixed distance tree */
 
 	/* special ordering of code length codes */
 	static const unsigned char clcidx[];
@@ -22,6 +22,10 @@
 #include <common.h>
 
 /* mmix does not support smp */
+inline void SpinLock::setProfiling(bool) {
+}
+inline void SpinLock::printStats(OStream &) {
+}
 inline void SpinLock::down() {
 }
 inline bool SpinLock::tryDown() {
@@ -24,9 +24,14 @@
 #include <cpu.h>
 
 #if !DEBUG_LOCKS
-inline void SpinLock::down() {
-	while(!Atomic::cmpnswap(&lock, 0, 1))
-		CPU::pause();
+/* always inline it, so that the profiling sees the caller as the call site */
+A_ALWAYS_INLINE inline void SpinLock::down() {
+	if(EXPECT_FALSE(profiling))
+		downProfiled();
+	else {
+		while(!Atomic::cmpnswap(&lock, 0, 1))
+			CPU::pause();
+	}
 }
 
 inline bool SpinLock::tryDown() {
@@ -61,6 +61,9 @@ enum {
 	MAP_PHYS_MAP		= 1,
 };
 
+/* the maximum number of pages that can be translated by virt2phys at once */
+#define MAX_VIRT2PHYS_PAGES	32
+
 class Proc;
 class Thread;
 class OStream;
@@ -217,6 +220,17 @@ public:
 	 */
 	int lockall();
 
+	/**
+	 * Determines the physical addresses of the <count> pages at <virt>. This is only allowed for
+	 * locked regions, because otherwise the frames might change at any time.
+	 *
+	 * @param virt the virtual address (page-aligned)
+	 * @param count the number of pages
+	 * @param phys the array to write the physical addresses to
+	 * @return 0 on success
+	 */
+	int virt2phys(uintptr_t virt,size_t count,uintptr_t *phys);
+
 	/**
 	 * This is a helper-function for determining the real memory-usage of all processes. It counts
 	 * the number of present frames in all regions of the given process and divides them for each
@@ -300,9 +314,10 @@ public:
 	 * Clones all regions of this virtmem (current) into the destination-virtmem
 	 *
 	 * @param dst the destination-virtmem
+	 * @param stackOnly whether to clone only the stack-regions of the current thread
 	 * @return 0 on success
 	 */
-	int cloneAll(VirtMem *dst);
+	int cloneAll(VirtMem *dst,bool stackOnly = false);
 
 	/**
 	 * If <amount> is positive, the region will be grown by <amount> pages. If negative it
@@ -23,17 +23,37 @@
 
 #define DEBUG_LOCKS		0
 
+class OStream;
+
 class SpinLock {
 public:
 	explicit SpinLock() : lock(0) {
 	}
 
+	/**
+	 * Enables or disables the contention profiling. If enabled, the number of acquisitions, the
+	 * number of contended acquisitions and the cycles spent waiting are counted per call site.
+	 *
+	 * @param enabled whether to enable it
+	 */
+	static void setProfiling(bool enabled);
+
+	/**
+	 * Prints the collected contention statistics per call site, sorted by the cycles spent waiting
+	 *
+	 * @param os the output-stream
+	 */
+	static void printStats(OStream &os);
+
 	void down();
 	bool tryDown();
 	void up();
 
 private:
+	A_NOINLINE void downProfiled();
+
 	uint lock;
+	static volatile bool profiling;
 };
 
 #if defined(__x86__)
@@ -134,6 +134,8 @@ private:
 	static int eof(Thread *t,IntrptStackFrame *stack);
 	static int seek(Thread *t,IntrptStackFrame *stack);
 	static int read(Thread *t,IntrptStackFrame *stack);
+	static int readdirplus(Thread *t,IntrptStackFrame *stack);
+	static int copyrange(Thread *t,IntrptStackFrame *stack);
 	static int write(Thread *t,IntrptStackFrame *stack);
 	static int dup(Thread *t,IntrptStackFrame *stack);
 	static int redirect(Thread *t,IntrptStackFrame *stack);
@@ -144,6 +146,7 @@ private:
 	static int cancel(Thread *t,IntrptStackFrame *stack);
 	static int delegate(Thread *t,IntrptStackFrame *stack);
 	static int obtain(Thread *t,IntrptStackFrame *stack);
+	static int stat(Thread *t,IntrptStackFrame *stack);
 	static int fstat(Thread *t,IntrptStackFrame *stack);
 	static int chmod(Thread *t,IntrptStackFrame *stack);
 	static int chown(Thread *t,IntrptStackFrame *stack);
@@ -156,6 +159,7 @@ private:
 	static int mkdir(Thread *t,IntrptStackFrame *stack);
 	static int rmdir(Thread *t,IntrptStackFrame *stack);
 	static int symlink(Thread *t,IntrptStackFrame *stack);
+	static int waitpath(Thread *t,IntrptStackFrame *stack);
 
 	// mounts
 	static int mount(Thread *t,IntrptStackFrame *stack);
@@ -170,6 +174,7 @@ private:
 	static int munmap(Thread *t,IntrptStackFrame *stack);
 	static int mmapphys(Thread *t,IntrptStackFrame *stack);
 	static int mattr(Thread *t,IntrptStackFrame *stack);
+	static int virt2phys(Thread *t,IntrptStackFrame *stack);
 	static int mlock(Thread *t,IntrptStackFrame *stack);
 	static int mlockall(Thread *t,IntrptStackFrame *stack);
 
@@ -186,6 +191,7 @@ private:
 	static int fork(Thread *t,IntrptStackFrame *stack);
 	static int waitchild(Thread *t,IntrptStackFrame *stack);
 	static int exec(Thread *t,IntrptStackFrame *stack);
+	static int spawn(Thread *t,IntrptStackFrame *stack);
 
 	// signals
 	static int signal(Thread *t,IntrptStackFrame *stack);
@@ -37,6 +37,9 @@
 #include <mutex.h>
 #include <spinlock.h>
 
+struct procstats_proc;
+struct procstats_thread;
+
 /* max number of coexistent processes */
 #define MAX_PROC_COUNT		8192
 #define MAX_FD_COUNT		1024
@@ -50,6 +53,8 @@
 
 #define ROOT_UID			0
 #define ROOT_GID			0
+/* the group all drivers are members of */
+#define DRIVER_GID			1
 
 /* process flags */
 #define P_ZOMBIE			1
@@ -107,6 +112,12 @@ public:
 		ulong migrations;
 	};
 
+	/* a file descriptor action for spawn(): <fd> becomes a copy of <src> or is closed (src = -1) */
+	struct SpawnFd {
+		int src;
+		int fd;
+	};
+
 	struct Stats {
 		/* thread stats */
 		uint64_t totalRuntime;
@@ -220,6 +231,20 @@ public:
 	 */
 	static void getMemUsageOf(pid_t pid,size_t *own,size_t *shared,size_t *swapped);
 
+	/**
+	 * Writes the statistics of all processes and their threads into the given records (see
+	 * sys/procstats.h). Processes and threads that don't fit into the records are skipped.
+	 *
+	 * @param precs the process records
+	 * @param maxProcs the number of process records
+	 * @param trecs the thread records
+	 * @param maxThreads the number of thread records
+	 * @param threadCount will be set to the number of written thread records
+	 * @return the number of written process records
+	 */
+	static size_t getSnapshot(struct procstats_proc *precs,size_t maxProcs,
+		struct procstats_thread *trecs,size_t maxThreads,size_t *threadCount);
+
 	/**
 	 * Adds the given signal to the given process. If necessary, the process is killed.
 	 *
@@ -253,9 +278,11 @@ public:
 	 * thread in Proc::clone() so that it will start there on thread_resume().
 	 *
 	 * @param flags the flags to set for the process (e.g. P_VM86)
+	 * @param stackOnly whether only the stack of the current thread should be cloned, because the
+	 *  child will exec immediately anyway
 	 * @return < 0 if an error occurred, the child-pid for parent, 0 for child
 	 */
-	static int clone(uint8_t flags);
+	static int clone(uint8_t flags,bool stackOnly = false);
 
 	/**
 	 * Starts a new thread at given entry-point. Will clone the kernel-stack from the current thread
@@ -278,6 +305,22 @@ public:
 	 */
 	static int exec(OpenFile *file,int fd,const char *const *args,USER const char *const *env);
 
+	/**
+	 * Creates a new process that executes the given program. In contrast to clone() and exec(),
+	 * the address space of the current process is not cloned, because the child replaces it
+	 * immediately. The child inherits all file descriptors and applies the given actions to them
+	 * before the program is loaded.
+	 *
+	 * @param fd the file descriptor for the executable
+	 * @param fds the file descriptor actions (in kernel memory)
+	 * @param count the number of actions
+	 * @param args the arguments
+	 * @param env the environment
+	 * @return the pid of the child or a negative error-code
+	 */
+	static int spawn(int fd,const SpawnFd *fds,size_t count,USER const char *const *args,
+	                 USER const char *const *env);
+
 	/**
 	 * Waits until the thread with given thread-id or all other threads of the process are terminated.
 	 *
@@ -564,7 +607,17 @@ private:
 	 */
 	static void terminateArch(Proc *p);
 
+	/* the arguments and environment for exec, copied to the kernel-heap */
+	struct ExecArgs {
+		char *buffer;
+		size_t size;
+		int argc;
+		int envc;
+	};
+
 	void initProps();
+	static int buildExecArgs(USER const char *const *args,USER const char *const *env,ExecArgs *ea);
+	static int doExec(OpenFile *file,int fd,ExecArgs *ea);
 	static void notifyProcDied(pid_t parent);
 	static int getExitState(pid_t ppid,pid_t pid,ExitState *state);
 	static void doRemoveRegions(Proc *p,bool remStack);
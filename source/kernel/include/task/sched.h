@@ -36,7 +36,8 @@ enum {
 	EV_SWAP_FREE,
 	EV_THREAD_DIED,
 	EV_CHILD_DIED,
-	EV_COUNT = EV_CHILD_DIED,
+	EV_VFS_NODE,
+	EV_COUNT = EV_VFS_NODE,
 };
 
 class Thread;
@@ -47,6 +48,21 @@ class Sched {
 	friend class Thread;
 	friend class ThreadBase;
 
+	/* the number of wait-queues (power of 2) */
+	static const size_t WAIT_QUEUES	= 128;
+
+	/**
+	 * The threads that wait for one of the (event,object) pairs that are mapped to this queue.
+	 * The lock protects the list and is always acquired after the scheduler lock.
+	 */
+	struct WaitQueue {
+		explicit WaitQueue() : lock(), list() {
+		}
+
+		SpinLock lock;
+		esc::DList<Thread> list;
+	};
+
 	Sched() = delete;
 
 public:
@@ -65,13 +81,39 @@ public:
 	static void wait(Thread *t,uint event,evobj_t object);
 
 	/**
-	 * Wakes up all threads that wait for given event and object
+	 * Wakes up all threads that wait for given event and object. This costs only time for the
+	 * threads waiting for the same event and object (and the ones that ignore the object), not
+	 * for all threads waiting for <event>.
 	 *
 	 * @param event the event
 	 * @param object the object
 	 * @param all if true, all are waked up, otherwise only the first one
+	 * @return the id of the first thread that has been waked up (INVALID_TID if none)
+	 */
+	static tid_t wakeup(uint event,evobj_t object,bool all = true);
+
+	/**
+	 * Lets <t> hand over the CPU directly to the thread <to> as soon as <t> blocks the next time.
+	 * If <to> is ready at that point, it runs immediately, regardless of its priority and the
+	 * ready-queues, and gets the remainder of the timeslice of <t>. This is intended for the
+	 * call-path of IPC, where <t> sends a message to <to> and waits for the response. Therefore,
+	 * it only happens if <t> blocks on <event> and <object> and if <to> still belongs to process
+	 * <pid>. In any case, the target is only used for the next block of <t>.
+	 *
+	 * @param t the current thread
+	 * @param to the thread to hand over the CPU to
+	 * @param pid the process of <to>
+	 * @param event the event <t> will wait for
+	 * @param object the object <t> will wait for
 	 */
-	static void wakeup(uint event,evobj_t object,bool all = true);
+	static void handoff(Thread *t,tid_t to,pid_t pid,uint event,evobj_t object);
+
+	/**
+	 * Removes the handoff target of <t>, if any, because the response has already been received.
+	 *
+	 * @param t the current thread
+	 */
+	static void cancelHandoff(Thread *t);
 
 	/**
 	 * @return the current ready-mask. 1 bit per priority.
@@ -162,6 +204,13 @@ private:
 
 	static void enqueue(Thread *t);
 	static void dequeue(Thread *t);
+	static WaitQueue *getQueue(uint event,evobj_t object) {
+		ulong h = (object >> 4) * 0x9E3779B1UL + event;
+		return waitQueues + ((h ^ (h >> 16)) & (WAIT_QUEUES - 1));
+	}
+	static bool hasWaiters(WaitQueue *q,uint event,evobj_t object);
+	static tid_t wakeupQueue(WaitQueue *q,uint event,evobj_t object,bool all);
+	static Thread *getHandoff(Thread *old);
 	static void removeFromEventlist(Thread *t);
 	static bool setReadyState(Thread *t);
 	static void print(OStream &os,esc::DList<Thread> *q);
@@ -169,7 +218,7 @@ private:
 	static SpinLock lock;
 	static ulong readyMask;
 	static esc::DList<Thread> rdyQueues[];
-	static esc::DList<Thread> evlists[EV_COUNT];
+	static WaitQueue waitQueues[WAIT_QUEUES];
 	static size_t rdyCount;
 	static Thread **idleThreads;
 };
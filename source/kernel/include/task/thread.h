@@ -89,6 +89,11 @@ class ThreadBase : public esc::DListItem {
 		ulong syscalls;
 		ulong schedCount;
 		ulong migrations;
+		/* the time of the last wakeup that has not been followed by a run yet (0 if none) and
+		 * the number of wakeups and the cycles between the wakeups and the runs in total */
+		uint64_t wakeupStart;
+		uint64_t wakeupLatency;
+		ulong wakeups;
 	};
 
 protected:
@@ -554,6 +559,15 @@ protected:
 	uint event;
 	evobj_t evobject;
 	uint64_t waitstart;
+	/* the thread that should get the CPU when we block the next time (see Sched::handoff) */
+	struct {
+		/* the thread (INVALID_TID = none) and its process, to detect reused tids */
+		tid_t tid;
+		pid_t pid;
+		/* the event and object we have to block on */
+		uint event;
+		evobj_t object;
+	} handoff;
 	/* a counter used to raise the priority after a certain number of "good behaviours" */
 	uint8_t prioGoodCnt;
 	uint8_t flags;
@@ -0,0 +1,93 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <sys/ktrace.h>
+#include <common.h>
+
+/**
+ * Static tracepoints for the kernel. Each tracepoint costs a load and a not-taken branch if it is
+ * disabled. Enabled tracepoints write their event into the ring buffer of the current CPU without
+ * taking a lock, so that they can be used in the scheduler and in the spinlock itself.
+ */
+class Trace {
+	Trace() = delete;
+
+	/* the number of events per CPU */
+	static const size_t EVENT_COUNT		= 4096;
+
+	struct Buffer {
+		/* the total number of events that have been recorded */
+		volatile size_t pos;
+		struct ktrace_event *events;
+	};
+
+public:
+	/**
+	 * @return the maximum number of events that can be stored in all buffers
+	 */
+	static size_t getMaxEvents();
+
+	/**
+	 * @return the mask of currently enabled tracepoints
+	 */
+	static uint getMask() {
+		return mask;
+	}
+
+	/**
+	 * Sets the mask of enabled tracepoints (1 << KTRACE_*). If tracing is enabled while it has been
+	 * disabled, the buffers are cleared.
+	 *
+	 * @param mask the new mask
+	 * @return 0 on success
+	 */
+	static int setMask(uint mask);
+
+	/**
+	 * Records an event of given type if the corresponding tracepoint is enabled
+	 *
+	 * @param type the type (KTRACE_*)
+	 * @param arg1 the first argument
+	 * @param arg2 the second argument
+	 * @param arg3 the third argument
+	 */
+	static void event(uint type,uint64_t arg1,uint64_t arg2 = 0,uint64_t arg3 = 0) {
+		if(EXPECT_FALSE(mask & (1U << type)))
+			record(type,arg1,arg2,arg3);
+	}
+
+	/**
+	 * Copies the recorded events into <events>. The events of one CPU are in chronological order.
+	 *
+	 * @param events the array to write to
+	 * @param max the size of the array
+	 * @param lost will be set to the number of overwritten events
+	 * @return the number of written events
+	 */
+	static size_t getEvents(struct ktrace_event *events,size_t max,uint64_t *lost);
+
+private:
+	static void record(uint type,uint64_t arg1,uint64_t arg2,uint64_t arg3);
+
+	static volatile uint mask;
+	static Buffer *volatile buffers;
+	static size_t bufCount;
+};
@@ -68,6 +68,20 @@ public:
 		fd = nfd;
 	}
 
+	/**
+	 * Determines how many bytes, starting at <buffer>, are in the memory that is shared with the
+	 * driver of this channel.
+	 *
+	 * @param buffer the buffer
+	 * @return the number of bytes (0 if <buffer> is not in the shared memory)
+	 */
+	size_t sharedSpace(const void *buffer) const {
+		if(!shmem || (uintptr_t)buffer < (uintptr_t)shmem ||
+				(uintptr_t)buffer >= (uintptr_t)shmem + shmemSize)
+			return 0;
+		return (uintptr_t)shmem + shmemSize - (uintptr_t)buffer;
+	}
+
 	/**
 	 * @return the thread who handles this channel
 	 */
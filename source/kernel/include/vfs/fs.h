@@ -42,6 +42,50 @@ public:
 	 */
 	static int fstat(pid_t pid,VFSChannel *chan,struct stat *info);
 
+	/**
+	 * Retrieves information about the file at <path> in the fs instance, without opening it.
+	 *
+	 * @param pid the process-id
+	 * @param chan the channel to the fs instance (of the mountpoint)
+	 * @param root the root inode
+	 * @param path the path within the fs instance
+	 * @param flags the flags (VFS_NOFOLLOW)
+	 * @param sympos will be set to the position of a symlink in <path>, if one is found
+	 * @param info should be filled
+	 * @return 0 on success
+	 */
+	static int stat(pid_t pid,VFSChannel *chan,ino_t root,const char *path,uint flags,
+		ssize_t *sympos,struct stat *info);
+
+	/**
+	 * Reads the entries of the directory, denoted by <chan>, including their attributes.
+	 *
+	 * @param pid the process-id
+	 * @param chan the channel for the directory to the fs instance
+	 * @param buffer the buffer to write the direntplus records to
+	 * @param count the size of <buffer>
+	 * @param offset the offset in the directory; will be set to the offset to continue at
+	 * @return the number of written bytes
+	 */
+	static ssize_t readdirplus(pid_t pid,VFSChannel *chan,USER void *buffer,size_t count,
+		off_t *offset);
+
+	/**
+	 * Lets the fs instance copy up to <count> bytes from the file, denoted by <in>, at <inOffset>
+	 * to the file, denoted by <out>, at <outOffset>. Both channels have to belong to the same fs
+	 * instance.
+	 *
+	 * @param pid the process-id
+	 * @param in the channel for the source file
+	 * @param out the channel for the destination file
+	 * @param inOffset the offset in the source file
+	 * @param outOffset the offset in the destination file
+	 * @param count the max. number of bytes to copy
+	 * @return the number of copied bytes
+	 */
+	static ssize_t copyrange(pid_t pid,VFSChannel *in,VFSChannel *out,off_t inOffset,
+		off_t outOffset,size_t count);
+
 	/**
 	 * Truncates the file, denoted by <chan>, to <length> bytes.
 	 *
@@ -58,6 +58,9 @@ class VFSInfo {
 	static void cpuReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
 	static void statsReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
 	static void memUsageReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
+	static void procStatsReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
+	static void ktraceReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
+	static void lockStatReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
 	static void selfLinkReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
 	static void pidLinkReadCallback(VFSNode *node,size_t *dataSize,void **buffer);
 
@@ -76,9 +79,31 @@ public:
 	GEN_INFO_FILECLASS(CPUFile,"cpu",cpuReadCallback);
 	GEN_INFO_FILECLASS(StatsFile,"stats",statsReadCallback);
 	GEN_INFO_FILECLASS(MemUsageFile,"memusage",memUsageReadCallback);
+	GEN_INFO_FILECLASS(ProcStatsFile,"procstats",procStatsReadCallback);
+	GEN_INFO_FILECLASS(LockStatFile,"lockstat",lockStatReadCallback);
 	GEN_INFO_FILECLASS(SelfLinkFile,"",selfLinkReadCallback);
 	GEN_INFO_FILECLASS(PidLinkFile,"",pidLinkReadCallback);
 
+	/* the kernel trace, which enables tracepoints if a mask is written to it. only root may use it,
+	 * because the events reveal what other processes are doing */
+	class KTraceFile : public VFSFile {
+	public:
+		explicit KTraceFile(pid_t pid,VFSNode *parent,bool &success)
+			: VFSFile(pid,parent,(char*)"trace",S_IFREG | S_IRUSR | S_IWUSR,success) {
+		}
+		virtual ssize_t read(pid_t pid,OpenFile *,void *buffer,off_t offset,size_t count) override {
+			ssize_t res = VFSInfo::readHelper(pid,this,buffer,offset,count,0,ktraceReadCallback);
+			acctime = Timer::getTime();
+			return res;
+		}
+		virtual ssize_t write(pid_t pid,OpenFile *file,const void *buffer,off_t offset,
+			size_t count) override;
+		virtual int truncate(pid_t,off_t) override {
+			/* allow "echo 1 > /sys/trace" */
+			return 0;
+		}
+	};
+
 	static ssize_t readHelper(pid_t pid,VFSNode *node,void *buffer,off_t offset,
 			size_t count,size_t dataSize,read_func callback);
 
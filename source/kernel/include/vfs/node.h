@@ -610,14 +610,11 @@ protected:
 	 */
 	static char *generateId(pid_t pid);
 	/**
-	 * Appends this node to <parent>.
+	 * Appends this node to <parent> and wakes up the threads that wait for new nodes.
 	 *
 	 * @param parent the parent-node
 	 */
-	void append(VFSNode *parent) {
-		LockGuard<SpinLock> guard(&treeLock);
-		doAppend(parent);
-	}
+	void append(VFSNode *parent);
 
 private:
 	static int createFile(pid_t pid,const char *path,VFSNode *dir,VFSNode **child,uint flags,mode_t mode);
@@ -342,6 +342,32 @@ public:
 	 */
 	ssize_t read(pid_t pid,void *buffer,size_t count);
 
+	/**
+	 * Reads the entries of this directory, starting at the current position, including their
+	 * attributes. Only supported for files in userspace filesystems.
+	 *
+	 * @param pid the process-id
+	 * @param buffer the buffer to write the direntplus records to
+	 * @param count the size of <buffer>
+	 * @return the number of written bytes
+	 */
+	ssize_t readdirplus(pid_t pid,void *buffer,size_t count);
+
+	/**
+	 * Copies up to <count> bytes from this file to <out>, starting at the current positions of
+	 * both files and advancing them. If both files belong to the same fs instance, the driver
+	 * copies the data itself. Otherwise, <shm> is used as the intermediate buffer, which has to
+	 * be shared with the drivers of both files so that the data goes from one driver to the
+	 * other without passing through the kernel.
+	 *
+	 * @param pid the process-id
+	 * @param out the file to write to
+	 * @param shm the shared buffer (may be NULL)
+	 * @param count the max. number of bytes to copy
+	 * @return the number of copied bytes or -ENOTSUP if neither way is possible
+	 */
+	ssize_t copyrange(pid_t pid,OpenFile *out,void *shm,size_t count);
+
 	/**
 	 * Writes count bytes from the given buffer into this file and returns the number of written
 	 * bytes.
@@ -25,6 +25,7 @@
 #include <common.h>
 
 class Proc;
+class Thread;
 class VFSMS;
 
 class VFS {
@@ -118,6 +119,31 @@ public:
 	 */
 	static int openPath(pid_t pid,ushort flags,mode_t mode,const char *path,ssize_t *sympos,OpenFile **file);
 
+	/**
+	 * Retrieves information about the file at <path>. For files in userspace filesystems, this is
+	 * a single request to the fs instance instead of opening and closing the file.
+	 *
+	 * @param pid the process-id
+	 * @param path the path
+	 * @param flags the flags (VFS_NOFOLLOW)
+	 * @param sympos will be set to the position within <path>, if a symlink is found
+	 * @param info will be filled
+	 * @return 0 if successfull or < 0
+	 */
+	static int stat(pid_t pid,const char *path,uint flags,ssize_t *sympos,struct stat *info);
+
+	/**
+	 * Waits until the node at <path> exists in the virtual filesystem, i.e., until it has been
+	 * created by e.g. a driver. The thread is woken up whenever a node is added to the tree,
+	 * instead of polling for it.
+	 *
+	 * @param t the running thread
+	 * @param path the path
+	 * @param msecs the maximum time to wait in milliseconds (0 = forever)
+	 * @return 0 if the node exists, -ETIMEOUT if it didn't appear in time or < 0 on errors
+	 */
+	static int waitPath(Thread *t,const char *path,time_t msecs);
+
 	/**
 	 * Opens the file with given number and given flags. That means it walks through the global
 	 * file table and searches for a free entry or an entry for that file.
@@ -217,6 +243,7 @@ private:
 	static bool hasMsg(VFSNode *node);
 	static bool hasData(VFSNode *node);
 	static bool hasWork(VFSNode *node);
+	static int findNode(pid_t pid,const char *path);
 
 	static VFSNode *pidsNode;
 	static VFSNode *procsNode;
@@ -17,12 +17,111 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <mem/cache.h>
 #include <task/thread.h>
+#include <atomic.h>
 #include <cpu.h>
+#include <ksymbols.h>
+#include <ostream.h>
 #include <spinlock.h>
 #include <stdarg.h>
+#include <trace.h>
 #include <util.h>
 
+/* the statistics of one call site of SpinLock::down() */
+struct LockSite {
+	volatile uintptr_t addr;
+	volatile uint64_t acquisitions;
+	volatile uint64_t contentions;
+	volatile uint64_t waitCycles;
+	volatile uint64_t maxWait;
+};
+
+static const size_t SITE_COUNT	= 256;
+
+static LockSite sites[SITE_COUNT];
+volatile bool SpinLock::profiling = false;
+
+static LockSite *getSite(uintptr_t addr) {
+	/* open addressing; entries are never removed, so that we can claim them without a lock */
+	size_t start = (addr >> 2) % SITE_COUNT;
+	for(size_t i = 0; i < SITE_COUNT; i++) {
+		LockSite *site = sites + (start + i) % SITE_COUNT;
+		if(site->addr == 0)
+			Atomic::cmpnswap(&site->addr,(uintptr_t)0,addr);
+		if(site->addr == addr)
+			return site;
+	}
+	return NULL;
+}
+
+void SpinLock::setProfiling(bool enabled) {
+	if(enabled && !profiling) {
+		for(size_t i = 0; i < SITE_COUNT; i++) {
+			sites[i].acquisitions = 0;
+			sites[i].contentions = 0;
+			sites[i].waitCycles = 0;
+			sites[i].maxWait = 0;
+		}
+	}
+	profiling = enabled;
+}
+
+void SpinLock::printStats(OStream &os) {
+	/* sort the used sites by the time spent waiting */
+	LockSite **sorted = (LockSite**)Cache::alloc(SITE_COUNT * sizeof(LockSite*));
+	if(!sorted)
+		return;
+	size_t count = 0;
+	for(size_t i = 0; i < SITE_COUNT; i++) {
+		if(sites[i].addr == 0 || sites[i].acquisitions == 0)
+			continue;
+		size_t j = count++;
+		for(; j > 0 && sorted[j - 1]->waitCycles < sites[i].waitCycles; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = sites + i;
+	}
+
+	os.writef("%-*s %-24s %12s %12s %16s %12s\n",
+		(ulong)(sizeof(uintptr_t) * 2 + sizeof(uintptr_t) / 2 - 1),"Site","Function",
+		"Acquired","Contended","WaitCycles","MaxWait");
+	for(size_t i = 0; i < count; i++) {
+		KSymbols::Symbol *sym = KSymbols::getSymbolAt(sorted[i]->addr);
+		os.writef("%p %-24.24s %12Lu %12Lu %16Lu %12Lu\n",
+			sorted[i]->addr,sym ? sym->funcName : "??",sorted[i]->acquisitions,
+			sorted[i]->contentions,sorted[i]->waitCycles,sorted[i]->maxWait);
+	}
+	Cache::free(sorted);
+}
+
+#if !DEBUG_LOCKS
+void SpinLock::downProfiled() {
+	/* down() is always inlined, thus our return address is the code that acquires the lock */
+	uintptr_t addr = (uintptr_t)__builtin_return_address(0);
+	LockSite *site = getSite(addr);
+	if(EXPECT_TRUE(Atomic::cmpnswap(&lock, 0, 1))) {
+		if(site)
+			Atomic::fetch_and_add(&site->acquisitions,1);
+		return;
+	}
+
+	uint64_t start = CPU::rdtsc();
+	while(!Atomic::cmpnswap(&lock, 0, 1))
+		CPU::pause();
+	uint64_t wait = CPU::rdtsc() - start;
+
+	if(site) {
+		Atomic::fetch_and_add(&site->acquisitions,1);
+		Atomic::fetch_and_add(&site->contentions,1);
+		Atomic::fetch_and_add(&site->waitCycles,wait);
+		uint64_t max;
+		while(wait > (max = site->maxWait) && !Atomic::cmpnswap(&site->maxWait,max,wait))
+			;
+	}
+	Trace::event(KTRACE_LOCK,addr,wait);
+}
+#endif
+
 #if DEBUG_LOCKS
 static const int MAX_WAIT_SECS 	= 2;
 
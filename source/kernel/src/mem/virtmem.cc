@@ -39,6 +39,7 @@
 #include <ostream.h>
 #include <spinlock.h>
 #include <string.h>
+#include <trace.h>
 #include <util.h>
 
 /**
@@ -543,9 +544,42 @@ int VirtMem::getRegRange(uintptr_t virt,uintptr_t *start,uintptr_t *end) {
 	return res;
 }
 
+int VirtMem::virt2phys(uintptr_t virt,size_t count,uintptr_t *phys) {
+	if(virt & (PAGE_SIZE - 1))
+		return -EINVAL;
+
+	int res = 0;
+	acquire();
+	VMRegion *vm = regtree.getByAddr(virt);
+	if(vm == NULL)
+		res = -ENXIO;
+	else {
+		vm->reg->acquire();
+		uintptr_t end = vm->virt() + esc::Util::round_page_up(vm->reg->getByteCount());
+		/* the region has to be locked; everything else might be swapped out meanwhile */
+		if(~vm->reg->getFlags() & RF_LOCKED)
+			res = -EPERM;
+		else if(virt + count * PAGE_SIZE < virt || virt + count * PAGE_SIZE > end)
+			res = -EINVAL;
+		else {
+			for(size_t i = 0; i < count; ++i, virt += PAGE_SIZE) {
+				if(!getPageDir()->isPresent(virt)) {
+					res = -EFAULT;
+					break;
+				}
+				phys[i] = getPageDir()->getFrameNo(virt) * PAGE_SIZE;
+			}
+		}
+		vm->reg->release();
+	}
+	release();
+	return res;
+}
+
 int VirtMem::pagefault(uintptr_t addr,bool write) {
 	Thread *t = Thread::getRunning();
 	VMRegion *vmreg;
+	Trace::event(KTRACE_PAGEFAULT,addr,write);
 
 	/* we can swap here; note that we don't need page-tables in this case, they're always present */
 	if(!t->reserveFrames(1))
@@ -842,7 +876,7 @@ errProc:
 	return res;
 }
 
-int VirtMem::cloneAll(VirtMem *dst) {
+int VirtMem::cloneAll(VirtMem *dst,bool stackOnly) {
 	Thread *t = Thread::getRunning();
 	VMTree::iterator vm;
 	VMRegion *nvm;
@@ -861,7 +895,7 @@ int VirtMem::cloneAll(VirtMem *dst) {
 
 	for(vm = regtree.begin(); vm != regtree.end(); ++vm) {
 		/* just clone the tls- and stack-region of the current thread */
-		if(!(vm->reg->getFlags() & RF_STACK) || t->hasStackRegion(&*vm)) {
+		if((!stackOnly && !(vm->reg->getFlags() & RF_STACK)) || t->hasStackRegion(&*vm)) {
 			vm->reg->acquire();
 			/* TODO ?? better don't share the file; they may have to read in parallel */
 			if(vm->reg->getFlags() & RF_SHAREABLE) {
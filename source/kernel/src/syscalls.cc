@@ -123,6 +123,14 @@ const Syscalls::handler_func Syscalls::syscalls[] = {
 	utime,
 	truncate,
 	symlink,
+	waitpath,
+	spawn,
+	virt2phys,
+	stat,
+
+	/* 80 */
+	readdirplus,
+	copyrange,
 #if defined(__x86__)
 	reqports,
 	relports,
@@ -79,6 +79,29 @@ int Syscalls::fcntl(Thread *t,IntrptStackFrame *stack) {
 	SYSC_RESULT(stack,res);
 }
 
+int Syscalls::stat(Thread *t,IntrptStackFrame *stack) {
+	char abspath[MAX_PATH_LEN + 1];
+	struct stat kinfo;
+	const char *path = (const char*)SYSC_ARG1(stack);
+	uint flags = (uint)SYSC_ARG2(stack);
+	struct stat *info = (struct stat*)SYSC_ARG3(stack);
+	ssize_t *sympos = (ssize_t*)SYSC_ARG4(stack);
+	pid_t pid = t->getProc()->getPid();
+	if(EXPECT_FALSE(!copyPath(abspath,sizeof(abspath),path)))
+		SYSC_ERROR(stack,-EFAULT);
+	if(!PageDir::isInUserSpace((uintptr_t)info,sizeof(struct stat)))
+		SYSC_ERROR(stack,-EFAULT);
+	if(!PageDir::isInUserSpace((uintptr_t)sympos,sizeof(size_t)))
+		SYSC_ERROR(stack,-EFAULT);
+
+	ssize_t ksympos = -1;
+	int res = VFS::stat(pid,abspath,flags & VFS_NOFOLLOW,&ksympos,&kinfo);
+	if(EXPECT_TRUE(res == 0))
+		UserAccess::write(info,&kinfo,sizeof(kinfo));
+	UserAccess::write(sympos,&ksympos,sizeof(ksympos));
+	SYSC_RESULT(stack,res);
+}
+
 int Syscalls::fstat(Thread *t,IntrptStackFrame *stack) {
 	struct stat kinfo;
 	int fd = (int)SYSC_ARG1(stack);
@@ -192,6 +215,48 @@ int Syscalls::read(Thread *t,IntrptStackFrame *stack) {
 	SYSC_RESULT(stack,readBytes);
 }
 
+int Syscalls::readdirplus(Thread *t,IntrptStackFrame *stack) {
+	int fd = (int)SYSC_ARG1(stack);
+	void *buffer = (void*)SYSC_ARG2(stack);
+	size_t count = SYSC_ARG3(stack);
+	Proc *p = t->getProc();
+
+	/* validate count and buffer */
+	if(EXPECT_FALSE(count == 0))
+		SYSC_ERROR(stack,-EINVAL);
+	if(EXPECT_FALSE(!PageDir::isInUserSpace((uintptr_t)buffer,count)))
+		SYSC_ERROR(stack,-EFAULT);
+
+	ScopedFile file(p,fd);
+	ssize_t res = EXPECT_TRUE(file) ? file->readdirplus(p->getPid(),buffer,count) : -EBADF;
+	SYSC_RESULT(stack,res);
+}
+
+int Syscalls::copyrange(Thread *t,IntrptStackFrame *stack) {
+	int infd = (int)SYSC_ARG1(stack);
+	int outfd = (int)SYSC_ARG2(stack);
+	void *shm = (void*)SYSC_ARG3(stack);
+	size_t count = SYSC_ARG4(stack);
+	Proc *p = t->getProc();
+
+	/* validate count and buffer */
+	if(EXPECT_FALSE(count == 0))
+		SYSC_ERROR(stack,-EINVAL);
+	if(EXPECT_FALSE(shm && !PageDir::isInUserSpace((uintptr_t)shm,1)))
+		SYSC_ERROR(stack,-EFAULT);
+
+	ScopedFile in(p,infd);
+	if(EXPECT_FALSE(!in))
+		SYSC_ERROR(stack,-EBADF);
+
+	ScopedFile out(p,outfd);
+	if(EXPECT_FALSE(!out))
+		SYSC_ERROR(stack,-EBADF);
+
+	ssize_t res = in->copyrange(p->getPid(),&*out,shm,count);
+	SYSC_RESULT(stack,res);
+}
+
 int Syscalls::write(Thread *t,IntrptStackFrame *stack) {
 	int fd = (int)SYSC_ARG1(stack);
 	const void *buffer = (const void*)SYSC_ARG2(stack);
@@ -477,3 +542,15 @@ int Syscalls::symlink(Thread *t,IntrptStackFrame *stack) {
 	int res = EXPECT_TRUE(file) ? file->symlink(p->getPid(),kname,ktarget) : -EBADF;
 	SYSC_RESULT(stack,res);
 }
+
+int Syscalls::waitpath(Thread *t,IntrptStackFrame *stack) {
+	char kpath[MAX_PATH_LEN + 1];
+	const char *path = (const char*)SYSC_ARG1(stack);
+	time_t msecs = SYSC_ARG2(stack);
+
+	if(EXPECT_FALSE(!copyPath(kpath,sizeof(kpath),path)))
+		SYSC_ERROR(stack,-EFAULT);
+
+	int res = VFS::waitPath(t,kpath,msecs);
+	SYSC_RESULT(stack,res);
+}
@@ -19,8 +19,10 @@
 
 #include <mem/kheap.h>
 #include <mem/pagedir.h>
+#include <mem/useraccess.h>
 #include <mem/virtmem.h>
 #include <task/filedesc.h>
+#include <task/groups.h>
 #include <task/proc.h>
 #include <boot.h>
 #include <common.h>
@@ -172,6 +174,27 @@ int Syscalls::mattr(A_UNUSED Thread *t,IntrptStackFrame *stack) {
 	SYSC_RESULT(stack,res);
 }
 
+int Syscalls::virt2phys(Thread *t,IntrptStackFrame *stack) {
+	uintptr_t virt = (uintptr_t)SYSC_ARG1(stack);
+	size_t count = SYSC_ARG2(stack);
+	uintptr_t *phys = (uintptr_t*)SYSC_ARG3(stack);
+	uintptr_t frames[MAX_VIRT2PHYS_PAGES];
+	Proc *p = t->getProc();
+
+	/* physical addresses are only needed for DMA, which is up to drivers */
+	if(EXPECT_FALSE(p->getUid() != ROOT_UID && !Groups::contains(p->getPid(),DRIVER_GID)))
+		SYSC_ERROR(stack,-EPERM);
+	if(EXPECT_FALSE(count > MAX_VIRT2PHYS_PAGES))
+		SYSC_ERROR(stack,-EINVAL);
+	if(EXPECT_FALSE(!PageDir::isInUserSpace((uintptr_t)phys,count * sizeof(uintptr_t))))
+		SYSC_ERROR(stack,-EFAULT);
+
+	int res = p->getVM()->virt2phys(virt,count,frames);
+	if(EXPECT_TRUE(res == 0))
+		res = UserAccess::write(phys,frames,count * sizeof(uintptr_t));
+	SYSC_RESULT(stack,res);
+}
+
 int Syscalls::mmapphys(Thread *t,IntrptStackFrame *stack) {
 	uintptr_t *phys = (uintptr_t*)SYSC_ARG1(stack);
 	size_t bytes = SYSC_ARG2(stack);
@@ -150,3 +150,39 @@ int Syscalls::exec(Thread *t,IntrptStackFrame *stack) {
 	int res = Proc::exec(&*file,fd,args,env);
 	SYSC_RESULT(stack,res);
 }
+
+int Syscalls::spawn(Thread *t,IntrptStackFrame *stack) {
+	int fd = (int)SYSC_ARG1(stack);
+	const Proc::SpawnFd *ufds = (const Proc::SpawnFd*)SYSC_ARG2(stack);
+	const char *const *args = (const char *const *)SYSC_ARG3(stack);
+	const char *const *env = (const char *const *)SYSC_ARG4(stack);
+	Proc::SpawnFd fds[MAX_SPAWN_FDS];
+	Proc *p = t->getProc();
+
+	/* copy the file descriptor actions; the list is terminated by an entry with fd = -1 */
+	size_t count = 0;
+	while(ufds) {
+		if(EXPECT_FALSE(!PageDir::isInUserSpace((uintptr_t)(ufds + count),sizeof(Proc::SpawnFd))))
+			SYSC_ERROR(stack,-EFAULT);
+		Proc::SpawnFd action;
+		UserAccess::read(&action,ufds + count,sizeof(action));
+		if(action.fd == -1)
+			break;
+		/* the executable has to stay where it is */
+		if(EXPECT_FALSE(count == MAX_SPAWN_FDS || action.fd == fd || action.fd < 0 || action.src < -1))
+			SYSC_ERROR(stack,-EINVAL);
+		fds[count++] = action;
+	}
+
+	/* don't keep a reference to the file here; the child would inherit it */
+	{
+		ScopedFile file(p,fd);
+		if(!file)
+			SYSC_ERROR(stack,-EBADF);
+		if((file->getFlags() & (VFS_EXEC | VFS_READ)) != (VFS_EXEC | VFS_READ))
+			SYSC_ERROR(stack,-EACCES);
+	}
+
+	int res = Proc::spawn(fd,fds,count,args,env);
+	SYSC_RESULT(stack,res);
+}
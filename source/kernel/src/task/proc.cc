@@ -47,6 +47,7 @@
 #include <spinlock.h>
 #include <string.h>
 #include <syscalls.h>
+#include <sys/procstats.h>
 #include <term.h>
 #include <util.h>
 
@@ -234,7 +235,77 @@ void ProcBase::getMemUsage(size_t *dataShared,size_t *dataOwn,size_t *dataReal)
 	*dataReal = dReal + (CopyOnWrite::getFrmCount() * PAGE_SIZE);
 }
 
-int ProcBase::clone(uint8_t flags) {
+size_t ProcBase::getSnapshot(struct procstats_proc *precs,size_t maxProcs,
+		struct procstats_thread *trecs,size_t maxThreads,size_t *threadCount) {
+	size_t pcount = 0,tcount = 0,total = 0;
+
+	/* collect the pids first, because Proc::kill() acquires PLOCK_PROG before procLock */
+	{
+		LockGuard<Mutex> guard(&procLock);
+		for(auto it = procs.cbegin(); it != procs.cend() && total < maxProcs; ++it)
+			precs[total++].pid = it->pid;
+	}
+
+	for(size_t i = 0; i < total; ++i) {
+		/* skip the processes that are gone in the meantime */
+		Proc *p = request(precs[i].pid,PLOCK_PROG);
+		if(!p)
+			continue;
+
+		/* pcount <= i, so we don't overwrite pids we still need */
+		struct procstats_proc *rec = precs + pcount++;
+		size_t pages;
+		memclear(rec,sizeof(*rec));
+		p->virtmem.getMemUsage(&pages);
+		rec->pid = p->pid;
+		rec->ppid = p->parentPid;
+		rec->uid = p->getUid();
+		rec->gid = p->getGid();
+		rec->pages = pages;
+		rec->ownFrames = p->virtmem.getOwnFrames() + p->getKMemUsage();
+		rec->sharedFrames = p->virtmem.getSharedFrames();
+		rec->swapped = p->virtmem.getSwappedFrames();
+		rec->input = p->stats.input;
+		rec->output = p->stats.output;
+		rec->runtime = p->getRuntime();
+		rec->cycles = p->stats.lastCycles;
+		const char *cmd = p->command ? p->command : "";
+		if(strlen(cmd) >= sizeof(rec->command))
+			rec->flags |= PROCSTATS_CMD_TRUNC;
+		strnzcpy(rec->command,cmd,sizeof(rec->command));
+
+		/* the threads are protected by PLOCK_PROG */
+		for(auto t = p->threads.cbegin(); t != p->threads.cend() && tcount < maxThreads; ++t) {
+			const Thread *th = *t;
+			struct procstats_thread *trec = trecs + tcount++;
+			memclear(trec,sizeof(*trec));
+			for(size_t i = 0; i < STACK_REG_COUNT; i++) {
+				uintptr_t stackBegin = 0,stackEnd = 0;
+				if(th->getStackRange(&stackBegin,&stackEnd,i))
+					trec->stackPages += (stackEnd - stackBegin) / PAGE_SIZE;
+			}
+			const Thread::Stats &st = th->getStats();
+			trec->tid = th->getTid();
+			trec->pid = p->pid;
+			trec->state = th->getState();
+			trec->flags = th->getFlags() & T_IDLE;
+			trec->priority = th->getPriority();
+			trec->cpu = th->getCPU();
+			trec->schedCount = st.schedCount;
+			trec->syscalls = st.syscalls;
+			trec->runtime = th->getRuntime();
+			trec->cycles = st.lastCycleCount;
+			trec->wakeups = st.wakeups;
+			trec->wakeupLatency = st.wakeups ? st.wakeupLatency / st.wakeups : 0;
+			rec->threadCount++;
+		}
+		release(p,PLOCK_PROG);
+	}
+	*threadCount = tcount;
+	return pcount;
+}
+
+int ProcBase::clone(uint8_t flags,bool stackOnly) {
 	int newPid,res = 0;
 	Proc *p,*cur;
 	Thread *nt,*curThread = Thread::getRunning();
@@ -314,7 +385,7 @@ int ProcBase::clone(uint8_t flags) {
 
 	/* clone regions */
 	p->virtmem.init();
-	if((res = cur->virtmem.cloneAll(&p->virtmem)) < 0)
+	if((res = cur->virtmem.cloneAll(&p->virtmem,stackOnly)) < 0)
 		goto errorGroups;
 
 	/* clone current thread */
@@ -436,57 +507,113 @@ errorReqProc:
 }
 
 int ProcBase::exec(OpenFile *file,int fd,USER const char *const *args,USER const char *const *env) {
-	char *argBuffer;
-	ELF::StartupInfo info;
-	Thread *t = Thread::getRunning();
-	Proc *p = request(t->getProc()->pid,PLOCK_PROG);
-	size_t argSize = EXEC_MAX_ARGSIZE;
-	int argc,envc,res;
-	if(!p)
-		return -ESRCH;
-	/* don't allow exec when the process should die */
-	if(p->flags & (P_ZOMBIE | P_PREZOMBIE)) {
-		res = -EINVAL;
-		goto error;
+	ExecArgs ea;
+	int res = buildExecArgs(args,env,&ea);
+	if(res < 0)
+		return res;
+	return doExec(file,fd,&ea);
+}
+
+int ProcBase::spawn(int fd,const SpawnFd *fds,size_t count,USER const char *const *args,
+                    USER const char *const *env) {
+	/* the child can't access our memory, so that we have to copy the arguments beforehand */
+	ExecArgs ea;
+	int res = buildExecArgs(args,env,&ea);
+	if(res < 0)
+		return res;
+
+	res = clone(0,true);
+	if(res != 0) {
+		/* if we succeeded, the child takes care of the arguments */
+		if(res < 0)
+			Cache::free(ea.buffer);
+		return res;
 	}
-	/* we can't do an exec if we have multiple threads (init can do that, because the threads are
-	 * "kernel-threads") */
-	if(p->pid != 0 && p->threads.length() > 1) {
-		res = -EINVAL;
-		goto error;
+
+	/* we're the child now; perform the file descriptor actions */
+	Proc *p = Thread::getRunning()->getProc();
+	for(size_t i = 0; i < count; ++i) {
+		if(fds[i].src == -1) {
+			OpenFile *old = FileDesc::unassoc(p,fds[i].fd);
+			if(old)
+				old->close(p->getPid());
+		}
+		else if(fds[i].src != fds[i].fd)
+			res = FileDesc::redirect(fds[i].fd,fds[i].src);
+		if(res < 0)
+			break;
 	}
 
-	argc = 0;
-	envc = 0;
-	argBuffer = NULL;
+	OpenFile *file = res == 0 ? FileDesc::request(p,fd) : NULL;
+	if(!file) {
+		Cache::free(ea.buffer);
+		terminate(127,SIG_COUNT);
+		A_UNREACHED;
+	}
+	res = doExec(file,fd,&ea);
+	FileDesc::release(file);
+	/* there is nothing left in user space to return to, except the stack */
+	if(res < 0) {
+		terminate(127,SIG_COUNT);
+		A_UNREACHED;
+	}
+	return 0;
+}
+
+int ProcBase::buildExecArgs(USER const char *const *args,USER const char *const *env,ExecArgs *ea) {
+	size_t argSize = EXEC_MAX_ARGSIZE;
+	ea->argc = 0;
+	ea->envc = 0;
+	ea->buffer = NULL;
 	if(args != NULL || env != NULL) {
 		/* alloc space for the arguments */
-		argBuffer = (char*)Cache::alloc(EXEC_MAX_ARGSIZE);
-		if(argBuffer == NULL) {
-			res = -ENOMEM;
-			goto error;
-		}
+		ea->buffer = (char*)Cache::alloc(EXEC_MAX_ARGSIZE);
+		if(ea->buffer == NULL)
+			return -ENOMEM;
 
 		/* copy arguments into buffer */
 		if(args != NULL) {
-			argc = buildArgs(args,argBuffer,&argSize);
-			if(argc < 0) {
-				res = argc;
+			ea->argc = buildArgs(args,ea->buffer,&argSize);
+			if(ea->argc < 0)
 				goto errorFree;
-			}
 		}
 
 		/* copy env into buffer */
 		if(env != NULL) {
 			size_t current = EXEC_MAX_ARGSIZE - argSize;
-			envc = buildArgs(env,argBuffer + current,&argSize);
-			if(envc < 0) {
-				res = envc;
+			ea->envc = buildArgs(env,ea->buffer + current,&argSize);
+			if(ea->envc < 0)
 				goto errorFree;
-			}
 		}
 	}
-	argSize = EXEC_MAX_ARGSIZE - argSize;
+	ea->size = EXEC_MAX_ARGSIZE - argSize;
+	return 0;
+
+errorFree:
+	Cache::free(ea->buffer);
+	return ea->argc < 0 ? ea->argc : ea->envc;
+}
+
+int ProcBase::doExec(OpenFile *file,int fd,ExecArgs *ea) {
+	ELF::StartupInfo info;
+	Thread *t = Thread::getRunning();
+	Proc *p = request(t->getProc()->pid,PLOCK_PROG);
+	int res;
+	if(!p) {
+		Cache::free(ea->buffer);
+		return -ESRCH;
+	}
+	/* don't allow exec when the process should die */
+	if(p->flags & (P_ZOMBIE | P_PREZOMBIE)) {
+		res = -EINVAL;
+		goto error;
+	}
+	/* we can't do an exec if we have multiple threads (init can do that, because the threads are
+	 * "kernel-threads") */
+	if(p->pid != 0 && p->threads.length() > 1) {
+		res = -EINVAL;
+		goto error;
+	}
 
 	/* remove all except stack */
 	doRemoveRegions(p,false);
@@ -503,7 +630,7 @@ int ProcBase::exec(OpenFile *file,int fd,USER const char *const *args,USER const
 	}
 
 	/* copy path so that we can identify the process */
-	p->setCommand(file->getPath(),argc,argBuffer);
+	p->setCommand(file->getPath(),ea->argc,ea->buffer);
 	/* reset stats */
 	p->stats.input = 0;
 	p->stats.output = 0;
@@ -524,21 +651,20 @@ int ProcBase::exec(OpenFile *file,int fd,USER const char *const *args,USER const
 	release(p,PLOCK_PROG);
 
 	/* for starting use the linker-entry, which will be progEntry if no dl is present */
-	if(!UEnv::setupProc(argc,envc,argBuffer,argSize,&info,info.linkerEntry,fd))
+	if(!UEnv::setupProc(ea->argc,ea->envc,ea->buffer,ea->size,&info,info.linkerEntry,fd))
 		goto errorTermNoRel;
-	Cache::free(argBuffer);
+	Cache::free(ea->buffer);
 	return 0;
 
-errorFree:
-	Cache::free(argBuffer);
 error:
+	Cache::free(ea->buffer);
 	release(p,PLOCK_PROG);
 	return res;
 
 errorTerm:
 	release(p,PLOCK_PROG);
 errorTermNoRel:
-	Cache::free(argBuffer);
+	Cache::free(ea->buffer);
 	terminate(1,SIG_COUNT);
 	A_UNREACHED;
 }
@@ -29,6 +29,7 @@
 #include <log.h>
 #include <spinlock.h>
 #include <string.h>
+#include <trace.h>
 #include <util.h>
 #include <video.h>
 
@@ -41,12 +42,17 @@
  * the beginning and end. Therefore we can dequeue the first, prepend, append and remove a thread
  * in O(1). Additionally the number of threads is limited by the kernel-heap (i.e. we don't need
  * a static storage of nodes for the linked list; we use the threads itself)
+ *
+ * Blocked threads are kept in wait-queues, which are selected by hashing the event and object
+ * they wait for. Thus, a wakeup only needs to look at the threads in one or two queues instead
+ * of all threads that wait for the same event. Each queue has its own lock, so that wakeups for
+ * which nobody waits don't need to acquire the scheduler lock at all.
  */
 
 SpinLock Sched::lock;
 ulong Sched::readyMask = 0;
 esc::DList<Thread> Sched::rdyQueues[MAX_PRIO + 1];
-esc::DList<Thread> Sched::evlists[EV_COUNT];
+Sched::WaitQueue Sched::waitQueues[WAIT_QUEUES];
 size_t Sched::rdyCount;
 Thread **Sched::idleThreads;
 
@@ -97,6 +103,7 @@ Thread *Sched::perform(Thread *old,cpuid_t cpu) {
 				/* we have to reset the newstate in this case and remove us from event */
 				old->setNewState(Thread::READY);
 				old->waitstart = 0;
+				old->handoff.tid = INVALID_TID;
 				removeFromEventlist(old);
 				return old;
 			}
@@ -109,22 +116,24 @@ Thread *Sched::perform(Thread *old,cpuid_t cpu) {
 		}
 	}
 
-	/* get new thread */
-	Thread *t;
-	for(ssize_t i = MAX_PRIO; i >= 0; i--) {
-		t = rdyQueues[i].removeFirst();
-		if(t) {
-			/* if its the old thread again and we have more ready threads, don't take this one again.
-			 * because we assume that Thread::switchAway() has been called for a reason. therefore, it
-			 * should be better to take a thread with a lower priority than taking the same again */
-			if(rdyCount > 1 && t == old) {
-				rdyQueues[i].append(t);
-				continue;
+	/* get new thread; prefer the one the old thread wants to hand over the CPU to */
+	Thread *t = old ? getHandoff(old) : NULL;
+	if(t == NULL) {
+		for(ssize_t i = MAX_PRIO; i >= 0; i--) {
+			t = rdyQueues[i].removeFirst();
+			if(t) {
+				/* if its the old thread again and we have more ready threads, don't take this one again.
+				 * because we assume that Thread::switchAway() has been called for a reason. therefore, it
+				 * should be better to take a thread with a lower priority than taking the same again */
+				if(rdyCount > 1 && t == old) {
+					rdyQueues[i].append(t);
+					continue;
+				}
+				if(rdyQueues[i].length() == 0)
+					readyMask &= ~(1UL << i);
+				rdyCount--;
+				break;
 			}
-			if(rdyQueues[i].length() == 0)
-				readyMask &= ~(1UL << i);
-			rdyCount--;
-			break;
 		}
 	}
 	if(t == NULL) {
@@ -135,14 +144,41 @@ Thread *Sched::perform(Thread *old,cpuid_t cpu) {
 	else {
 		t->setState(Thread::RUNNING);
 		t->setNewState(Thread::READY);
+		/* measure the time from the wakeup until the thread actually runs */
+		if(t->stats.wakeupStart) {
+			t->stats.wakeupLatency += CPU::rdtsc() - t->stats.wakeupStart;
+			t->stats.wakeups++;
+			t->stats.wakeupStart = 0;
+		}
 	}
 
+	Trace::event(KTRACE_SCHED,old ? old->getTid() : INVALID_TID,t->getTid());
+
 	/* if there is another thread ready, check if we have another cpu that we can start for it */
 	if(rdyCount > 0)
 		SMP::wakeupCPU();
 	return t;
 }
 
+Thread *Sched::getHandoff(Thread *old) {
+	tid_t tid = old->handoff.tid;
+	old->handoff.tid = INVALID_TID;
+	/* only if the old thread blocks, i.e. waits for the other one, it makes sense to give it
+	 * the rest of our timeslice */
+	if(EXPECT_TRUE(tid == INVALID_TID) || old->getState() != Thread::BLOCKED)
+		return NULL;
+	/* and only if it waits for the response from that channel and not for something else */
+	if(old->event != old->handoff.event || old->evobject != old->handoff.object)
+		return NULL;
+
+	/* the thread might have died and the tid might have been reused in the meantime */
+	Thread *t = Thread::getById(tid);
+	if(!t || t->getProc()->getPid() != old->handoff.pid || t->getState() != Thread::READY)
+		return NULL;
+	dequeue(t);
+	return t;
+}
+
 void Sched::adjustPrio(Thread *t,uint64_t total) {
 	LockGuard<SpinLock> g(&lock);
 	/* if it is still blocked, add the time to the blocked time */
@@ -208,30 +244,83 @@ void Sched::wait(Thread *t,uint event,evobj_t object) {
 	t->event = event;
 	t->evobject = object;
 	setBlocked(t);
-	if(event)
-		evlists[event - 1].append(t);
+	if(event) {
+		WaitQueue *q = getQueue(event,object);
+		LockGuard<SpinLock> qg(&q->lock);
+		q->list.append(t);
+	}
 }
 
-void Sched::wakeup(uint event,evobj_t object,bool all) {
+void Sched::handoff(Thread *t,tid_t to,pid_t pid,uint event,evobj_t object) {
+	assert(t == Thread::getRunning());
+	/* only the running thread itself and Sched::perform() on its CPU access it */
+	t->handoff.tid = to;
+	t->handoff.pid = pid;
+	t->handoff.event = event;
+	t->handoff.object = object;
+}
+
+void Sched::cancelHandoff(Thread *t) {
+	assert(t == Thread::getRunning());
+	t->handoff.tid = INVALID_TID;
+}
+
+tid_t Sched::wakeup(uint event,evobj_t object,bool all) {
 	assert(event >= 1 && event <= EV_COUNT);
-	esc::DList<Thread> *list = evlists + event - 1;
+	WaitQueue *q = getQueue(event,object);
+	/* threads with object 0 wait for all objects */
+	WaitQueue *anyq = object != 0 ? getQueue(event,0) : NULL;
+	/* a thread that starts waiting concurrently would not have been found with the scheduler
+	 * lock either. thus, it is sufficient to check the queues with their own lock. */
+	if(!hasWaiters(q,event,object) && (!anyq || !hasWaiters(anyq,event,0)))
+		return INVALID_TID;
+
 	LockGuard<SpinLock> g(&lock);
-	for(auto it = list->begin(); it != list->end(); ) {
+	tid_t first = wakeupQueue(q,event,object,all);
+	if(anyq && (first == INVALID_TID || all)) {
+		tid_t res = wakeupQueue(anyq,event,0,all);
+		if(first == INVALID_TID)
+			first = res;
+	}
+	return first;
+}
+
+bool Sched::hasWaiters(WaitQueue *q,uint event,evobj_t object) {
+	LockGuard<SpinLock> g(&q->lock);
+	for(auto it = q->list.cbegin(); it != q->list.cend(); ++it) {
+		if(it->event == event && it->evobject == object)
+			return true;
+	}
+	return false;
+}
+
+tid_t Sched::wakeupQueue(WaitQueue *q,uint event,evobj_t object,bool all) {
+	tid_t first = INVALID_TID;
+	uint64_t now = CPU::rdtsc();
+	LockGuard<SpinLock> g(&q->lock);
+	for(auto it = q->list.begin(); it != q->list.end(); ) {
 		auto old = it++;
-		assert(old->event == event);
-		if(old->evobject == 0 || old->evobject == object) {
-			removeFromEventlist(&*old);
+		if(old->event == event && old->evobject == object) {
+			/* remove it here, because removeFromEventlist() would acquire the queue lock again */
+			q->list.remove(&*old);
+			old->event = 0;
+			old->stats.wakeupStart = now;
 			setReady(&*old);
+			if(first == INVALID_TID)
+				first = old->getTid();
 			if(!all)
 				break;
 		}
 	}
+	return first;
 }
 
 void Sched::removeFromEventlist(Thread *t) {
 	if(t->event) {
 		/* important: remove it first from the event-list and set event to 0 */
-		evlists[t->event - 1].remove(t);
+		WaitQueue *q = getQueue(t->event,t->evobject);
+		LockGuard<SpinLock> g(&q->lock);
+		q->list.remove(t);
 		t->event = 0;
 	}
 }
@@ -321,15 +410,21 @@ void Sched::print(OStream &os) {
 void Sched::printEventLists(OStream &os) {
 	os.writef("Eventlists:\n");
 	for(size_t e = 0; e < EV_COUNT; e++) {
-		esc::DList<Thread> *list = evlists + e;
 		os.writef("\t%s:\n",getEventName(e + 1));
-		for(auto t = list->cbegin(); t != list->cend(); ++t) {
-			os.writef("\t\tthread=%d (%d:%s), object=%x",
-					t->getTid(),t->getProc()->getPid(),t->getProc()->getProgram(),t->evobject);
-			ino_t nodeNo = ((VFSNode*)t->evobject)->getNo();
-			if(VFSNode::isValid(nodeNo))
-				os.writef("(%s)",((VFSNode*)t->evobject)->getPath());
-			os.writef("\n");
+		for(size_t i = 0; i < WAIT_QUEUES; i++) {
+			esc::DList<Thread> *list = &waitQueues[i].list;
+			for(auto t = list->cbegin(); t != list->cend(); ++t) {
+				if(t->event != e + 1)
+					continue;
+				os.writef("\t\tthread=%d (%d:%s), object=%x",
+						t->getTid(),t->getProc()->getPid(),t->getProc()->getProgram(),t->evobject);
+				if(t->evobject) {
+					ino_t nodeNo = ((VFSNode*)t->evobject)->getNo();
+					if(VFSNode::isValid(nodeNo))
+						os.writef("(%s)",((VFSNode*)t->evobject)->getPath());
+				}
+				os.writef("\n");
+			}
 		}
 	}
 }
@@ -344,6 +439,7 @@ const char *Sched::getEventName(uint event) {
 		"SWAP_FREE",
 		"THREAD_DIED",
 		"CHILD_DIED",
+		"VFS_NODE",
 	};
 	return names[event - 1];
 }
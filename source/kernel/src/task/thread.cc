@@ -71,10 +71,11 @@ void ThreadBase::relRef(const Thread *t) {
 
 ThreadBase::ThreadBase(Proc *p,uint8_t flags)
 	: esc::DListItem(), tid(), refs(1), proc(p), sigHandler(), sigmask(), event(), evobject(),
-	  waitstart(), prioGoodCnt(), flags(flags), priority(MAX_PRIO), state(BLOCKED), newState(READY),
+	  waitstart(), handoff(), prioGoodCnt(), flags(flags), priority(MAX_PRIO), state(BLOCKED), newState(READY),
 	  cpu(), stackRegions(), threadDir(), threadListItem(static_cast<Thread*>(this)),
 	  signalListItem(static_cast<Thread*>(this)), reqFrames(), stats() {
 	stats.cycleStart = CPU::rdtsc();
+	handoff.tid = INVALID_TID;
 }
 
 Thread *ThreadBase::init(Proc *p) {
@@ -323,6 +324,7 @@ void ThreadBase::print(OStream &os) const {
 	os.writef("Scheduled = %lu\n",stats.schedCount);
 	os.writef("Syscalls = %lu\n",stats.syscalls);
 	os.writef("Migrations = %lu\n",stats.migrations);
+	os.writef("Wakeups = %lu (%Lu cycles latency in total)\n",stats.wakeups,stats.wakeupLatency);
 	os.writef("CurCycleCount = %Lu\n",stats.curCycleCount);
 	os.writef("LastCycleCount = %Lu\n",stats.lastCycleCount);
 	os.writef("cycleStart = %Lu\n",stats.cycleStart);
@@ -0,0 +1,115 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <esc/util.h>
+#include <mem/cache.h>
+#include <task/proc.h>
+#include <task/smp.h>
+#include <task/thread.h>
+#include <atomic.h>
+#include <common.h>
+#include <cpu.h>
+#include <errno.h>
+#include <lockguard.h>
+#include <spinlock.h>
+#include <trace.h>
+
+volatile uint Trace::mask = 0;
+Trace::Buffer *volatile Trace::buffers = NULL;
+size_t Trace::bufCount = 0;
+static SpinLock traceLock;
+
+size_t Trace::getMaxEvents() {
+	return bufCount * EVENT_COUNT;
+}
+
+int Trace::setMask(uint nmask) {
+	LockGuard<SpinLock> g(&traceLock);
+	nmask &= KTRACE_ALL;
+
+	if(nmask && !mask) {
+		/* the buffers are allocated on first use and kept afterwards, because there might still
+		 * be tracepoints running on other CPUs that have seen the old mask */
+		if(!buffers) {
+			size_t count = SMP::getCPUCount();
+			Buffer *bufs = (Buffer*)Cache::calloc(count,sizeof(Buffer));
+			if(!bufs)
+				return -ENOMEM;
+			for(size_t i = 0; i < count; i++) {
+				bufs[i].events = (struct ktrace_event*)Cache::alloc(
+					EVENT_COUNT * sizeof(struct ktrace_event));
+				if(!bufs[i].events) {
+					while(i-- > 0)
+						Cache::free(bufs[i].events);
+					Cache::free(bufs);
+					return -ENOMEM;
+				}
+			}
+			bufCount = count;
+			buffers = bufs;
+		}
+
+		/* start with empty buffers */
+		for(size_t i = 0; i < bufCount; i++)
+			buffers[i].pos = 0;
+	}
+
+	SpinLock::setProfiling(nmask & (1 << KTRACE_LOCK));
+	mask = nmask;
+	return 0;
+}
+
+void Trace::record(uint type,uint64_t arg1,uint64_t arg2,uint64_t arg3) {
+	cpuid_t cpu = SMP::getCurId();
+	if(EXPECT_FALSE(cpu >= bufCount))
+		return;
+
+	/* reserve a slot first; this makes it safe against interrupts and other tracepoints that are
+	 * hit in the meantime on this CPU */
+	Buffer *buf = buffers + cpu;
+	size_t idx = Atomic::fetch_and_add(&buf->pos,1);
+	struct ktrace_event *ev = buf->events + (idx % EVENT_COUNT);
+
+	Thread *t = Thread::getRunning();
+	ev->tsc = CPU::rdtsc();
+	ev->type = type;
+	ev->cpu = cpu;
+	ev->tid = t ? t->getTid() : INVALID_TID;
+	ev->pid = t ? t->getProc()->getPid() : INVALID_PID;
+	ev->args[0] = arg1;
+	ev->args[1] = arg2;
+	ev->args[2] = arg3;
+}
+
+size_t Trace::getEvents(struct ktrace_event *events,size_t max,uint64_t *lost) {
+	size_t total = 0;
+	*lost = 0;
+	if(!buffers)
+		return 0;
+
+	for(size_t i = 0; i < bufCount && total < max; i++) {
+		/* events that are recorded while we're copying may overwrite the oldest ones. thus, the
+		 * result is only a best-effort snapshot, which is good enough for tracing. */
+		size_t pos = buffers[i].pos;
+		size_t count = esc::Util::min(esc::Util::min(pos,EVENT_COUNT),max - total);
+		*lost += pos - count;
+		for(size_t j = pos - count; j < pos; j++)
+			events[total++] = buffers[i].events[j % EVENT_COUNT];
+	}
+	return total;
+}
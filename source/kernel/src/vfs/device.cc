@@ -29,6 +29,7 @@
 #include <common.h>
 #include <errno.h>
 #include <spinlock.h>
+#include <trace.h>
 #include <video.h>
 
 #define PRINT_MSGS			0
@@ -219,17 +220,23 @@ ssize_t VFSDevice::send(VFSChannel *chan,ushort flags,msgid_t id,USER const void
 			if(id >> 16 == 0)
 				id |= 0x00010000;
 
-			/* notify driver */
+			/* notify driver. the client will usually wait for the response now, so that we can
+			 * give the CPU directly to the handling thread */
 			addMsgs(1);
 			if(EXPECT_FALSE(msg2))
 				addMsgs(1);
 			Sched::wakeup(EV_CLIENT,(evobj_t)this,true);
+			Sched::handoff(Thread::getRunning(),chan->getHandler(),getOwner(),
+				EV_RECEIVED_MSG,(evobj_t)chan);
 		}
 		else {
 			/* for devices, we just use whatever the driver gave us */
 
-			/* notify receivers */
-			Sched::wakeup(EV_RECEIVED_MSG,(evobj_t)chan,true);
+			/* notify receivers and switch back to the client as soon as the driver waits for
+			 * the next request */
+			tid_t client = Sched::wakeup(EV_RECEIVED_MSG,(evobj_t)chan,true);
+			if(client != INVALID_TID)
+				Sched::handoff(Thread::getRunning(),client,chan->getOwner(),EV_CLIENT,(evobj_t)this);
 		}
 
 		/* append to list */
@@ -240,6 +247,7 @@ ssize_t VFSDevice::send(VFSChannel *chan,ushort flags,msgid_t id,USER const void
 			list->append(msg2);
 		}
 	}
+	Trace::event(KTRACE_MSG_SEND,id,size1,chan->getNo());
 
 #if PRINT_MSGS
 	{
@@ -314,6 +322,9 @@ ssize_t VFSDevice::receive(VFSChannel *chan,ushort flags,msgid_t *id,USER void *
 	if(event == EV_CLIENT)
 		remMsgs(1);
 	msgLock.up();
+	/* we got what we have been waiting for, so don't give the CPU away the next time we block */
+	Sched::cancelHandoff(t);
+	Trace::event(KTRACE_MSG_RECV,msg->id,msg->length,chan->getNo());
 
 #if PRINT_MSGS
 	Proc *p = Proc::getByPid(pid);
@@ -71,6 +71,91 @@ int VFSFS::fstat(pid_t pid,VFSChannel *chan,struct stat *info) {
 	return res;
 }
 
+int VFSFS::stat(pid_t pid,VFSChannel *chan,ino_t root,const char *path,uint flags,
+		ssize_t *sympos,struct stat *info) {
+	ulong buffer[IPC_DEF_SIZE / sizeof(ulong)];
+	esc::IPCBuf ib(buffer,sizeof(buffer));
+
+	const Proc *p = Proc::getByPid(pid);
+	fs::User user(p->getUid(),p->getGid(),p->getPid());
+	ib << esc::FSPathStat::Request(flags,user,esc::CString(path),root,0);
+
+	esc::FSPathStat::Result res;
+	int err = communicateOverChan(pid,chan,esc::FSPathStat::MSG,ib);
+	ib >> res;
+	if(ib.error())
+		return err < 0 ? err : -EINVAL;
+	*info = res.info;
+	*sympos = res.sympos;
+	/* set device id */
+	info->st_dev = chan->getParent()->getNo();
+	return err;
+}
+
+ssize_t VFSFS::readdirplus(pid_t pid,VFSChannel *chan,USER void *buffer,size_t count,
+		off_t *offset) {
+	ulong ibuffer[IPC_DEF_SIZE / sizeof(ulong)];
+	esc::IPCBuf ib(ibuffer,sizeof(ibuffer));
+
+	const Proc *p = Proc::getByPid(pid);
+	fs::User user(p->getUid(),p->getGid(),p->getPid());
+	ib << esc::FSReaddirPlus::Request(user,*offset,count);
+	if(ib.error())
+		return -EINVAL;
+
+	ssize_t res = chan->send(pid,0,esc::FSReaddirPlus::MSG,ib.buffer(),ib.pos(),NULL,0);
+	if(res < 0)
+		return res;
+
+	ib.reset();
+	msgid_t mid = res;
+	res = chan->receive(pid,0,&mid,ib.buffer(),ib.max());
+	if(res < 0)
+		return res;
+
+	esc::FSReaddirPlus::Response r;
+	ib >> r;
+	if(r.err < 0)
+		return r.err;
+
+	/* the records follow in a separate message */
+	if(r.res.size > 0) {
+		res = chan->receive(pid,0,&mid,buffer,count);
+		if(res < 0)
+			return res;
+	}
+	*offset = r.res.next;
+	return r.res.size;
+}
+
+ssize_t VFSFS::copyrange(pid_t pid,VFSChannel *in,VFSChannel *out,off_t inOffset,
+		off_t outOffset,size_t count) {
+	ulong buffer[IPC_DEF_SIZE / sizeof(ulong)];
+	esc::IPCBuf ib(buffer,sizeof(buffer));
+
+	const Proc *p = Proc::getByPid(pid);
+	fs::User user(p->getUid(),p->getGid(),p->getPid());
+	ib << esc::FSCopyRange::Request(user,out->getFd(),inOffset,outOffset,count);
+	if(ib.error())
+		return -EINVAL;
+
+	ssize_t res = in->send(pid,0,esc::FSCopyRange::MSG,ib.buffer(),ib.pos(),NULL,0);
+	if(res < 0)
+		return res;
+
+	ib.reset();
+	msgid_t mid = res;
+	res = in->receive(pid,0,&mid,ib.buffer(),ib.max());
+	if(res < 0)
+		return res;
+
+	esc::FSCopyRange::Response r;
+	ib >> r;
+	if(ib.error())
+		return -EINVAL;
+	return r.err < 0 ? r.err : r.res;
+}
+
 int VFSFS::truncate(pid_t pid,VFSChannel *chan,off_t length) {
 	ulong buffer[IPC_DEF_SIZE / sizeof(ulong)];
 	esc::IPCBuf ib(buffer,sizeof(buffer));
@@ -26,6 +26,7 @@
 #include <mem/useraccess.h>
 #include <mem/virtmem.h>
 #include <task/proc.h>
+#include <task/smp.h>
 #include <task/timer.h>
 #include <vfs/file.h>
 #include <vfs/fs.h>
@@ -41,13 +42,40 @@
 #include <errno.h>
 #include <ostringstream.h>
 #include <spinlock.h>
+#include <stdlib.h>
 #include <string.h>
+#include <trace.h>
 #include <util.h>
+#include <sys/ktrace.h>
+#include <sys/procstats.h>
 
 void VFSInfo::init(VFSNode *sysNode) {
 	VFSNode::release(createObj<MemUsageFile>(KERNEL_PID,sysNode));
 	VFSNode::release(createObj<CPUFile>(KERNEL_PID,sysNode));
 	VFSNode::release(createObj<StatsFile>(KERNEL_PID,sysNode));
+	VFSNode::release(createObj<ProcStatsFile>(KERNEL_PID,sysNode));
+	VFSNode::release(createObj<KTraceFile>(KERNEL_PID,sysNode));
+	/* the lock statistics are only for root, like the kernel trace */
+	VFSNode::release(createObj<LockStatFile>(KERNEL_PID,sysNode,(char*)"lockstat",S_IFREG | S_IRUSR));
+}
+
+ssize_t VFSInfo::KTraceFile::write(A_UNUSED pid_t pid,A_UNUSED OpenFile *file,
+		USER const void *buffer,A_UNUSED off_t offset,size_t count) {
+	char str[16];
+	size_t len = esc::Util::min(count,sizeof(str) - 1);
+	int res = UserAccess::read(str,buffer,len);
+	if(res < 0)
+		return res;
+	str[len] = '\0';
+
+	char *end;
+	uint mask = strtoul(str,&end,0);
+	if(end == str)
+		return -EINVAL;
+	if((res = Trace::setMask(mask)) < 0)
+		return res;
+	modtime = Timer::getTime();
+	return count;
 }
 
 void VFSInfo::traceReadCallback(VFSNode *node,size_t *dataSize,void **buffer) {
@@ -155,6 +183,8 @@ void VFSInfo::threadReadCallback(VFSNode *node,size_t *dataSize,void **buffer) {
 			"%-16s%Lu\n"
 			"%-16s%016Lx\n"
 			"%-16s%u\n"
+			"%-16s%zu\n"
+			"%-16s%Lu\n"
 			,
 			"Tid:",t->getTid(),
 			"Pid:",p->getPid(),
@@ -167,7 +197,9 @@ void VFSInfo::threadReadCallback(VFSNode *node,size_t *dataSize,void **buffer) {
 			"Syscalls:",t->getStats().syscalls,
 			"Runtime:",t->getRuntime(),
 			"Cycles:",t->getStats().lastCycleCount,
-			"CPU:",t->getCPU()
+			"CPU:",t->getCPU(),
+			"Wakeups:",t->getStats().wakeups,
+			"WakeupLatency:",t->getStats().wakeups ? t->getStats().wakeupLatency / t->getStats().wakeups : 0
 		);
 	}
 	Thread::relRef(t);
@@ -204,6 +236,70 @@ void VFSInfo::statsReadCallback(A_UNUSED VFSNode *node,size_t *dataSize,void **b
 	*dataSize = os.getLength();
 }
 
+void VFSInfo::procStatsReadCallback(A_UNUSED VFSNode *node,size_t *dataSize,void **buffer) {
+	/* leave some room for processes and threads that are created in the meantime */
+	size_t maxProcs = Proc::getCount() + 8;
+	size_t maxThreads = Thread::getCount() + 16;
+	size_t procsOff = sizeof(struct procstats_hdr);
+	size_t threadsOff = procsOff + maxProcs * sizeof(struct procstats_proc);
+	uint8_t *mem = (uint8_t*)Cache::alloc(threadsOff + maxThreads * sizeof(struct procstats_thread));
+	if(!mem)
+		return;
+
+	size_t threadCount;
+	struct procstats_hdr *hdr = (struct procstats_hdr*)mem;
+	struct procstats_proc *procs = (struct procstats_proc*)(mem + procsOff);
+	struct procstats_thread *threads = (struct procstats_thread*)(mem + threadsOff);
+	size_t procCount = Proc::getSnapshot(procs,maxProcs,threads,maxThreads,&threadCount);
+
+	/* move the thread records directly behind the process records */
+	size_t tcopy = procsOff + procCount * sizeof(struct procstats_proc);
+	memmove(mem + tcopy,threads,threadCount * sizeof(struct procstats_thread));
+
+	hdr->version = PROCSTATS_VERSION;
+	hdr->hdrSize = sizeof(struct procstats_hdr);
+	hdr->procSize = sizeof(struct procstats_proc);
+	hdr->threadSize = sizeof(struct procstats_thread);
+	hdr->procCount = procCount;
+	hdr->threadCount = threadCount;
+	hdr->cycles = CPU::rdtsc();
+	hdr->uptime = Timer::getIntrptCount() / Timer::FREQUENCY_DIV;
+
+	*buffer = mem;
+	*dataSize = tcopy + threadCount * sizeof(struct procstats_thread);
+}
+
+void VFSInfo::ktraceReadCallback(A_UNUSED VFSNode *node,size_t *dataSize,void **buffer) {
+	size_t maxEvents = Trace::getMaxEvents();
+	size_t eventsOff = sizeof(struct ktrace_hdr);
+	uint8_t *mem = (uint8_t*)Cache::alloc(eventsOff + maxEvents * sizeof(struct ktrace_event));
+	if(!mem)
+		return;
+
+	uint64_t lost;
+	struct ktrace_hdr *hdr = (struct ktrace_hdr*)mem;
+	struct ktrace_event *events = (struct ktrace_event*)(mem + eventsOff);
+	size_t count = Trace::getEvents(events,maxEvents,&lost);
+
+	hdr->version = KTRACE_VERSION;
+	hdr->hdrSize = sizeof(struct ktrace_hdr);
+	hdr->eventSize = sizeof(struct ktrace_event);
+	hdr->cpuCount = SMP::getCPUCount();
+	hdr->eventCount = count;
+	hdr->mask = Trace::getMask();
+	hdr->lost = lost;
+
+	*buffer = mem;
+	*dataSize = eventsOff + count * sizeof(struct ktrace_event);
+}
+
+void VFSInfo::lockStatReadCallback(A_UNUSED VFSNode *node,size_t *dataSize,void **buffer) {
+	OStringStream os;
+	SpinLock::printStats(os);
+	*buffer = os.keepString();
+	*dataSize = os.getLength();
+}
+
 void VFSInfo::memUsageReadCallback(A_UNUSED VFSNode *node,size_t *dataSize,void **buffer) {
 	OStringStream os;
 
@@ -24,6 +24,7 @@
 #include <mem/physmem.h>
 #include <task/groups.h>
 #include <task/proc.h>
+#include <task/sched.h>
 #include <vfs/channel.h>
 #include <vfs/device.h>
 #include <vfs/dir.h>
@@ -622,6 +623,16 @@ const VFSNode *VFSNode::findInDir(const char *ename,size_t enameLen,bool locked)
 	return res;
 }
 
+void VFSNode::append(VFSNode *p) {
+	{
+		LockGuard<SpinLock> guard(&treeLock);
+		doAppend(p);
+	}
+	/* channels are created on every open; nobody waits for them */
+	if(!IS_CHANNEL(mode))
+		Sched::wakeup(EV_VFS_NODE,0);
+}
+
 void VFSNode::doAppend(VFSNode *p) {
 	if(p != NULL) {
 		prev = NULL;
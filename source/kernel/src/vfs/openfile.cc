@@ -58,6 +58,9 @@ int OpenFile::fcntl(A_UNUSED pid_t pid,uint cmd,int arg) {
 		case F_GETFL:
 			return flags & VFS_NOBLOCK;
 
+		case F_GETREFS:
+			return refCount;
+
 		case F_SETFL: {
 			LockGuard<SpinLock> g(&lock);
 			flags &= VFS_READ | VFS_WRITE | VFS_MSGS | VFS_CREATE | VFS_DEVICE;
@@ -347,6 +350,84 @@ ssize_t OpenFile::read(pid_t pid,USER void *buffer,size_t count) {
 	return readBytes;
 }
 
+ssize_t OpenFile::readdirplus(pid_t pid,USER void *buffer,size_t count) {
+	if(EXPECT_FALSE(!(flags & VFS_READ)))
+		return -EACCES;
+	if(devNo == VFS_DEV_NO || !IS_CHANNEL(node->getMode()))
+		return -ENOTSUP;
+
+	VFSChannel *chan = static_cast<VFSChannel*>(node);
+	off_t offset = position;
+	ssize_t res = VFSFS::readdirplus(pid,chan,buffer,count,&offset);
+	if(EXPECT_TRUE(res >= 0)) {
+		LockGuard<SpinLock> g(&lock);
+		position = offset;
+	}
+	return res;
+}
+
+ssize_t OpenFile::copyrange(pid_t pid,OpenFile *out,USER void *shm,size_t count) {
+	if(EXPECT_FALSE(!(flags & VFS_READ) || !(out->flags & VFS_WRITE)))
+		return -EACCES;
+	if(!IS_CHANNEL(node->getMode()) || !IS_CHANNEL(out->node->getMode()))
+		return -ENOTSUP;
+
+	VFSChannel *inChan = static_cast<VFSChannel*>(node);
+	VFSChannel *outChan = static_cast<VFSChannel*>(out->node);
+	size_t total = 0;
+	ssize_t res = -ENOTSUP;
+
+	/* if both files are on the same fs instance, let the driver copy it */
+	if(devNo != VFS_DEV_NO && devNo == out->devNo) {
+		while(total < count) {
+			res = VFSFS::copyrange(pid,inChan,outChan,position,out->position,count - total);
+			if(res <= 0)
+				break;
+
+			{
+				LockGuard<SpinLock> g(&lock);
+				position += res;
+			}
+			{
+				LockGuard<SpinLock> g(&out->lock);
+				out->position += res;
+			}
+			total += res;
+		}
+		if(total > 0 || res != -ENOTSUP)
+			return total > 0 ? (ssize_t)total : res;
+	}
+
+	/* otherwise, move the data through the buffer that both drivers can access */
+	size_t amount = esc::Util::min(inChan->sharedSpace(shm),outChan->sharedSpace(shm));
+	if(amount == 0)
+		return -ENOTSUP;
+
+	while(total < count) {
+		size_t chunk = esc::Util::min(count - total,amount);
+		res = read(pid,shm,chunk);
+		if(res <= 0)
+			break;
+
+		ssize_t written = out->write(pid,shm,res);
+		if(written < res) {
+			/* don't skip the data that we could not write */
+			{
+				LockGuard<SpinLock> g(&lock);
+				position -= res - esc::Util::max(written,(ssize_t)0);
+			}
+			if(written > 0)
+				total += written;
+			res = written;
+			break;
+		}
+		total += written;
+		if((size_t)written < chunk)
+			break;
+	}
+	return total > 0 ? (ssize_t)total : res;
+}
+
 ssize_t OpenFile::write(pid_t pid,USER const void *buffer,size_t count) {
 	if(EXPECT_FALSE(!(flags & VFS_WRITE)))
 		return -EACCES;
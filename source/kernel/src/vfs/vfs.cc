@@ -25,6 +25,8 @@
 #include <task/filedesc.h>
 #include <task/groups.h>
 #include <task/proc.h>
+#include <task/sched.h>
+#include <task/thread.h>
 #include <task/timer.h>
 #include <usergroup/usergroup.h>
 #include <vfs/channel.h>
@@ -196,6 +198,60 @@ int VFS::hasAccess(pid_t pid,mode_t mode,uid_t uid,gid_t gid,ushort flags) {
 	return fs::Permissions::canAccess<Groups::contains>(&u,mode,uid,gid,perms);
 }
 
+int VFS::waitPath(Thread *t,const char *path,time_t msecs) {
+	time_t end = Timer::getRuntime() + msecs;
+	while(true) {
+		/* start waiting before we look for the node. this way, we can't miss it if it is created
+		 * in between. note that findNode() only uses spinlocks, so that we can't block here. */
+		t->wait(EV_VFS_NODE,0);
+		int res = findNode(t->getProc()->getPid(),path);
+		if(res != -ENOENT) {
+			Sched::unblock(t);
+			return res;
+		}
+
+		if(msecs) {
+			time_t now = Timer::getRuntime();
+			if(now >= end) {
+				Sched::unblock(t);
+				return -ETIMEOUT;
+			}
+			res = Timer::sleepFor(t->getTid(),end - now,true);
+			if(res < 0) {
+				Sched::unblock(t);
+				return res;
+			}
+		}
+
+		Thread::switchAway();
+		if(msecs)
+			Timer::removeThread(t->getTid());
+		if(t->hasSignal())
+			return -EINTR;
+	}
+}
+
+int VFS::findNode(pid_t pid,const char *path) {
+	OpenFile *fsFile;
+	const char *begin;
+	Proc *p = Proc::getByPid(pid);
+	ino_t root = p->getMS()->request(path,&begin,&fsFile);
+	if(root < 0)
+		return root;
+
+	/* we can only wait for nodes in the virtual fs */
+	int err = -ENOTSUP;
+	if(!IS_CHANNEL(fsFile->getNode()->getMode())) {
+		VFSNode *node = root == 0 ? fsFile->getNode() : VFSNode::get(root);
+		VFSNode::RequestResult rres;
+		err = VFSNode::request(begin,node,&rres,VFS_NOFOLLOW,0);
+		if(err == 0)
+			VFSNode::release(rres.node);
+	}
+	VFSMS::release(fsFile);
+	return err;
+}
+
 int VFS::openPath(pid_t pid,ushort flags,mode_t mode,const char *path,ssize_t *sympos,OpenFile **file) {
 	OpenFile *fsFile;
 	const char *begin;
@@ -298,6 +354,36 @@ errorMnt:
 	return err;
 }
 
+int VFS::stat(pid_t pid,const char *path,uint flags,ssize_t *sympos,struct stat *info) {
+	OpenFile *fsFile;
+	const char *begin;
+
+	Proc *p = Proc::getByPid(pid);
+	ino_t root = p->getMS()->request(path,&begin,&fsFile);
+	if(root < 0)
+		return root;
+
+	/* in the virtual fs, just open it */
+	if(!IS_CHANNEL(fsFile->getNode()->getMode())) {
+		VFSMS::release(fsFile);
+
+		OpenFile *file;
+		int err = openPath(pid,VFS_NOCHAN | (flags & VFS_NOFOLLOW),0,path,sympos,&file);
+		if(err < 0)
+			return err;
+		err = file->fstat(pid,info);
+		file->close(pid);
+		return err;
+	}
+
+	VFSChannel *chan = static_cast<VFSChannel*>(fsFile->getNode());
+	int err = VFSFS::stat(pid,chan,root,begin,flags & VFS_NOFOLLOW,sympos,info);
+	if(*sympos != -1)
+		*sympos += begin - path;
+	VFSMS::release(fsFile);
+	return err;
+}
+
 int VFS::openFile(pid_t pid,uint8_t mntperms,ushort flags,const VFSNode *node,ino_t nodeNo,
 				  dev_t devNo,OpenFile **file) {
 	int err;
@@ -0,0 +1,172 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <mem/cache.h>
+#include <sys/ktrace.h>
+#include <sys/test.h>
+#include <task/smp.h>
+#include <common.h>
+#include <trace.h>
+
+/* a type that isn't recorded by the kernel itself while the tests are running */
+#define TEST_TYPE			KTRACE_MSG_SEND
+
+/* forward declarations */
+static void test_trace();
+static void test_trace_mask();
+static void test_trace_order();
+static void test_trace_wrap();
+static void test_trace_reset();
+
+/* our test-module */
+sTestModule tModTrace = {
+	"Tracing",
+	&test_trace
+};
+
+static struct ktrace_event *events;
+static size_t maxEvents;
+static size_t perCPU;
+
+static void test_trace() {
+	test_trace_mask();
+	if(events) {
+		test_trace_order();
+		test_trace_wrap();
+		test_trace_reset();
+	}
+
+	Trace::setMask(0);
+	Cache::free(events);
+	events = NULL;
+}
+
+static void record(uint64_t first,size_t count) {
+	for(size_t i = 0; i < count; i++)
+		Trace::event(TEST_TYPE,first + i,i);
+}
+
+/* collects the events of the current CPU and checks that they are <first> .. <first>+<count>-1 */
+static void checkEvents(size_t max,uint64_t first,size_t count,uint64_t expLost) {
+	uint64_t lost;
+	size_t total = Trace::getEvents(events,max,&lost);
+	test_assertULLInt(lost,expLost);
+
+	size_t found = 0;
+	cpuid_t cpu = SMP::getCurId();
+	for(size_t i = 0; i < total; i++) {
+		if(events[i].cpu != cpu)
+			continue;
+		test_assertUInt(events[i].type,TEST_TYPE);
+		test_assertULLInt(events[i].args[0],first + found);
+		found++;
+	}
+	test_assertSize(found,count);
+}
+
+static void test_trace_mask() {
+	test_caseStart("Setting the mask");
+
+	test_assertInt(Trace::setMask(0),0);
+	test_assertUInt(Trace::getMask(),0);
+
+	/* unknown bits are ignored */
+	test_assertInt(Trace::setMask(~0U),0);
+	test_assertUInt(Trace::getMask(),KTRACE_ALL);
+
+	test_assertInt(Trace::setMask(1 << TEST_TYPE),0);
+	test_assertUInt(Trace::getMask(),1 << TEST_TYPE);
+
+	/* the buffers exist now */
+	maxEvents = Trace::getMaxEvents();
+	perCPU = maxEvents / SMP::getCPUCount();
+	test_assertTrue(perCPU > 0);
+	events = (struct ktrace_event*)Cache::alloc(maxEvents * sizeof(struct ktrace_event));
+	test_assertTrue(events != NULL);
+
+	test_caseSucceeded();
+}
+
+static void test_trace_order() {
+	test_caseStart("Recording events");
+
+	/* start with empty buffers */
+	Trace::setMask(0);
+	Trace::setMask(1 << TEST_TYPE);
+	checkEvents(maxEvents,0,0,0);
+
+	record(100,10);
+	/* disabled types are not recorded */
+	Trace::event(KTRACE_PAGEFAULT,0);
+	checkEvents(maxEvents,100,10,0);
+
+	test_caseSucceeded();
+}
+
+static void test_trace_wrap() {
+	test_caseStart("Overwriting old events");
+
+	Trace::setMask(0);
+	Trace::setMask(1 << TEST_TYPE);
+
+	/* fill the buffer exactly */
+	record(0,perCPU);
+	checkEvents(maxEvents,0,perCPU,0);
+
+	/* now the oldest ones are overwritten */
+	record(perCPU,10);
+	checkEvents(maxEvents,10,perCPU,10);
+
+	/* if the caller has not enough space, it gets the newest events */
+	checkEvents(5,perCPU + 5,5,perCPU + 5);
+
+	/* wrap around multiple times */
+	record(perCPU + 10,perCPU * 2 + 3);
+	checkEvents(maxEvents,perCPU * 2 + 13,perCPU,perCPU * 2 + 13);
+
+	test_caseSucceeded();
+}
+
+static void test_trace_reset() {
+	test_caseStart("Resetting the buffers");
+
+	Trace::setMask(0);
+	Trace::setMask(1 << TEST_TYPE);
+	record(0,20);
+
+	/* disabling keeps the events, but doesn't record new ones */
+	Trace::setMask(0);
+	record(20,5);
+	checkEvents(maxEvents,0,20,0);
+
+	/* changing the mask while enabled keeps the events as well */
+	Trace::setMask(1 << TEST_TYPE);
+	record(20,5);
+	Trace::setMask((1 << TEST_TYPE) | (1 << KTRACE_MSG_RECV));
+	checkEvents(maxEvents,0,25,0);
+
+	/* enabling it again starts with empty buffers */
+	Trace::setMask(0);
+	Trace::setMask(1 << TEST_TYPE);
+	checkEvents(maxEvents,0,0,0);
+	record(50,3);
+	checkEvents(maxEvents,50,3,0);
+
+	test_caseSucceeded();
+}
@@ -25,16 +25,23 @@
 static const size_t DIRE_SIZE	= sizeof(struct dirent) - (NAME_MAX + 1);
 
 bool readdirto(DIR *dir,struct dirent *e) {
-	if(fread(e,1,DIRE_SIZE,dir) > 0) {
+	while(fread(e,1,DIRE_SIZE,dir) > 0) {
 		/* convert endianess */
 		e->d_namelen = le16tocpu(e->d_namelen);
 		e->d_reclen = le16tocpu(e->d_reclen);
 		e->d_ino = le32tocpu(e->d_ino);
 		size_t len = e->d_namelen;
 		/* ensure that the name is short enough */
-		if(len >= NAME_MAX)
+		if(len >= NAME_MAX || e->d_reclen < DIRE_SIZE)
 			return false;
 
+		/* skip unused entries (e.g., the blocks of a directory-index look like that) */
+		if(len == 0) {
+			if(fseek(dir,e->d_reclen - DIRE_SIZE,SEEK_CUR) < 0)
+				return false;
+			continue;
+		}
+
 		/* now read the name */
 		if(fread(e->d_name,1,len,dir) > 0) {
 			/* if the record is longer, we have to skip the stuff until the next record */
@@ -48,6 +55,7 @@ bool readdirto(DIR *dir,struct dirent *e) {
 			e->d_name[e->d_namelen] = '\0';
 			return true;
 		}
+		break;
 	}
 
 	return false;
@@ -46,6 +46,8 @@ extern A_WEAK void sigRetFunc(void);
 extern void initTLS(void);
 extern void initStdio(void);
 extern void initHeap(void);
+extern void initHeapCache(void);
+extern void heapThreadExit(void);
 
 /**
  * Is called at the very beginning to setup some initial stuff
@@ -122,6 +124,10 @@ void __cxa_finalize(A_UNUSED void *d) {
 			exitFuncs[i].f(exitFuncs[i].p);
 	}
 	usemup(&__libc_sem);
+
+	/* give the objects in our heap-cache back. this has to be done last, because the
+	 * exit-functions might still allocate memory */
+	heapThreadExit();
 }
 
 uintptr_t __libc_preinit(uintptr_t entryPoint,int argc,char *argv[]) {
@@ -143,6 +149,7 @@ uintptr_t __libc_preinit(uintptr_t entryPoint,int argc,char *argv[]) {
 		if(usemcrt(&__libc_sem,1) < 0)
 			error("Unable to create libc lock");
 		initHeap();
+		initHeapCache();
 		initialized = true;
 	}
 	initTLS();
@@ -0,0 +1,40 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/pipe.h>
+#include <stdio.h>
+
+#include "iobuf.h"
+
+ssize_t bfdread(FILE *f,void *ptr,size_t count) {
+	sIOBuf *buf = &f->in;
+	/* read directly from the ring, if possible, to not need a message for every chunk */
+	tPipeEnd *end = bpipe(buf);
+	if(end) {
+		if(f->flags & O_SIGNALS)
+			return piperead(end,ptr,count);
+		return IGNSIGS(piperead(end,ptr,count));
+	}
+
+	if(f->flags & O_SIGNALS)
+		return read(buf->fd,ptr,count);
+	return IGNSIGS(read(buf->fd,ptr,count));
+}
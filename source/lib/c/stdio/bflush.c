@@ -32,7 +32,7 @@ int bflush(FILE *f) {
 				fflush(stdout);
 			res = buf->pos;
 			buf->pos = 0;
-			if((res = write(buf->fd,buf->buffer,res * sizeof(char))) < 0) {
+			if((res = bfdwrite(f,buf->buffer,res * sizeof(char))) < 0) {
 				f->error = (int)res;
 				return EOF;
 			}
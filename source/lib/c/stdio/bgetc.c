@@ -33,10 +33,7 @@ int bgetc(FILE *f) {
 			fflush(stdout);
 		if(buf->pos >= buf->max) {
 			ssize_t count;
-			if(f->flags & O_SIGNALS)
-				count = read(buf->fd,buf->buffer,IN_BUFFER_SIZE);
-			else
-				count = IGNSIGS(read(buf->fd,buf->buffer,IN_BUFFER_SIZE));
+			count = bfdread(f,buf->buffer,IN_BUFFER_SIZE);
 			if(count < 0) {
 				f->error = (int)count;
 				return EOF;
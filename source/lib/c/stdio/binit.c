@@ -33,6 +33,8 @@ bool binit(FILE *f,int fd,uint flags,char *buffer,size_t insize,size_t outsize,b
 	f->istty = 0;
 	f->in.buffer = NULL;
 	f->out.buffer = NULL;
+	f->in.pipechk = f->out.pipechk = false;
+	f->in.pipe = f->out.pipe = NULL;
 	f->prev = NULL;
 	f->next = NULL;
 
@@ -27,11 +27,15 @@ int fclose(FILE *stream) {
 	int res = 0;
 	fflush(stream);
 	if(stream->in.fd >= 0) {
+		if(stream->in.pipe)
+			pipeunmap(stream->in.pipe);
 		if((stream->flags & O_NOCLOSE) == 0)
 			close(stream->in.fd);
 		free(stream->in.buffer);
 	}
 	if(stream->out.fd >= 0 || stream->out.dynamic) {
+		if(stream->out.pipe)
+			pipeunmap(stream->out.pipe);
 		if(stream->out.fd >= 0 && (stream->flags & O_NOCLOSE) == 0)
 			close(stream->out.fd);
 		free(stream->out.buffer);
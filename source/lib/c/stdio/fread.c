@@ -44,19 +44,13 @@ size_t fread(void *ptr,size_t size,size_t count,FILE *file) {
 	if(buf->fd >= 0) {
 		/* if its more than the buffer-capacity, better read it at once without buffer */
 		if(rem > IN_BUFFER_SIZE) {
-			if(file->flags & O_SIGNALS)
-				res = read(buf->fd,cptr,rem);
-			else
-				res = IGNSIGS(read(buf->fd,cptr,rem));
+			res = bfdread(file,cptr,rem);
 			if(res > 0)
 				rem -= res;
 		}
 		/* otherwise fill the buffer and copy the part the user wants */
 		else if(rem > 0) {
-			if(file->flags & O_SIGNALS)
-				res = read(buf->fd,buf->buffer,IN_BUFFER_SIZE);
-			else
-				res = IGNSIGS(read(buf->fd,buf->buffer,IN_BUFFER_SIZE));
+			res = bfdread(file,buf->buffer,IN_BUFFER_SIZE);
 			if(res > 0) {
 				size_t amount = MIN((size_t)res,rem);
 				memcpy(cptr,file->in.buffer,amount);
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <sys/common.h>
+#include <sys/pipe.h>
 #include <sys/sync.h>
 
 #define IN_BUFFER_SIZE		1024
@@ -85,6 +86,10 @@ typedef struct {
 	size_t pos;
 	size_t max;
 	uchar dynamic;
+	/* whether we have already checked if fd is a pipe end that we can map */
+	uchar pipechk;
+	/* the mapped pipe end, if so */
+	tPipeEnd *pipe;
 	char *buffer;
 } sIOBuf;
 
@@ -121,6 +126,8 @@ char *bgets(FILE *f,char *str,size_t size);
 int breadn(FILE *f,llong *num,size_t length,int c);
 int breads(FILE *f,size_t length,char *str);
 ssize_t bwrite(FILE *f,const void *ptr,size_t count);
+ssize_t bfdread(FILE *f,void *ptr,size_t count);
+ssize_t bfdwrite(FILE *f,const void *ptr,size_t count);
 int vbscanf(FILE *f,const char *fmt,va_list ap);
 
 FILE *bcreate(int fd,uint flags,char *buffer,size_t insize,size_t outsize,bool dynamic);
@@ -161,6 +168,15 @@ static inline uint parsemode(const char *mode) {
 	return flags;
 }
 
+/* maps the ring of <buf>'s fd, if it is a pipe end that only we use. only done once per stream */
+static inline tPipeEnd *bpipe(sIOBuf *buf) {
+	if(!buf->pipechk) {
+		buf->pipechk = true;
+		buf->pipe = pipemapexcl(buf->fd);
+	}
+	return buf->pipe;
+}
+
 static inline void benqueue(FILE *f) {
 	if(iostreams)
 		iostreams->prev = f;
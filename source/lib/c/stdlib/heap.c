@@ -18,16 +18,30 @@
  */
 
 #include <sys/arch.h>
+#include <sys/atomic.h>
 #include <sys/common.h>
 #include <sys/conf.h>
 #include <sys/debug.h>
 #include <sys/mman.h>
 #include <sys/sync.h>
+#include <sys/tls.h>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * The heap consists of three layers:
+ * 1. every thread has a cache with a free-list per size-class. malloc and free operate only on
+ *    this cache in the common case and thus need no lock at all.
+ * 2. if a cache-bin is empty or too full, a batch of objects is moved from or to the central
+ *    free-list of the size-class, which is protected by a lock per size-class.
+ * 3. the central free-lists are refilled by carving spans (slabs) of pages, that are taken from
+ *    the data-region of the process via chgsize.
+ * Allocations that are larger than the largest size-class are mapped directly via mmap and
+ * unmapped again on free.
+ */
+
 #if DEBUGGING
 #define DEBUG_ALLOC_N_FREE		0
 #define DEBUG_ALLOC_N_FREE_PID	27	/* -1 = all */
@@ -37,121 +51,409 @@
 #define ROUND_UP(count,align)	(((count) + (align) - 1) & ~((align) - 1))
 
 #define GUARD_MAGIC				0xDEADBEEF
+#define LARGE_MAGIC				0xDEADBEE0
 #define FREE_MAGIC				0xFEEEFEEE
 
-/* an area in memory */
-typedef struct sMemArea sMemArea;
-struct sMemArea {
-	size_t size;
-	void *address;
-	sMemArea *next;
+/* the sizes of the classes grow by 16 bytes up to 128 bytes and by a quarter of the power of two
+ * afterwards, i.e. 16,32,...,128,160,192,224,256,320,...,32768 */
+#define SMALL_CLASSES			8
+#define SMALL_STEP				16
+#define CLASS_COUNT				40
+#define MAX_CLASS_SIZE			32768
+
+/* the minimum number of pages and objects per span */
+#define SPAN_MIN_PAGES			4
+#define SPAN_MIN_OBJS			8
+/* the number of bytes that we move between a thread-cache and the central list at once */
+#define BATCH_BYTES				(PAGE_SIZE * 2)
+#define BATCH_MAX				64
+
+#define HEADER_SIZE				sizeof(sHeader)
+
+/* the value of the TLS slot of threads that have already given their cache back */
+#define CACHE_EXITED			1UL
+
+/* the header in front of each object */
+typedef struct {
+	ulong info;		/* the class for small objects or the mapping size for large objects */
+	ulong magic;	/* GUARD_MAGIC, LARGE_MAGIC or FREE_MAGIC */
+} sHeader;
+
+/* a free object; the link is stored behind the header */
+typedef struct sFreeObj sFreeObj;
+struct sFreeObj {
+	sFreeObj *next;
 };
 
-void initHeap(void);
+/* the central free-list of a size-class */
+typedef struct {
+	tUserSem lock;
+	sFreeObj *list;
+	size_t count;
+	size_t spans;
+} sSizeClass;
 
-/**
- * Allocates a new page for areas
- *
- * @return true on success
- */
-static bool loadNewAreas(void);
+/* a bin of a thread-cache */
+typedef struct {
+	sFreeObj *list;
+	size_t count;
+} sCacheBin;
+
+/* the cache of one thread */
+typedef struct sThreadCache sThreadCache;
+struct sThreadCache {
+	sCacheBin bins[CLASS_COUNT];
+	/* may become negative if we free objects of other threads */
+	long used;
+	size_t mallocs;
+	size_t frees;
+	size_t refills;
+	size_t flushes;
+	sThreadCache *next;
+};
+
+void initHeap(void);
+void initHeapCache(void);
+void heapThreadExit(void);
+void heapPreFork(void);
+void heapPostFork(bool child);
 
 /**
- * Allocates new space for alloation
+ * Allocates new space for a span of the given class
  *
- * @param size the minimum size
+ * @param cls the size-class
  * @return true on success
  */
-static bool loadNewSpace(size_t size);
-
-/* a linked list of free and usable areas. That means the areas have an address and size */
-static sMemArea *usableList = NULL;
-/* a linked list of free but not usable areas. That means the areas have no address and size */
-static sMemArea *freeList = NULL;
+static bool loadNewSpan(size_t cls);
+
+/* the size-classes */
+static sSizeClass classes[CLASS_COUNT];
+/* the TLS slot for the thread-caches or -1 if there are none */
+static long cacheKey = -1;
+/* all caches of living threads and the ones of dead threads for reuse */
+static sThreadCache *caches = NULL;
+static sThreadCache *freeCaches = NULL;
+/* the statistics that are not counted in the thread-caches */
+static long globalUsed = 0;
+static long largeBytes = 0;
+static long largeCount = 0;
+static long globalMallocs = 0;
+static long globalFrees = 0;
+static size_t globalRefills = 0;
+static size_t globalFlushes = 0;
 /* total number of pages we're using */
 static uintptr_t heapstart = 0;
 static size_t pageCount = 0;
 
-/* the lock for the heap */
+/* the lock for the pages and the cache-lists */
 static tUserSem heapSem;
 static bool initialized = false;
 
+static inline size_t classSize(size_t cls) {
+	if(cls < SMALL_CLASSES)
+		return (cls + 1) * SMALL_STEP;
+	size_t k = cls - SMALL_CLASSES;
+	size_t bit = 7 + k / 4;
+	return (1UL << bit) + ((k % 4) + 1) * (1UL << (bit - 2));
+}
+
+static inline size_t sizeToClass(size_t size) {
+	if(size <= SMALL_CLASSES * SMALL_STEP)
+		return (size + SMALL_STEP - 1) / SMALL_STEP - 1;
+	size_t s = size - 1;
+	size_t bit = sizeof(ulong) * 8 - 1 - __builtin_clzl(s);
+	return SMALL_CLASSES + (bit - 7) * 4 + ((s >> (bit - 2)) & 3);
+}
+
+static inline size_t batchSize(size_t cls) {
+	size_t n = BATCH_BYTES / classSize(cls);
+	return n < 2 ? 2 : (n > BATCH_MAX ? BATCH_MAX : n);
+}
+
+static inline sHeader *objHeader(sFreeObj *obj) {
+	return (sHeader*)obj;
+}
+
+static inline sFreeObj **objLink(sFreeObj *obj) {
+	return (sFreeObj**)((uintptr_t)obj + HEADER_SIZE);
+}
+
 void initHeap(void) {
 	if(initialized)
 		return;
 
 	if(usemcrt(&heapSem,1) < 0)
 		error("Unable to create heap lock");
+	for(size_t i = 0; i < CLASS_COUNT; ++i) {
+		if(usemcrt(&classes[i].lock,1) < 0)
+			error("Unable to create heap lock");
+	}
 	initialized = true;
 }
 
-void *malloc(size_t size) {
-	ulong *begin;
-	sMemArea *area,*prev,*narea;
+void initHeapCache(void) {
+	if(cacheKey == -1)
+		cacheKey = tlsadd();
+}
 
-	if(size == 0)
+/**
+ * Takes up to <max> objects from the central list of class <cls>.
+ *
+ * @return the number of objects put into <list>
+ */
+static size_t centralFetch(size_t cls,sFreeObj **list,size_t max) {
+	sSizeClass *c = classes + cls;
+	size_t n = 0;
+
+	usemdown(&c->lock);
+	if(c->list == NULL && !loadNewSpan(cls)) {
+		usemup(&c->lock);
+		return 0;
+	}
+
+	sFreeObj *first = c->list;
+	sFreeObj *last = NULL;
+	sFreeObj *obj = first;
+	while(obj && n < max) {
+		last = obj;
+		obj = *objLink(obj);
+		n++;
+	}
+	*objLink(last) = NULL;
+	c->list = obj;
+	c->count -= n;
+	usemup(&c->lock);
+
+	*list = first;
+	return n;
+}
+
+/**
+ * Puts the <n> objects in <list> back into the central list of class <cls>.
+ */
+static void centralRelease(size_t cls,sFreeObj *list,sFreeObj *last,size_t n) {
+	sSizeClass *c = classes + cls;
+	usemdown(&c->lock);
+	*objLink(last) = c->list;
+	c->list = list;
+	c->count += n;
+	usemup(&c->lock);
+}
+
+static sThreadCache *getCache(void) {
+	if(EXPECT_FALSE(cacheKey == -1))
+		return NULL;
+	/* initTLS allocates the TLS struct itself, which is NULL until then */
+	ulong *tls = *(ulong**)stack_top(2);
+	if(EXPECT_FALSE(tls == NULL))
 		return NULL;
 
-	usemdown(&heapSem);
+	sThreadCache *cache = (sThreadCache*)tls[cacheKey];
+	if(EXPECT_TRUE((ulong)cache > CACHE_EXITED))
+		return cache;
+	/* the thread is exiting and has already given its cache back; don't create a new one,
+	 * because nobody would give that back */
+	if(EXPECT_FALSE((ulong)cache == CACHE_EXITED))
+		return NULL;
 
-	/* align and we need 3 ulongs for the guards */
-	size = ROUND_UP(size,sizeof(ulong)) + sizeof(ulong) * 4;
-
-	/* find a suitable area */
-	prev = NULL;
-	area = usableList;
-	while(area != NULL) {
-		if(area->size >= size)
-			break;
-		prev = area;
-		area = area->next;
+	/* it's the first allocation of this thread; create a cache for it */
+	usemdown(&heapSem);
+	if(freeCaches) {
+		cache = freeCaches;
+		freeCaches = freeCaches->next;
 	}
+	usemup(&heapSem);
 
-	/* no area found? */
-	if(area == NULL) {
-		if(!loadNewSpace(size)) {
-			usemup(&heapSem);
+	if(cache == NULL) {
+		sFreeObj *obj;
+		size_t cls = sizeToClass(sizeof(sThreadCache) + HEADER_SIZE);
+		if(centralFetch(cls,&obj,1) == 0)
 			return NULL;
-		}
-		/* we can assume that it fits */
-		area = usableList;
-		/* remove from usable-list */
-		usableList = area->next;
+		objHeader(obj)->info = cls;
+		objHeader(obj)->magic = GUARD_MAGIC;
+		atomic_add(&globalUsed,classSize(cls));
+		cache = (sThreadCache*)(objHeader(obj) + 1);
 	}
-	else {
-		/* remove from usable-list */
-		if(prev == NULL)
-			usableList = area->next;
+	memclear(cache,sizeof(sThreadCache));
+
+	usemdown(&heapSem);
+	cache->next = caches;
+	caches = cache;
+	usemup(&heapSem);
+
+	tls[cacheKey] = (ulong)cache;
+	return cache;
+}
+
+static void flushBin(sThreadCache *cache,size_t cls,size_t keep) {
+	sCacheBin *bin = cache->bins + cls;
+	if(bin->count <= keep)
+		return;
+
+	size_t n = bin->count - keep;
+	sFreeObj *first = bin->list;
+	sFreeObj *last = first;
+	for(size_t i = 1; i < n; ++i)
+		last = *objLink(last);
+	bin->list = *objLink(last);
+	bin->count = keep;
+	centralRelease(cls,first,last,n);
+	cache->flushes++;
+}
+
+/**
+ * Gives all objects of <cache>, which is not in the list of caches anymore, back, keeps the
+ * statistics and puts it into the list of free caches for the next thread.
+ */
+static void releaseCache(sThreadCache *cache) {
+	for(size_t i = 0; i < CLASS_COUNT; ++i)
+		flushBin(cache,i,0);
+
+	usemdown(&heapSem);
+	atomic_add(&globalUsed,cache->used);
+	globalMallocs += cache->mallocs;
+	globalFrees += cache->frees;
+	globalRefills += cache->refills;
+	globalFlushes += cache->flushes;
+	cache->next = freeCaches;
+	freeCaches = cache;
+	usemup(&heapSem);
+}
+
+void heapThreadExit(void) {
+	if(cacheKey == -1)
+		return;
+	ulong *tls = *(ulong**)stack_top(2);
+	if(tls == NULL)
+		return;
+
+	sThreadCache *cache = (sThreadCache*)tls[cacheKey];
+	/* allocations from now on go to the central lists */
+	tls[cacheKey] = CACHE_EXITED;
+	if((ulong)cache <= CACHE_EXITED)
+		return;
+
+	usemdown(&heapSem);
+	sThreadCache *c = caches, *prev = NULL;
+	while(c != cache) {
+		prev = c;
+		c = c->next;
+	}
+	if(prev)
+		prev->next = cache->next;
+	else
+		caches = cache->next;
+	usemup(&heapSem);
+
+	releaseCache(cache);
+}
+
+void heapPreFork(void) {
+	/* the child inherits the locks in their current state, but not the threads that hold them.
+	 * thus, make sure that nobody is in the middle of changing the heap. a thread holds at most
+	 * one class lock and takes heapSem after it, so that this order can't deadlock */
+	for(size_t i = 0; i < CLASS_COUNT; ++i)
+		usemdown(&classes[i].lock);
+	usemdown(&heapSem);
+}
+
+void heapPostFork(bool child) {
+	usemup(&heapSem);
+	for(size_t i = 0; i < CLASS_COUNT; ++i)
+		usemup(&classes[i].lock);
+	if(!child || cacheKey == -1)
+		return;
+
+	/* only the forking thread exists in the child. give the caches of all others back, because
+	 * they would never be released otherwise */
+	ulong *tls = *(ulong**)stack_top(2);
+	sThreadCache *own = tls ? (sThreadCache*)tls[cacheKey] : NULL;
+	sThreadCache *c = caches;
+	caches = NULL;
+	while(c != NULL) {
+		sThreadCache *next = c->next;
+		if(c == own) {
+			own->next = NULL;
+			caches = own;
+		}
 		else
-			prev->next = area->next;
+			releaseCache(c);
+		c = next;
 	}
+}
+
+static void *allocLarge(size_t size) {
+	/* check for overflow */
+	if(size + PAGE_SIZE < size)
+		return NULL;
+
+	size = ROUND_UP(size,PAGE_SIZE);
+	sHeader *h = (sHeader*)mmap(NULL,size,0,PROT_READ | PROT_WRITE,MAP_PRIVATE,-1,0);
+	if(h == NULL)
+		return NULL;
+
+	atomic_add(&largeBytes,size);
+	atomic_add(&largeCount,1);
+	h->info = size;
+	h->magic = LARGE_MAGIC;
+	return h;
+}
+
+static void freeLarge(sHeader *h) {
+	atomic_add(&largeBytes,-(long)h->info);
+	atomic_add(&largeCount,-1);
+	munmap(h);
+}
 
-	/* is there space left? */
-	if(size < area->size) {
-		if(freeList == NULL) {
-			if(!loadNewAreas()) {
-				/* TODO we may have changed something... */
-				usemup(&heapSem);
+void *malloc(size_t size) {
+	sHeader *h;
+	sFreeObj *obj;
+
+	if(size == 0)
+		return NULL;
+
+	/* align and we need space for the header */
+	size = ROUND_UP(size,sizeof(ulong)) + HEADER_SIZE;
+	if(EXPECT_FALSE(size > MAX_CLASS_SIZE)) {
+		h = (sHeader*)allocLarge(size);
+		if(h == NULL)
+			return NULL;
+		goto done;
+	}
+
+	size_t cls = sizeToClass(size);
+	sThreadCache *cache = getCache();
+	if(EXPECT_TRUE(cache)) {
+		sCacheBin *bin = cache->bins + cls;
+		if(EXPECT_FALSE(bin->list == NULL)) {
+			bin->count = centralFetch(cls,&bin->list,batchSize(cls));
+			if(bin->count == 0)
 				return NULL;
-			}
+			cache->refills++;
 		}
-
-		/* split the area */
-		narea = freeList;
-		freeList = freeList->next;
-		narea->address = (void*)((uintptr_t)area->address + size);
-		narea->size = area->size - size;
-		area->size = size;
-		/* insert in usable-list */
-		narea->next = usableList;
-		usableList = narea;
+		obj = bin->list;
+		bin->list = *objLink(obj);
+		bin->count--;
+		cache->used += classSize(cls);
+		cache->mallocs++;
 	}
+	else {
+		if(centralFetch(cls,&obj,1) == 0)
+			return NULL;
+		atomic_add(&globalUsed,classSize(cls));
+		atomic_add(&globalMallocs,1);
+	}
+
+	h = objHeader(obj);
+	h->info = cls;
+	h->magic = GUARD_MAGIC;
 
+done:
 #if DEBUG_ALLOC_N_FREE
 	if(DEBUG_ALLOC_N_FREE_PID == -1 || getpid() == DEBUG_ALLOC_N_FREE_PID) {
 		size_t i = 0;
 		uintptr_t *trace = getStackTrace();
-		debugf("[A] %x %d ",(char*)area->address + 3,area->size);
+		debugf("[A] %x %d ",h + 1,size);
 		while(*trace && i++ < 10) {
 			debugf("%x",*trace);
 			if(trace[1])
@@ -161,15 +463,7 @@ void *malloc(size_t size) {
 		debugf("\n");
 	}
 #endif
-
-	/* add guards */
-	begin = (ulong*)area->address;
-	begin[0] = (ulong)area;
-	begin[1] = size - sizeof(ulong) * 4;
-	begin[2] = GUARD_MAGIC;
-	begin[size / sizeof(ulong) - 1] = GUARD_MAGIC;
-	usemup(&heapSem);
-	return begin + 3;
+	return h + 1;
 }
 
 void *calloc(size_t num,size_t size) {
@@ -182,53 +476,22 @@ void *calloc(size_t num,size_t size) {
 }
 
 void free(void *addr) {
-	ulong *begin;
-	sMemArea *area,*a,*prev,*next,*nprev,*pprev,*tprev;
+	sHeader *h;
 
 	/* addr may be null */
 	if(addr == NULL)
 		return;
 
 	/* check guards */
-	begin = (ulong*)addr - 3;
-	area = (sMemArea*)begin[0];
-	vassert(begin[0] != FREE_MAGIC,"Duplicate free of %p?",addr);
-	assert(begin[2] == GUARD_MAGIC);
-	assert(begin[begin[1] / sizeof(ulong) + 3] == GUARD_MAGIC);
-
-	usemdown(&heapSem);
-
-	/* mark as free */
-	begin[0] = FREE_MAGIC;
-
-	/* find the previous and next free areas */
-	prev = NULL;
-	next = NULL;
-	tprev = NULL;
-	pprev = NULL;
-	nprev = NULL;
-	a = usableList;
-	while(a != NULL) {
-		if((uintptr_t)a->address + a->size == (uintptr_t)begin) {
-			prev = a;
-			pprev = tprev;
-		}
-		if((uintptr_t)a->address == (uintptr_t)begin + area->size) {
-			next = a;
-			nprev = tprev;
-		}
-		/* do we have both? */
-		if(prev && next)
-			break;
-		tprev = a;
-		a = a->next;
-	}
+	h = (sHeader*)addr - 1;
+	vassert(h->magic != FREE_MAGIC,"Duplicate free of %p?",addr);
+	assert(h->magic == GUARD_MAGIC || h->magic == LARGE_MAGIC);
 
 #if DEBUG_ALLOC_N_FREE
 	if(DEBUG_ALLOC_N_FREE_PID == -1 || getpid() == DEBUG_ALLOC_N_FREE_PID) {
 		size_t i = 0;
 		uintptr_t *trace = getStackTrace();
-		debugf("[F] %x %d ",addr,area->size);
+		debugf("[F] %x %d ",addr,h->magic == LARGE_MAGIC ? h->info : classSize(h->info));
 		while(*trace && i++ < 10) {
 			debugf("%x",*trace);
 			if(trace[1])
@@ -239,203 +502,104 @@ void free(void *addr) {
 	}
 #endif
 
-	/* see what we have to merge */
-	if(prev && next) {
-		/* merge prev & area & next */
-		area->size += prev->size + next->size;
-		area->address = prev->address;
-		/* remove prev and next from the list */
-		if(nprev)
-			nprev->next = next->next;
-		else
-			usableList = next->next;
-		/* special-case if next is the previous of prev */
-		if(pprev == next) {
-			if(nprev)
-				nprev->next = prev->next;
-			else
-				usableList = prev->next;
-		}
-		else {
-			if(pprev)
-				pprev->next = prev->next;
-			else
-				usableList = prev->next;
-		}
-		/* put area on the usable-list */
-		area->next = usableList;
-		usableList = area;
-		/* put prev and next on the freelist */
-		prev->next = next;
-		next->next = freeList;
-		freeList = prev;
-	}
-	else if(prev) {
-		/* merge preg & area */
-		prev->size += area->size;
-		/* put area on the freelist */
-		area->next = freeList;
-		freeList = area;
+	if(EXPECT_FALSE(h->magic == LARGE_MAGIC)) {
+		freeLarge(h);
+		return;
 	}
-	else if(next) {
-		/* merge area & next */
-		next->address = area->address;
-		next->size += area->size;
-		/* put area on the freelist */
-		area->next = freeList;
-		freeList = area;
+
+	size_t cls = h->info;
+	assert(cls < CLASS_COUNT);
+	/* mark as free */
+	h->magic = FREE_MAGIC;
+
+	sFreeObj *obj = (sFreeObj*)h;
+	sThreadCache *cache = getCache();
+	if(EXPECT_TRUE(cache)) {
+		sCacheBin *bin = cache->bins + cls;
+		*objLink(obj) = bin->list;
+		bin->list = obj;
+		bin->count++;
+		cache->used -= classSize(cls);
+		cache->frees++;
+		/* give half of the objects back, if the bin got too large */
+		if(EXPECT_FALSE(bin->count >= batchSize(cls) * 2))
+			flushBin(cache,cls,batchSize(cls));
 	}
 	else {
-		/* insert area in usableList */
-		area->next = usableList;
-		usableList = area;
+		centralRelease(cls,obj,obj,1);
+		atomic_add(&globalUsed,-(long)classSize(cls));
+		atomic_add(&globalFrees,1);
 	}
-
-	usemup(&heapSem);
 }
 
 void *realloc(void *addr,size_t size) {
-	ulong *begin;
-	sMemArea *area,*a,*prev;
+	sHeader *h;
+	size_t avail;
+	void *a;
 	if(addr == NULL)
 		return malloc(size);
 
-	begin = (ulong*)addr - 3;
-	area = (sMemArea*)begin[0];
+	h = (sHeader*)addr - 1;
 	/* check guards */
-	vassert(begin[0] != FREE_MAGIC,"Duplicate free?");
-	assert(begin[2] == GUARD_MAGIC);
-	assert(begin[begin[1] / sizeof(ulong) + 3] == GUARD_MAGIC);
-
-	usemdown(&heapSem);
-
-	/* align and we need 3 ulongs for the guards */
-	size = ROUND_UP(size,sizeof(ulong)) + sizeof(ulong) * 4;
-
-	/* ignore shrinks */
-	if(size < area->size) {
-		usemup(&heapSem);
+	vassert(h->magic != FREE_MAGIC,"Duplicate free?");
+	assert(h->magic == GUARD_MAGIC || h->magic == LARGE_MAGIC);
+
+	/* is there still enough space in the area? this ignores shrinks as well */
+	if(h->magic == LARGE_MAGIC)
+		avail = h->info - HEADER_SIZE;
+	else
+		avail = classSize(h->info) - HEADER_SIZE;
+	if(size <= avail)
 		return addr;
-	}
 
-	a = usableList;
-	prev = NULL;
-	while(a != NULL) {
-		/* found the area behind? */
-		if((uintptr_t)a->address == (uintptr_t)area->address + area->size) {
-			/* if the size of both is big enough we can use them */
-			if(area->size + a->size >= size) {
-				/* space left? */
-				if(size < area->size + a->size) {
-					/* so move the area forward */
-					a->address = (void*)((uintptr_t)area->address + size);
-					a->size = (area->size + a->size) - size;
-				}
-				/* otherwise we don't need a anymore */
-				else {
-					/* remove a from usable-list */
-					if(prev == NULL)
-						usableList = a->next;
-					else
-						prev->next = a->next;
-					/* free a */
-					a->next = freeList;
-					freeList = a;
-				}
-
-				area->size = size;
-				/* reset guards */
-				begin[0] = (ulong)area;
-				begin[1] = size - sizeof(ulong) * 4;
-				begin[2] = GUARD_MAGIC;
-				begin[size / sizeof(ulong) - 1] = GUARD_MAGIC;
-				usemup(&heapSem);
-				return begin + 3;
-			}
-
-			/* makes no sense to continue since we've found the area behind */
-			break;
-		}
-		prev = a;
-		a = a->next;
-	}
-
-	usemup(&heapSem);
-
-	/* the areas are not big enough, so allocate a new one */
+	/* the area is not big enough, so allocate a new one */
 	a = malloc(size);
 	if(a == NULL)
 		return NULL;
 
 	/* copy the old data and free it */
-	memcpy(a,addr,area->size - sizeof(ulong) * 4);
+	memcpy(a,addr,avail);
 	free(addr);
 	return a;
 }
 
-static bool loadNewSpace(size_t size) {
+static bool loadNewSpan(size_t cls) {
 	void *oldEnd;
-	size_t count;
-	sMemArea *area;
+	size_t size,count,objSize,objs;
+	sSizeClass *c = classes + cls;
+	uintptr_t obj;
 
-	/* no free areas? */
-	if(freeList == NULL) {
-		if(!loadNewAreas())
-			return false;
-	}
-
-	/* check for overflow */
-	if(size + PAGE_SIZE < PAGE_SIZE)
-		return false;
+	/* determine the size of the span */
+	objSize = classSize(cls);
+	size = MAX(SPAN_MIN_PAGES * PAGE_SIZE,ROUND_UP(objSize * SPAN_MIN_OBJS,PAGE_SIZE));
+	count = size / PAGE_SIZE;
 
 	/* allocate the required pages */
-	count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	usemdown(&heapSem);
 	oldEnd = chgsize(count);
-	if(oldEnd == NULL)
+	if(oldEnd == NULL) {
+		usemup(&heapSem);
 		return false;
+	}
 
 	if(pageCount == 0)
 		heapstart = (uintptr_t)oldEnd;
-
 	pageCount += count;
-	/* take one area from the freelist and put the memory in it */
-	area = freeList;
-	freeList = freeList->next;
-	area->address = oldEnd;
-	area->size = PAGE_SIZE * count;
-	/* put area in the usable-list */
-	area->next = usableList;
-	usableList = area;
-	return true;
-}
-
-static bool loadNewAreas(void) {
-	sMemArea *area,*end;
-	void *oldEnd;
-
-	/* allocate one page for area-structs */
-	oldEnd = chgsize(1);
-	if(oldEnd == NULL)
-		return false;
-
-	if(pageCount == 0)
-		heapstart = (uintptr_t)oldEnd;
+	usemup(&heapSem);
 
-	/* determine start- and end-address */
-	pageCount++;
-	area = (sMemArea*)oldEnd;
-	end = area + (PAGE_SIZE / sizeof(sMemArea));
-
-	/* put all areas in the freelist */
-	freeList = area;
-	area->next = NULL;
-	area++;
-	while(area < end) {
-		area->next = freeList;
-		freeList = area;
-		area++;
+	/* put all objects into the central list */
+	objs = size / objSize;
+	obj = (uintptr_t)oldEnd + (objs - 1) * objSize;
+	for(size_t i = 0; i < objs; ++i) {
+		sFreeObj *o = (sFreeObj*)obj;
+		objHeader(o)->info = cls;
+		objHeader(o)->magic = FREE_MAGIC;
+		*objLink(o) = c->list;
+		c->list = o;
+		obj -= objSize;
 	}
-
+	c->count += objs;
+	c->spans++;
 	return true;
 }
 
@@ -443,37 +607,57 @@ bool isOnHeap(const void *ptr) {
 	return (uintptr_t)ptr >= heapstart && (uintptr_t)ptr < heapstart + pageCount * PAGE_SIZE;
 }
 
-size_t heapspace(void) {
-	sMemArea *area;
-	size_t c = 0;
-	area = usableList;
-	while(area != NULL) {
-		c += area->size;
-		area = area->next;
+void heapstats(sHeapStats *stats) {
+	long used;
+
+	/* the values of the thread-caches might change meanwhile, but that's fine for statistics */
+	usemdown(&heapSem);
+	used = globalUsed;
+	stats->mallocs = globalMallocs;
+	stats->frees = globalFrees;
+	stats->cacheRefills = globalRefills;
+	stats->cacheFlushes = globalFlushes;
+	for(sThreadCache *c = caches; c != NULL; c = c->next) {
+		used += c->used;
+		stats->mallocs += c->mallocs;
+		stats->frees += c->frees;
+		stats->cacheRefills += c->refills;
+		stats->cacheFlushes += c->flushes;
 	}
-	return c;
+	stats->heapPages = pageCount;
+	usemup(&heapSem);
+
+	stats->usedBytes = used;
+	stats->largeBytes = largeBytes;
+	stats->largeCount = largeCount;
+	stats->spans = 0;
+	for(size_t i = 0; i < CLASS_COUNT; ++i)
+		stats->spans += classes[i].spans;
+}
+
+size_t heapspace(void) {
+	sHeapStats stats;
+	heapstats(&stats);
+	return stats.heapPages * PAGE_SIZE - stats.usedBytes;
 }
 
 /* #### TEST/DEBUG FUNCTIONS #### */
 #if DEBUGGING
 
 void printheap(void) {
-	sMemArea *area;
-
-	printf("PageCount=%d\n",pageCount);
-	printf("UsableList:\n");
-	area = usableList;
-	while(area != NULL) {
-		printf("\t%p: addr=%p, size=0x%x, next=%p\n",area,area->address,area->size,area->next);
-		area = area->next;
+	sHeapStats stats;
+	heapstats(&stats);
+
+	printf("PageCount=%zu, used=%zu, large=%zu (%zu bytes)\n",
+		stats.heapPages,stats.usedBytes,stats.largeCount,stats.largeBytes);
+	printf("mallocs=%zu, frees=%zu, refills=%zu, flushes=%zu\n",
+		stats.mallocs,stats.frees,stats.cacheRefills,stats.cacheFlushes);
+	printf("Classes:\n");
+	for(size_t i = 0; i < CLASS_COUNT; ++i) {
+		if(classes[i].spans == 0)
+			continue;
+		printf("\t%5zu: spans=%zu, free=%zu\n",classSize(i),classes[i].spans,classes[i].count);
 	}
-
-	/*printf("FreeList:\n");
-	area = freeList;
-	while(area != NULL) {
-		printf("\t0x%x: addr=0x%x, size=0x%x, next=0x%x\n",area,area->address,area->size,area->next);
-		area = area->next;
-	}*/
 }
 
 #endif
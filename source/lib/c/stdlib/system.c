@@ -22,6 +22,7 @@
 #include <sys/proc.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <spawn.h>
 #include <stdlib.h>
 
 int system(const char *cmd) {
@@ -37,17 +38,10 @@ int system(const char *cmd) {
 		return EXIT_FAILURE;
 	}
 
-	child = fork();
-	if(child == 0) {
-		const char *args[] = {"/bin/shell","-e",NULL,NULL};
-		args[2] = cmd;
-		execv(args[0],args);
-
-		/* if we're here there is something wrong */
-		error("Exec of '%s' failed",args[0]);
-	}
-	else if(child < 0)
-		error("Fork failed");
+	const char *args[] = {"/bin/shell","-e",NULL,NULL};
+	args[2] = cmd;
+	if(posix_spawn(NULL,args[0],NULL,NULL,(char**)args,NULL) < 0)
+		error("Spawn of '%s' failed",args[0]);
 
 	/* wait and return exit-code */
 	if((child = waitchild(&state,-1,0)) < 0)
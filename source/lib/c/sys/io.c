@@ -114,6 +114,12 @@ ssize_t readlink(const char *path,char *buf,size_t size) {
 	return fd;
 }
 
+int waitpath(const char *path,time_t msecs) {
+	char tmp[MAX_PATH_LEN];
+	char *apath = abspath(tmp,sizeof(tmp),path);
+	return syscall2(SYSCALL_WAITPATH,(ulong)apath,msecs);
+}
+
 int truncate(const char *path,off_t length) {
 	int fd = open(path,O_WRONLY);
 	if(fd < 0)
@@ -251,7 +257,10 @@ int fsymlink(const char *target,int fd,const char *name) {
 }
 
 int pipe(int *readFd,int *writeFd) {
-	int fd = open("/dev/pipe",O_WRONLY);
+	/* with O_MSGS, both ends can use the shared ring buffer (see sys/pipe.h) */
+	int fd = open("/dev/pipe",O_WRONLY | O_MSGS);
+	if(fd == -EACCES)
+		fd = open("/dev/pipe",O_WRONLY);
 	if(fd < 0)
 		return fd;
 	*writeFd = fd;
@@ -0,0 +1,148 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/messages.h>
+#include <sys/mman.h>
+#include <sys/pipe.h>
+#include <errno.h>
+#include <stdlib.h>
+
+bool ispipe(int fd) {
+	errcode_t res = -ENOTSUP;
+	msgid_t mid = MSG_PIPE_ISPIPE;
+	if(sendrecv(fd,&mid,&res,sizeof(res)) < 0)
+		return false;
+	return res == 0;
+}
+
+tPipeEnd *pipemap(int fd) {
+	tPipeEnd *end = (tPipeEnd*)malloc(sizeof(tPipeEnd));
+	if(!end)
+		return NULL;
+
+	end->fd = fd;
+	end->waitmid = 0;
+	end->shmfd = obtain(fd,OBT_ARG_PIPERING);
+	if(end->shmfd < 0)
+		goto errorEnd;
+
+	size_t size = PIPE_RING_DATA + PIPE_RING_SIZE;
+	end->ring = (tPipeRing*)mmap(NULL,size,size,PROT_READ | PROT_WRITE,MAP_SHARED,end->shmfd,0);
+	if(!end->ring)
+		goto errorFile;
+	return end;
+
+errorFile:
+	close(end->shmfd);
+errorEnd:
+	free(end);
+	return NULL;
+}
+
+tPipeEnd *pipemapexcl(int fd) {
+	/* if somebody else can use the end at the same time, there might be two producers or two
+	 * consumers. check the cheap conditions first to avoid the message for other files */
+	if(fcntl(fd,F_GETREFS,0) != 1 || (fcntl(fd,F_GETACCESS,0) & O_MSGS) == 0)
+		return NULL;
+	if(!ispipe(fd))
+		return NULL;
+	return pipemap(fd);
+}
+
+static int pipewait(tPipeEnd *end) {
+	errcode_t res = 0;
+	ssize_t err;
+	msgid_t mid = end->waitmid;
+	/* if we have been interrupted last time, the response to that wait is still pending */
+	if(mid)
+		err = receive(end->fd,&mid,&res,sizeof(res));
+	else {
+		mid = MSG_PIPE_WAIT;
+		err = sendrecv(end->fd,&mid,&res,sizeof(res));
+	}
+	if(err == -EINTR) {
+		end->waitmid = mid;
+		return err;
+	}
+	end->waitmid = 0;
+	return err < 0 ? err : res;
+}
+
+static void pipewake(tPipeEnd *end) {
+	/* there is no response; if it fails, the driver is gone and nobody waits anyway */
+	if(send(end->fd,MSG_PIPE_WAKE,NULL,0) < 0) {}
+}
+
+ssize_t piperead(tPipeEnd *end,void *buffer,size_t count) {
+	tPipeRing *r = end->ring;
+	size_t avail;
+	while((avail = pipering_used(r)) == 0) {
+		if(r->closed & PIPE_WRCLOSED) {
+			/* the writer might have written something before it was closed */
+			__sync_synchronize();
+			if(pipering_used(r) == 0)
+				return 0;
+			continue;
+		}
+
+		int res = pipewait(end);
+		if(res < 0)
+			return res;
+	}
+
+	size_t amount = MIN(avail,count);
+	pipering_get(r,buffer,amount);
+	if(pipering_takewait(&r->wrwait))
+		pipewake(end);
+	return amount;
+}
+
+ssize_t pipewrite(tPipeEnd *end,const void *buffer,size_t count) {
+	tPipeRing *r = end->ring;
+	const char *src = (const char*)buffer;
+	size_t rem = count;
+	while(rem > 0) {
+		if(r->closed & PIPE_RDCLOSED)
+			return -EDESTROYED;
+
+		size_t space = pipering_free(r);
+		if(space == 0) {
+			int res = pipewait(end);
+			if(res < 0)
+				return rem < count ? (ssize_t)(count - rem) : res;
+			continue;
+		}
+
+		size_t amount = MIN(space,rem);
+		pipering_put(r,src,amount);
+		src += amount;
+		rem -= amount;
+		if(pipering_takewait(&r->rdwait))
+			pipewake(end);
+	}
+	return count;
+}
+
+void pipeunmap(tPipeEnd *end) {
+	munmap(end->ring);
+	close(end->shmfd);
+	free(end);
+}
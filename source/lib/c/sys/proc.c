@@ -25,6 +25,17 @@
 #include <stdlib.h>
 #include <string.h>
 
+extern void heapPreFork(void);
+extern void heapPostFork(bool child);
+
+int fork(void) {
+	/* let the heap prepare itself; the other threads don't exist in the child */
+	heapPreFork();
+	int res = syscall0(SYSCALL_FORK);
+	heapPostFork(res == 0);
+	return res;
+}
+
 int execv(const char *path,const char **args) {
 	return execvpe(path,args,(const char**)environ);
 }
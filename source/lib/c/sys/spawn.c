@@ -0,0 +1,207 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/proc.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+
+static sSpawnAction *addAction(posix_spawn_file_actions_t *fa,int type,int fd);
+static bool isTarget(int fd,const sSpawnFd *fds,size_t count);
+static int moveExec(int fd,const sSpawnFd *fds,size_t count);
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa) {
+	fa->count = 0;
+	return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa) {
+	for(size_t i = 0; i < fa->count; ++i) {
+		if(fa->actions[i].type == SPAWN_OPEN)
+			free(fa->actions[i].path);
+	}
+	fa->count = 0;
+	return 0;
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa,int fd) {
+	if(fd < 0)
+		return -EBADF;
+	if(!addAction(fa,SPAWN_CLOSE,fd))
+		return -ENOMEM;
+	return 0;
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,int fd,int newfd) {
+	if(fd < 0 || newfd < 0)
+		return -EBADF;
+	sSpawnAction *a = addAction(fa,SPAWN_DUP2,newfd);
+	if(!a)
+		return -ENOMEM;
+	a->src = fd;
+	return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa,int fd,const char *path,
+		int oflag,mode_t mode) {
+	if(fd < 0)
+		return -EBADF;
+	sSpawnAction *a = addAction(fa,SPAWN_OPEN,fd);
+	if(!a)
+		return -ENOMEM;
+	a->path = strdup(path);
+	if(!a->path) {
+		fa->count--;
+		return -ENOMEM;
+	}
+	a->oflag = oflag;
+	a->mode = mode;
+	return 0;
+}
+
+int posix_spawnattr_init(posix_spawnattr_t *attr) {
+	attr->flags = 0;
+	return 0;
+}
+
+int posix_spawnattr_destroy(A_UNUSED posix_spawnattr_t *attr) {
+	return 0;
+}
+
+int posix_spawn(pid_t *pid,const char *path,const posix_spawn_file_actions_t *fa,
+		const posix_spawnattr_t *attr,char *const argv[],char *const envp[]) {
+	sSpawnFd fds[MAX_SPAWN_FDS + 1];
+	int tmpfds[SPAWN_MAX_ACTIONS];
+	size_t count = 0,tmpcount = 0;
+	char apath[MAX_PATH_LEN];
+	int res;
+
+	if(attr && attr->flags)
+		return -ENOTSUP;
+
+	int fd = open(abspath(apath,sizeof(apath),path),O_EXEC | O_READ);
+	if(fd < 0)
+		return fd;
+
+	/* translate the actions. files are opened here and moved to their place by the child */
+	for(size_t i = 0; fa && i < fa->count; ++i) {
+		const sSpawnAction *a = fa->actions + i;
+		switch(a->type) {
+			case SPAWN_CLOSE:
+				fds[count].src = -1;
+				fds[count++].fd = a->fd;
+				break;
+
+			case SPAWN_DUP2:
+				fds[count].src = a->src;
+				fds[count++].fd = a->fd;
+				break;
+
+			case SPAWN_OPEN:
+				res = open(a->path,a->oflag,a->mode);
+				if(res < 0)
+					goto error;
+				tmpfds[tmpcount++] = res;
+				if(res != a->fd) {
+					fds[count].src = res;
+					fds[count++].fd = a->fd;
+					fds[count].src = -1;
+					fds[count++].fd = res;
+				}
+				break;
+		}
+	}
+	fds[count].fd = -1;
+
+	/* the child is not allowed to touch the file descriptor of the executable */
+	res = fd = moveExec(fd,fds,count);
+	if(fd < 0)
+		goto error;
+
+	res = fspawn(fd,fds,(const char**)argv,envp ? (const char**)envp : (const char**)environ);
+	if(res >= 0) {
+		if(pid)
+			*pid = res;
+		res = 0;
+	}
+
+error:
+	while(tmpcount > 0)
+		close(tmpfds[--tmpcount]);
+	if(fd >= 0)
+		close(fd);
+	return res;
+}
+
+int posix_spawnp(pid_t *pid,const char *file,const posix_spawn_file_actions_t *fa,
+		const posix_spawnattr_t *attr,char *const argv[],char *const envp[]) {
+	char path[MAX_PATH_LEN];
+	size_t len,flen;
+
+	/* if there is a slash in file, use the default spawn */
+	if(strchr(file,'/') != NULL || getenvto(path,sizeof(path),"PATH") < 0)
+		return posix_spawn(pid,file,fa,attr,argv,envp);
+
+	/* append file */
+	len = strlen(path);
+	if(len < MAX_PATH_LEN - 1 && path[len - 1] != '/') {
+		path[len++] = '/';
+		path[len] = '\0';
+	}
+	flen = strlen(file);
+	if(len + flen >= MAX_PATH_LEN)
+		return -ENAMETOOLONG;
+	strcpy(path + len,file);
+	return posix_spawn(pid,path,fa,attr,argv,envp);
+}
+
+static sSpawnAction *addAction(posix_spawn_file_actions_t *fa,int type,int fd) {
+	if(fa->count == SPAWN_MAX_ACTIONS)
+		return NULL;
+	sSpawnAction *a = fa->actions + fa->count++;
+	a->type = type;
+	a->fd = fd;
+	return a;
+}
+
+static bool isTarget(int fd,const sSpawnFd *fds,size_t count) {
+	for(size_t i = 0; i < count; ++i) {
+		if(fds[i].fd == fd)
+			return true;
+	}
+	return false;
+}
+
+static int moveExec(int fd,const sSpawnFd *fds,size_t count) {
+	/* keep the old ones open until we're done to get a different fd each time */
+	int old[MAX_SPAWN_FDS + 1];
+	size_t n = 0;
+	while(fd >= 0 && isTarget(fd,fds,count)) {
+		old[n++] = fd;
+		fd = dup(fd);
+	}
+	while(n > 0)
+		close(old[--n]);
+	return fd;
+}
@@ -20,13 +20,21 @@
 #include <sys/common.h>
 #include <sys/stat.h>
 #include <sys/io.h>
+#include <dirent.h>
 
 static int doStat(const char *path,struct stat *info,uint flags) {
-	int fd = open(path,flags);
-	if(fd < 0)
-		return fd;
-	int res = fstat(fd,info);
-	close(fd);
+	char buf[MAX_PATH_LEN];
+	char *apath = abspath(buf,sizeof(buf),path);
+	ssize_t pos = -1;
+	int res = syscall4(SYSCALL_STAT,(ulong)apath,flags & O_NOFOLLOW,(ulong)info,(ulong)&pos);
+	/* let open() resolve the symlink or do the work if the filesystem can't stat by path */
+	if(pos != -1 || res == -ENOTSUP) {
+		int fd = open(apath,flags);
+		if(fd < 0)
+			return fd;
+		res = fstat(fd,info);
+		close(fd);
+	}
 	errno = res;
 	return res;
 }
@@ -128,6 +128,14 @@ const struct Syscall syscalls[] = {
 	{"utime",			"%d,%p"						},
 	{"truncate",		"%d,%u"						},
 	{"symlink",			"%s,%d,%s"					},
+	{"waitpath",		"%s,%u"						},
+	{"spawn",			"%d,%p,%p,%p"				},
+	{"virt2phys",		"%p,%x,%p"					},
+	{"stat",			"%s,%x,%p,%p"				},
+
+	/* 80 */
+	{"readdirplus",		"%d,%p,%x"					},
+	{"copyrange",		"%d,%d,%p,%x"				},
 #if defined(__x86__)
 	{"reqports",   		"%d,%d"						},
 	{"relports",    	"%d,%d"						},
@@ -170,6 +178,9 @@ static const char *fsMsgs[] = {
 	"FS_UTIME",
 	"FS_TRUNCATE",
 	"FS_SYMLINK",
+	"FS_STAT",
+	"FS_READDIRPLUS",
+	"FS_COPYRANGE",
 };
 
 static const char *spkMsgs[] = {
@@ -274,6 +285,12 @@ static const char *dnsMsgs[] = {
 	"DNS_SET_SERVER",
 };
 
+static const char *pipeMsgs[] = {
+	"PIPE_ISPIPE",
+	"PIPE_WAIT",
+	"PIPE_WAKE",
+};
+
 static const struct Messages msgs[] = {
 	{fileMsgs,	50,		ARRAY_SIZE(fileMsgs)},
 	{fsMsgs,	100,	ARRAY_SIZE(fsMsgs)},
@@ -290,6 +307,7 @@ static const struct Messages msgs[] = {
 	{netMsgs,	1200,	ARRAY_SIZE(netMsgs)},
 	{sockMsgs,	1300,	ARRAY_SIZE(sockMsgs)},
 	{dnsMsgs,	1400,	ARRAY_SIZE(dnsMsgs)},
+	{pipeMsgs,	1600,	ARRAY_SIZE(pipeMsgs)},
 };
 
 struct Flag {
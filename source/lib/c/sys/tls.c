@@ -31,11 +31,13 @@ long __tls_num = 0;
 void initTLS(void);
 
 void initTLS(void) {
+	/* the heap looks for its thread-cache in the TLS struct; there is none yet */
+	ulong **ptr = (ulong**)stack_top(2);
+	*ptr = NULL;
+
 	ulong *tls = calloc(MAX_TLS_ENTRIES,sizeof(ulong));
 	if(!tls)
 		error("Not enough memory for TLS struct");
-
-	ulong **ptr = (ulong**)stack_top(2);
 	*ptr = tls;
 }
 
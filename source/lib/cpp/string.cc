@@ -29,42 +29,42 @@
 namespace std {
 	// === constructors ===
 	string::string(const string& str,size_type pos,size_type n)
-		: _str(), _size(0), _length(0) {
+		: _str(_buf), _size(SSO_SIZE), _length(0) {
+		_buf[0] = '\0';
 		if(n == npos)
 			n = str._length - pos;
 		assign(str,pos,n);
 	}
 	string::string(const char* s,size_type n)
-		: _str(new char[n + 1]), _size(n + 1), _length(n) {
-		memcpy(_str,s,n);
-		_str[n] = '\0';
+		: _str(_buf), _size(SSO_SIZE), _length(0) {
+		init(s,n);
 	}
 	string::string(const char* s)
-		: _str(nullptr), _size(0), _length(0) {
-		size_type len = strlen(s);
-		if(len) {
-			_str = new char[len + 1];
-			_size = len + 1;
-			_length = len;
-			memcpy(_str,s,len * sizeof(char));
-			_str[len] = '\0';
-		}
+		: _str(_buf), _size(SSO_SIZE), _length(0) {
+		init(s,strlen(s));
 	}
 	string::string(size_type n,char c)
-		: _str(new char[n + 1]), _size(n + 1), _length(n) {
+		: _str(_buf), _size(SSO_SIZE), _length(0) {
+		init(nullptr,n);
+		memset(_str,c,n);
+	}
+
+	void string::init(const char *s,size_type n) {
+		if(n + 1 > SSO_SIZE) {
+			_str = new char[n + 1];
+			_size = n + 1;
+		}
+		if(s)
+			memcpy(_str,s,n * sizeof(char));
+		_length = n;
 		_str[n] = '\0';
-		for(; n > 0; n--)
-			_str[n - 1] = c;
 	}
 
 	// === operator=() ===
 	string& string::operator=(char c) {
-		delete[] _str;
-		_length = 1;
-		_size = 2;
-		_str = new char[2];
 		_str[0] = c;
 		_str[1] = '\0';
+		_length = 1;
 		return *this;
 	}
 
@@ -80,12 +80,11 @@ namespace std {
 	void string::reserve(size_type n) {
 		if(n + 1 > _size) {
 			// reserve at least the double of the current size to prevent reallocations
-			n = max((_size == 0 ? INIT_SIZE : _size) * 2,n + 1);
+			n = max(_size * 2,n + 1);
 			char *tmp = new char[n];
-			if(_size > 0)
-				memcpy(tmp,_str,_size * sizeof(char));
-			memclear(tmp + _size,n - _size);
-			delete[] _str;
+			memcpy(tmp,_str,(_length + 1) * sizeof(char));
+			if(_str != _buf)
+				delete[] _str;
 			_str = tmp;
 			_size = n;
 		}
@@ -93,10 +92,9 @@ namespace std {
 
 	// === clear() and empty() ===
 	void string::clear() {
-		delete[] _str;
-		_str = nullptr;
-		_size = 0;
+		// keep the memory to reuse it for the next content
 		_length = 0;
+		_str[0] = '\0';
 	}
 
 	// === at() ===
@@ -113,6 +111,8 @@ namespace std {
 
 	// === assign() ===
 	string& string::assign(const string& str) {
+		if(&str == this)
+			return *this;
 		clear();
 		return append(str);
 	}
@@ -202,15 +202,22 @@ namespace std {
 		return n;
 	}
 	void string::swap(string& str) {
-		std::swap(_str,str._str);
-		std::swap(_length,str._length);
-		std::swap(_size,str._size);
+		if(_str != _buf && str._str != str._buf) {
+			std::swap(_str,str._str);
+			std::swap(_length,str._length);
+			std::swap(_size,str._size);
+		}
+		else {
+			string tmp(std::move(str));
+			str.steal(*this);
+			steal(tmp);
+		}
 	}
 
 	// === find() ===
 	string::size_type string::find(const char* s,size_type pos,size_type n) const {
 		// handle special case to prevent looping the string
-		if(n == 0 || s == nullptr || _str == nullptr)
+		if(n == 0 || s == nullptr)
 			return npos;
 		char *str1 = _str + pos;
 		for(size_type i = pos; *str1; i++) {
@@ -223,7 +230,7 @@ namespace std {
 	// === rfind() ===
 	string::size_type string::rfind(const char* s,size_type pos,size_type n) const {
 		// handle special case to prevent looping the string
-		if(n == 0 || s == nullptr || _str == nullptr || pos < (n - 1))
+		if(n == 0 || s == nullptr || pos < (n - 1))
 			return npos;
 		if(pos == npos)
 			pos = _length - 1;
@@ -239,7 +246,7 @@ namespace std {
 
 	// === find_first_of() ===
 	string::size_type string::find_first_of(const char* s,size_type pos,size_type n) const {
-		if(n == 0 || s == nullptr || _str == nullptr)
+		if(n == 0 || s == nullptr)
 			return npos;
 		for(size_type i = pos; i < _length; i++) {
 			for(size_type j = 0; j < n; j++) {
@@ -252,7 +259,7 @@ namespace std {
 
 	// === find_last_of() ===
 	string::size_type string::find_last_of(const char* s,size_type pos,size_type n) const {
-		if(n == 0 || s == nullptr || _str == nullptr)
+		if(n == 0 || s == nullptr)
 			return npos;
 		if(pos == npos)
 			pos = _length - 1;
@@ -17,32 +17,41 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <esc/ipc/ipcstream.h>
 #include <esc/proto/socket.h>
 #include <esc/stream/fstream.h>
 #include <esc/stream/istringstream.h>
 #include <esc/stream/ostream.h>
 #include <esc/dns.h>
+#include <esc/util.h>
 #include <sys/common.h>
 #include <sys/endian.h>
 #include <sys/proc.h>
 #include <sys/thread.h>
+#include <sys/time.h>
+#include <ctype.h>
 #include <signal.h>
 
 namespace esc {
 
 /* based on http://tools.ietf.org/html/rfc1035 */
 
+#define DNS_RESPONSE			0x8000
 #define DNS_RECURSION_DESIRED	0x100
+#define DNS_RCODE_MASK			0xF
+#define DNS_RCODE_NXDOMAIN		3
 #define DNS_PORT				53
-#define BUF_SIZE				512
+/* the number of seconds to cache negative answers without SOA record */
+#define DNS_NEG_TTL				60
 
-uint16_t DNS::_nextId = 0;
+uint64_t DNS::_rand = 0;
 esc::Net::IPv4Addr DNS::_nameserver;
 
 enum Type {
 	TYPE_A		= 1,	/* a host address */
 	TYPE_NS		= 2,	/* an authoritative name server */
 	TYPE_CNAME	= 5,	/* the canonical name for an alias */
+	TYPE_SOA	= 6,	/* the start of a zone of authority */
 	TYPE_HINFO	= 13,	/* host information */
 	TYPE_MX		= 15,	/* mail exchange */
 };
@@ -65,8 +74,8 @@ struct DNSQuestionEnd {
 	uint16_t cls;
 } A_PACKED;
 
+/* a resource record, following its name */
 struct DNSAnswer {
-	uint16_t name;
 	uint16_t type;
 	uint16_t cls;
 	uint32_t ttl;
@@ -74,16 +83,34 @@ struct DNSAnswer {
 } A_PACKED;
 
 esc::Net::IPv4Addr DNS::getHost(const char *name,uint timeout) {
+	esc::Net::IPv4Addr addr;
 	if(isIPAddress(name)) {
-		esc::Net::IPv4Addr addr;
 		IStringStream is(name);
 		is >> addr;
 		return addr;
 	}
 
+	if(resolveViaService(name,timeout,&addr))
+		return addr;
 	return resolve(name,timeout);
 }
 
+bool DNS::resolveViaService(const char *name,uint timeout,esc::Net::IPv4Addr *addr) {
+	int fd = open(getServiceDev(),O_MSGS);
+	if(fd < 0)
+		return false;
+
+	errcode_t res;
+	{
+		IPCStream is(fd);
+		is << timeout << CString(name) << SendReceive(MSG_DNS_RESOLVE) >> res >> *addr;
+	}
+	close(fd);
+	if(res < 0)
+		VTHROWE("Unable to resolve '" << name << "'",res);
+	return true;
+}
+
 bool DNS::isIPAddress(const char *name) {
 	int dots = 0;
 	int len = 0;
@@ -109,37 +136,22 @@ bool DNS::isIPAddress(const char *name) {
 	return dots == 3 && len > 0 && len < 4;
 }
 
-esc::Net::IPv4Addr DNS::resolve(const char *name,uint timeout) {
-	uint8_t buffer[BUF_SIZE];
-	if(_nameserver.value() == 0) {
-		FStream in(getResolveFile(),"r");
-		in >> _nameserver;
-		if(_nameserver.value() == 0)
-			VTHROWE("No nameserver",-EHOSTNOTFOUND);
-	}
-
-	size_t nameLen = strlen(name);
-	size_t total = sizeof(DNSHeader) + nameLen + 2 + sizeof(DNSQuestionEnd);
-	if(total > sizeof(buffer))
-		VTHROWE("Hostname too long",-EINVAL);
-
-	// generate a unique
-	uint16_t txid = (getpid() << 16) | _nextId;
-
-	// build DNS request message
-	DNSHeader *h = reinterpret_cast<DNSHeader*>(buffer);
-	h->id = cputobe16(txid);
-	h->flags = cputobe16(DNS_RECURSION_DESIRED);
-	h->qdCount = cputobe16(1);
-	h->anCount = 0;
-	h->nsCount = 0;
-	h->arCount = 0;
+esc::Net::IPv4Addr DNS::getNameserver() {
+	esc::Net::IPv4Addr ns;
+	FStream in(getResolveFile(),"r");
+	in >> ns;
+	if(ns.value() == 0)
+		VTHROWE("No nameserver",-EHOSTNOTFOUND);
+	return ns;
+}
 
-	convertHostname(reinterpret_cast<char*>(h + 1),name,nameLen);
+esc::Net::IPv4Addr DNS::resolve(const char *name,uint timeout) {
+	uint8_t buffer[MAX_MSG_SIZE];
+	if(_nameserver.value() == 0)
+		_nameserver = getNameserver();
 
-	DNSQuestionEnd *qend = reinterpret_cast<DNSQuestionEnd*>(buffer + sizeof(*h) + nameLen + 2);
-	qend->type = cputobe16(TYPE_A);
-	qend->cls = cputobe16(CLASS_IN);
+	uint16_t txid = genTxId();
+	size_t total = buildQuery(buffer,txid,name);
 
 	// create socket
 	esc::Socket sock(esc::Socket::SOCK_DGRAM,esc::Socket::PROTO_UDP);
@@ -158,9 +170,20 @@ esc::Net::IPv4Addr DNS::resolve(const char *name,uint timeout) {
 	if((res = ualarm(timeout * 1000)) < 0)
 		VTHROWE("ualarm(" << (timeout * 1000) << ")",res);
 
+	uint32_t ttl;
+	esc::Net::IPv4Addr ip;
 	try {
-		// receive response
-		sock.recvfrom(addr,buffer,sizeof(buffer));
+		// receive responses until we got the one for our query
+		do {
+			esc::Socket::Addr src;
+			size_t len = sock.recvfrom(src,buffer,sizeof(buffer));
+			if(src.family != esc::Socket::AF_INET || src.d.ipv4.addr != _nameserver.value() ||
+					src.d.ipv4.port != DNS_PORT)
+				res = -EINVAL;
+			else
+				res = parseResponse(buffer,len,txid,name,&ip,&ttl);
+		}
+		while(res == -EINVAL);
 	}
 	catch(const esc::default_error &e) {
 		if(e.error() == -EINTR)
@@ -174,27 +197,118 @@ esc::Net::IPv4Addr DNS::resolve(const char *name,uint timeout) {
 	// ignore errors here
 	if(signal(SIGALRM,oldhandler) == SIG_ERR) {}
 
-	if(be16tocpu(h->id) != txid)
-		VTHROWE("Received DNS response with wrong transaction id",-EHOSTNOTFOUND);
+	if(res < 0)
+		VTHROWE("Unable to find IP address in DNS response",res);
+	return ip;
+}
 
-	int questions = be16tocpu(h->qdCount);
-	int answers = be16tocpu(h->anCount);
+uint16_t DNS::genTxId() {
+	// xorshift, mixed with the TSC to make it unpredictable
+	_rand ^= rdtsc() ^ ((uint64_t)getpid() << 48);
+	_rand ^= _rand << 13;
+	_rand ^= _rand >> 7;
+	_rand ^= _rand << 17;
+	return _rand >> 32;
+}
 
-	// skip questions
-	uint8_t *data = reinterpret_cast<uint8_t*>(h + 1);
-	for(int i = 0; i < questions; ++i) {
-		size_t len = questionLength(data);
-		data += len + sizeof(DNSQuestionEnd);
-	}
+size_t DNS::buildQuery(uint8_t *buf,uint16_t txid,const char *name) {
+	size_t nameLen = strlen(name);
+	size_t total = sizeof(DNSHeader) + nameLen + 2 + sizeof(DNSQuestionEnd);
+	if(nameLen > MAX_NAME_LEN || total > MAX_MSG_SIZE)
+		VTHROWE("Hostname too long",-EINVAL);
+
+	// build DNS request message
+	DNSHeader *h = reinterpret_cast<DNSHeader*>(buf);
+	h->id = cputobe16(txid);
+	h->flags = cputobe16(DNS_RECURSION_DESIRED);
+	h->qdCount = cputobe16(1);
+	h->anCount = 0;
+	h->nsCount = 0;
+	h->arCount = 0;
+
+	convertHostname(reinterpret_cast<char*>(h + 1),name,nameLen);
+
+	DNSQuestionEnd *qend = reinterpret_cast<DNSQuestionEnd*>(buf + sizeof(*h) + nameLen + 2);
+	qend->type = cputobe16(TYPE_A);
+	qend->cls = cputobe16(CLASS_IN);
+	return total;
+}
+
+int DNS::getTxId(const uint8_t *buf,size_t len) {
+	if(len < sizeof(DNSHeader))
+		return -EINVAL;
+	return be16tocpu(reinterpret_cast<const DNSHeader*>(buf)->id);
+}
+
+int DNS::parseResponse(const uint8_t *buf,size_t len,uint16_t txid,const char *name,
+		esc::Net::IPv4Addr *addr,uint32_t *ttl) {
+	*ttl = 0;
+	if(len < sizeof(DNSHeader))
+		return -EINVAL;
+
+	// check whether it is the response to our query
+	const DNSHeader *h = reinterpret_cast<const DNSHeader*>(buf);
+	const uint8_t *end = buf + len;
+	uint16_t flags = be16tocpu(h->flags);
+	if(be16tocpu(h->id) != txid || !(flags & DNS_RESPONSE) || be16tocpu(h->qdCount) != 1)
+		return -EINVAL;
+
+	const uint8_t *data = matchName(reinterpret_cast<const uint8_t*>(h + 1),end,name);
+	if(!data || data + sizeof(DNSQuestionEnd) > end)
+		return -EINVAL;
+	const DNSQuestionEnd *qend = reinterpret_cast<const DNSQuestionEnd*>(data);
+	if(be16tocpu(qend->type) != TYPE_A || be16tocpu(qend->cls) != CLASS_IN)
+		return -EINVAL;
+	data += sizeof(DNSQuestionEnd);
+
+	uint16_t rcode = flags & DNS_RCODE_MASK;
+	if(rcode != 0 && rcode != DNS_RCODE_NXDOMAIN)
+		return -EHOSTNOTFOUND;
+
+	// parse answers and authority records. the TTL of the answer is the minimum of all records in
+	// the chain (e.g. CNAMEs) and the negative TTL is determined by the SOA record
+	int records = be16tocpu(h->anCount) + be16tocpu(h->nsCount);
+	int answers = rcode == 0 ? be16tocpu(h->anCount) : 0;
+	uint32_t minttl = 0xFFFFFFFF;
+	uint32_t negttl = DNS_NEG_TTL;
+	bool found = false;
+	int i;
+	for(i = 0; data && i < records; ++i) {
+		data = skipName(data,end);
+		if(!data || data + sizeof(DNSAnswer) > end)
+			break;
+
+		const DNSAnswer *ans = reinterpret_cast<const DNSAnswer*>(data);
+		const uint8_t *rdata = data + sizeof(DNSAnswer);
+		uint16_t rdlen = be16tocpu(ans->length);
+		uint32_t rttl = be32tocpu(ans->ttl);
+		if(rdata + rdlen > end)
+			break;
 
-	// parse answers
-	for(int i = 0; i < answers; ++i) {
-		DNSAnswer *ans = reinterpret_cast<DNSAnswer*>(data);
-		if(be16tocpu(ans->type) == TYPE_A && be16tocpu(ans->length) == esc::Net::IPv4Addr::LEN)
-			return esc::Net::IPv4Addr(data + sizeof(DNSAnswer));
+		uint16_t type = be16tocpu(ans->type);
+		if(i < answers) {
+			minttl = esc::Util::min(minttl,rttl);
+			if(type == TYPE_A && rdlen == esc::Net::IPv4Addr::LEN && !found) {
+				*addr = esc::Net::IPv4Addr(const_cast<uint8_t*>(rdata));
+				found = true;
+			}
+		}
+		else if(type == TYPE_SOA && rdlen >= sizeof(uint32_t)) {
+			uint32_t soamin;
+			memcpy(&soamin,rdata + rdlen - sizeof(uint32_t),sizeof(uint32_t));
+			negttl = esc::Util::min(rttl,be32tocpu(soamin));
+		}
+		data = rdata + rdlen;
 	}
 
-	VTHROWE("Unable to find IP address in DNS response",-EHOSTNOTFOUND);
+	if(found) {
+		*ttl = minttl;
+		return 0;
+	}
+	// don't cache malformed responses
+	if(i == records)
+		*ttl = negttl;
+	return -EHOSTNOTFOUND;
 }
 
 void DNS::convertHostname(char *dst,const char *src,size_t len) {
@@ -217,16 +331,35 @@ void DNS::convertHostname(char *dst,const char *src,size_t len) {
 	*to = partLen;
 }
 
-size_t DNS::questionLength(const uint8_t *data) {
-	size_t total = 0;
-	while(*data != 0) {
-		uint8_t len = *data;
+const uint8_t *DNS::skipName(const uint8_t *data,const uint8_t *end) {
+	while(data < end && *data != 0) {
+		// a pointer to a previous name ends the name
+		if((*data & 0xC0) == 0xC0)
+			return data + 2 <= end ? data + 2 : NULL;
 		// skip this name-part
-		total += len + 1;
-		data += len + 1;
+		data += *data + 1;
 	}
 	// skip zero ending, too
-	return total + 1;
+	return data < end ? data + 1 : NULL;
+}
+
+const uint8_t *DNS::matchName(const uint8_t *data,const uint8_t *end,const char *name) {
+	while(data < end && *data != 0) {
+		// we don't accept pointers in the question
+		size_t partLen = *data++;
+		if((partLen & 0xC0) || data + partLen > end)
+			return NULL;
+		for(size_t i = 0; i < partLen; ++i) {
+			if(!*name || tolower(data[i]) != tolower(*name++))
+				return NULL;
+		}
+		data += partLen;
+		if(*name == '.')
+			name++;
+		else if(*name)
+			return NULL;
+	}
+	return data < end && *name == '\0' ? data + 1 : NULL;
 }
 
 }
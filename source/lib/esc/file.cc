@@ -32,6 +32,9 @@ namespace esc {
 		: _info(), _parent(), _name() {
 		init(p,n,flags);
 	}
+	file::file(const std::string& p,const std::string& n,const struct stat &info)
+		: _info(info), _parent(p), _name(n) {
+	}
 	file::file(const file& f)
 		: _info(f._info), _parent(f._parent), _name(f._name) {
 	}
@@ -62,6 +65,59 @@ namespace esc {
 		return v;
 	}
 
+	std::vector<file> file::list_entries(bool showHidden,const std::string& pattern,
+			std::vector<std::pair<std::string,default_error>> *errors) const {
+		static const size_t BUF_SIZE = 16 * 1024;
+		std::vector<file> v;
+		if(!is_dir())
+			throw default_error("list_entries failed: No directory",0);
+
+		std::string dir = _name.empty() ? _parent : path();
+		int fd = open(dir.c_str(),O_RDONLY);
+		if(fd < 0)
+			throw default_error("open failed",fd);
+
+		char *buf = new char[BUF_SIZE];
+		ssize_t res;
+		while((res = readdirplus(fd,buf,BUF_SIZE)) > 0) {
+			for(ssize_t off = 0; off < res; ) {
+				const struct direntplus *e = reinterpret_cast<struct direntplus*>(buf + off);
+				off += e->d_ent.d_reclen;
+				if((pattern.empty() || strmatch(pattern.c_str(),e->d_ent.d_name)) &&
+						(showHidden || e->d_ent.d_name[0] != '.')) {
+					/* the filesystem couldn't stat it; try it again to get the reason */
+					if(e->d_stat.st_mode == 0)
+						addEntry(v,dir,e->d_ent.d_name,errors);
+					else
+						v.push_back(file(dir,e->d_ent.d_name,e->d_stat));
+				}
+			}
+		}
+		delete[] buf;
+		close(fd);
+
+		/* not supported by the filesystem, so stat them one by one */
+		if(res == -ENOTSUP) {
+			std::vector<struct dirent> files = list_files(showHidden,pattern);
+			for(auto it = files.begin(); it != files.end(); ++it)
+				addEntry(v,dir,it->d_name,errors);
+		}
+		else if(res < 0)
+			throw default_error("readdirplus failed",res);
+		return v;
+	}
+
+	void file::addEntry(std::vector<file> &v,const std::string &dir,const char *name,
+			std::vector<std::pair<std::string,default_error>> *errors) {
+		try {
+			v.push_back(file(dir,name,O_NOCHAN | O_NOFOLLOW));
+		}
+		catch(const default_error &e) {
+			if(errors)
+				errors->push_back(std::make_pair(std::string(name),e));
+		}
+	}
+
 	void file::init(const std::string& p,const std::string& n,uint flags) {
 		char apath[MAX_PATH_LEN];
 		ssize_t len = canonpath(apath,sizeof(apath),p.c_str());
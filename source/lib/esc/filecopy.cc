@@ -29,6 +29,9 @@
 
 namespace esc {
 
+/* the number of bytes to copy at once via copyrange(); limits the delay of progress updates */
+static const size_t COPY_STEP = 1024 * 1024;
+
 FileCopy::FileCopy(size_t bufsize,uint fl)
 		: _bufsize(bufsize), _shmfd(), _shm(), _flags(fl), _cols() {
 	/* create shm file */
@@ -105,19 +108,43 @@ bool FileCopy::copyFile(const char *src,const char *dest,bool remove) {
 
 	ssize_t res;
 	bool success = true;
-	if(_flags & FL_PROGRESS) {
-		size_t total = filesize(infd);
-		size_t pos = 0;
-		size_t lastPos = -1;
-		ulong lastSteps = -1;
-		ulong totalSteps = getTotalSteps();
-		while((res = read(infd,_shm,_bufsize)) > 0) {
-			if(write(outfd,_shm,res) != res) {
+	bool kernel = true;
+	size_t total = (_flags & FL_PROGRESS) ? filesize(infd) : 0;
+	size_t pos = 0;
+	size_t lastPos = -1;
+	ulong lastSteps = -1;
+	ulong totalSteps = (_flags & FL_PROGRESS) ? getTotalSteps() : 0;
+	while(1) {
+		/* let the filesystem or the kernel move the data, if possible */
+		if(kernel) {
+			res = copyrange(infd,outfd,_shm,COPY_STEP);
+			if(res == -ENOTSUP) {
+				kernel = false;
+				continue;
+			}
+			if(res < 0) {
+				handleError("copying '%s' to '%s' failed",src,dest);
+				success = false;
+				break;
+			}
+		}
+		else {
+			res = read(infd,_shm,_bufsize);
+			if(res < 0) {
+				handleError("read from '%s' failed",src);
+				success = false;
+				break;
+			}
+			if(res > 0 && write(outfd,_shm,res) != res) {
 				handleError("write to '%s' failed",dest);
 				success = false;
 				break;
 			}
+		}
+		if(res == 0)
+			break;
 
+		if(_flags & FL_PROGRESS) {
 			pos += res;
 			ulong steps = getSteps(totalSteps,pos,total);
 			if(steps != lastSteps || pos - lastPos > 1024 * 1024) {
@@ -126,23 +153,10 @@ bool FileCopy::copyFile(const char *src,const char *dest,bool remove) {
 				lastPos = pos;
 			}
 		}
-		if(res == 0) {
-			putchar('\n');
-			fflush(stdout);
-		}
-	}
-	else {
-		while((res = read(infd,_shm,_bufsize)) > 0) {
-			if(write(outfd,_shm,res) != res) {
-				handleError("write to '%s' failed",dest);
-				success = false;
-				break;
-			}
-		}
 	}
-	if(res < 0) {
-		handleError("read from '%s' failed",src);
-		success = false;
+	if(success && (_flags & FL_PROGRESS)) {
+		putchar('\n');
+		fflush(stdout);
 	}
 
 	close(outfd);
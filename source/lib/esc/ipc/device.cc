@@ -18,6 +18,7 @@
  */
 
 #include <esc/ipc/device.h>
+#include <esc/util.h>
 #include <esc/vthrow.h>
 #include <sys/common.h>
 #include <sys/messages.h>
@@ -25,31 +26,53 @@
 namespace esc {
 
 Device::Device(const char *path,mode_t mode,uint type,uint ops)
-	: _ops(), _id(createdev(path,mode,type,ops | DEV_CLOSE)), _run(true) {
+	: _devOps(), _ops(), _opsBase(), _opsCount(), _id(createdev(path,mode,type,ops | DEV_CLOSE)),
+	  _run(true) {
 	if(_id < 0)
 		VTHROWE("createdev(" << path << ")",_id);
 	set(MSG_FILE_CLOSE,std::make_memfun(this,&Device::close),false);
 }
 
 Device::~Device() {
-	for(auto it = _ops.begin(); it != _ops.end(); ) {
-		auto old = it++;
-		delete old->second.func;
-	}
+	for(size_t i = 0; i < ARRAY_SIZE(_devOps); ++i)
+		delete _devOps[i].func;
+	for(size_t i = 0; i < _opsCount; ++i)
+		delete _ops[i].func;
+	delete[] _ops;
 	::close(_id);
 }
 
+Device::Handler *Device::slot(msgid_t op) {
+	if(op - MSG_FILE_OPEN < ARRAY_SIZE(_devOps))
+		return _devOps + (op - MSG_FILE_OPEN);
+
+	/* extend the table to include <op> */
+	if(_opsCount == 0 || op < _opsBase || op >= _opsBase + _opsCount) {
+		msgid_t base = _opsCount == 0 ? op : esc::Util::min(op,_opsBase);
+		size_t end = _opsCount == 0 ? op + 1 : esc::Util::max<size_t>(op + 1,_opsBase + _opsCount);
+		Handler *ops = new Handler[end - base];
+		for(size_t i = 0; i < _opsCount; ++i)
+			ops[_opsBase - base + i] = _ops[i];
+		delete[] _ops;
+		_ops = ops;
+		_opsBase = base;
+		_opsCount = end - base;
+	}
+	return _ops + (op - _opsBase);
+}
+
 void Device::set(msgid_t op,handler_type *handler,bool rep) {
 	assert(handler != NULL);
-	unset(op);
-	_ops[op] = Handler(handler,rep);
+	Handler *h = slot(op);
+	delete h->func;
+	*h = Handler(handler,rep);
 }
 
 void Device::unset(msgid_t op) {
-	oplist_type::iterator it = _ops.find(op);
-	if(it != _ops.end()) {
-		delete it->second.func;
-		_ops.erase(it);
+	Handler *h = const_cast<Handler*>(lookup(op));
+	if(h) {
+		delete h->func;
+		*h = Handler();
 	}
 }
 
@@ -80,23 +103,23 @@ void Device::reply(IPCStream &is,errcode_t errcode) {
 }
 
 void Device::handleMsg(msgid_t mid,IPCStream &is) {
-	oplist_type::iterator it = _ops.find(mid & 0xFFFF);
-	Handler &h = (*it).second;
+	const Handler *h = lookup(mid & 0xFFFF);
+	bool rep = h ? h->reply : true;
 	try {
-		if(EXPECT_FALSE(it == _ops.end()))
+		if(EXPECT_FALSE(h == NULL))
 			reply(is,-ENOTSUP);
 		else
-			(*h.func)(is);
+			(*h->func)(is);
 	}
 	catch(const esc::default_error &e) {
 		// TODO printe is annoying here since it prints errno, which is typically nonsense.
 		printe("Client %d, message %u: %s",is.fd(),mid & 0xFFFF,e.what());
-		if(h.reply)
+		if(rep)
 			reply(is,e.error() ? e.error() : -EINVAL);
 	}
 	catch(...) {
 		printe("Client %d, message %u: unknown error",is.fd(),mid & 0xFFFF);
-		if(h.reply)
+		if(rep)
 			reply(is,-EINVAL);
 	}
 }
@@ -21,6 +21,9 @@
 #include <fs/fsdev.h>
 #include <sys/common.h>
 #include <sys/debug.h>
+#include <sys/io.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/thread.h>
 #include <assert.h>
 #include <stdio.h>
@@ -33,10 +36,13 @@ namespace fs {
 BlockCache::BlockCache(int fd,size_t blocks,size_t bsize)
 		: _blockCacheSize(blocks), _blockSize(bsize), _hashmap(new CBlock*[HASH_SIZE]()),
 		  _oldestBlock(NULL), _newestBlock(NULL), _freeBlocks(NULL),
-		  _blockCache(new CBlock[blocks]), _blockmem(), _blockfd(), _hits(), _misses() {
+		  _blockCache(new CBlock[blocks]), _blockmem(), _blockfd(), _dax(), _daxsize(),
+		  _hits(), _misses() {
 	size_t i;
 	CBlock *bentry;
-	if((_blockfd = sharebuf(fd,_blockCacheSize * _blockSize,&_blockmem,0)) < 0) {
+	/* with direct access, we only need the entries for the locking and the LRU list */
+	if(!mapDirect(fd) &&
+			(_blockfd = sharebuf(fd,_blockCacheSize * _blockSize,&_blockmem,0)) < 0) {
 		if(_blockmem == NULL)
 			VTHROW("Unable to create block cache");
 		printe("Unable to share buffer with disk driver");
@@ -44,7 +50,7 @@ BlockCache::BlockCache(int fd,size_t blocks,size_t bsize)
 	bentry = _blockCache;
 	for(i = 0; i < _blockCacheSize; i++) {
 		bentry->blockNo = 0;
-		bentry->buffer = (char*)_blockmem + i * _blockSize;
+		bentry->buffer = _blockmem ? (char*)_blockmem + i * _blockSize : NULL;
 		bentry->dirty = false;
 		bentry->refs = 0;
 		bentry->prev = (i < _blockCacheSize - 1) ? bentry + 1 : NULL;
@@ -56,16 +62,37 @@ BlockCache::BlockCache(int fd,size_t blocks,size_t bsize)
 }
 
 BlockCache::~BlockCache() {
-	destroybuf(_blockmem,_blockfd);
+	destroybuf(_dax ? _dax : _blockmem,_blockfd);
 	delete[] _hashmap;
 	delete[] _blockCache;
 }
 
+bool BlockCache::mapDirect(int fd) {
+	int daxfd = obtain(fd,OBT_ARG_DAX);
+	if(daxfd < 0)
+		return false;
+
+	/* we need write access, because the filesystem writes into the blocks */
+	off_t size = filesize(daxfd);
+	if(size > 0)
+		_dax = (char*)mmap(NULL,size,size,PROT_READ | PROT_WRITE,MAP_SHARED,daxfd,0);
+	if(!_dax) {
+		close(daxfd);
+		return false;
+	}
+	_blockfd = daxfd;
+	_daxsize = size;
+	return true;
+}
+
 void BlockCache::flush() {
 	CBlock *bentry = _newestBlock;
 	while(bentry != NULL) {
 		sassert(tpool_lock(ALLOC_LOCK,LOCK_EXCLUSIVE | LOCK_KEEP) == 0);
-		if(bentry->dirty) {
+		/* with direct access, the block has already been written to the device memory */
+		if(bentry->dirty && _dax)
+			bentry->dirty = false;
+		else if(bentry->dirty) {
 			acquire(bentry,READ);
 			writeBlocks(bentry->buffer,bentry->blockNo,1);
 			bentry->dirty = false;
@@ -125,14 +152,22 @@ CBlock *BlockCache::doRequest(block_t blockNo,bool doRead,uint mode) {
 		bentry = bentry->hnext;
 	}
 
+	/* with direct access, the block simply refers to the device memory */
+	if(_dax && (blockNo + 1) * _blockSize > _daxsize) {
+		sassert(tpool_unlock(ALLOC_LOCK) == 0);
+		return NULL;
+	}
+
 	/* init cached block */
 	block = getBlock(blockNo);
 	block->blockNo = blockNo;
 	block->dirty = false;
 	block->refs = 0;
 
-	/* now read from disk */
-	if(doRead) {
+	if(_dax)
+		block->buffer = _dax + blockNo * _blockSize;
+	/* otherwise read it from disk */
+	else if(doRead) {
 		/* we need always a write-tpool_lock because we have to read the content into it */
 		acquire(block,WRITE);
 		if(readBlocks(block->buffer,blockNo,1) != 0) {
@@ -205,7 +240,7 @@ CBlock *BlockCache::getBlock(block_t blockNo) {
 		*list = block;
 	}
 	/* if it is dirty we have to write it first to disk */
-	if(block->dirty) {
+	if(block->dirty && !_dax) {
 		acquire(block,READ);
 		writeBlocks(block->buffer,block->blockNo,1);
 		doRelease(block,false);
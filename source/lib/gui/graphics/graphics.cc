@@ -31,14 +31,14 @@ namespace gui {
 		Size rsize = size;
 		Pos rpos = pos;
 		Size bsize = _buf->getSize();
-		gsize_t psize = Application::getInstance()->getColorDepth() / 8;
-		// TODO really size.width?
-		gsize_t wsize = size.width * psize;
-		gsize_t bwsize = bsize.width * psize;
 		uint8_t *pixels = getPixels();
 		if(!pixels || !validateParams(rpos,rsize))
 			return;
 
+		const PixelFormat *fmt = _buf->getFormat();
+		gsize_t psize = fmt->getBytesPerPixel();
+		gsize_t bwsize = _buf->getStride();
+
 		gpos_t startx = _off.x + rpos.x;
 		gpos_t starty = _off.y + rpos.y;
 		if(up > 0) {
@@ -50,20 +50,16 @@ namespace gui {
 				up = -(bsize.height - (rsize.height + starty));
 		}
 
+		// TODO really size.width?
 		pixels += startx * psize;
 		if(up > 0) {
-			for(gsize_t i = 0; i < rsize.height; i++) {
-				memcpy(pixels + (starty + i - up) * bwsize,
-					pixels + (starty + i) * bwsize,
-					wsize);
-			}
+			fmt->copyRows(pixels + (starty - up) * bwsize,bwsize,
+				pixels + starty * bwsize,bwsize,size.width,rsize.height);
 		}
 		else {
-			for(gsize_t i = 0; i < rsize.height; i++) {
-				memcpy(pixels + (starty + rsize.height - 1 - i - up) * bwsize,
-					pixels + (starty + rsize.height - 1 - i) * bwsize,
-					wsize);
-			}
+			// copy from bottom to top to not overwrite the rows we still have to move
+			fmt->copyRows(pixels + (starty + rsize.height - 1 - up) * bwsize,-(ssize_t)bwsize,
+				pixels + (starty + rsize.height - 1) * bwsize,-(ssize_t)bwsize,size.width,rsize.height);
 		}
 		updateMinMax(Pos(rpos.x,rpos.y - up));
 		updateMinMax(Pos(rsize.width - 1,rpos.y + rsize.height - up - 1));
@@ -73,13 +69,14 @@ namespace gui {
 		Size rsize = size;
 		Pos rpos = pos;
 		Size bsize = _buf->getSize();
-		gsize_t psize = Application::getInstance()->getColorDepth() / 8;
-		gsize_t wsize = size.width * psize;
-		gsize_t bwsize = bsize.width * psize;
 		uint8_t *pixels = getPixels();
 		if(!pixels || !validateParams(rpos,rsize))
 			return;
 
+		const PixelFormat *fmt = _buf->getFormat();
+		gsize_t psize = fmt->getBytesPerPixel();
+		gsize_t bwsize = _buf->getStride();
+
 		gpos_t startx = _off.x + rpos.x;
 		gpos_t starty = _off.y + rpos.y;
 		if(left > 0) {
@@ -92,11 +89,8 @@ namespace gui {
 		}
 
 		pixels += startx * psize;
-		for(gsize_t i = 0; i < rsize.height; i++) {
-			memmove(pixels + (starty + i) * bwsize - left * psize,
-				pixels + (starty + i) * bwsize,
-				wsize);
-		}
+		fmt->copyRows(pixels + starty * bwsize - left * psize,bwsize,
+			pixels + starty * bwsize,bwsize,size.width,rsize.height);
 		updateMinMax(Pos(rpos.x - left,rpos.y));
 		updateMinMax(Pos(rpos.x + rsize.width - left - 1,rsize.height - 1));
 	}
@@ -109,16 +103,11 @@ namespace gui {
 
 		updateMinMax(rpos);
 		updateMinMax(Pos(rpos.x + fsize.width - 1,rpos.y + fsize.height - 1));
-		gpos_t cx,cy;
 		gpos_t xoff = rpos.x - pos.x,yoff = rpos.y - pos.y;
 		gpos_t xend = xoff + fsize.width;
 		gpos_t yend = yoff + fsize.height;
-		for(cy = yoff; cy < yend; cy++) {
-			for(cx = xoff; cx < xend; cx++) {
-				if(_font.isPixelSet(c,cx,cy))
-					doSetPixel(pos.x + cx,pos.y + cy);
-			}
-		}
+		_buf->getFormat()->drawGlyph(getPixelAddr(pos.x,pos.y),_buf->getStride(),_font.getGlyph(c),
+			xoff,yoff,xend,yend,_col);
 	}
 
 	void Graphics::drawString(const Pos &pos,const string &str) {
@@ -221,8 +210,7 @@ namespace gui {
 		updateMinMax(Pos(x2,y));
 		if(x1 > x2)
 			swap(x1,x2);
-		for(; x1 <= x2; x1++)
-			doSetPixel(x1,y);
+		_buf->getFormat()->fillSpan(getPixelAddr(x1,y),x2 - x1 + 1,_col);
 	}
 
 	void Graphics::drawRect(const Pos &pos,const Size &size) {
@@ -245,57 +233,12 @@ namespace gui {
 		if(!getPixels() || !validateParams(rpos,rsize))
 			return;
 
-		gpos_t yend = rpos.y + rsize.height;
 		updateMinMax(rpos);
-		updateMinMax(Pos(rpos.x + rsize.width - 1,yend - 1));
-		gpos_t xcur;
-		gpos_t xend = rpos.x + rsize.width;
-
-		gcoldepth_t bpp = Application::getInstance()->getColorDepth();
-		gsize_t bwidth = _buf->getSize().width;
-		uint8_t *orgaddr = getPixels() + (((_off.y + rpos.y) * bwidth + (_off.x + rpos.x)) * (bpp / 8));
-		gsize_t widthadd = bwidth * (bpp / 8);
-		// optimized versions for the individual color depths
-		// This is necessary if we want to have reasonable speed because the simple version
-		// performs too many function-calls (one to a virtual-function and one to memcpy
-		// that the compiler doesn't inline). Additionally the offset into the
-		// memory-region will be calculated many times.
-		// This version is much quicker :)
-		switch(bpp) {
-			case 16: {
-				for(; rpos.y < yend; rpos.y++) {
-					uint16_t *addr = (uint16_t*)orgaddr;
-					for(xcur = rpos.x; xcur < xend; xcur++)
-						*addr++ = _col;
-					orgaddr += widthadd;
-				}
-			}
-			break;
-
-			case 24: {
-				uint8_t *col = (uint8_t*)&_col;
-				for(; rpos.y < yend; rpos.y++) {
-					uint8_t *addr = orgaddr;
-					for(xcur = rpos.x; xcur < xend; xcur++) {
-						*addr++ = *col;
-						*addr++ = *(col + 1);
-						*addr++ = *(col + 2);
-					}
-					orgaddr += widthadd;
-				}
-			}
-			break;
-
-			case 32: {
-				for(; rpos.y < yend; rpos.y++) {
-					uint32_t *addr = (uint32_t*)orgaddr;
-					for(xcur = rpos.x; xcur < xend; xcur++)
-						*addr++ = _col;
-					orgaddr += widthadd;
-				}
-			}
-			break;
-		}
+		updateMinMax(Pos(rpos.x + rsize.width - 1,rpos.y + rsize.height - 1));
+		// the pixel-format fills whole spans at once, so that we neither decide the color-depth
+		// nor calculate the offset into the buffer for every pixel
+		_buf->getFormat()->fillRect(getPixelAddr(rpos.x,rpos.y),_buf->getStride(),
+			rsize.width,rsize.height,_col);
 	}
 
 	void Graphics::colorFadeRect(Orientation orientation,const Color &col1,const Color &col2,
@@ -45,6 +45,12 @@ namespace gui {
 		close(fd);
 		if(_pixels == NULL)
 			throw esc::default_error(string("Unable to mmap window buffer"),errno);
+
+		_format = PixelFormat::create(*Application::getInstance()->getScreenMode());
+		if(_format == nullptr) {
+			freeBuffer();
+			throw esc::default_error(string("Unsupported color depth"),-ENOTSUP);
+		}
 	}
 
 	void GraphicsBuffer::freeBuffer() {
@@ -52,6 +58,8 @@ namespace gui {
 			munmap(_pixels);
 			_pixels = nullptr;
 		}
+		delete _format;
+		_format = nullptr;
 	}
 
 	void GraphicsBuffer::moveTo(const Pos &pos) {
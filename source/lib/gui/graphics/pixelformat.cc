@@ -0,0 +1,77 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <gui/graphics/pixelformat.h>
+#include <sys/common.h>
+#include <string.h>
+
+namespace gui {
+	PixelFormat *PixelFormat::create(const esc::Screen::Mode &mode) {
+		switch(mode.bitsPerPixel) {
+			case 16:
+				return new PixelFormatImpl<uint16_t>(mode);
+			case 24:
+				return new PixelFormat24(mode);
+			case 32:
+				return new PixelFormatImpl<uint32_t>(mode);
+		}
+		return nullptr;
+	}
+
+	void PixelFormat24::fillSpan(uint8_t *dst,gsize_t count,color_type col) const {
+		if(count < 4) {
+			for(gsize_t i = 0; i < count; ++i, dst += 3)
+				set(dst,col);
+			return;
+		}
+
+		// 4 pixels are 3 words; build them once and copy them afterwards
+		uint32_t words[3];
+		uint8_t *pat = reinterpret_cast<uint8_t*>(words);
+		for(int i = 0; i < 4; ++i)
+			set(pat + i * 3,col);
+
+		gsize_t i = 0;
+		for(; i + 4 <= count; i += 4, dst += 12)
+			memcpy(dst,words,12);
+		for(; i < count; ++i, dst += 3)
+			set(dst,col);
+	}
+
+	void PixelFormat24::drawGlyph(uint8_t *dst,size_t stride,const uint8_t *glyph,gpos_t xoff,
+			gpos_t yoff,gpos_t xend,gpos_t yend,color_type col) const {
+		dst += yoff * stride;
+		for(gpos_t y = yoff; y < yend; ++y) {
+			uint bits = glyph[y];
+			for(gpos_t x = xoff; x < xend; ++x) {
+				if(bits & (0x80 >> x))
+					set(dst + x * 3,col);
+			}
+			dst += stride;
+		}
+	}
+
+	void PixelFormat24::blendSpan(uint8_t *dst,const uint32_t *src,gsize_t count) const {
+		for(gsize_t i = 0; i < count; ++i, dst += 3) {
+			uint32_t a = src[i] >> 24;
+			if(a != 0xFF)
+				set(dst,blendPixel(get(dst),src[i]));
+		}
+	}
+}
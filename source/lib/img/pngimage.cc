@@ -30,6 +30,8 @@ const uint8_t PNGImage::SIG[] = {
 };
 
 void PNGImage::paint(gpos_t x,gpos_t y,gsize_t width,gsize_t height) {
+	// decode one row at a time and hand it to the painter as a whole
+	uint32_t *row = new uint32_t[width];
 	size_t p = y * ((_header.width * _bpp) + 1);
 	gpos_t yend = y + height;
 	for(gpos_t cy = y; cy < yend; cy++) {
@@ -74,12 +76,14 @@ void PNGImage::paint(gpos_t x,gpos_t y,gsize_t width,gsize_t height) {
 					}
 					break;
 			}
-			_painter->paintPixel(cx,cy,col);
+			row[cx - x] = col;
 		}
+		_painter->paintRow(x,cy,row,width);
 
 		// skip over end of line
 		p += (_header.width - width) * _bpp;
 	}
+	delete[] row;
 }
 
 uint8_t PNGImage::left(size_t off,size_t x) {
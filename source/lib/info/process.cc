@@ -20,6 +20,7 @@
 #include <esc/stream/fstream.h>
 #include <esc/file.h>
 #include <info/process.h>
+#include <info/procstats.h>
 #include <info/thread.h>
 #include <ctype.h>
 
@@ -28,6 +29,33 @@ using namespace esc;
 namespace info {
 	std::vector<process*> process::get_list(bool own,uid_t uid,bool fullcmd) {
 		std::vector<process*> procs;
+		try {
+			procstats stats;
+			for(size_t i = 0; i < stats.proc_count(); ++i) {
+				struct procstats_proc rec = stats.proc(i);
+				if(own && rec.uid != uid)
+					continue;
+
+				// the snapshot contains only the beginning of long commands
+				process *p = NULL;
+				if(fullcmd && (rec.flags & PROCSTATS_CMD_TRUNC)) {
+					try {
+						p = get_proc(rec.pid,own,uid,fullcmd);
+					}
+					catch(const default_error&) {
+					}
+				}
+				else
+					p = new process(rec,fullcmd);
+				if(p)
+					procs.push_back(p);
+			}
+			return procs;
+		}
+		catch(const default_error&) {
+			// fall back to the info-files
+		}
+
 		file dir("/sys/pid");
 		std::vector<struct dirent> files = dir.list_files(false);
 		for(auto it = files.begin(); it != files.end(); ++it) {
@@ -62,6 +90,18 @@ namespace info {
 		return p;
 	}
 
+	process::process(const struct procstats_proc &rec,bool fullcmd)
+		: _fullcmd(fullcmd), _pid(rec.pid), _ppid(rec.ppid), _uid(rec.uid), _gid(rec.gid),
+		  _pages(rec.pages), _ownFrames(rec.ownFrames), _sharedFrames(rec.sharedFrames),
+		  _swapped(rec.swapped), _cycles(rec.cycles), _runtime(rec.runtime), _input(rec.input),
+		  _output(rec.output), _cmd(rec.command) {
+		if(!fullcmd) {
+			size_t end = _cmd.find(' ');
+			if(end != std::string::npos)
+				_cmd.erase(end);
+		}
+	}
+
 	process::process(const process& p)
 		: _fullcmd(p._fullcmd), _pid(p._pid), _ppid(p._ppid), _uid(p._uid), _gid(p._gid),
 		  _pages(p._pages), _ownFrames(p._ownFrames), _sharedFrames(p._sharedFrames),
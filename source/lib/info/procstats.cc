@@ -0,0 +1,74 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <esc/util.h>
+#include <esc/vthrow.h>
+#include <info/procstats.h>
+#include <sys/io.h>
+#include <string.h>
+
+namespace info {
+	procstats::procstats() : _buf(), _hdr() {
+		int fd = open(PROCSTATS_PATH,O_READ);
+		if(fd < 0)
+			VTHROWE("open(" << PROCSTATS_PATH << ")",fd);
+
+		// the snapshot has to be read at once. thus, start with a reasonable size and retry with
+		// a larger buffer if it was not sufficient
+		size_t size = 16 * 1024;
+		ssize_t res;
+		while(1) {
+			_buf = new char[size];
+			res = read(fd,_buf,size);
+			if(res < 0 || (size_t)res < size)
+				break;
+
+			delete[] _buf;
+			_buf = NULL;
+			size *= 2;
+			off_t pos = seek(fd,0,SEEK_SET);
+			if(pos < 0) {
+				res = pos;
+				break;
+			}
+		}
+		close(fd);
+
+		if(res < 0) {
+			delete[] _buf;
+			_buf = NULL;
+			VTHROWE("read(" << PROCSTATS_PATH << ")",res);
+		}
+
+		_hdr = reinterpret_cast<const struct procstats_hdr*>(_buf);
+		if((size_t)res < sizeof(struct procstats_hdr) || _hdr->version != PROCSTATS_VERSION ||
+				(size_t)res < _hdr->hdrSize + _hdr->procCount * _hdr->procSize +
+					_hdr->threadCount * _hdr->threadSize) {
+			delete[] _buf;
+			_buf = NULL;
+			VTHROWE("Invalid or unsupported snapshot in " << PROCSTATS_PATH,-EINVAL);
+		}
+	}
+
+	void procstats::get(void *rec,size_t size,size_t off,size_t recsize) const {
+		// the kernel might provide less or more fields than we know
+		memclear(rec,size);
+		memcpy(rec,_buf + off,esc::Util::min(size,recsize));
+	}
+}
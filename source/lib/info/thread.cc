@@ -19,8 +19,10 @@
 
 #include <esc/stream/fstream.h>
 #include <esc/file.h>
+#include <info/procstats.h>
 #include <info/thread.h>
 #include <ctype.h>
+#include <map>
 #include <vector>
 
 using namespace esc;
@@ -28,6 +30,23 @@ using namespace esc;
 namespace info {
 	std::vector<thread*> thread::get_list() {
 		std::vector<thread*> threads;
+		try {
+			procstats stats;
+			std::map<pid_t,std::string> names;
+			for(size_t i = 0; i < stats.proc_count(); ++i) {
+				struct procstats_proc rec = stats.proc(i);
+				names[rec.pid] = rec.command;
+			}
+			for(size_t i = 0; i < stats.thread_count(); ++i) {
+				struct procstats_thread rec = stats.thread(i);
+				threads.push_back(new thread(rec,names[rec.pid]));
+			}
+			return threads;
+		}
+		catch(const default_error&) {
+			// fall back to the info-files
+		}
+
 		file dir("/sys/pid");
 		std::vector<struct dirent> files = dir.list_files(false);
 		for(auto it = files.begin(); it != files.end(); ++it) {
@@ -84,6 +103,8 @@ namespace info {
 		is.ignore(unlimited,' ') >> t._runtime;
 		is.ignore(unlimited,' ') >> fmt(t._cycles,"x");
 		is.ignore(unlimited,' ') >> t._cpu;
+		is.ignore(unlimited,' ') >> t._wakeups;
+		is.ignore(unlimited,' ') >> t._wakeupLatency;
 		return is;
 	}
 
@@ -98,6 +119,8 @@ namespace info {
 		os << "\tcycles    : " << t.cycles() << "\n";
 		os << "\truntime   : " << t.runtime() << "\n";
 		os << "\tlastCPU   : " << t.cpu() << "\n";
+		os << "\twakeups   : " << t.wakeups() << "\n";
+		os << "\twakeupLat : " << t.wakeupLatency() << "\n";
 		return os;
 	}
 }
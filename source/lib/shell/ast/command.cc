@@ -26,6 +26,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -51,6 +52,10 @@ static int ast_redirFromFile(sEnv *e,sRedirFile *redir);
  * Opens the given file for output-redirection
  */
 static int ast_redirToFile(sEnv *e,sRedirFile *redir);
+/**
+ * Builds the environment for the given command, including the variables in front of it
+ */
+static const char **ast_buildEnv(sExecSubCmd *cmd,size_t cmdidx);
 /**
  * Free's the memory of the given command
  */
@@ -245,44 +250,41 @@ sValue *ast_execCommand(sEnv *e,sCommand *n) {
 				close(pipeFds[0]);
 		}
 		else {
-			if((pid = fork()) == 0) {
-				/* redirect fds */
-				if(redirFdesc->type == REDIR_OUT2ERR)
-					redirect(STDOUT_FILENO,STDERR_FILENO);
-				else if(pipeFds[1] >= 0)
-					redirect(STDOUT_FILENO,pipeFds[1]);
-				if(prevPipe >= 0)
-					redirect(STDIN_FILENO,prevPipe);
-				if(redirFdesc->type == REDIR_ERR2OUT)
-					redirect(STDERR_FILENO,STDOUT_FILENO);
-				else if(errFd >= 0)
-					redirect(STDERR_FILENO,errFd);
-				/* close our read-end */
-				if(pipeFds[0] >= 0)
-					close(pipeFds[0]);
-
-				/* set env vars */
-				for(size_t i = 0; i < cmdidx; ++i) {
-					char tmp[32];
-					const char *eq = strchr(cmd->exprs[i],'=');
-					assert(eq != NULL);
-					strnzcpy(tmp,cmd->exprs[i],sizeof(tmp));
-					tmp[eq - cmd->exprs[i]] = '\0';
-					setenv(tmp,eq + 1);
-				}
-
-				/* exec */
-				snprintf(path,sizeof(path),"%s/%s",shcmd[0]->path,shcmd[0]->name);
-				execv(path,(const char**)cmd->exprs + cmdidx);
-
-				/* if we're here, there is something wrong */
-				printe("Exec of '%s' failed",path);
-				fflush(stderr);
-				exit(EXIT_FAILURE);
-			}
-			else if(pid < 0)
-				printe("Fork of '%s/%s' failed",shcmd[0]->path,shcmd[0]->name);
+			/* redirect fds */
+			posix_spawn_file_actions_t fa;
+			posix_spawn_file_actions_init(&fa);
+			if(redirFdesc->type == REDIR_OUT2ERR)
+				posix_spawn_file_actions_adddup2(&fa,STDERR_FILENO,STDOUT_FILENO);
+			else if(pipeFds[1] >= 0)
+				posix_spawn_file_actions_adddup2(&fa,pipeFds[1],STDOUT_FILENO);
+			if(prevPipe >= 0)
+				posix_spawn_file_actions_adddup2(&fa,prevPipe,STDIN_FILENO);
+			if(redirFdesc->type == REDIR_ERR2OUT)
+				posix_spawn_file_actions_adddup2(&fa,STDOUT_FILENO,STDERR_FILENO);
+			else if(errFd >= 0)
+				posix_spawn_file_actions_adddup2(&fa,errFd,STDERR_FILENO);
+			/* close our read-end */
+			if(pipeFds[0] >= 0)
+				posix_spawn_file_actions_addclose(&fa,pipeFds[0]);
+			/* close the originals of the redirected pipe ends as well, so that the child is their
+			 * only user and stdio can map their rings (see pipemapexcl) */
+			if(pipeFds[1] >= 0 && pipeFds[1] != STDOUT_FILENO)
+				posix_spawn_file_actions_addclose(&fa,pipeFds[1]);
+			if(prevPipe >= 0 && prevPipe != STDIN_FILENO)
+				posix_spawn_file_actions_addclose(&fa,prevPipe);
+
+			/* start the process directly instead of fork + exec */
+			const char **env = ast_buildEnv(cmd,cmdidx);
+			snprintf(path,sizeof(path),"%s/%s",shcmd[0]->path,shcmd[0]->name);
+			pid_t child;
+			int err = posix_spawn(&child,path,&fa,NULL,cmd->exprs + cmdidx,(char *const*)env);
+			efree(env);
+			posix_spawn_file_actions_destroy(&fa);
+
+			if(err < 0)
+				printe("Spawn of '%s' failed",path);
 			else {
+				pid = child;
 				curWaitCount++;
 				jobs_addProc(curJob,pid,cmd->exprCount,cmd->exprs,n->runInBG);
 				if(n->runInBG)
@@ -321,6 +323,29 @@ error:
 	return val_createInt(res);
 }
 
+static const char **ast_buildEnv(sExecSubCmd *cmd,size_t cmdidx) {
+	size_t envc = 0;
+	while(environ[envc])
+		envc++;
+
+	const char **env = (const char**)emalloc((envc + cmdidx + 1) * sizeof(char*));
+	size_t n = 0;
+	for(size_t i = 0; i < envc; ++i) {
+		/* skip the variables that are set for the command */
+		const char *eq = strchr(environ[i],'=');
+		size_t len = eq ? (size_t)(eq - environ[i]) : strlen(environ[i]);
+		bool overwritten = false;
+		for(size_t j = 0; !overwritten && j < cmdidx; ++j)
+			overwritten = strncmp(cmd->exprs[j],environ[i],len) == 0 && cmd->exprs[j][len] == '=';
+		if(!overwritten)
+			env[n++] = environ[i];
+	}
+	for(size_t j = 0; j < cmdidx; ++j)
+		env[n++] = cmd->exprs[j];
+	env[n] = NULL;
+	return env;
+}
+
 void ast_catchZombies(void) {
 	while(zombies > 0) {
 		if(!ast_catchZombie())
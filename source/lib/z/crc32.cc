@@ -17,32 +17,73 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <sys/endian.h>
 #include <z/crc32.h>
 
 namespace z {
 
 /* source: http://tools.ietf.org/html/rfc1952 */
 
+CRC32::type CRC32::_table[8][256];
+bool CRC32::_initialized = false;
+
 CRC32::CRC32() {
+	/* all instances compute the same tables, so it doesn't hurt if multiple threads do that */
+	if(!_initialized)
+		init();
+}
+
+void CRC32::init() {
 	/* Make the table for a fast CRC. */
 	for(size_t n = 0; n < 256; n++) {
-		ulong c = n;
+		type c = n;
 		for(int k = 0; k < 8; k++) {
 			if(c & 1)
 				c = 0xedb88320L ^ (c >> 1);
 			else
 				c = c >> 1;
 		}
-		_table[n] = c;
+		_table[0][n] = c;
+	}
+	/* table i contains the CRC of a byte that is followed by i zero bytes */
+	for(size_t n = 0; n < 256; n++) {
+		type c = _table[0][n];
+		for(size_t k = 1; k < 8; k++) {
+			c = _table[0][c & 0xff] ^ (c >> 8);
+			_table[k][n] = c;
+		}
 	}
+	_initialized = true;
 }
 
 CRC32::type CRC32::update(type crc,const void *buf,size_t len) {
 	type c = crc ^ 0xffffffffL;
-	const char *b = reinterpret_cast<const char*>(buf);
+	const uint8_t *b = reinterpret_cast<const uint8_t*>(buf);
+
+	/* align the buffer to process 8 bytes at once */
+	while(len > 0 && ((uintptr_t)b & 3)) {
+		c = _table[0][(c ^ *b++) & 0xff] ^ (c >> 8);
+		len--;
+	}
+
+	const uint32_t *w = reinterpret_cast<const uint32_t*>(b);
+	while(len >= 8) {
+		uint32_t one = le32tocpu(*w++) ^ c;
+		uint32_t two = le32tocpu(*w++);
+		c = _table[7][one & 0xff] ^
+			_table[6][(one >> 8) & 0xff] ^
+			_table[5][(one >> 16) & 0xff] ^
+			_table[4][one >> 24] ^
+			_table[3][two & 0xff] ^
+			_table[2][(two >> 8) & 0xff] ^
+			_table[1][(two >> 16) & 0xff] ^
+			_table[0][two >> 24];
+		len -= 8;
+	}
 
-	for(size_t n = 0; n < len; n++)
-		c = _table[(c ^ b[n]) & 0xff] ^ (c >> 8);
+	b = reinterpret_cast<const uint8_t*>(w);
+	while(len-- > 0)
+		c = _table[0][(c ^ *b++) & 0xff] ^ (c >> 8);
 	return c ^ 0xffffffffL;
 }
 
@@ -20,170 +20,361 @@
 #include <esc/util.h>
 #include <sys/endian.h>
 #include <z/deflate.h>
+#include <string.h>
 
 namespace z {
 
-/* based on http://tools.ietf.org/html/rfc1951 */
+/* based on http://tools.ietf.org/html/rfc1951. the match search follows the one of zlib */
+
+const Deflate::Config Deflate::configs[] = {
+	/* good lazy nice chain */
+	{0,		0,		0,		0},		/* 0: store only */
+	{4,		0,		8,		4},		/* 1: greedy search */
+	{4,		0,		16,		8},
+	{4,		0,		32,		32},
+	{4,		4,		16,		16},	/* 4: lazy search */
+	{8,		16,		32,		32},
+	{8,		16,		128,	128},
+	{8,		32,		128,	256},
+	{32,	128,	258,	1024},
+	{32,	258,	258,	4096},	/* 9: maximum compression */
+};
+
+static inline unsigned int bit_reverse(unsigned int v,unsigned int bits) {
+	unsigned int res = 0;
+	while(bits-- > 0) {
+		res = (res << 1) | (v & 1);
+		v >>= 1;
+	}
+	return res;
+}
 
 /* ---------------------- *
  * -- encode functions -- *
  * ---------------------- */
 
-void Deflate::flush(Data *d) {
+void Deflate::flush_output(Data *d) {
+	if(d->outpos > 0) {
+		d->drain->write(d->out,d->outpos);
+		d->outpos = 0;
+	}
+}
+
+void Deflate::flush_bits(Data *d) {
 	if(d->bitcount > 0) {
-		d->drain->put(d->tag);
+		d->out[d->outpos++] = d->tag;
 		d->tag = 0;
 		d->bitcount = 0;
+		if(d->outpos == OUT_BUF_SIZE)
+			flush_output(d);
 	}
 }
 
-void Deflate::writebit(Data *d,int bit) {
-	assert((bit & ~0x1) == 0);
-	d->tag |= bit << d->bitcount;
+inline void Deflate::write_bits(Data *d,unsigned int bits,unsigned int num) {
+	d->tag |= bits << d->bitcount;
+	d->bitcount += num;
+	while(d->bitcount >= 8) {
+		d->out[d->outpos++] = d->tag;
+		d->tag >>= 8;
+		d->bitcount -= 8;
+		if(EXPECT_FALSE(d->outpos == OUT_BUF_SIZE))
+			flush_output(d);
+	}
+}
 
-	if(++d->bitcount == 8)
-		flush(d);
+/* --------------------- *
+ * -- match functions -- *
+ * --------------------- */
+
+size_t Deflate::read_fully(Data *d,uint8_t *buf,size_t count) {
+	size_t total = 0;
+	while(!d->eof && total < count) {
+		size_t res = d->source->read(buf + total,count - total);
+		if(res == 0)
+			d->eof = true;
+		total += res;
+	}
+	return total;
 }
 
-void Deflate::write_bits(Data *d,unsigned int bits,int num) {
-	while(num-- > 0) {
-		writebit(d,bits & 0x1);
-		bits >>= 1;
+void Deflate::fill_window(Data *d) {
+	/* slide the window, if the current position is too close to the end */
+	if(d->strstart >= WSIZE + MAX_DIST) {
+		memcpy(d->window,d->window + WSIZE,WSIZE);
+		d->match_start -= WSIZE;
+		d->strstart -= WSIZE;
+		d->block_start -= WSIZE;
+		for(size_t i = 0; i < HASH_SIZE; ++i)
+			d->head[i] = d->head[i] >= (int)WSIZE ? d->head[i] - (int)WSIZE : -1;
+		for(size_t i = 0; i < WSIZE; ++i)
+			d->prev[i] = d->prev[i] >= (int)WSIZE ? d->prev[i] - (int)WSIZE : -1;
 	}
+
+	size_t end = d->strstart + d->lookahead;
+	d->lookahead += read_fully(d,d->window + end,sizeof(d->window) - end);
 }
 
-void Deflate::write_bits_reverse(Data *d,unsigned int bits,unsigned int num) {
-	while(num-- > 0)
-		writebit(d,(bits >> num) & 0x1);
+/* inserts the string at <pos> into the hash table and returns the previous head of its chain */
+inline int Deflate::insert_string(Data *d,size_t pos) {
+	const uint8_t *p = d->window + pos;
+	size_t h = ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+	int res = d->head[h];
+	d->prev[pos & (WSIZE - 1)] = res;
+	d->head[h] = pos;
+	return res;
 }
 
-void Deflate::write_symbol(Data *d,Tree *t,unsigned int sym) {
-	size_t i;
-	for(i = 0; i < 4; ++i) {
-		if(t->litbase[i] > sym)
-			break;
+size_t Deflate::longest_match(Data *d,int cur_match,size_t prev_length) {
+	const Config *cfg = d->config;
+	size_t chain = cfg->max_chain;
+	size_t best_len = prev_length;
+	size_t max_len = esc::Util::min(MAX_MATCH,d->lookahead);
+	size_t nice = esc::Util::min((size_t)cfg->nice_length,max_len);
+	int limit = d->strstart > MAX_DIST ? (int)(d->strstart - MAX_DIST) : -1;
+	const uint8_t *scan = d->window + d->strstart;
+
+	if(best_len >= max_len)
+		return best_len;
+	/* we have already a good match, so search less */
+	if(prev_length >= cfg->good_length)
+		chain >>= 2;
+
+	do {
+		const uint8_t *match = d->window + cur_match;
+		/* check the end of the best match first, because it's most likely to differ */
+		if(match[best_len] != scan[best_len] || match[best_len - 1] != scan[best_len - 1] ||
+				match[0] != scan[0] || match[1] != scan[1])
+			continue;
+
+		size_t len = 2;
+		while(len < max_len && match[len] == scan[len])
+			len++;
+
+		if(len > best_len) {
+			d->match_start = cur_match;
+			best_len = len;
+			if(len >= nice)
+				break;
+		}
 	}
-	assert(i > 0);
-	i--;
+	while((cur_match = d->prev[cur_match & (WSIZE - 1)]) > limit && --chain != 0);
+	return best_len;
+}
+
+/* ----------------------------- *
+ * -- block deflate functions -- *
+ * ----------------------------- */
 
-	unsigned int num = t->length[i];
-	unsigned int bits = t->codebase[i] + (sym - t->litbase[i]);
-	write_bits_reverse(d,bits,num);
+inline void Deflate::tally_literal(Data *d,uint8_t c) {
+	d->dists[d->symcount] = 0;
+	d->lcs[d->symcount++] = c;
+	d->block_len++;
+	if(EXPECT_FALSE(d->symcount == SYM_BUF_SIZE))
+		flush_block(d,false);
 }
 
-void Deflate::write_int(Data *d,Tree *t,unsigned short *base,unsigned char *bits,unsigned int value,int add) {
-	/* determine code */
-	size_t i;
-	for(i = 0; i < 30; ++i) {
-		if(base[i] > value)
-			break;
+inline void Deflate::tally_match(Data *d,size_t dist,size_t len) {
+	d->dists[d->symcount] = dist;
+	d->lcs[d->symcount++] = len - MIN_MATCH;
+	d->block_len += len;
+	if(EXPECT_FALSE(d->symcount == SYM_BUF_SIZE))
+		flush_block(d,false);
+}
+
+size_t Deflate::fixed_block_size(Data *d) {
+	/* block header and end of block */
+	size_t bits = 3 + lit_lengths[256];
+	for(size_t i = 0; i < d->symcount; ++i) {
+		unsigned int dist = d->dists[i];
+		unsigned int lc = d->lcs[i];
+		if(dist == 0)
+			bits += lit_lengths[lc];
+		else {
+			unsigned int code = length_code[lc];
+			bits += lit_lengths[257 + code] + length_bits[code];
+			dist--;
+			code = dist < 256 ? dist_code[dist] : dist_code[256 + (dist >> 7)];
+			bits += 5 + dist_bits[code];
+		}
 	}
-	assert(i > 0);
-	i--;
+	return bits;
+}
 
-	/* write code */
-	write_symbol(d,t,add + i);
-	write_bits(d,value - base[i],bits[i]);
+void Deflate::stored_block(Data *d,const uint8_t *buf,size_t len,bool final) {
+	do {
+		size_t amount = len > MAX_STORED ? MAX_STORED : len;
+		bool last = final && amount == len;
+
+		write_bits(d,last ? 1 : 0,1);
+		write_bits(d,0,2);
+		/* make sure we start the block on a byte boundary */
+		flush_bits(d);
+		write_bits(d,amount,16);
+		write_bits(d,~amount & 0xFFFF,16);
+
+		/* copy block */
+		flush_output(d);
+		d->drain->write(buf,amount);
+		buf += amount;
+		len -= amount;
+	}
+	while(len > 0);
 }
 
-void Deflate::write_symbol_chain(Data *d,Tree *lt,Tree *dt,unsigned int len,unsigned int dist) {
-	write_int(d,lt,length_base,length_bits,len,257);
-	write_int(d,dt,dist_base,dist_bits,dist,0);
+void Deflate::fixed_block(Data *d,bool final) {
+	write_bits(d,final ? 1 : 0,1);
+	write_bits(d,1,2);
+
+	for(size_t i = 0; i < d->symcount; ++i) {
+		unsigned int dist = d->dists[i];
+		unsigned int lc = d->lcs[i];
+		if(dist == 0)
+			write_bits(d,lit_codes[lc],lit_lengths[lc]);
+		else {
+			/* length code and extra bits */
+			unsigned int code = length_code[lc];
+			write_bits(d,lit_codes[257 + code],lit_lengths[257 + code]);
+			if(length_bits[code])
+				write_bits(d,lc + MIN_MATCH - length_base[code],length_bits[code]);
+
+			/* distance code and extra bits */
+			dist--;
+			code = dist < 256 ? dist_code[dist] : dist_code[256 + (dist >> 7)];
+			write_bits(d,dist_codes[code],5);
+			if(dist_bits[code])
+				write_bits(d,dist + 1 - dist_base[code],dist_bits[code]);
+		}
+	}
+
+	/* end of block */
+	write_bits(d,lit_codes[256],lit_lengths[256]);
 }
 
-/* ----------------------------- *
- * -- block deflate functions -- *
- * ----------------------------- */
+void Deflate::flush_block(Data *d,bool final) {
+	/* incompressible data would grow with the fixed codes. thus, store the block instead, if
+	 * that is shorter and the bytes are still in the window. the header of a stored block
+	 * needs up to 7 bits for the alignment + 32 bits for the length */
+	size_t stored_bits = d->block_len * 8 + ((d->block_len + MAX_STORED - 1) / MAX_STORED) * 42;
+	if(d->block_start >= 0 && d->block_len > 0 && stored_bits < fixed_block_size(d))
+		stored_block(d,d->window + d->block_start,d->block_len,final);
+	else
+		fixed_block(d,final);
+
+	d->block_start += d->block_len;
+	d->block_len = 0;
+	d->symcount = 0;
+}
 
-void Deflate::deflate_fixed_block(Data *d) {
-	size_t len = d->source->cached();
-	size_t orglen = len;
-	while(len > 0) {
-		unsigned char sym = d->source->peek(0);
-
-		// first, check if we already had the now following byte-sequence
-		int x,maxlen = 0,max = 0;
-		// ensure that we don't look more than 29 bytes back and not past the block-start and our
-		// current position
-		int end = esc::Util::min((size_t)29,len);
-		int begin = -esc::Util::min((size_t)29,orglen - len);
-		for(x = begin; x < 0; ++x) {
-			// check how many bytes match
-			int y;
-			for(y = 0; x + y < 0 && y < end; ++y) {
-				if(d->source->peek(x + y) != d->source->peek(y))
-					break;
-			}
-			// if we reached the end, the last one didn't match
-			if(x + y >= 0 || y >= end)
-				y--;
-
-			// the longest so far?
-			if(y > maxlen) {
-				maxlen = y;
-				max = x;
-			}
+void Deflate::deflate_stored(Data *d) {
+	bool final;
+	do {
+		size_t length = read_fully(d,d->window,MAX_STORED);
+		final = length < MAX_STORED;
+		stored_block(d,d->window,length,final);
+	}
+	while(!final);
+}
+
+/* takes the longest match at each position, without looking at the next one */
+void Deflate::deflate_fast(Data *d) {
+	while(1) {
+		if(d->lookahead < MIN_LOOKAHEAD) {
+			fill_window(d);
+			if(d->lookahead == 0)
+				break;
 		}
 
-		// the smallest length we can encode is 3
-		if(maxlen >= 3) {
-			write_symbol_chain(d,&sltree,&sdtree,maxlen,-max);
-			x = maxlen;
+		size_t match_length = 0;
+		if(d->lookahead >= MIN_MATCH) {
+			int hash_head = insert_string(d,d->strstart);
+			if(hash_head != -1 && d->strstart - hash_head <= MAX_DIST)
+				match_length = longest_match(d,hash_head,MIN_MATCH - 1);
 		}
-		else {
-			// first write the symbol
-			write_symbol(d,&sltree,sym);
 
-			// now check if the symbol is following again at least 3 times
-			for(x = 1; x < end; ++x) {
-				if(d->source->peek(x) != sym)
-					break;
-			}
-			x--;
-			if(x == end)
-				x--;
+		if(match_length >= MIN_MATCH) {
+			tally_match(d,d->strstart - d->match_start,match_length);
+			d->lookahead -= match_length;
 
-			if(x >= 3) {
-				write_symbol_chain(d,&sltree,&sdtree,x,1);
-				x++;
+			/* insert the strings of short matches into the hash table */
+			if(match_length <= d->config->nice_length && d->lookahead >= MIN_MATCH) {
+				while(--match_length > 0)
+					insert_string(d,++d->strstart);
+				d->strstart++;
 			}
-			// adjust x to fetch one byte from source
 			else
-				x = 1;
+				d->strstart += match_length;
+		}
+		else {
+			tally_literal(d,d->window[d->strstart]);
+			d->lookahead--;
+			d->strstart++;
 		}
-
-		// fetch the bytes from source
-		len -= x;
-		while(x-- > 0)
-			d->source->get();
 	}
-
-	/* end of block */
-	write_symbol(d,&sltree,256);
 }
 
-void Deflate::deflate_uncompressed_block(Data *d) {
-	unsigned int length,invlength;
-	unsigned int i;
+/* only takes a match if there is no longer one at the next position */
+void Deflate::deflate_slow(Data *d) {
+	size_t match_length = MIN_MATCH - 1;
+	size_t prev_match;
+	bool match_available = false;
 
-	/* make sure we start next block on a byte boundary */
-	flush(d);
+	while(1) {
+		if(d->lookahead < MIN_LOOKAHEAD) {
+			fill_window(d);
+			if(d->lookahead == 0)
+				break;
+		}
 
-	/* get length */
-	length = d->source->cached();
-	invlength = ~length & 0x0000ffff;
-	assert(length <= 0xffff);
+		int hash_head = -1;
+		if(d->lookahead >= MIN_MATCH)
+			hash_head = insert_string(d,d->strstart);
+
+		/* find the longest match, discarding those <= prev_length */
+		size_t prev_length = match_length;
+		prev_match = d->match_start;
+		match_length = MIN_MATCH - 1;
+		if(hash_head != -1 && prev_length < d->config->max_lazy &&
+				d->strstart - hash_head <= MAX_DIST) {
+			match_length = longest_match(d,hash_head,prev_length);
+			if(match_length == MIN_MATCH && d->strstart - d->match_start > TOO_FAR)
+				match_length = MIN_MATCH - 1;
+		}
 
-	length = cputole16(length);
-	invlength = cputole16(invlength);
-	d->drain->put(length & 0xff);
-	d->drain->put(length >> 8);
-	d->drain->put(invlength & 0xff);
-	d->drain->put(invlength >> 8);
+		/* if there was a match at the previous position and the current one is not better,
+		 * output the previous match */
+		if(prev_length >= MIN_MATCH && match_length <= prev_length) {
+			size_t max_insert = d->strstart + d->lookahead - MIN_MATCH;
+			tally_match(d,d->strstart - 1 - prev_match,prev_length);
+
+			/* insert all strings of the match into the hash table. strstart-1 and strstart are
+			 * already inserted */
+			d->lookahead -= prev_length - 1;
+			prev_length -= 2;
+			do {
+				if(++d->strstart <= max_insert)
+					insert_string(d,d->strstart);
+			}
+			while(--prev_length != 0);
+			match_available = false;
+			match_length = MIN_MATCH - 1;
+			d->strstart++;
+		}
+		else if(match_available) {
+			/* the previous match was not taken, so output the single character */
+			tally_literal(d,d->window[d->strstart - 1]);
+			d->strstart++;
+			d->lookahead--;
+		}
+		else {
+			/* wait for the next step to decide */
+			match_available = true;
+			d->strstart++;
+			d->lookahead--;
+		}
+	}
 
-	/* copy block */
-	for(i = le16tocpu(length); i; --i)
-		d->drain->put(d->source->get());
+	if(match_available)
+		tally_literal(d,d->window[d->strstart - 1]);
 }
 
 /* ---------------------- *
@@ -191,60 +382,78 @@ void Deflate::deflate_uncompressed_block(Data *d) {
  * ---------------------- */
 
 Deflate::Deflate() : DeflateBase() {
-	/* init static length tree */
-	sltree.litbase[0] = 0;
-	sltree.length[0] = 8;
-	sltree.codebase[0] = 0x30;
-
-	sltree.litbase[1] = 144;
-	sltree.length[1] = 9;
-	sltree.codebase[1] = 0x190;
-
-	sltree.litbase[2] = 256;
-	sltree.length[2] = 7;
-	sltree.codebase[2] = 0;
-
-	sltree.litbase[3] = 280;
-	sltree.length[3] = 8;
-	sltree.codebase[3] = 0xC0;
-
-	/* init static distance tree */
-	sdtree.litbase[0] = 0;
-	sdtree.length[0] = 5;
-	sdtree.codebase[0] = 0;
-	// termination
-	sdtree.litbase[1] = 32;
-}
-
-int Deflate::compress(DeflateDrain *drain,DeflateSource *source,int compr) {
-	Data d;
-	d.source = source;
-	d.bitcount = 0;
-	d.tag = 0;
-	d.drain = drain;
-
-	while(source->more() || source->cached() > 0) {
-		/* final block? */
-		writebit(&d,source->more() ? 0 : 1);
-		/* compression type */
-		write_bits(&d,compr,2);
-
-		/* write data */
-		switch(compr) {
-			case NONE:
-				deflate_uncompressed_block(&d);
-				break;
-			case FIXED:
-				deflate_fixed_block(&d);
-				break;
-			case DYN:
-				// TODO deflate_dynamic_block(&d);
-				break;
+	/* build the fixed huffman codes (canonical codes of the lengths from rfc1951) */
+	static const struct {
+		unsigned int first,last,length,code;
+	} ranges[] = {
+		{0,		143,	8,	0x30},
+		{144,	255,	9,	0x190},
+		{256,	279,	7,	0x0},
+		{280,	287,	8,	0xC0},
+	};
+	for(size_t r = 0; r < ARRAY_SIZE(ranges); ++r) {
+		for(unsigned int i = ranges[r].first; i <= ranges[r].last; ++i) {
+			lit_lengths[i] = ranges[r].length;
+			lit_codes[i] = bit_reverse(ranges[r].code + i - ranges[r].first,ranges[r].length);
+		}
+	}
+	for(unsigned int i = 0; i < 30; ++i)
+		dist_codes[i] = bit_reverse(i,5);
+
+	/* build the tables to map lengths and distances to codes */
+	for(unsigned int code = 0; code < 29; ++code) {
+		for(unsigned int i = 0; i < (1U << length_bits[code]); ++i)
+			length_code[length_base[code] - MIN_MATCH + i] = code;
+	}
+	for(unsigned int code = 0; code < 30; ++code) {
+		if(code < 16) {
+			for(unsigned int i = 0; i < (1U << dist_bits[code]); ++i)
+				dist_code[dist_base[code] - 1 + i] = code;
+		}
+		else {
+			for(unsigned int i = 0; i < (1U << (dist_bits[code] - 7)); ++i)
+				dist_code[256 + ((dist_base[code] - 1) >> 7) + i] = code;
 		}
 	}
+}
+
+int Deflate::compress(DeflateDrain *drain,DeflateSource *source,int level) {
+	if(level < NONE || level > BEST)
+		return FAILED;
+
+	Data *d = new Data;
+	d->source = source;
+	d->drain = drain;
+	d->config = configs + level;
+	for(size_t i = 0; i < HASH_SIZE; ++i)
+		d->head[i] = -1;
+	for(size_t i = 0; i < WSIZE; ++i)
+		d->prev[i] = -1;
+	d->strstart = 0;
+	d->lookahead = 0;
+	d->match_start = 0;
+	d->eof = false;
+	d->symcount = 0;
+	d->block_start = 0;
+	d->block_len = 0;
+	d->tag = 0;
+	d->bitcount = 0;
+	d->outpos = 0;
+
+	if(level == NONE)
+		deflate_stored(d);
+	else {
+		if(d->config->max_lazy == 0)
+			deflate_fast(d);
+		else
+			deflate_slow(d);
+		flush_block(d,true);
+	}
 
-	flush(&d);
-	return 0;
+	flush_bits(d);
+	flush_output(d);
+	delete d;
+	return OK;
 }
 
 }
@@ -17,7 +17,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
-/* This is a slightly modified version of: */
+/* This is based on (the table-driven Huffman decoding and the buffered input are new): */
 
 /*
  * tinflate  -  tiny inflate
@@ -52,8 +52,10 @@
  *    any source distribution.
  */
 
+#include <esc/util.h>
 #include <sys/endian.h>
 #include <z/inflate.h>
+#include <string.h>
 
 namespace z {
 
@@ -64,128 +66,188 @@ const unsigned char Inflate::clcidx[] = {
 	14,1,15
 };
 
+static inline unsigned int bit_reverse(unsigned int v,unsigned int bits) {
+	v = ((v & 0xAAAA) >> 1) | ((v & 0x5555) << 1);
+	v = ((v & 0xCCCC) >> 2) | ((v & 0x3333) << 2);
+	v = ((v & 0xF0F0) >> 4) | ((v & 0x0F0F) << 4);
+	v = ((v & 0xFF00) >> 8) | ((v & 0x00FF) << 8);
+	return v >> (16 - bits);
+}
+
 /* ----------------------- *
  * -- utility functions -- *
  * ----------------------- */
 
 /* build the fixed huffman trees */
-void Inflate::build_fixed_trees(Tree *lt,Tree *dt) {
+void Inflate::build_fixed_trees(Huffman *lt,Huffman *dt) {
+	unsigned char lengths[288];
 	int i;
 
 	/* build fixed length tree */
-	for(i = 0; i < 7; ++i)
-		lt->table[i] = 0;
-
-	lt->table[7] = 24;
-	lt->table[8] = 152;
-	lt->table[9] = 112;
-
-	for(i = 0; i < 24; ++i)
-		lt->trans[i] = 256 + i;
 	for(i = 0; i < 144; ++i)
-		lt->trans[24 + i] = i;
-	for(i = 0; i < 8; ++i)
-		lt->trans[24 + 144 + i] = 280 + i;
-	for(i = 0; i < 112; ++i)
-		lt->trans[24 + 144 + 8 + i] = 144 + i;
+		lengths[i] = 8;
+	for(; i < 256; ++i)
+		lengths[i] = 9;
+	for(; i < 280; ++i)
+		lengths[i] = 7;
+	for(; i < 288; ++i)
+		lengths[i] = 8;
+	build_tree(lt,lengths,288);
 
 	/* build fixed distance tree */
-	for(i = 0; i < 5; ++i)
-		dt->table[i] = 0;
-
-	dt->table[5] = 32;
-
 	for(i = 0; i < 32; ++i)
-		dt->trans[i] = i;
+		lengths[i] = 5;
+	build_tree(dt,lengths,32);
 }
 
 /* given an array of code lengths, build a tree */
-void Inflate::build_tree(Tree *t,const unsigned char *lengths,unsigned int num) {
-	unsigned short offs[16];
-	unsigned int i,sum;
+bool Inflate::build_tree(Huffman *t,const unsigned char *lengths,unsigned int num) {
+	unsigned int next_code[16];
+	unsigned int sizes[16];
+	unsigned int i,code,k;
 
-	/* clear code length count table */
-	for(i = 0; i < 16; ++i)
-		t->table[i] = 0;
+	memset(t->fast,0,sizeof(t->fast));
 
-	/* scan symbol lengths,and sum code length counts */
+	/* count the number of codes for each length */
+	for(i = 0; i < 16; ++i)
+		sizes[i] = 0;
 	for(i = 0; i < num; ++i)
-		t->table[lengths[i]]++;
-
-	t->table[0] = 0;
-
-	/* compute offset table for distribution sort */
-	for(sum = 0,i = 0; i < 16; ++i) {
-		offs[i] = sum;
-		sum += t->table[i];
+		sizes[lengths[i]]++;
+	sizes[0] = 0;
+
+	/* determine the first code for each length (canonical huffman code) */
+	for(code = 0,k = 0,i = 1; i < 16; ++i) {
+		next_code[i] = code;
+		t->firstcode[i] = code;
+		t->firstsymbol[i] = k;
+		code += sizes[i];
+		/* over-subscribed? */
+		if(sizes[i] && code > (1U << i))
+			return false;
+		t->maxcode[i] = code << (16 - i);
+		code <<= 1;
+		k += sizes[i];
 	}
+	t->maxcode[16] = 0x10000;
 
-	/* create code->symbol translation table (symbols sorted by code) */
+	/* sort the symbols by code and put the short ones into the fast table */
 	for(i = 0; i < num; ++i) {
-		if(lengths[i])
-			t->trans[offs[lengths[i]]++] = i;
+		unsigned int len = lengths[i];
+		if(len) {
+			unsigned int idx = next_code[len] - t->firstcode[len] + t->firstsymbol[len];
+			t->size[idx] = len;
+			t->value[idx] = i;
+			if(len <= FAST_BITS) {
+				/* the code is read LSB first, so that all entries ending with it decode to it */
+				unsigned int j = bit_reverse(next_code[len],len);
+				while(j < (1 << FAST_BITS)) {
+					t->fast[j] = (len << 9) | i;
+					j += 1 << len;
+				}
+			}
+			next_code[len]++;
+		}
 	}
+	return true;
 }
 
 /* ---------------------- *
  * -- decode functions -- *
  * ---------------------- */
 
-/* get one bit from source stream */
-int Inflate::getbit(Data *d) {
-	unsigned int bit;
-
-	/* check if tag is empty */
-	if(!d->bitcount--) {
-		/* load next tag */
-		d->tag = d->source->get();
-		d->bitcount = 7;
+/* get the next byte from the source */
+uint8_t Inflate::next_byte(Data *d) {
+	if(EXPECT_FALSE(d->in == d->inend)) {
+		size_t count;
+		if(d->chunk)
+			d->source->consume(d->in - d->chunk);
+		d->chunk = d->in = d->source->chunk(&count);
+		if(count == 0) {
+			d->chunk = d->in = d->inend = NULL;
+			return d->source->get();
+		}
+		d->inend = d->in + count;
 	}
+	return *d->in++;
+}
 
-	/* shift bit out of tag */
-	bit = d->tag & 0x01;
-	d->tag >>= 1;
+/* fill the bit buffer from the current chunk. we never start a new chunk here to be able to
+ * give the unused bytes back to the source at the end (see finish) */
+inline void Inflate::refill(Data *d) {
+	while(d->bitcount <= 24 && d->in < d->inend) {
+		d->tag |= (uint32_t)*d->in++ << d->bitcount;
+		d->bitcount += 8;
+	}
+}
 
-	return bit;
+/* ensure that there are at least num bits in the bit buffer */
+inline void Inflate::need(Data *d,unsigned int num) {
+	refill(d);
+	while(d->bitcount < num) {
+		d->tag |= (uint32_t)next_byte(d) << d->bitcount;
+		d->bitcount += 8;
+	}
 }
 
 /* read a num bit value from a stream and add base */
 unsigned int Inflate::read_bits(Data *d,int num,int base) {
-	unsigned int val = 0;
-
-	/* read num bits */
-	if(num) {
-		unsigned int limit = 1 << (num);
-		unsigned int mask;
-
-		for(mask = 1; mask < limit; mask *= 2)
-			if(getbit(d)) val += mask;
-	}
+	if(num == 0)
+		return base;
 
+	need(d,num);
+	unsigned int val = d->tag & ((1U << num) - 1);
+	d->tag >>= num;
+	d->bitcount -= num;
 	return val + base;
 }
 
-/* given a data stream and a tree, decode a symbol */
-int Inflate::decode_symbol(Data *d,Tree *t) {
-	int sum = 0,cur = 0,len = 0;
+/* decode a symbol that is longer than FAST_BITS bits */
+int Inflate::decode_slow(Data *d,const Huffman *t,unsigned int *len) {
+	unsigned int s,k = bit_reverse(d->tag & 0xFFFF,16);
+	for(s = FAST_BITS + 1; k >= (unsigned int)t->maxcode[s]; ++s)
+		;
+	if(s >= 16)
+		return FAILED;
 
-	/* get more bits while code value is above sum */
-	do {
-		cur = 2 * cur + getbit(d);
+	unsigned int idx = (k >> (16 - s)) - t->firstcode[s] + t->firstsymbol[s];
+	if(idx >= 288 || t->size[idx] != s)
+		return FAILED;
+	*len = s;
+	return t->value[idx];
+}
 
-		++len;
+/* given a data stream and a tree, decode a symbol */
+int Inflate::decode_symbol(Data *d,const Huffman *t) {
+	refill(d);
+	while(1) {
+		unsigned int len;
+		int sym;
+		uint16_t e = t->fast[d->tag & ((1 << FAST_BITS) - 1)];
+		if(EXPECT_TRUE(e)) {
+			len = e >> 9;
+			sym = e & 0x1FF;
+		}
+		else
+			sym = decode_slow(d,t,&len);
+
+		/* the missing bits are zero. but since no code is a prefix of another code, a code that
+		 * fits into the available bits is always the correct one */
+		if(EXPECT_TRUE(sym >= 0 && len <= d->bitcount)) {
+			d->tag >>= len;
+			d->bitcount -= len;
+			return sym;
+		}
+		if(d->bitcount >= 16)
+			return FAILED;
 
-		sum += t->table[len];
-		cur -= t->table[len];
+		d->tag |= (uint32_t)next_byte(d) << d->bitcount;
+		d->bitcount += 8;
 	}
-	while(cur >= 0);
-
-	return t->trans[sum + cur];
 }
 
 /* given a data stream, decode dynamic trees from it */
-void Inflate::decode_trees(Data *d,Tree *lt,Tree *dt) {
-	Tree code_tree;
+int Inflate::decode_trees(Data *d,Huffman *lt,Huffman *dt) {
+	Huffman code_tree;
 	unsigned char lengths[288 + 32];
 	unsigned int hlit,hdist,hclen;
 	unsigned int i,num,length;
@@ -211,41 +273,71 @@ void Inflate::decode_trees(Data *d,Tree *lt,Tree *dt) {
 	}
 
 	/* build code length tree */
-	build_tree(&code_tree,lengths,19);
+	if(!build_tree(&code_tree,lengths,19))
+		return FAILED;
 
 	/* decode code lengths for the dynamic trees */
 	for(num = 0; num < hlit + hdist;) {
 		int sym = decode_symbol(d,&code_tree);
+		unsigned char val = 0;
 
 		switch(sym) {
 			case 16:
 				/* copy previous code length 3-6 times (read 2 bits) */
-				{
-					unsigned char prev = lengths[num - 1];
-					for(length = read_bits(d,2,3); length; --length)
-						lengths[num++] = prev;
-				}
+				if(num == 0)
+					return FAILED;
+				val = lengths[num - 1];
+				length = read_bits(d,2,3);
 				break;
 			case 17:
 				/* repeat code length 0 for 3-10 times (read 3 bits) */
-				for(length = read_bits(d,3,3); length; --length)
-					lengths[num++] = 0;
+				length = read_bits(d,3,3);
 				break;
 			case 18:
 				/* repeat code length 0 for 11-138 times (read 7 bits) */
-				for(length = read_bits(d,7,11); length; --length)
-					lengths[num++] = 0;
+				length = read_bits(d,7,11);
 				break;
 			default:
 				/* values 0-15 represent the actual code lengths */
-				lengths[num++] = sym;
+				if(sym < 0)
+					return FAILED;
+				val = sym;
+				length = 1;
 				break;
 		}
+
+		if(num + length > hlit + hdist)
+			return FAILED;
+		memset(lengths + num,val,length);
+		num += length;
 	}
 
 	/* build dynamic trees */
-	build_tree(lt,lengths,hlit);
-	build_tree(dt,lengths + hlit,hdist);
+	if(!build_tree(lt,lengths,hlit) || !build_tree(dt,lengths + hlit,hdist))
+		return FAILED;
+	return OK;
+}
+
+/* pass the collected literals to the drain */
+inline void Inflate::flush_literals(Data *d) {
+	if(d->litcount > 0) {
+		d->drain->write(d->lits,d->litcount);
+		d->litcount = 0;
+	}
+}
+
+/* give the unused input back to the source */
+void Inflate::finish(Data *d) {
+	flush_literals(d);
+
+	/* all whole bytes in the bit buffer have been taken from the current chunk (we only start a
+	 * new chunk if the bits of the previous one are not sufficient) */
+	if(d->chunk) {
+		d->in -= esc::Util::min((size_t)(d->in - d->chunk),(size_t)(d->bitcount / 8));
+		d->source->consume(d->in - d->chunk);
+	}
+	d->tag = 0;
+	d->bitcount = 0;
 }
 
 /* ----------------------------- *
@@ -253,33 +345,40 @@ void Inflate::decode_trees(Data *d,Tree *lt,Tree *dt) {
  * ----------------------------- */
 
 /* given a stream and two trees, inflate a block of data */
-int Inflate::inflate_block_data(Data *d,Tree *lt,Tree *dt) {
+int Inflate::inflate_block_data(Data *d,const Huffman *lt,const Huffman *dt) {
 	while(1) {
 		int sym = decode_symbol(d,lt);
 
+		if(sym < 256) {
+			if(EXPECT_FALSE(sym < 0))
+				return FAILED;
+			d->lits[d->litcount++] = sym;
+			if(EXPECT_FALSE(d->litcount == LIT_BUF_SIZE))
+				flush_literals(d);
+		}
 		/* check for end of block */
-		if(sym == 256)
+		else if(sym == 256)
 			return OK;
-
-		if(sym < 256)
-			d->drain->put(sym);
 		else {
 			int length,dist,offs;
-			int i;
 
 			sym -= 257;
+			if(sym >= 29)
+				return FAILED;
 
 			/* possibly get more bits from length code */
 			length = read_bits(d,length_bits[sym],length_base[sym]);
 
 			dist = decode_symbol(d,dt);
+			if(dist < 0 || dist >= 30)
+				return FAILED;
 
 			/* possibly get more bits from distance code */
 			offs = read_bits(d,dist_bits[dist],dist_base[dist]);
 
 			/* copy match */
-			for(i = 0; i < length; ++i)
-				d->drain->put(d->drain->get(offs));
+			flush_literals(d);
+			d->drain->copy(offs,length);
 		}
 	}
 }
@@ -287,27 +386,45 @@ int Inflate::inflate_block_data(Data *d,Tree *lt,Tree *dt) {
 /* inflate an uncompressed block of data */
 int Inflate::inflate_uncompressed_block(Data *d) {
 	unsigned int length,invlength;
-	unsigned int i;
+
+	/* start on a byte boundary */
+	d->tag >>= d->bitcount & 7;
+	d->bitcount &= ~7;
 
 	/* get length */
-	length = d->source->get();
-	length = length + 256 * d->source->get();
+	length = read_bits(d,16,0);
 
 	/* get one's complement of length */
-	invlength = d->source->get();
-	invlength = invlength + 256 * d->source->get();
+	invlength = read_bits(d,16,0);
 
 	/* check length */
 	if(length != (~invlength & 0x0000ffff))
 		return FAILED;
 
-	/* copy block */
-	for(i = length; i; --i)
-		d->drain->put(d->source->get());
+	flush_literals(d);
 
-	/* make sure we start next block on a byte boundary */
-	d->bitcount = 0;
+	/* the first bytes might still be in the bit buffer */
+	for(; length > 0 && d->bitcount > 0; --length) {
+		d->lits[d->litcount++] = d->tag & 0xFF;
+		d->tag >>= 8;
+		d->bitcount -= 8;
+	}
+	flush_literals(d);
+
+	/* copy the rest directly from the source */
+	while(length > 0) {
+		if(d->in == d->inend) {
+			d->lits[0] = next_byte(d);
+			d->drain->write(d->lits,1);
+			length--;
+			continue;
+		}
 
+		size_t amount = esc::Util::min((size_t)length,(size_t)(d->inend - d->in));
+		d->drain->write(d->in,amount);
+		d->in += amount;
+		length -= amount;
+	}
 	return OK;
 }
 
@@ -320,7 +437,8 @@ int Inflate::inflate_fixed_block(Data *d) {
 /* inflate a block of data compressed with dynamic huffman trees */
 int Inflate::inflate_dynamic_block(Data *d) {
 	/* decode trees from stream */
-	decode_trees(d,&d->ltree,&d->dtree);
+	if(decode_trees(d,&d->ltree,&d->dtree) != OK)
+		return FAILED;
 
 	/* decode block using decoded trees */
 	return inflate_block_data(d,&d->ltree,&d->dtree);
@@ -343,16 +461,19 @@ int Inflate::uncompress(InflateDrain *drain,InflateSource *source) {
 
 	/* initialise data */
 	d.source = source;
+	d.chunk = d.in = d.inend = NULL;
+	d.tag = 0;
 	d.bitcount = 0;
 
 	d.drain = drain;
+	d.litcount = 0;
 
 	do {
 		unsigned int btype;
 		int res;
 
 		/* read final block flag */
-		bfinal = getbit(&d);
+		bfinal = read_bits(&d,1,0);
 
 		/* read block type (2 bits) */
 		btype = read_bits(&d,2,0);
@@ -372,15 +493,18 @@ int Inflate::uncompress(InflateDrain *drain,InflateSource *source) {
 				res = inflate_dynamic_block(&d);
 				break;
 			default:
-				return FAILED;
+				res = FAILED;
+				break;
 		}
 
-		if(res != OK)
+		if(res != OK) {
+			finish(&d);
 			return FAILED;
-
+		}
 	}
 	while(!bfinal);
 
+	finish(&d);
 	return 0;
 }
 
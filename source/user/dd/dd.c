@@ -87,16 +87,32 @@ int main(int argc,char *argv[]) {
 		}
 
 		ssize_t result;
+		bool kernel = true;
 		ullong limit = (ullong)count * bs;
 		while(run && (!count || total < limit)) {
-			if((result = read(infd,shmem,bs)) <= 0) {
-				if(result < 0)
-					error("Read failed");
-				break;
+			/* let the kernel move the data from driver to driver, if possible */
+			if(kernel) {
+				result = copyrange(infd,outfd,shmem,bs);
+				if(result == -ENOTSUP) {
+					kernel = false;
+					continue;
+				}
+				if(result <= 0) {
+					if(result < 0)
+						error("Copy failed");
+					break;
+				}
 			}
+			else {
+				if((result = read(infd,shmem,bs)) <= 0) {
+					if(result < 0)
+						error("Read failed");
+					break;
+				}
 
-			if(write(outfd,shmem,result) < 0)
-				error("Write failed");
+				if(write(outfd,shmem,result) < 0)
+					error("Write failed");
+			}
 
 			total += result;
 		}
@@ -17,8 +17,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <sys/io.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,6 +33,7 @@ enum {
 };
 
 static const off_t BLOCK_SIZE = 1024;
+static const size_t DIRPLUS_SIZE = 16 * 1024;
 
 static uint flags = 0;
 
@@ -52,33 +55,84 @@ static void printsize(const char *path,off_t size) {
 		printf("%lu\t%s\n",size,path);
 }
 
-static off_t getsize(const char *path) {
-	struct stat info;
-	if(lstat(path,&info) < 0) {
-		printe("stat failed for '%s'",path);
+static bool isdots(const struct dirent *e) {
+	if(e->d_namelen == 1 && e->d_name[0] == '.')
+		return true;
+	return e->d_namelen == 2 && e->d_name[0] == '.' && e->d_name[1] == '.';
+}
+
+static off_t getsize(const char *path,const struct stat *info);
+
+static off_t getdirsize(const char *path) {
+	off_t total = 0;
+	int fd = open(path,O_RDONLY);
+	if(fd < 0) {
+		printe("open failed for '%s'",path);
 		return 0;
 	}
 
-	off_t total;
-	if(flags & FL_BYTES)
-		total = info.st_size;
-	else
-		total = (info.st_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	/* get the entries including their info in bulk, if possible */
+	ssize_t res = -ENOMEM;
+	char *buf = malloc(DIRPLUS_SIZE);
+	while(buf && (res = readdirplus(fd,buf,DIRPLUS_SIZE)) > 0) {
+		for(ssize_t off = 0; off < res; ) {
+			struct direntplus *e = (struct direntplus*)(buf + off);
+			off += e->d_ent.d_reclen;
+			if(isdots(&e->d_ent))
+				continue;
 
-	if(S_ISDIR(info.st_mode)) {
+			char fpath[MAX_PATH_LEN];
+			snprintf(fpath,sizeof(fpath),"%s/%s",path,e->d_ent.d_name);
+			total += getsize(fpath,e->d_stat.st_mode ? &e->d_stat : NULL);
+		}
+	}
+	free(buf);
+	close(fd);
+
+	/* otherwise stat them one by one */
+	if(res == -ENOTSUP) {
 		DIR *d = opendir(path);
+		if(!d) {
+			printe("opendir failed for '%s'",path);
+			return total;
+		}
+
 		struct dirent *e;
 		while((e = readdir(d))) {
-			if(e->d_namelen == 1 && e->d_name[0] == '.')
-				continue;
-			if(e->d_namelen == 2 && e->d_name[0] == '.' && e->d_name[1] == '.')
+			if(isdots(e))
 				continue;
 
 			char fpath[MAX_PATH_LEN];
 			snprintf(fpath,sizeof(fpath),"%s/%s",path,e->d_name);
-			total += getsize(fpath);
+			total += getsize(fpath,NULL);
 		}
 		closedir(d);
+	}
+	else if(res < 0) {
+		errno = res;
+		printe("readdirplus failed for '%s'",path);
+	}
+	return total;
+}
+
+static off_t getsize(const char *path,const struct stat *info) {
+	struct stat tmp;
+	if(info == NULL) {
+		if(lstat(path,&tmp) < 0) {
+			printe("stat failed for '%s'",path);
+			return 0;
+		}
+		info = &tmp;
+	}
+
+	off_t total;
+	if(flags & FL_BYTES)
+		total = info->st_size;
+	else
+		total = (info->st_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	if(S_ISDIR(info->st_mode)) {
+		total += getdirsize(path);
 
 		if(!(flags & FL_SUMMARY))
 			printsize(path,total);
@@ -111,7 +165,7 @@ int main(int argc,char **argv) {
 	off_t total = 0;
 
 	for(int i = optind; i < argc; ++i) {
-		off_t size = getsize(argv[i]);
+		off_t size = getsize(argv[i],NULL);
 		if(flags & FL_SUMMARY)
 			printsize(argv[i],size);
 		total += size;
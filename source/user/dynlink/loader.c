@@ -33,6 +33,7 @@
 #define LIB_PATH	"/lib/"
 
 static void load_library(sSharedLib *dst);
+static void load_initGnuHash(sSharedLib *l);
 static sSharedLib *load_addLib(sSharedLib *lib);
 static uintptr_t load_addSeg(int binFd,sElfPHeader *pheader,size_t loadSegNo,bool isLib);
 static void load_read(int binFd,off_t offset,void *buffer,size_t count);
@@ -169,6 +170,7 @@ uintptr_t load_addSegments(void) {
 			l->dynstrtbl = (char*)((uintptr_t)l->dynstrtbl + l->loadAddr);
 		if(l->hashTbl)
 			l->hashTbl = (ElfWord*)((uintptr_t)l->hashTbl + l->loadAddr);
+		load_initGnuHash(l);
 		if(l->dynsyms)
 			l->dynsyms = (sElfSym*)((uintptr_t)l->dynsyms + l->loadAddr);
 		if(l->jmprel)
@@ -177,6 +179,26 @@ uintptr_t load_addSegments(void) {
 	return entryPoint;
 }
 
+static void load_initGnuHash(sSharedLib *l) {
+	ElfWord *tbl = (ElfWord*)load_getDyn(l->dyn,DT_GNU_HASH);
+	l->gnuBuckets = NULL;
+	if(tbl == NULL)
+		return;
+
+	/* the table consists of a header, the bloom-filter, the buckets and the hash-chains */
+	tbl = (ElfWord*)((uintptr_t)tbl + l->loadAddr);
+	l->gnuNBuckets = tbl[0];
+	l->gnuSymOffset = tbl[1];
+	l->gnuBloomMask = tbl[2] - 1;
+	l->gnuBloomShift = tbl[3];
+	l->gnuBloom = (ElfAddr*)(tbl + 4);
+	l->gnuBuckets = (ElfWord*)(l->gnuBloom + tbl[2]);
+	l->gnuChain = l->gnuBuckets + l->gnuNBuckets;
+	/* an empty table or an invalid bloom-filter size is useless */
+	if(l->gnuNBuckets == 0 || tbl[2] == 0 || (tbl[2] & (tbl[2] - 1)))
+		l->gnuBuckets = NULL;
+}
+
 static void load_library(sSharedLib *dst) {
 	char path[MAX_PATH_LEN];
 	int fd;
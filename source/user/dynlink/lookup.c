@@ -27,9 +27,41 @@
 #include "loader.h"
 #include "lookup.h"
 
-static sElfSym *lookup_byNameIntern(sSharedLib *lib,const char *name,uint32_t hash);
+/* the initial number of entries in the symbol cache; has to be a power of 2 */
+#define CACHE_INIT_SIZE		256
+
+typedef struct {
+	const char *name;
+	uint32_t gnuHash;
+	uint32_t hash;
+	bool hasHash;
+} sSymKey;
+
+typedef struct {
+	const char *name;
+	uint32_t hash;
+	sSharedLib *lib;
+	sElfSym *sym;
+} sCacheEntry;
+
+static sElfSym *lookup_search(sSharedLib *start,sSymKey *key,sSharedLib **lib);
+static sElfSym *lookup_byNameIntern(sSharedLib *lib,sSymKey *key);
+static sElfSym *lookup_byGnuHash(sSharedLib *lib,const sSymKey *key);
+static sElfSym *lookup_byHash(sSharedLib *lib,sSymKey *key);
+static sCacheEntry *lookup_cacheFind(const sSymKey *key);
+static void lookup_cacheInsert(const sSymKey *key,sSharedLib *lib,sElfSym *sym);
+static void lookup_initKey(sSymKey *key,const char *name);
+static uint32_t lookup_getGnuHash(const uint8_t *name);
 static uint32_t lookup_getHash(const uint8_t *name);
 
+/* caches the library that defines a symbol first, i.e., the result of lookup_byName(NULL,...).
+ * it is only filled while we're single-threaded. afterwards it is read-only, so that lazy binding
+ * can use it from multiple threads without a lock */
+static sCacheEntry *cache = NULL;
+static size_t cacheSize = 0;
+static size_t cacheCount = 0;
+static bool cacheFrozen = false;
+
 #if defined(CALLTRACE_PID)
 static int pid = -1;
 static int depth = 0;
@@ -107,44 +139,164 @@ void lookup_tracePop(void) {
 #endif
 
 sElfSym *lookup_byName(sSharedLib *skip,const char *name,uintptr_t *value) {
+	sSharedLib *lib;
 	sElfSym *s;
-	uint32_t hash = lookup_getHash((const uint8_t*)name);
-	for(sSharedLib *l = libs; l != NULL; l = l->next) {
-		if(l == skip)
-			continue;
-		s = lookup_byNameIntern(l,name,hash);
-		if(s) {
-			*value = s->st_value + l->loadAddr;
-			return s;
-		}
+	sSymKey key;
+	lookup_initKey(&key,name);
+
+	sCacheEntry *e = lookup_cacheFind(&key);
+	if(e) {
+		lib = e->lib;
+		s = e->sym;
 	}
-	return NULL;
+	else {
+		s = lookup_search(libs,&key,&lib);
+		if(s && !cacheFrozen)
+			lookup_cacheInsert(&key,lib,s);
+	}
+
+	/* if the first definition is in the library to skip, the next one after it is the result */
+	if(s && lib == skip)
+		s = lookup_search(skip->next,&key,&lib);
+	if(s)
+		*value = s->st_value + lib->loadAddr;
+	return s;
+}
+
+void lookup_freezeCache(void) {
+	cacheFrozen = true;
 }
 
 sElfSym *lookup_byNameIn(sSharedLib *lib,const char *name,uintptr_t *value) {
-	uint32_t hash = lookup_getHash((const uint8_t*)name);
-	sElfSym *sym = lookup_byNameIntern(lib,name,hash);
+	sSymKey key;
+	lookup_initKey(&key,name);
+	sElfSym *sym = lookup_byNameIntern(lib,&key);
 	if(sym)
 		*value = sym->st_value + lib->loadAddr;
 	return sym;
 }
 
-static sElfSym *lookup_byNameIntern(sSharedLib *lib,const char *name,uint32_t hash) {
+static sElfSym *lookup_search(sSharedLib *start,sSymKey *key,sSharedLib **lib) {
+	for(sSharedLib *l = start; l != NULL; l = l->next) {
+		sElfSym *s = lookup_byNameIntern(l,key);
+		if(s) {
+			*lib = l;
+			return s;
+		}
+	}
+	return NULL;
+}
+
+static sElfSym *lookup_byNameIntern(sSharedLib *lib,sSymKey *key) {
+	if(lib->gnuBuckets)
+		return lookup_byGnuHash(lib,key);
+	return lookup_byHash(lib,key);
+}
+
+static sElfSym *lookup_byGnuHash(sSharedLib *lib,const sSymKey *key) {
+	const size_t bits = sizeof(ElfAddr) * 8;
+	uint32_t hash = key->gnuHash;
+
+	/* the bloom-filter tells us quickly whether the symbol is not in this library */
+	ElfAddr word = lib->gnuBloom[(hash / bits) & lib->gnuBloomMask];
+	ElfAddr mask = ((ElfAddr)1 << (hash % bits)) |
+		((ElfAddr)1 << ((hash >> lib->gnuBloomShift) % bits));
+	if((word & mask) != mask)
+		return NULL;
+
+	ElfWord symindex = lib->gnuBuckets[hash % lib->gnuNBuckets];
+	if(symindex == STN_UNDEF)
+		return NULL;
+
+	/* the chain contains the hashes of all symbols in this bucket; the lowest bit marks the end */
+	const ElfWord *chain = lib->gnuChain + (symindex - lib->gnuSymOffset);
+	for(; ; symindex++, chain++) {
+		if(((*chain ^ hash) >> 1) == 0) {
+			sElfSym *sym = lib->dynsyms + symindex;
+			if(sym->st_shndx != STN_UNDEF && strcmp(key->name,lib->dynstrtbl + sym->st_name) == 0)
+				return sym;
+		}
+		if(*chain & 1)
+			break;
+	}
+	return NULL;
+}
+
+static sElfSym *lookup_byHash(sSharedLib *lib,sSymKey *key) {
 	ElfWord nhash;
 	ElfWord symindex;
 	sElfSym *sym;
 	if(lib->hashTbl == NULL || (nhash = lib->hashTbl[0]) == 0)
 		return NULL;
-	symindex = lib->hashTbl[(hash % nhash) + 2];
+	if(!key->hasHash) {
+		key->hash = lookup_getHash((const uint8_t*)key->name);
+		key->hasHash = true;
+	}
+	symindex = lib->hashTbl[(key->hash % nhash) + 2];
 	while(symindex != STN_UNDEF) {
 		sym = lib->dynsyms + symindex;
-		if(sym->st_shndx != STN_UNDEF && strcmp(name,lib->dynstrtbl + sym->st_name) == 0)
+		if(sym->st_shndx != STN_UNDEF && strcmp(key->name,lib->dynstrtbl + sym->st_name) == 0)
 			return sym;
 		symindex = lib->hashTbl[2 + nhash + symindex];
 	}
 	return NULL;
 }
 
+static sCacheEntry *lookup_cacheFind(const sSymKey *key) {
+	if(cacheSize == 0)
+		return NULL;
+	for(size_t i = key->gnuHash & (cacheSize - 1); cache[i].name; i = (i + 1) & (cacheSize - 1)) {
+		if(cache[i].hash == key->gnuHash && strcmp(cache[i].name,key->name) == 0)
+			return cache + i;
+	}
+	return NULL;
+}
+
+static void lookup_cacheInsert(const sSymKey *key,sSharedLib *lib,sElfSym *sym) {
+	/* keep the load below 3/4 */
+	if((cacheCount + 1) * 4 > cacheSize * 3) {
+		size_t nsize = cacheSize ? cacheSize * 2 : CACHE_INIT_SIZE;
+		sCacheEntry *ncache = (sCacheEntry*)calloc(nsize,sizeof(sCacheEntry));
+		/* the cache is just an optimization */
+		if(!ncache)
+			return;
+		for(size_t i = 0; i < cacheSize; ++i) {
+			if(cache[i].name) {
+				size_t j = cache[i].hash & (nsize - 1);
+				while(ncache[j].name)
+					j = (j + 1) & (nsize - 1);
+				ncache[j] = cache[i];
+			}
+		}
+		free(cache);
+		cache = ncache;
+		cacheSize = nsize;
+	}
+
+	size_t i = key->gnuHash & (cacheSize - 1);
+	while(cache[i].name)
+		i = (i + 1) & (cacheSize - 1);
+	/* the name points into the string-table of a loaded library, which stays valid */
+	cache[i].name = key->name;
+	cache[i].hash = key->gnuHash;
+	cache[i].lib = lib;
+	cache[i].sym = sym;
+	cacheCount++;
+}
+
+static void lookup_initKey(sSymKey *key,const char *name) {
+	key->name = name;
+	key->gnuHash = lookup_getGnuHash((const uint8_t*)name);
+	key->hasHash = false;
+}
+
+static uint32_t lookup_getGnuHash(const uint8_t *name) {
+	uint32_t h = 5381;
+	while(*name)
+		h = (h << 5) + h + *name++;
+	return h;
+}
+
 static uint32_t lookup_getHash(const uint8_t *name) {
 	uint32_t h = 0,g;
 	while(*name) {
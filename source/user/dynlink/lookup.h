@@ -55,7 +55,8 @@ A_REGPARM(0) uintptr_t lookup_resolve(SavedRegs regs,sSharedLib *lib,size_t offs
 #endif
 
 /**
- * Resolves a symbol by name
+ * Resolves a symbol by name. The results are cached, so that subsequent lookups of the same
+ * symbol don't have to search the libraries again.
  *
  * @param skip the library to skip (don't search for symbols in it)
  * @param name the name of the symbol
@@ -64,6 +65,12 @@ A_REGPARM(0) uintptr_t lookup_resolve(SavedRegs regs,sSharedLib *lib,size_t offs
  */
 sElfSym *lookup_byName(sSharedLib *skip,const char *name,uintptr_t *value);
 
+/**
+ * Stops adding symbols to the cache. Has to be called before other threads might exist, because
+ * the cache is not protected by a lock.
+ */
+void lookup_freezeCache(void);
+
 /**
  * Resolves a symbol by name in the given library
  *
@@ -69,11 +69,6 @@ ElfDynVal load_getDyn(sElfDyn *dyn,ElfDynTag tag) {
 
 void load_initHeap(void) {
 	initHeap();
-#ifndef NDEBUG
-	/* allocate a lot of memory at the beginning to make the beginning of shared libraries more
-	 * predictable */
-	free(malloc(MAX_MEM));
-#endif
 }
 
 #if defined(__i586__)
@@ -118,6 +113,8 @@ uintptr_t load_setupProg(int binFd,int argc,char **argv) {
 
 	/* relocate everything we need so that the program can start */
 	load_reloc();
+	/* constructors might create threads, which would resolve symbols concurrently */
+	lookup_freezeCache();
 
 	/* call global constructors */
 	load_init(argc,argv);
@@ -33,8 +33,6 @@
 #	define DBGDL(x,...)
 #endif
 
-#define MAX_MEM			(1024 * 64)
-
 typedef struct sSharedLib sSharedLib;
 
 typedef struct sDep {
@@ -51,6 +49,14 @@ struct sSharedLib {
 	size_t textSize;
 	sElfDyn *dyn;
 	ElfWord *hashTbl;
+	/* the GNU-style hash table, if present (gnuBuckets is NULL otherwise) */
+	ElfWord gnuNBuckets;
+	ElfWord gnuSymOffset;
+	ElfWord gnuBloomMask;
+	ElfWord gnuBloomShift;
+	ElfAddr *gnuBloom;
+	ElfWord *gnuBuckets;
+	ElfWord *gnuChain;
 	uint jmprelType;
 	sElfRel *jmprel;
 	sElfSym *dynsyms;
@@ -30,7 +30,7 @@
 
 using namespace esc;
 
-static int compr = z::Deflate::FIXED;
+static int compr = z::Deflate::DEFAULT;
 static int tostdout = false;
 static int keep = false;
 
@@ -75,7 +75,7 @@ static void compress(IStream &is,const std::string &filename) {
 static void usage(const char *name) {
 	serr << "Usage: " << name << " [-c] [-l <level>] [-k] [<file>...]\n";
 	serr << "  -c: write to stdout\n";
-	serr << "  -l: the compression type (0=none, 1=fixed, 2=dyn)\n";
+	serr << "  -l: the compression level (0=none, 1=fastest .. 9=best)\n";
 	serr << "  -k: keep the original files, don't delete them\n";
 	serr << "  If no file is given or <file> is '-', stdin is compressed to stdout.\n";
 	exit(EXIT_FAILURE);
@@ -90,7 +90,7 @@ int main(int argc,char **argv) {
 			case 'k': keep = true; break;
 			case 'l':
 				compr = atoi(optarg);
-				if(compr != z::Deflate::NONE && compr != z::Deflate::FIXED && compr != z::Deflate::DYN)
+				if(compr < z::Deflate::NONE || compr > z::Deflate::BEST)
 					usage(argv[0]);
 				break;
 			default:
@@ -0,0 +1,205 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <esc/stream/std.h>
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/ktrace.h>
+#include <algorithm>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *typeNames[] = {
+	/* KTRACE_SCHED */		"sched",
+	/* KTRACE_MSG_SEND */	"send",
+	/* KTRACE_MSG_RECV */	"recv",
+	/* KTRACE_PAGEFAULT */	"pagefault",
+	/* KTRACE_LOCK */		"lock",
+};
+
+static void usage(const char *name) {
+	esc::serr << "Usage: " << name << " [-e <types>] [-d] [-l]\n";
+	esc::serr << "  -e: enable the given comma-separated tracepoints (";
+	for(size_t i = 0; i < ARRAY_SIZE(typeNames); ++i)
+		esc::serr << typeNames[i] << ", ";
+	esc::serr << "all)\n";
+	esc::serr << "  -d: disable all tracepoints\n";
+	esc::serr << "  -l: print the spinlock contention statistics\n";
+	esc::serr << "Without options, the recorded events are printed.\n";
+	exit(EXIT_FAILURE);
+}
+
+static uint parseTypes(char *list) {
+	uint mask = 0;
+	for(char *name = strtok(list,","); name; name = strtok(NULL,",")) {
+		if(strcmp(name,"all") == 0) {
+			mask |= KTRACE_ALL;
+			continue;
+		}
+
+		size_t i;
+		for(i = 0; i < ARRAY_SIZE(typeNames); ++i) {
+			if(strcmp(name,typeNames[i]) == 0)
+				break;
+		}
+		if(i == ARRAY_SIZE(typeNames))
+			exitmsg("Unknown tracepoint '" << name << "'");
+		mask |= 1 << i;
+	}
+	return mask;
+}
+
+static void setMask(uint mask) {
+	int fd = open(KTRACE_PATH,O_WRONLY);
+	if(fd < 0)
+		exitmsg("Unable to open " << KTRACE_PATH << " for writing");
+
+	char str[16];
+	int len = snprintf(str,sizeof(str),"%#x",mask);
+	if(write(fd,str,len) != len)
+		exitmsg("Unable to write to " << KTRACE_PATH);
+	close(fd);
+}
+
+static void printLockStats() {
+	int fd = open(LOCKSTAT_PATH,O_RDONLY);
+	if(fd < 0)
+		exitmsg("Unable to open " << LOCKSTAT_PATH);
+
+	char buf[512];
+	ssize_t res;
+	while((res = read(fd,buf,sizeof(buf))) > 0)
+		esc::sout.write(buf,res);
+	close(fd);
+}
+
+static char *readTrace(ssize_t *size) {
+	int fd = open(KTRACE_PATH,O_RDONLY);
+	if(fd < 0)
+		exitmsg("Unable to open " << KTRACE_PATH);
+
+	/* the snapshot is created for every read. thus, read it at once and retry with a larger
+	 * buffer if it was not sufficient */
+	size_t bufSize = 64 * 1024;
+	char *buf;
+	while(1) {
+		buf = new char[bufSize];
+		*size = read(fd,buf,bufSize);
+		if(*size < 0)
+			exitmsg("Unable to read " << KTRACE_PATH);
+		if((size_t)*size < bufSize)
+			break;
+
+		delete[] buf;
+		bufSize *= 2;
+		if(seek(fd,0,SEEK_SET) < 0)
+			exitmsg("Unable to seek in " << KTRACE_PATH);
+	}
+	close(fd);
+	return buf;
+}
+
+static void printEvents() {
+	ssize_t size;
+	char *buf = readTrace(&size);
+	const struct ktrace_hdr *hdr = reinterpret_cast<const struct ktrace_hdr*>(buf);
+	if((size_t)size < sizeof(struct ktrace_hdr) || hdr->version != KTRACE_VERSION ||
+			hdr->eventSize < sizeof(struct ktrace_event) ||
+			(size_t)size < hdr->hdrSize + hdr->eventCount * hdr->eventSize)
+		exitmsg("Invalid or unsupported trace in " << KTRACE_PATH);
+
+	/* the kernel provides the events per CPU; merge them into one timeline */
+	struct ktrace_event *events = new struct ktrace_event[hdr->eventCount];
+	for(size_t i = 0; i < hdr->eventCount; ++i)
+		memcpy(events + i,buf + hdr->hdrSize + i * hdr->eventSize,sizeof(struct ktrace_event));
+	std::sort(events,events + hdr->eventCount,
+		[](const struct ktrace_event &a,const struct ktrace_event &b) {
+			return a.tsc < b.tsc;
+	});
+
+	esc::sout << "Mask: " << esc::fmt(hdr->mask,"#x") << ", CPUs: " << hdr->cpuCount;
+	esc::sout << ", events: " << hdr->eventCount << ", lost: " << hdr->lost << "\n";
+	esc::sout << esc::fmt("Cycles","-",14) << " " << esc::fmt("CPU","-",3) << " ";
+	esc::sout << esc::fmt("TID","-",5) << " " << esc::fmt("PID","-",5) << " ";
+	esc::sout << esc::fmt("Type","-",9) << " Arguments\n";
+
+	uint64_t start = hdr->eventCount > 0 ? events[0].tsc : 0;
+	for(size_t i = 0; i < hdr->eventCount; ++i) {
+		const struct ktrace_event *ev = events + i;
+		esc::sout << esc::fmt(ev->tsc - start,14) << " " << esc::fmt(ev->cpu,3) << " ";
+		esc::sout << esc::fmt(ev->tid,5) << " " << esc::fmt(ev->pid,5) << " ";
+		if(ev->type < ARRAY_SIZE(typeNames))
+			esc::sout << esc::fmt(typeNames[ev->type],"-",9);
+		else
+			esc::sout << esc::fmt(ev->type,"-",9);
+
+		switch(ev->type) {
+			case KTRACE_SCHED:
+				esc::sout << " " << ev->args[0] << " -> " << ev->args[1];
+				break;
+			case KTRACE_MSG_SEND:
+			case KTRACE_MSG_RECV:
+				esc::sout << " msg=" << (ev->args[0] & 0xFFFF) << " len=" << ev->args[1];
+				esc::sout << " chan=" << ev->args[2];
+				break;
+			case KTRACE_PAGEFAULT:
+				esc::sout << " addr=" << esc::fmt(ev->args[0],"#0x",8);
+				esc::sout << (ev->args[1] ? " write" : " read");
+				break;
+			case KTRACE_LOCK:
+				esc::sout << " site=" << esc::fmt(ev->args[0],"#0x",8);
+				esc::sout << " wait=" << ev->args[1];
+				break;
+		}
+		esc::sout << "\n";
+	}
+
+	delete[] events;
+	delete[] buf;
+}
+
+int main(int argc,char **argv) {
+	bool disable = false;
+	bool lockStats = false;
+	char *enable = NULL;
+
+	int opt;
+	while((opt = getopt(argc,argv,"e:dl")) != -1) {
+		switch(opt) {
+			case 'e': enable = optarg; break;
+			case 'd': disable = true; break;
+			case 'l': lockStats = true; break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if(optind < argc || (enable && disable))
+		usage(argv[0]);
+
+	if(enable)
+		setMask(parseTypes(enable));
+	else if(disable)
+		setMask(0);
+	else if(lockStats)
+		printLockStats();
+	else
+		printEvents();
+	return 0;
+}
@@ -42,6 +42,8 @@ static void test_includes(void);
 static void test_minmax(void);
 static void test_lexcompare(void);
 static void test_sort(void);
+static void test_sort_large(void);
+static void test_stable_sort(void);
 
 static void check_content(const list<int> &l,size_t count,...) {
 	va_list ap;
@@ -73,6 +75,8 @@ static void test_algo(void) {
 	test_minmax();
 	test_lexcompare();
 	test_sort();
+	test_sort_large();
+	test_stable_sort();
 }
 
 static void test_find(void) {
@@ -432,3 +436,63 @@ static void test_sort(void) {
 
 	test_caseSucceeded();
 }
+
+static void test_sort_large(void) {
+	test_caseStart("Testing sort with large inputs");
+
+	const size_t count = 5000;
+	vector<int> v(count);
+	for(int mode = 0; mode < 4; ++mode) {
+		for(size_t i = 0; i < count; ++i) {
+			switch(mode) {
+				case 0: v[i] = rand(); break;
+				case 1: v[i] = i; break;
+				case 2: v[i] = count - i; break;
+				case 3: v[i] = i % 3; break;
+			}
+		}
+		std::sort(v.begin(),v.end());
+		for(size_t i = 1; i < count; ++i)
+			test_assertTrue(v[i - 1] <= v[i]);
+	}
+
+	test_caseSucceeded();
+}
+
+struct KeyVal {
+	int key;
+	int val;
+
+	bool operator<(const KeyVal &o) const {
+		return key < o.key;
+	}
+};
+
+static void test_stable_sort(void) {
+	test_caseStart("Testing stable_sort");
+
+	{
+		int ints[] = {3,1,2};
+		std::stable_sort(ints,ints + ARRAY_SIZE(ints));
+		test_assertInt(ints[0],1);
+		test_assertInt(ints[1],2);
+		test_assertInt(ints[2],3);
+	}
+
+	{
+		const size_t count = 1000;
+		vector<KeyVal> v(count);
+		for(size_t i = 0; i < count; ++i) {
+			v[i].key = rand() % 10;
+			v[i].val = i;
+		}
+		std::stable_sort(v.begin(),v.end());
+		for(size_t i = 1; i < count; ++i) {
+			test_assertTrue(v[i - 1].key <= v[i].key);
+			if(v[i - 1].key == v[i].key)
+				test_assertTrue(v[i - 1].val < v[i].val);
+		}
+	}
+
+	test_caseSucceeded();
+}
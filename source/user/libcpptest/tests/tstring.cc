@@ -26,6 +26,9 @@ using namespace std;
 /* forward declarations */
 static void test_string(void);
 static void test_constr(void);
+static void test_sso(void);
+static void test_move(void);
+static void test_swap(void);
 static void test_iterators(void);
 static void test_assign(void);
 static void test_resize(void);
@@ -42,6 +45,9 @@ static void test_find_first_not_of(void);
 static void test_find_last_not_of(void);
 static void test_trim(void);
 
+static const char *shortStr = "012345678901234";
+static const char *longStr = "0123456789012345";
+
 /* our test-module */
 sTestModule tModString = {
 	"String",
@@ -50,6 +56,9 @@ sTestModule tModString = {
 
 static void test_string(void) {
 	test_constr();
+	test_sso();
+	test_move();
+	test_swap();
 	test_iterators();
 	test_assign();
 	test_resize();
@@ -123,6 +132,152 @@ static void test_constr(void) {
 	test_caseSucceeded();
 }
 
+static bool is_inline(const string &s) {
+	const char *obj = reinterpret_cast<const char*>(&s);
+	return s.c_str() >= obj && s.c_str() < obj + sizeof(s);
+}
+
+static void test_sso(void) {
+	test_caseStart("Testing small string optimization");
+
+	{
+		string s(shortStr);
+		test_assertStr(s.c_str(),shortStr);
+		test_assertSize(s.length(),15);
+		test_assertTrue(is_inline(s));
+	}
+	{
+		string s(longStr);
+		test_assertStr(s.c_str(),longStr);
+		test_assertSize(s.length(),16);
+		test_assertFalse(is_inline(s));
+	}
+	{
+		string s(shortStr);
+		s += 'x';
+		test_assertStr(s.c_str(),"012345678901234x");
+		test_assertFalse(is_inline(s));
+		s.resize(15);
+		test_assertStr(s.c_str(),shortStr);
+	}
+	{
+		string s1(longStr);
+		string s2(s1);
+		test_assertStr(s2.c_str(),longStr);
+		test_assertTrue(s1.c_str() != s2.c_str());
+		string s3(shortStr);
+		string s4(s3);
+		test_assertStr(s4.c_str(),shortStr);
+		test_assertTrue(is_inline(s4));
+	}
+
+	test_caseSucceeded();
+}
+
+static void test_move(void) {
+	test_caseStart("Testing move and self-assignment");
+
+	{
+		string s1(shortStr);
+		string s2(std::move(s1));
+		test_assertStr(s2.c_str(),shortStr);
+		test_assertTrue(is_inline(s2));
+		test_assertStr(s1.c_str(),"");
+		test_assertSize(s1.length(),0);
+	}
+	{
+		string s1(longStr);
+		const char *buf = s1.c_str();
+		string s2(std::move(s1));
+		test_assertStr(s2.c_str(),longStr);
+		test_assertPtr(s2.c_str(),buf);
+		test_assertStr(s1.c_str(),"");
+		test_assertTrue(is_inline(s1));
+	}
+	{
+		string s1(shortStr);
+		string s2(longStr);
+		s2 = std::move(s1);
+		test_assertStr(s2.c_str(),shortStr);
+		test_assertTrue(is_inline(s2));
+		test_assertStr(s1.c_str(),"");
+	}
+	{
+		string s1(longStr);
+		string s2(shortStr);
+		s2 = std::move(s1);
+		test_assertStr(s2.c_str(),longStr);
+		test_assertFalse(is_inline(s2));
+		test_assertStr(s1.c_str(),"");
+	}
+	{
+		string s1(shortStr);
+		string &ref1 = s1;
+		s1 = ref1;
+		test_assertStr(s1.c_str(),shortStr);
+		s1 = std::move(ref1);
+		test_assertStr(s1.c_str(),shortStr);
+
+		string s2(longStr);
+		string &ref2 = s2;
+		s2 = ref2;
+		test_assertStr(s2.c_str(),longStr);
+		s2 = std::move(ref2);
+		test_assertStr(s2.c_str(),longStr);
+	}
+
+	test_caseSucceeded();
+}
+
+static void test_swap(void) {
+	test_caseStart("Testing swap()");
+
+	{
+		string s1(shortStr);
+		string s2("abc");
+		s1.swap(s2);
+		test_assertStr(s1.c_str(),"abc");
+		test_assertStr(s2.c_str(),shortStr);
+		test_assertTrue(is_inline(s1));
+		test_assertTrue(is_inline(s2));
+	}
+	{
+		string s1(shortStr);
+		string s2(longStr);
+		s1.swap(s2);
+		test_assertStr(s1.c_str(),longStr);
+		test_assertStr(s2.c_str(),shortStr);
+		test_assertFalse(is_inline(s1));
+		test_assertTrue(is_inline(s2));
+		s1.swap(s2);
+		test_assertStr(s1.c_str(),shortStr);
+		test_assertStr(s2.c_str(),longStr);
+		test_assertTrue(is_inline(s1));
+		test_assertFalse(is_inline(s2));
+	}
+	{
+		string s1(longStr);
+		string s2("a different string on the heap");
+		const char *buf1 = s1.c_str();
+		const char *buf2 = s2.c_str();
+		swap(s1,s2);
+		test_assertStr(s1.c_str(),"a different string on the heap");
+		test_assertStr(s2.c_str(),longStr);
+		test_assertPtr(s1.c_str(),buf2);
+		test_assertPtr(s2.c_str(),buf1);
+	}
+	{
+		string s1(shortStr);
+		s1.swap(s1);
+		test_assertStr(s1.c_str(),shortStr);
+		string s2(longStr);
+		s2.swap(s2);
+		test_assertStr(s2.c_str(),longStr);
+	}
+
+	test_caseSucceeded();
+}
+
 static void test_iterators(void) {
 	test_caseStart("Testing iterators");
 
@@ -201,6 +356,18 @@ static void test_clear(void) {
 	test_assertStr(s1.c_str(),"");
 	test_assertSize(s1.length(),0);
 
+	string s2("a string that is stored on the heap");
+	string::size_type cap = s2.capacity();
+	const char *buf = s2.c_str();
+	s2.clear();
+	test_assertStr(s2.c_str(),"");
+	test_assertSize(s2.length(),0);
+	test_assertSize(s2.capacity(),cap);
+	test_assertPtr(s2.c_str(),buf);
+	s2 = "foo";
+	test_assertStr(s2.c_str(),"foo");
+	test_assertPtr(s2.c_str(),buf);
+
 	test_caseSucceeded();
 }
 
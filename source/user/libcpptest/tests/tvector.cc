@@ -20,6 +20,7 @@
 #include <sys/common.h>
 #include <sys/test.h>
 #include <stdlib.h>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -33,6 +34,8 @@ static void test_insert(void);
 static void test_at(void);
 static void test_erase(void);
 static void test_nonpod(void);
+static void test_strings(void);
+static void test_emplace(void);
 
 /* our test-module */
 sTestModule tModVector = {
@@ -48,6 +51,8 @@ static void test_vector(void) {
 	test_at();
 	test_erase();
 	test_nonpod();
+	test_strings();
+	test_emplace();
 }
 
 static void test_constr(void) {
@@ -338,3 +343,107 @@ static void test_nonpod(void) {
 
 	test_caseSucceeded();
 }
+
+static void assert_strings(const vector<string> &v,const char **exp,size_t count) {
+	test_assertSize(v.size(),count);
+	for(size_t i = 0; i < count; ++i)
+		test_assertStr(v[i].c_str(),exp[i]);
+}
+
+static void test_strings(void) {
+	test_caseStart("Testing insert() and erase() with strings");
+
+	size_t before = heapspace();
+
+	{
+		vector<string> v;
+		v.push_back("a string that is stored on the heap");
+		v.push_back("b");
+		v.push_back("c");
+
+		v.insert(v.begin(),string("first"));
+		v.insert(v.begin() + 2,string("another string that is stored on the heap"));
+		v.insert(v.end(),string("last"));
+		const char *exp1[] = {
+			"first","a string that is stored on the heap",
+			"another string that is stored on the heap","b","c","last"
+		};
+		assert_strings(v,exp1,ARRAY_SIZE(exp1));
+
+		// insert an element of the vector itself, which might be moved during the insert
+		v.insert(v.begin(),v[1]);
+		v.insert(v.begin(),(size_t)2,v[3]);
+		const char *exp2[] = {
+			"another string that is stored on the heap",
+			"another string that is stored on the heap",
+			"a string that is stored on the heap",
+			"first","a string that is stored on the heap",
+			"another string that is stored on the heap","b","c","last"
+		};
+		assert_strings(v,exp2,ARRAY_SIZE(exp2));
+
+		v.erase(v.begin());
+		v.erase(v.begin() + 1,v.begin() + 4);
+		v.erase(v.end() - 1);
+		const char *exp3[] = {
+			"another string that is stored on the heap",
+			"another string that is stored on the heap","b","c"
+		};
+		assert_strings(v,exp3,ARRAY_SIZE(exp3));
+
+		v.erase(v.begin(),v.end());
+		test_assertSize(v.size(),0);
+	}
+
+	size_t after = heapspace();
+	test_assertTrue(after >= before);
+
+	test_caseSucceeded();
+}
+
+static void test_emplace(void) {
+	test_caseStart("Testing emplace_back()");
+
+	size_t before = heapspace();
+
+	{
+		vector<NonPOD> v;
+		for(int i = 1; i <= 10; ++i)
+			v.emplace_back(i);
+		test_assertSize(v.size(),10);
+		test_assertUInt(counter,10);
+		v.clear();
+		test_assertUInt(counter,0);
+	}
+
+	{
+		vector<string> v;
+		v.emplace_back("a string that is stored on the heap");
+		v.emplace_back((size_t)3,'x');
+		v.emplace_back();
+		const char *exp1[] = {"a string that is stored on the heap","xxx",""};
+		assert_strings(v,exp1,ARRAY_SIZE(exp1));
+
+		// the argument refers to an element of the vector, which has to survive the growth
+		while(v.size() < v.capacity())
+			v.emplace_back();
+		size_t size = v.size();
+		v.emplace_back(v[0]);
+		test_assertSize(v.size(),size + 1);
+		test_assertStr(v[size].c_str(),"a string that is stored on the heap");
+
+		while(v.size() < v.capacity())
+			v.emplace_back();
+		size = v.size();
+		v.emplace_back(v[1],1);
+		test_assertSize(v.size(),size + 1);
+		test_assertStr(v[size].c_str(),"xx");
+		for(size_t i = 0; i < ARRAY_SIZE(exp1); ++i)
+			test_assertStr(v[i].c_str(),exp1[i]);
+	}
+
+	size_t after = heapspace();
+	test_assertTrue(after >= before);
+
+	test_caseSucceeded();
+}
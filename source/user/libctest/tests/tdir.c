@@ -18,6 +18,7 @@
  */
 
 #include <sys/common.h>
+#include <sys/io.h>
 #include <sys/stat.h>
 #include <sys/test.h>
 #include <dirent.h>
@@ -29,6 +30,7 @@
 /* forward declarations */
 static void test_dir(void);
 static void test_opendir(void);
+static void test_readdirplus(void);
 static void test_canonpath(void);
 static void test_abspath(void);
 static void test_basename(void);
@@ -42,6 +44,7 @@ sTestModule tModDir = {
 
 static void test_dir(void) {
 	test_opendir();
+	test_readdirplus();
 	test_canonpath();
 	test_abspath();
 	test_basename();
@@ -65,6 +68,42 @@ static void test_opendir(void) {
 	test_caseSucceeded();
 }
 
+static void test_readdirplus(void) {
+	static char buf[1024];
+	size_t count = 0;
+	ssize_t res;
+	int fd;
+	test_caseStart("Testing readdirplus");
+
+	fd = open("/bin",O_RDONLY);
+	if(fd < 0) {
+		test_caseFailed("Unable to open '/bin'");
+		return;
+	}
+
+	/* use a small buffer to get multiple requests */
+	while((res = readdirplus(fd,buf,sizeof(buf))) > 0) {
+		ssize_t off;
+		for(off = 0; off < res; ) {
+			struct direntplus *e = (struct direntplus*)(buf + off);
+			char path[MAX_PATH_LEN];
+			struct stat info;
+			snprintf(path,sizeof(path),"/bin/%s",e->d_ent.d_name);
+			test_assertInt(lstat(path,&info),0);
+			test_assertUInt(e->d_stat.st_ino,info.st_ino);
+			test_assertUInt(e->d_stat.st_mode,info.st_mode);
+			test_assertOff(e->d_stat.st_size,info.st_size);
+			off += e->d_ent.d_reclen;
+			count++;
+		}
+	}
+	test_assertSSize(res,0);
+	test_assertTrue(count > 2);
+	close(fd);
+
+	test_caseSucceeded();
+}
+
 static void test_canonpath(void) {
 	char path[MAX_PATH_LEN];
 	size_t count;
@@ -35,6 +35,7 @@ static void test_heap_t1v3(void);
 static void test_heap_t1v4(void);
 static void test_heap_t2(void);
 static void test_heap_t3(void);
+static void test_heap_t4(void);
 
 /* our test-module */
 sTestModule tModHeap = {
@@ -59,6 +60,7 @@ static void test_heap(void) {
 		&test_heap_t1v4,
 		&test_heap_t2,
 		&test_heap_t3,
+		&test_heap_t4,
 	};
 
 	size_t i;
@@ -197,3 +199,24 @@ static void test_heap_t3(void) {
 	}
 	test_check();
 }
+
+/* large allocations are mapped separately */
+static void test_heap_t4(void) {
+	sHeapStats before,after;
+	size_t size;
+	test_init("Allocate and free large areas");
+	heapstats(&before);
+	for(size = 0; size < ARRAY_SIZE(ptrs); size++) {
+		ptrs[size] = (uint*)malloc((size + 1) * 64 * 1024);
+		*(ptrs[size]) = 1;
+		*(ptrs[size] + (size + 1) * 16 * 1024 - 1) = 2;
+	}
+	heapstats(&after);
+	test_assertSize(after.largeCount,before.largeCount + ARRAY_SIZE(ptrs));
+	for(size = 0; size < ARRAY_SIZE(ptrs); size++)
+		free(ptrs[size]);
+	heapstats(&after);
+	test_assertSize(after.largeCount,before.largeCount);
+	test_assertSize(after.largeBytes,before.largeBytes);
+	test_check();
+}
@@ -28,6 +28,7 @@ extern sTestModule tModDList;
 extern sTestModule tModTreap;
 extern sTestModule tModStream;
 extern sTestModule tModRegex;
+extern sTestModule tModDNS;
 
 int main() {
 	test_register(&tModRBuffer);
@@ -37,6 +38,7 @@ int main() {
 	test_register(&tModTreap);
 	test_register(&tModStream);
 	test_register(&tModRegex);
+	test_register(&tModDNS);
 	test_start();
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,170 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <esc/dns.h>
+#include <sys/common.h>
+#include <sys/endian.h>
+#include <sys/test.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* forward declarations */
+static void test_dns();
+static void test_query();
+static void test_answer();
+static void test_negative();
+static void test_malformed();
+static void test_foreign();
+
+/* our test-module */
+sTestModule tModDNS = {
+	"DNS",
+	&test_dns
+};
+
+static void test_dns() {
+	test_query();
+	test_answer();
+	test_negative();
+	test_malformed();
+	test_foreign();
+}
+
+static size_t putRecord(uint8_t *buf,uint16_t type,uint32_t ttl,const uint8_t *rdata,uint16_t len) {
+	/* name is a pointer to the question */
+	buf[0] = 0xC0;
+	buf[1] = 0x0C;
+	uint16_t vals[] = {cputobe16(type),cputobe16(1)};
+	memcpy(buf + 2,vals,sizeof(vals));
+	uint32_t bettl = cputobe32(ttl);
+	memcpy(buf + 6,&bettl,sizeof(bettl));
+	uint16_t belen = cputobe16(len);
+	memcpy(buf + 10,&belen,sizeof(belen));
+	memcpy(buf + 12,rdata,len);
+	return 12 + len;
+}
+
+static void setCounts(uint8_t *buf,uint16_t flags,uint16_t an,uint16_t ns) {
+	uint16_t vals[] = {cputobe16(flags),cputobe16(1),cputobe16(an),cputobe16(ns)};
+	memcpy(buf + 2,vals,sizeof(vals));
+}
+
+static size_t buildAnswer(uint8_t *buf) {
+	static const uint8_t cname[] = {0xC0,0x0C};
+	static const uint8_t ip[] = {10,0,2,3};
+	size_t len = esc::DNS::buildQuery(buf,0x1234,"www.example.com");
+	setCounts(buf,0x8180,2,0);
+	len += putRecord(buf + len,5,300,cname,sizeof(cname));
+	len += putRecord(buf + len,1,120,ip,sizeof(ip));
+	return len;
+}
+
+static void test_query() {
+	uint8_t buf[esc::DNS::MAX_MSG_SIZE];
+	test_caseStart("Building a query");
+
+	size_t len = esc::DNS::buildQuery(buf,0x1234,"www.example.com");
+	test_assertSize(len,12 + 17 + 4);
+	test_assertUInt(buf[0],0x12);
+	test_assertUInt(buf[1],0x34);
+	test_assertUInt(buf[12],3);
+	test_assertTrue(memcmp(buf + 13,"www",3) == 0);
+	test_assertUInt(buf[16],7);
+	test_assertUInt(buf[24],3);
+	test_assertUInt(buf[28],0);
+
+	test_caseSucceeded();
+}
+
+static void test_answer() {
+	uint8_t buf[esc::DNS::MAX_MSG_SIZE];
+	test_caseStart("Parsing an answer with CNAME");
+
+	size_t len = buildAnswer(buf);
+	uint32_t ttl;
+	esc::Net::IPv4Addr addr;
+	test_assertInt(esc::DNS::getTxId(buf,len),0x1234);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"www.example.com",&addr,&ttl),0);
+	test_assertUInt(addr.value(),esc::Net::IPv4Addr(10,0,2,3).value());
+	test_assertUInt(ttl,120);
+
+	test_caseSucceeded();
+}
+
+static void test_negative() {
+	uint8_t buf[esc::DNS::MAX_MSG_SIZE];
+	test_caseStart("Parsing a negative answer");
+
+	/* mname, rname, serial, refresh, retry, expire, minimum */
+	uint8_t soa[24] = {0xC0,0x0C,0xC0,0x0C};
+	uint32_t min = cputobe32(30);
+	memcpy(soa + 20,&min,sizeof(min));
+
+	size_t len = esc::DNS::buildQuery(buf,0x4321,"nothing.example.com");
+	setCounts(buf,0x8183,0,1);
+	len += putRecord(buf + len,6,900,soa,sizeof(soa));
+
+	uint32_t ttl;
+	esc::Net::IPv4Addr addr;
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x4321,"nothing.example.com",&addr,&ttl),
+		-EHOSTNOTFOUND);
+	test_assertUInt(ttl,30);
+
+	test_caseSucceeded();
+}
+
+static void test_malformed() {
+	uint8_t buf[esc::DNS::MAX_MSG_SIZE];
+	test_caseStart("Parsing a truncated answer");
+
+	size_t len = buildAnswer(buf);
+	uint32_t ttl;
+	esc::Net::IPv4Addr addr;
+	test_assertInt(esc::DNS::parseResponse(buf,len - 2,0x1234,"www.example.com",&addr,&ttl),
+		-EHOSTNOTFOUND);
+	test_assertUInt(ttl,0);
+	test_assertInt(esc::DNS::getTxId(buf,6),-EINVAL);
+	test_assertInt(esc::DNS::parseResponse(buf,6,0x1234,"www.example.com",&addr,&ttl),-EINVAL);
+	test_assertUInt(ttl,0);
+
+	test_caseSucceeded();
+}
+
+static void test_foreign() {
+	uint8_t buf[esc::DNS::MAX_MSG_SIZE];
+	test_caseStart("Ignoring responses to other queries");
+
+	size_t len = buildAnswer(buf);
+	uint32_t ttl;
+	esc::Net::IPv4Addr addr;
+	/* the name is compared case-insensitively */
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"WWW.Example.COM",&addr,&ttl),0);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1235,"www.example.com",&addr,&ttl),-EINVAL);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"www.example.org",&addr,&ttl),-EINVAL);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"www.example",&addr,&ttl),-EINVAL);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"www.example.com.au",&addr,&ttl),
+		-EINVAL);
+	test_assertUInt(ttl,0);
+
+	/* a query is no response */
+	setCounts(buf,0x0100,2,0);
+	test_assertInt(esc::DNS::parseResponse(buf,len,0x1234,"www.example.com",&addr,&ttl),-EINVAL);
+
+	test_caseSucceeded();
+}
@@ -0,0 +1,148 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <gui/graphics/pixelformat.h>
+#include <sys/common.h>
+#include <sys/test.h>
+#include <string.h>
+
+using namespace gui;
+
+static void test_pixelformat(void);
+static void test_fill(void);
+static void test_glyph(void);
+static void test_blend(void);
+
+/* our test-module */
+sTestModule tModPixelFormat = {
+	"PixelFormat",
+	&test_pixelformat
+};
+
+static esc::Screen::Mode makeMode(uchar bpp) {
+	esc::Screen::Mode mode;
+	memclear(&mode,sizeof(mode));
+	mode.bitsPerPixel = bpp;
+	if(bpp == 16) {
+		mode.redMaskSize = 5;
+		mode.redFieldPosition = 11;
+		mode.greenMaskSize = 6;
+		mode.greenFieldPosition = 5;
+		mode.blueMaskSize = 5;
+		mode.blueFieldPosition = 0;
+	}
+	else {
+		mode.redMaskSize = 8;
+		mode.redFieldPosition = 16;
+		mode.greenMaskSize = 8;
+		mode.greenFieldPosition = 8;
+		mode.blueMaskSize = 8;
+		mode.blueFieldPosition = 0;
+	}
+	return mode;
+}
+
+static uint32_t getPixel(const uint8_t *buf,size_t bytespp,size_t idx) {
+	uint32_t val = 0;
+	memcpy(&val,buf + idx * bytespp,bytespp);
+	return val;
+}
+
+static void test_pixelformat(void) {
+	test_fill();
+	test_glyph();
+	test_blend();
+}
+
+static void test_fill(void) {
+	static const uchar depths[] = {16,24,32};
+	uint8_t buf[64 * 4 + 16];
+
+	test_caseStart("Testing fillSpan");
+	for(size_t d = 0; d < ARRAY_SIZE(depths); ++d) {
+		PixelFormat *fmt = PixelFormat::create(makeMode(depths[d]));
+		size_t bytespp = fmt->getBytesPerPixel();
+		uint32_t col = fmt->fromColor(Color(0x12,0x34,0x56));
+
+		/* try all combinations of start and length to hit every alignment */
+		for(size_t start = 0; start < 5; ++start) {
+			for(size_t count = 0; count < 40; ++count) {
+				memset(buf,0xAB,sizeof(buf));
+				fmt->fillSpan(buf + start * bytespp,count,col);
+				for(size_t i = 0; i < start; ++i)
+					test_assertUInt(getPixel(buf,bytespp,i),0xABABABAB & ((1ULL << (bytespp * 8)) - 1));
+				for(size_t i = start; i < start + count; ++i)
+					test_assertUInt(getPixel(buf,bytespp,i),col);
+				test_assertUInt(getPixel(buf,bytespp,start + count),
+					0xABABABAB & ((1ULL << (bytespp * 8)) - 1));
+			}
+		}
+		delete fmt;
+	}
+	test_caseSucceeded();
+}
+
+static void test_glyph(void) {
+	static const uint8_t glyph[] = {0x81,0x42,0x3C};
+	uint32_t buf[3][8];
+
+	test_caseStart("Testing drawGlyph");
+	PixelFormat *fmt = PixelFormat::create(makeMode(32));
+	memclear(buf,sizeof(buf));
+	fmt->drawGlyph(reinterpret_cast<uint8_t*>(buf),sizeof(buf[0]),glyph,0,0,8,3,0xFFFFFF);
+	for(size_t y = 0; y < 3; ++y) {
+		for(size_t x = 0; x < 8; ++x)
+			test_assertUInt(buf[y][x],(glyph[y] & (0x80 >> x)) ? 0xFFFFFF : 0);
+	}
+
+	/* only a part of it */
+	memclear(buf,sizeof(buf));
+	fmt->drawGlyph(reinterpret_cast<uint8_t*>(buf),sizeof(buf[0]),glyph,4,1,8,2,0xFFFFFF);
+	test_assertUInt(buf[0][0],0);
+	test_assertUInt(buf[1][1],0);
+	test_assertUInt(buf[1][6],0xFFFFFF);
+	test_assertUInt(buf[2][4],0);
+	delete fmt;
+	test_caseSucceeded();
+}
+
+static void test_blend(void) {
+	static const uchar depths[] = {16,24,32};
+
+	test_caseStart("Testing blendSpan");
+	for(size_t d = 0; d < ARRAY_SIZE(depths); ++d) {
+		uint8_t buf[4 * 4];
+		PixelFormat *fmt = PixelFormat::create(makeMode(depths[d]));
+		size_t bytespp = fmt->getBytesPerPixel();
+		uint32_t white = fmt->fromColor(Color(0xFF,0xFF,0xFF));
+		fmt->fillSpan(buf,4,white);
+
+		/* opaque, transparent and half transparent black */
+		const uint32_t src[] = {0x00000000,0xFF000000,0x80000000,0x00FF0000};
+		fmt->blendSpan(buf,src,ARRAY_SIZE(src));
+		test_assertUInt(getPixel(buf,bytespp,0),fmt->fromColor(Color(0,0,0)));
+		test_assertUInt(getPixel(buf,bytespp,1),white);
+		Color half = fmt->toColor(getPixel(buf,bytespp,2));
+		test_assertTrue(half.getRed() >= 0x70 && half.getRed() <= 0x88);
+		test_assertTrue(half.getGreen() >= 0x70 && half.getGreen() <= 0x88);
+		test_assertUInt(getPixel(buf,bytespp,3),fmt->fromColor(Color(0xFF,0,0)));
+		delete fmt;
+	}
+	test_caseSucceeded();
+}
@@ -344,13 +344,16 @@ static vector<lsfile*> getEntries(const string& path) {
 	try {
 		file dir(path);
 		if(dir.is_dir()) {
-			vector<struct dirent> files = dir.list_files(flags & F_ALL);
+			vector<pair<string,default_error>> errors;
+			vector<file> files = dir.list_entries(flags & F_ALL,string(),&errors);
+			for(auto it = errors.begin(); it != errors.end(); ++it)
+				printe("Skipping '%s/%s': %s",path.c_str(),it->first.c_str(),it->second.what());
 			for(auto it = files.begin(); it != files.end(); ++it) {
 				try {
-					res.push_back(buildFile(file(path,std::string(it->d_name),O_NOCHAN | O_NOFOLLOW)));
+					res.push_back(buildFile(*it));
 				}
 				catch(const exception &e) {
-					printe("Skipping '%s/%s': %s",path.c_str(),it->d_name,e.what());
+					printe("Skipping '%s/%s': %s",path.c_str(),it->name().c_str(),e.what());
 				}
 			}
 		}
@@ -380,10 +383,9 @@ static lsfile* buildFile(const file& f) {
 
 static file::size_type getDirSize(const file& d) {
 	file::size_type res = 0;
-	string path = d.path();
-	vector<struct dirent> files = d.list_files((flags & F_ALL) != 0);
+	vector<file> files = d.list_entries((flags & F_ALL) != 0);
 	for(auto it = files.begin(); it != files.end(); ++it) {
-		file f(path,std::string(it->d_name));
+		const file &f = *it;
 		if(f.is_dir()) {
 			string name = f.name();
 			if(name != "." && name != "..")
@@ -17,8 +17,16 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <esc/stream/fstream.h>
 #include <esc/stream/std.h>
+#include <sys/common.h>
+#include <sys/conf.h>
+#include <sys/proc.h>
+#include <sys/thread.h>
+#include <algorithm>
+#include <ctype.h>
 #include <getopt.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
@@ -27,27 +35,324 @@
 using namespace std;
 using namespace esc;
 
-static bool compareStrs(const string& a,const string& b);
+/* the default number of bytes of lines we keep in memory before we write a run to disk */
+static const size_t DEF_RUN_SIZE = 8 * 1024 * 1024;
+/* the maximum number of runs that are merged at once */
+static const size_t MAX_MERGE = 16;
+
+static bool figncase = false;
+static bool freverse = false;
+static int keyStart = 0;
+static int keyEnd = 0;
+static int separator = -1;
+
+/**
+ * A line with its precomputed sort key. Without -i, the key is a part of the line. With -i, it is
+ * stored in lowercase in <folded>.
+ */
+struct Line {
+	explicit Line() : str(), folded(), keyOff(), keyLen() {
+	}
+
+	const char *key() const {
+		return figncase ? folded.c_str() : str.c_str() + keyOff;
+	}
+	size_t keyLength() const {
+		return figncase ? folded.length() : keyLen;
+	}
+	size_t memSize() const {
+		return sizeof(Line) + str.length() + folded.length();
+	}
+
+	void init() {
+		keyOff = 0;
+		keyLen = str.length();
+		if(keyStart > 0)
+			findKey();
+		if(figncase) {
+			folded.resize(keyLen);
+			for(size_t i = 0; i < keyLen; ++i)
+				folded[i] = tolower(str[keyOff + i]);
+		}
+	}
+
+	string str;
+	string folded;
+	size_t keyOff;
+	size_t keyLen;
+
+private:
+	size_t fieldStart(size_t pos,int field) const {
+		const char *s = str.c_str();
+		size_t len = str.length();
+		for(int i = 1; i < field && pos < len; ++i) {
+			if(separator != -1) {
+				while(pos < len && s[pos] != separator)
+					pos++;
+				if(pos < len)
+					pos++;
+			}
+			else {
+				while(pos < len && isblank(s[pos]))
+					pos++;
+				while(pos < len && !isblank(s[pos]))
+					pos++;
+			}
+		}
+		return pos;
+	}
+
+	size_t fieldEnd(size_t pos) const {
+		const char *s = str.c_str();
+		size_t len = str.length();
+		if(separator != -1) {
+			while(pos < len && s[pos] != separator)
+				pos++;
+		}
+		else {
+			while(pos < len && isblank(s[pos]))
+				pos++;
+			while(pos < len && !isblank(s[pos]))
+				pos++;
+		}
+		return pos;
+	}
+
+	void findKey() {
+		keyOff = fieldStart(0,keyStart);
+		size_t end = str.length();
+		if(keyEnd >= keyStart)
+			end = fieldEnd(fieldStart(keyOff,keyEnd - keyStart + 1));
+		keyLen = end - keyOff;
+	}
+};
+
+static int compareLines(const Line &a,const Line &b) {
+	size_t alen = a.keyLength();
+	size_t blen = b.keyLength();
+	int res = memcmp(a.key(),b.key(),min(alen,blen));
+	if(res == 0)
+		res = alen < blen ? -1 : (alen > blen ? 1 : 0);
+	return freverse ? -res : res;
+}
+
+static bool lessThan(const Line &a,const Line &b) {
+	return compareLines(a,b) < 0;
+}
+
+static bool readLine(IStream &is,Line &line) {
+	is.getline(line.str);
+	if(line.str.empty() && is.bad())
+		return false;
+	line.init();
+	return true;
+}
+
+/**
+ * A sorted sequence of lines, either in memory or in a temporary file.
+ */
+class Run {
+public:
+	virtual ~Run() {
+	}
+
+	/**
+	 * @return the current line or NULL if there are no lines left
+	 */
+	virtual const Line *current() const = 0;
+	/**
+	 * Moves to the next line
+	 */
+	virtual void next() = 0;
+};
+
+class MemRun : public Run {
+public:
+	explicit MemRun(vector<Line>::iterator begin,vector<Line>::iterator end)
+		: Run(), _cur(begin), _end(end) {
+	}
+
+	virtual const Line *current() const {
+		return _cur != _end ? &*_cur : NULL;
+	}
+	virtual void next() {
+		++_cur;
+	}
+
+private:
+	vector<Line>::iterator _cur;
+	vector<Line>::iterator _end;
+};
+
+class FileRun : public Run {
+public:
+	explicit FileRun(const string &path)
+		: Run(), _path(path), _file(new FStream(path.c_str(),"r")), _line(), _valid() {
+		if(!_file->good())
+			exitmsg("Unable to open '" << path << "'");
+		next();
+	}
+	virtual ~FileRun() {
+		delete _file;
+		if(unlink(_path.c_str()) < 0)
+			errmsg("Unable to unlink '" << _path << "'");
+	}
+
+	virtual const Line *current() const {
+		return _valid ? &_line : NULL;
+	}
+	virtual void next() {
+		_valid = readLine(*_file,_line);
+	}
+
+private:
+	string _path;
+	FStream *_file;
+	Line _line;
+	bool _valid;
+};
+
+/**
+ * Merges the given runs into <os>. The runs are kept in a heap, ordered by their current line.
+ */
+static void mergeRuns(vector<Run*> &runs,OStream &os) {
+	vector<Run*> heap;
+	for(auto it = runs.begin(); it != runs.end(); ++it) {
+		if((*it)->current())
+			heap.push_back(*it);
+	}
+
+	// the heap has the largest element first; thus, invert the comparison
+	auto greater = [](Run *a,Run *b) {
+		return lessThan(*b->current(),*a->current());
+	};
+	make_heap(heap.begin(),heap.end(),greater);
+
+	while(!heap.empty()) {
+		pop_heap(heap.begin(),heap.end(),greater);
+		Run *run = heap.back();
+		os << run->current()->str << '\n';
+		if(os.bad())
+			exitmsg("Write failed");
+
+		run->next();
+		if(run->current())
+			push_heap(heap.begin(),heap.end(),greater);
+		else
+			heap.pop_back();
+	}
+}
+
+struct SortChunk {
+	vector<Line>::iterator begin;
+	vector<Line>::iterator end;
+};
+
+static int sortThread(void *arg) {
+	SortChunk *chunk = (SortChunk*)arg;
+	std::sort(chunk->begin,chunk->end,lessThan);
+	return 0;
+}
+
+/**
+ * Sorts <lines> by <threads> threads in parallel and appends a MemRun for each chunk to <runs>.
+ */
+static void sortLines(vector<Line> &lines,size_t threads,vector<Run*> &runs) {
+	if(threads > lines.size() / 1024 + 1)
+		threads = lines.size() / 1024 + 1;
+
+	SortChunk *chunks = new SortChunk[threads];
+	int *tids = new int[threads];
+	size_t per = lines.size() / threads;
+	for(size_t i = 0; i < threads; ++i) {
+		chunks[i].begin = lines.begin() + i * per;
+		chunks[i].end = i == threads - 1 ? lines.end() : chunks[i].begin + per;
+		tids[i] = -1;
+		if(i > 0 && (tids[i] = startthread(sortThread,chunks + i)) < 0)
+			sortThread(chunks + i);
+	}
+	sortThread(chunks);
+	for(size_t i = 1; i < threads; ++i) {
+		if(tids[i] >= 0)
+			join(tids[i]);
+	}
+
+	for(size_t i = 0; i < threads; ++i)
+		runs.push_back(new MemRun(chunks[i].begin,chunks[i].end));
+	delete[] tids;
+	delete[] chunks;
+}
+
+static void deleteRuns(vector<Run*> &runs) {
+	for(auto it = runs.begin(); it != runs.end(); ++it)
+		delete *it;
+	runs.clear();
+}
+
+static string tempName() {
+	static size_t no = 0;
+	char path[64];
+	snprintf(path,sizeof(path),"/tmp/sort-%d-%zu",getpid(),no++);
+	return path;
+}
+
+/**
+ * Merges <runs> into a new temporary file and returns its path.
+ */
+static string writeRun(vector<Run*> &runs) {
+	string path = tempName();
+	{
+		FStream out(path.c_str(),"w");
+		if(!out.good())
+			exitmsg("Unable to create '" << path << "'");
+		mergeRuns(runs,out);
+	}
+	deleteRuns(runs);
+	return path;
+}
+
 static void usage(const char *name) {
-	serr << "Usage: " << name << " [-r] [-i] [<file>]" << '\n';
+	serr << "Usage: " << name << " [-r] [-i] [-k <start>[,<end>]] [-t <sep>] [-j <threads>]";
+	serr << " [-S <bytes>] [<file>]" << '\n';
 	serr << "    -r: reverse; i.e. descending instead of ascending" << '\n';
 	serr << "    -i: ignore case" << '\n';
+	serr << "    -k: sort by the fields <start> to <end> (1-based; to the end of line by default)" << '\n';
+	serr << "    -t: use <sep> as field separator instead of blanks" << '\n';
+	serr << "    -j: use <threads> threads (default: number of CPUs)" << '\n';
+	serr << "    -S: keep up to <bytes> in memory before using temporary files" << '\n';
 	exit(EXIT_FAILURE);
 }
 
-static int figncase = 0;
-static int freverse = 0;
-
 int main(int argc,char *argv[]) {
+	size_t runSize = DEF_RUN_SIZE;
+	long threads = sysconf(CONF_CPU_COUNT);
+	char *end;
+
 	int opt;
-	while((opt = getopt(argc,argv,"ri")) != -1) {
+	while((opt = getopt(argc,argv,"rik:t:j:S:")) != -1) {
 		switch(opt) {
-			case 'r': freverse = 1; break;
-			case 'i': figncase = 1; break;
+			case 'r': freverse = true; break;
+			case 'i': figncase = true; break;
+			case 'k':
+				keyStart = strtol(optarg,&end,10);
+				if(*end == ',')
+					keyEnd = strtol(end + 1,&end,10);
+				if(keyStart < 1 || *end != '\0' || (keyEnd != 0 && keyEnd < keyStart))
+					usage(argv[0]);
+				break;
+			case 't':
+				if(strlen(optarg) != 1)
+					usage(argv[0]);
+				separator = optarg[0];
+				break;
+			case 'j': threads = strtol(optarg,NULL,10); break;
+			case 'S': runSize = strtoul(optarg,NULL,0); break;
 			default:
 				usage(argv[0]);
 		}
 	}
+	if(threads < 1)
+		threads = 1;
 
 	// use arg?
 	FStream *in = &sin;
@@ -57,31 +362,41 @@ int main(int argc,char *argv[]) {
 			exitmsg("Open failed");
 	}
 
-	// read lines
-	string line;
-	vector<string> lines;
-	while(in->getline(line))
-		lines.push_back(line);
+	// read lines and write a sorted run to disk whenever we exceed the limit
+	vector<string> files;
+	vector<Line> lines;
+	vector<Run*> runs;
+	size_t memSize = 0;
+	Line line;
+	while(readLine(*in,line)) {
+		memSize += line.memSize();
+		lines.push_back(Line());
+		std::swap(lines.back(),line);
+		if(memSize >= runSize) {
+			sortLines(lines,threads,runs);
+			files.push_back(writeRun(runs));
+			lines.clear();
+			memSize = 0;
+		}
+	}
 
 	// close if it has been opened
 	if(in != &sin)
 		delete in;
 
-	// sort and print
-	sort(lines.begin(),lines.end(),compareStrs);
-	for(auto it = lines.begin(); it != lines.end(); ++it) {
-		sout << *it << '\n';
-		if(sout.bad())
-			exitmsg("Write failed");
+	// reduce the number of runs so that we can merge them at once
+	while(files.size() > MAX_MERGE) {
+		for(size_t i = 0; i < MAX_MERGE; ++i)
+			runs.push_back(new FileRun(files[i]));
+		files.erase(files.begin(),files.begin() + MAX_MERGE);
+		files.push_back(writeRun(runs));
 	}
-	return EXIT_SUCCESS;
-}
 
-static bool compareStrs(const string& a,const string& b) {
-	bool res;
-	if(figncase)
-		res = strcasecmp(a.c_str(),b.c_str()) < 0;
-	else
-		res = a < b;
-	return freverse ? !res : res;
+	// merge the remaining lines with the runs on disk
+	sortLines(lines,threads,runs);
+	for(auto it = files.begin(); it != files.end(); ++it)
+		runs.push_back(new FileRun(*it));
+	mergeRuns(runs,sout);
+	deleteRuns(runs);
+	return EXIT_SUCCESS;
 }
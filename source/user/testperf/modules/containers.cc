@@ -0,0 +1,80 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "../modules.h"
+
+static const uint TEST_COUNT	= 1000;
+
+/* prevent the compiler from optimizing the loops away */
+static volatile size_t sink;
+
+static void print_result(const char *name,uint64_t total) {
+	printf("%-26s: %Lu cycles/run\n",name,total / TEST_COUNT);
+}
+
+int mod_containers(A_UNUSED int argc,A_UNUSED char *argv[]) {
+	uint64_t start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		std::vector<int> v;
+		sink = v.size();
+	}
+	print_result("vector()",rdtsc() - start);
+
+	start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		std::vector<int> v;
+		for(int j = 0; j < 100; ++j)
+			v.push_back(j);
+		sink = v.size();
+	}
+	print_result("100 x push_back(int)",rdtsc() - start);
+
+	start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		std::vector<std::string> v;
+		for(int j = 0; j < 100; ++j)
+			v.push_back(std::string("a somewhat longer string"));
+		sink = v.size();
+	}
+	print_result("100 x push_back(string)",rdtsc() - start);
+
+	start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		std::string s("short");
+		std::string copy(s);
+		sink = copy.length();
+	}
+	print_result("string(short) + copy",rdtsc() - start);
+
+	start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		std::string s;
+		for(int j = 0; j < 100; ++j)
+			s += 'x';
+		sink = s.length();
+	}
+	print_result("100 x operator+=(char)",rdtsc() - start);
+	return 0;
+}
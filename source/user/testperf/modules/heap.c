@@ -19,6 +19,7 @@
 
 #include <sys/common.h>
 #include <sys/proc.h>
+#include <sys/thread.h>
 #include <sys/time.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -27,7 +28,10 @@
 #include "../modules.h"
 
 static const uint TEST_COUNT    = 10000;
+static const uint THREAD_OBJS   = 64;
 static size_t sizes[] = {4,8,16,32,64,128,256,512,1024};
+static size_t threadCounts[] = {1,2,4,8};
+static uint64_t threadTimes[8];
 
 static void test1(void) {
 	uint64_t atimes[ARRAY_SIZE(sizes)];
@@ -86,8 +90,52 @@ static void test2(void) {
 	free(areas);
 }
 
+static int thread_heap(void *arg) {
+	void *objs[THREAD_OBJS];
+	uint64_t start = rdtsc();
+	for(uint i = 0; i < TEST_COUNT; ++i) {
+		for(uint j = 0; j < THREAD_OBJS; ++j)
+			objs[j] = malloc(sizes[(i + j) % ARRAY_SIZE(sizes)]);
+		for(uint j = 0; j < THREAD_OBJS; ++j)
+			free(objs[j]);
+	}
+	threadTimes[(size_t)arg] = rdtsc() - start;
+	return 0;
+}
+
+static void test3(void) {
+	printf("%u*(%u*malloc + %u*free) per thread:\n",TEST_COUNT,THREAD_OBJS,THREAD_OBJS);
+	for(size_t t = 0; t < ARRAY_SIZE(threadCounts); ++t) {
+		for(size_t i = 0; i < threadCounts[t]; ++i) {
+			if(startthread(thread_heap,(void*)i) < 0) {
+				printe("Unable to start thread");
+				return;
+			}
+		}
+		join(0);
+
+		uint64_t max = 0;
+		for(size_t i = 0; i < threadCounts[t]; ++i)
+			max = MAX(max,threadTimes[i]);
+		uint64_t ops = (uint64_t)threadCounts[t] * TEST_COUNT * THREAD_OBJS;
+		printf("%zu threads: %Lu cycles total, %Lu cycles per malloc+free\n",
+			threadCounts[t],max,max * threadCounts[t] / ops);
+	}
+}
+
+static void printStats(void) {
+	sHeapStats stats;
+	heapstats(&stats);
+	printf("heap: %zu pages, %zu spans, %zu bytes used, %zu large objects (%zu bytes)\n",
+		stats.heapPages,stats.spans,stats.usedBytes,stats.largeCount,stats.largeBytes);
+	printf("      %zu mallocs, %zu frees, %zu cache refills, %zu cache flushes\n",
+		stats.mallocs,stats.frees,stats.cacheRefills,stats.cacheFlushes);
+}
+
 int mod_heap(A_UNUSED int argc,A_UNUSED char *argv[]) {
 	test1();
 	test2();
+	test3();
+	printStats();
 	return 0;
 }
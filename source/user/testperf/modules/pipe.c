@@ -18,6 +18,7 @@
  */
 
 #include <sys/common.h>
+#include <sys/pipe.h>
 #include <sys/proc.h>
 #include <sys/time.h>
 #include <sys/wait.h>
@@ -29,7 +30,27 @@
 
 #define WRITE_COUNT		10000
 
-static void test_pipe(size_t size) {
+static ssize_t pipe_read(tPipeEnd *end,int fd,void *buf,size_t size) {
+	if(end) {
+		size_t pos = 0;
+		while(pos < size) {
+			ssize_t res = piperead(end,(char*)buf + pos,size - pos);
+			if(res <= 0)
+				return res;
+			pos += res;
+		}
+		return pos;
+	}
+	return read(fd,buf,size);
+}
+
+static ssize_t pipe_write(tPipeEnd *end,int fd,const void *buf,size_t size) {
+	if(end)
+		return pipewrite(end,buf,size);
+	return write(fd,buf,size);
+}
+
+static void test_pipe(size_t size,bool ring) {
 	int rfd,wfd;
 	if(pipe(&rfd,&wfd) < 0) {
 		printe("pipe failed");
@@ -41,19 +62,24 @@ static void test_pipe(size_t size) {
 	const char *name;
 	void *buf;
 	int buffd;
+	tPipeEnd *pend = NULL;
 	if(fork() == 0) {
 		close(wfd);
 		if((buffd = sharebuf(rfd,size,&buf,0)) < 0)
 			printe("Unable to share buffer");
+		if(ring && (pend = pipemap(rfd)) == NULL)
+			printe("Unable to map pipe ring");
 		name = "read";
 		start = rdtsc();
 		for(i = 0; i < WRITE_COUNT; ++i) {
-			if(read(rfd,buf,size) < 0) {
+			if(pipe_read(pend,rfd,buf,size) < 0) {
 				printe("read failed");
 				return;
 			}
 		}
 		end = rdtsc();
+		if(pend)
+			pipeunmap(pend);
 		destroybuf(buf,buffd);
 		close(rfd);
 	}
@@ -61,22 +87,26 @@ static void test_pipe(size_t size) {
 		close(rfd);
 		if((buffd = sharebuf(wfd,size,&buf,0)) < 0)
 			printe("Unable to share buffer");
+		if(ring && (pend = pipemap(wfd)) == NULL)
+			printe("Unable to map pipe ring");
 		name = "write";
 		start = rdtsc();
 		for(i = 0; i < WRITE_COUNT; ++i) {
-			if(write(wfd,buf,size) < 0) {
+			if(pipe_write(pend,wfd,buf,size) < 0) {
 				printe("write failed");
 				return;
 			}
 		}
 		end = rdtsc();
+		if(pend)
+			pipeunmap(pend);
 		destroybuf(buf,buffd);
 		close(wfd);
 		waitchild(NULL,-1,0);
 	}
 
-	printf("[%4d] %s(%3zuK): %6Lu cycles/call, %Lu MB/s\n",
-			getpid(),name,size / 1024,(end - start) / WRITE_COUNT,
+	printf("[%4d] %s-%s(%3zuK): %6Lu cycles/call, %Lu MB/s\n",
+			getpid(),ring ? "ring" : "drv",name,size / 1024,(end - start) / WRITE_COUNT,
 			(size * WRITE_COUNT) / tsctotime(end - start));
 	/* child should exit here */
 	if(strcmp(name,"read") == 0)
@@ -87,7 +117,11 @@ int mod_pipe(A_UNUSED int argc,A_UNUSED char *argv[]) {
 	size_t i, sizes[] = {0x1000,0x2000,0x4000,0x8000,0x10000};
 	for(i = 0; i < ARRAY_SIZE(sizes); ++i) {
 		fflush(stdout);
-		test_pipe(sizes[i]);
+		test_pipe(sizes[i],false);
+	}
+	for(i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		fflush(stdout);
+		test_pipe(sizes[i],true);
 	}
 	return 0;
 }
@@ -0,0 +1,107 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/io.h>
+#include <sys/proc.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../modules.h"
+
+#define TEST_COUNT		100
+#define BIG_SIZE		(8 * 1024 * 1024)
+
+static const char *args[] = {"/bin/echo",NULL};
+
+static void forkexec(int nullfd) {
+	size_t i;
+	uint64_t total = 0;
+	for(i = 0; i < TEST_COUNT; ++i) {
+		uint64_t start = rdtsc();
+		int pid = fork();
+		if(pid == 0) {
+			redirect(STDOUT_FILENO,nullfd);
+			execv(args[0],args);
+			exit(1);
+		}
+		else if(pid < 0) {
+			printe("fork failed");
+			return;
+		}
+		waitchild(NULL,-1,0);
+		total += rdtsc() - start;
+	}
+	printf("fork+exec : %Lu cycles/call\n",total / TEST_COUNT);
+}
+
+static void spawn(int nullfd) {
+	posix_spawn_file_actions_t fa;
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_adddup2(&fa,nullfd,STDOUT_FILENO);
+
+	size_t i;
+	uint64_t total = 0;
+	for(i = 0; i < TEST_COUNT; ++i) {
+		uint64_t start = rdtsc();
+		int res = posix_spawn(NULL,args[0],&fa,NULL,(char**)args,NULL);
+		if(res < 0) {
+			printe("spawn failed");
+			break;
+		}
+		waitchild(NULL,-1,0);
+		total += rdtsc() - start;
+	}
+	printf("spawn     : %Lu cycles/call\n",total / TEST_COUNT);
+	posix_spawn_file_actions_destroy(&fa);
+}
+
+int mod_spawn(A_UNUSED int argc,A_UNUSED char *argv[]) {
+	int nullfd = open("/dev/null",O_WRONLY);
+	if(nullfd < 0) {
+		printe("Unable to open /dev/null");
+		return EXIT_FAILURE;
+	}
+
+	printf("Small parent...\n");
+	fflush(stdout);
+	forkexec(nullfd);
+	spawn(nullfd);
+
+	/* the costs of fork grow with the address space of the parent; spawn's don't */
+	char *big = (char*)malloc(BIG_SIZE);
+	if(!big) {
+		printe("Unable to allocate memory");
+		return EXIT_FAILURE;
+	}
+	memset(big,0,BIG_SIZE);
+
+	printf("Big parent (%d KiB)...\n",BIG_SIZE / 1024);
+	fflush(stdout);
+	forkexec(nullfd);
+	spawn(nullfd);
+
+	free(big);
+	close(nullfd);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**
+ * $Id$
+ * Copyright (C) 2008 - 2014 Nils Asmussen
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <sys/common.h>
+#include <sys/time.h>
+#include <z/crc32.h>
+#include <z/deflate.h>
+#include <z/inflate.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../modules.h"
+
+static const size_t DATA_SIZE	= 256 * 1024;
+static const uint TEST_COUNT	= 8;
+
+static uint32_t crctable[256];
+
+/* the classic byte-wise CRC32 as a baseline */
+static uint32_t crc32_bytewise(const uint8_t *buf,size_t len) {
+	uint32_t crc = 0xFFFFFFFF;
+	while(len-- > 0)
+		crc = crctable[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFF;
+}
+
+static void fill_data(uint8_t *buf,size_t len) {
+	/* something text-like: random words from a small dictionary */
+	static const char *words[] = {
+		"the ","kernel ","process ","thread ","memory ","file ","page ","driver ","\n",
+		"inode ","block ","lock ","signal ","channel ","message ","region ","= ","; ",
+	};
+	size_t pos = 0;
+	while(pos < len) {
+		const char *w = words[rand() % ARRAY_SIZE(words)];
+		while(*w && pos < len)
+			buf[pos++] = *w++;
+	}
+}
+
+static void print_result(const char *name,size_t bytes,uint64_t total) {
+	printf("%-14s: %Lu cycles/call, %Lu MB/s\n",
+		name,total / TEST_COUNT,(bytes * TEST_COUNT) / tsctotime(total));
+}
+
+int mod_zlib(A_UNUSED int argc,A_UNUSED char *argv[]) {
+	uint8_t *data = (uint8_t*)malloc(DATA_SIZE);
+	uint8_t *comp = (uint8_t*)malloc(DATA_SIZE * 2);
+	uint8_t *decomp = (uint8_t*)malloc(DATA_SIZE);
+	if(!data || !comp || !decomp) {
+		printe("Not enough memory");
+		return 1;
+	}
+	fill_data(data,DATA_SIZE);
+
+	for(uint32_t i = 0; i < 256; ++i) {
+		uint32_t c = i;
+		for(int k = 0; k < 8; ++k)
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		crctable[i] = c;
+	}
+
+	{
+		z::CRC32 crc;
+		uint64_t total = 0;
+		uint32_t res1 = 0, res2 = 0;
+		for(uint i = 0; i < TEST_COUNT; ++i) {
+			uint64_t start = rdtsc();
+			res1 = crc32_bytewise(data,DATA_SIZE);
+			total += rdtsc() - start;
+		}
+		print_result("crc32 bytewise",DATA_SIZE,total);
+
+		total = 0;
+		for(uint i = 0; i < TEST_COUNT; ++i) {
+			uint64_t start = rdtsc();
+			res2 = crc.get(data,DATA_SIZE);
+			total += rdtsc() - start;
+		}
+		print_result("crc32",DATA_SIZE,total);
+		if(res1 != res2)
+			printe("CRC mismatch: %#x vs. %#x",res1,res2);
+	}
+
+	z::Deflate deflate;
+	z::Inflate inflate;
+	int levels[] = {
+		z::Deflate::NONE,z::Deflate::FASTEST,z::Deflate::DEFAULT,z::Deflate::BEST
+	};
+	for(size_t l = 0; l < ARRAY_SIZE(levels); ++l) {
+		char name[32];
+		size_t size = 0;
+		uint64_t total = 0;
+		for(uint i = 0; i < TEST_COUNT; ++i) {
+			z::MemDeflateSource src(data,DATA_SIZE);
+			z::MemDeflateDrain drain(comp,DATA_SIZE * 2);
+			uint64_t start = rdtsc();
+			deflate.compress(&drain,&src,levels[l]);
+			total += rdtsc() - start;
+			size = drain.count();
+		}
+		snprintf(name,sizeof(name),"deflate(%d)",levels[l]);
+		print_result(name,DATA_SIZE,total);
+		printf("%-14s: %zu -> %zu bytes\n",name,DATA_SIZE,size);
+
+		total = 0;
+		for(uint i = 0; i < TEST_COUNT; ++i) {
+			z::MemInflateSource src(comp,size);
+			z::MemInflateDrain drain(decomp,DATA_SIZE);
+			uint64_t start = rdtsc();
+			int res = inflate.uncompress(&drain,&src);
+			total += rdtsc() - start;
+			if(res != 0 || memcmp(data,decomp,DATA_SIZE) != 0)
+				printe("Decompression failed");
+		}
+		snprintf(name,sizeof(name),"inflate(%d)",levels[l]);
+		print_result(name,DATA_SIZE,total);
+	}
+
+	free(decomp);
+	free(comp);
+	free(data);
+	return 0;
+}
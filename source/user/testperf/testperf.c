@@ -37,6 +37,7 @@ static sTestModule modules[] = {
 	{"getpid",		mod_getpid},
 	{"yield",		mod_yield},
 	{"fork",		mod_fork},
+	{"spawn",		mod_spawn},
 	{"startthread",	mod_startthread},
 	{"file",		mod_file},
 	{"mmap",		mod_mmap},
@@ -51,6 +52,8 @@ static sTestModule modules[] = {
 	{"pagefault",	mod_pagefault},
 	{"heap",		mod_heap},
 	{"stdio",		mod_stdio},
+	{"zlib",		mod_zlib},
+	{"containers",	mod_containers},
 };
 
 int main(int argc,char *argv[]) {